@@ -27,6 +27,11 @@
 
 const int MAX_REGISTERS = 16;
 const int MAX_MEM_OPERATIONS = 16;
+/** @brief Most instructions in a block query, the bits of the slot masks. */
+const int MAX_FETCH_BLOCK_INSTRUCTIONS = 16;
+/** @brief Most memory operations of a FetchTargetPacket, enough for any
+ * single instruction. */
+const int MAX_FETCH_BLOCK_MEMORY_OPERATIONS = 2 * MAX_MEM_OPERATIONS;
 const int TRACE_LINE_SIZE = 256;
 /**
  * @brief Intel Pin warns that any size < 23 may cause output to be truncated.
@@ -133,9 +138,36 @@ union FetchPacket {
 };
 
 /**
- * @brief Used by memory components.
+ * @brief Tag for the MemoryPacket.
  */
-typedef unsigned long MemoryPacket;
+enum MemoryPacketType {
+    MemoryPacketTypeRead,
+    MemoryPacketTypeWrite,
+    MemoryPacketTypeWriteBack, /** @brief Dirty line evicted by the sender.
+                                  It is not answered. */
+    MemoryPacketTypeEvict,     /** @brief Clean line evicted by the sender.
+                                  It is not answered. */
+    MemoryPacketTypeInvalidate, /** @brief Sent as a response, the receiver
+                                   must drop the line. */
+};
+
+/**
+ * @brief Used by memory components. Responses carry the request back.
+ */
+struct MemoryPacket {
+    unsigned long address;
+    unsigned long instAddress; /**< Of the load or store, 0 if unknown. */
+    MemoryPacketType type;
+};
+
+/**
+ * @brief Used by TLBs and page walkers. Requests carry the virtual address,
+ * responses carry the request back with the size of the page found.
+ */
+struct TranslationPacket {
+    unsigned long address;
+    bool largePage; /**< Response only, the page has 2 MiB. */
+};
 
 /**
  * @brief Tag for the PredictorPacket union.
@@ -148,6 +180,8 @@ enum PredictorPacketType {
     PredictorPacketTypeResponseTake,
     PredictorPacketTypeResponseTakeToAddress,
     PredictorPacketTypeResponseDontTake,
+    PredictorPacketTypeRequestBlockQuery,
+    PredictorPacketTypeResponseBlock,
 };
 
 /**
@@ -163,6 +197,14 @@ enum PredictorPacketType {
  * the target is not known, a ResponseTakeToAddress if the prediction is to take
  * and the address is known (data is filled with responseAddress), and a
  * ResponseDontTake if the prediction is to not take the branch.
+ *
+ * A fetcher may instead send one RequestBlockQuery per fetch block, with the
+ * static information of its instructions in program order. The predictor
+ * answers with a single ResponseBlock holding the prediction of each slot as
+ * bit masks: slots without a bit in knownMask got a ResponseUnknown, slots in
+ * takenMask a ResponseTake, and those also in targetMask a
+ * ResponseTakeToAddress with the target in targets. Updates are still sent
+ * per instruction.
  */
 struct PredictorPacket {
     union {
@@ -185,8 +227,68 @@ struct PredictorPacket {
             InstructionPacket instruction; /** @brief The instruction. */
             unsigned long target;          /** @brief Its target. */
         } targetResponse;                  /** @brief Data of response types. */
+
+        struct {
+            const StaticInstructionInfo*
+                instructions[MAX_FETCH_BLOCK_INSTRUCTIONS];
+            unsigned long startAddress; /** @brief Of the first instruction. */
+            unsigned long nextAddress;  /** @brief Where the trace continues
+                                            after the block, for oracles. */
+            unsigned int numberOfInstructions;
+        } blockQuery; /** @brief A request to predict a fetch block. */
+
+        struct {
+            unsigned long targets[MAX_FETCH_BLOCK_INSTRUCTIONS];
+            unsigned long startAddress;
+            unsigned int numberOfInstructions;
+            unsigned int knownMask;  /** @brief Slots with a prediction. */
+            unsigned int takenMask;  /** @brief Slots predicted taken. */
+            unsigned int targetMask; /** @brief Slots with a known target. */
+        } blockResponse; /** @brief Per slot predictions of a fetch block. */
     } data;                                /** @brief The data. */
     PredictorPacketType type;              /** @brief The tag. */
 };
 
+/**
+ * @brief Tag for the FetchTargetPacket.
+ */
+enum FetchTargetPacketType {
+    FetchTargetPacketTypeRequestBlock,    /** @brief A FTQ entry is free. */
+    FetchTargetPacketTypeRequestRedirect, /** @brief The mispredicted block
+                                             was fetched. */
+    FetchTargetPacketTypeResponseBlock,
+};
+
+/**
+ * @brief Exchanged between a branch prediction unit and the fetch unit that
+ * consumes its fetch target queue (FTQ).
+ * @details The fetch unit sends a RequestBlock for each free FTQ entry and the
+ * prediction unit answers each one with a ResponseBlock, a predicted fetch
+ * block: a run of consecutive instructions ending at a taken branch or at
+ * MAX_FETCH_BLOCK_INSTRUCTIONS. When the fetch unit is done with a block
+ * marked mispredicted it sends a RequestRedirect, as the branch would be
+ * resolved from then on. Requests carry only the type.
+ *
+ * Every message has the size of the packet, so a block keeps only what
+ * rebuilds its InstructionPackets: the static information, where the trace
+ * goes after the last instruction (the others fall through) and the memory
+ * operations of all instructions packed in program order, the reads of an
+ * instruction before its writes. A block ends early when the operations of an
+ * instruction do not fit.
+ */
+struct FetchTargetPacket {
+    const StaticInstructionInfo* instructions[MAX_FETCH_BLOCK_INSTRUCTIONS];
+    unsigned long memoryAddresses[MAX_FETCH_BLOCK_MEMORY_OPERATIONS];
+    unsigned int memorySizes[MAX_FETCH_BLOCK_MEMORY_OPERATIONS];
+    unsigned char numReadings[MAX_FETCH_BLOCK_INSTRUCTIONS];
+    unsigned char numWritings[MAX_FETCH_BLOCK_INSTRUCTIONS];
+    unsigned long startAddress; /** @brief Of the first instruction. */
+    unsigned long endAddress;   /** @brief After the last byte of the block. */
+    unsigned long nextAddress;  /** @brief Next instruction of the last one. */
+    unsigned int numberOfInstructions;
+    unsigned int numberOfMemoryOperations;
+    bool mispredicted; /** @brief The block ends the predicted path. */
+    FetchTargetPacketType type;
+};
+
 #endif  // SINUCA3_DEFAULT_PACKETS_HPP_
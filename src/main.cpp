@@ -28,6 +28,7 @@
 #include <cstring>
 #include <sinuca3.hpp>
 #include <tracer/sinuca/trace_reader.hpp>
+#include <tracer/synthetic/trace_reader.hpp>
 #include <tracer/trace_reader.hpp>
 #include <utils/map.hpp>
 #include <vector>
@@ -81,8 +82,9 @@ void usage() {
         "to see license information.\n"
         "\n"
         "Other simulation options:\n"
-        "   -T <string> sets the trace reader to use (orcs, foo, bar, "
-        "TODO...)\n");
+        "   -T <string> sets the trace reader to use (sinuca3 or synthetic). "
+        "The synthetic reader takes its parameters through -t as a "
+        "key=value list, e.g. -t threads=2,instructions=1000000\n");
 }
 
 /**
@@ -91,6 +93,8 @@ void usage() {
 TraceReader* AllocTraceReader(const char* traceReader) {
     if (strcmp(traceReader, "sinuca3") == 0)
         return new SinucaTraceReader;
+    else if (strcmp(traceReader, "synthetic") == 0)
+        return new SyntheticTraceReader;
     else
         return NULL;
 }
@@ -0,0 +1,626 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file out_of_order_core.cpp
+ * @brief Implementation of the OutOfOrderCore.
+ */
+
+#include "out_of_order_core.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <sinuca3.hpp>
+
+int OutOfOrderCore::Configure(Config config) {
+    if (config.ComponentReference("fetching", &this->fetching, true)) return 1;
+    if (config.ComponentReference("dataMemory", &this->dataMemory)) return 1;
+
+    long fetchSize = this->fetchSize;
+    if (config.Integer("fetchSize", &fetchSize)) return 1;
+    if (fetchSize <= 0) return config.Error("fetchSize", "is not > 0.");
+    this->fetchSize = fetchSize;
+
+    long width = this->width;
+    if (config.Integer("width", &width)) return 1;
+    if (width <= 0) return config.Error("width", "is not > 0.");
+    this->width = width;
+
+    long robSize = this->robSize;
+    if (config.Integer("robSize", &robSize)) return 1;
+    if (robSize <= 0) return config.Error("robSize", "is not > 0.");
+    this->robSize = robSize;
+
+    long physicalRegisters = this->physicalRegisters;
+    if (config.Integer("physicalRegisters", &physicalRegisters)) return 1;
+    if (physicalRegisters <= 0 ||
+        physicalRegisters >= OUT_OF_ORDER_CORE_RETIRED) {
+        return config.Error("physicalRegisters",
+                            "is not between 1 and 65534.");
+    }
+    this->physicalRegisters = physicalRegisters;
+
+    const char* issueQueues = "unified";
+    if (config.String("issueQueues", &issueQueues)) return 1;
+    if (strcmp(issueQueues, "unified") == 0) {
+        this->numberOfQueues = 1;
+    } else if (strcmp(issueQueues, "split") == 0) {
+        this->numberOfQueues = OUT_OF_ORDER_CORE_UNITS;
+    } else {
+        return config.Error("issueQueues", "should be unified or split");
+    }
+
+    if (config.Integer("issueQueueSize", &this->issueQueueSize)) return 1;
+    if (this->issueQueueSize <= 0 ||
+        this->issueQueueSize > OUT_OF_ORDER_CORE_MAX_QUEUE) {
+        return config.Error("issueQueueSize", "is not between 1 and 64.");
+    }
+
+    const char* portNames[OUT_OF_ORDER_CORE_UNITS] = {
+        "aluPorts", "memoryPorts", "branchPorts"};
+    const long defaultPorts[OUT_OF_ORDER_CORE_UNITS] = {3, 2, 1};
+    long totalPorts = 0;
+    for (int i = 0; i < OUT_OF_ORDER_CORE_UNITS; ++i) {
+        this->ports[i] = defaultPorts[i];
+        if (config.Integer(portNames[i], &this->ports[i])) return 1;
+        if (this->ports[i] <= 0) {
+            return config.Error(portNames[i], "is not > 0.");
+        }
+        totalPorts += this->ports[i];
+    }
+
+    long aluLatency = 1;
+    if (config.Integer("aluLatency", &aluLatency)) return 1;
+    if (aluLatency <= 0) return config.Error("aluLatency", "is not > 0.");
+    long branchLatency = 1;
+    if (config.Integer("branchLatency", &branchLatency)) return 1;
+    if (branchLatency <= 0) {
+        return config.Error("branchLatency", "is not > 0.");
+    }
+    long loadLatency = this->loadLatency;
+    if (config.Integer("loadLatency", &loadLatency)) return 1;
+    if (loadLatency <= 0) return config.Error("loadLatency", "is not > 0.");
+    // Memory instructions that do not wait for dataMemory only compute their
+    // addresses.
+    this->latencies[OutOfOrderCoreUnitAlu] = aluLatency;
+    this->latencies[OutOfOrderCoreUnitMemory] = aluLatency;
+    this->latencies[OutOfOrderCoreUnitBranch] = branchLatency;
+    this->loadLatency = loadLatency;
+
+    this->fetchingID = this->fetching->Connect(0);
+    if (this->dataMemory != NULL) {
+        this->dataMemoryID = this->dataMemory->Connect(0);
+    }
+
+    this->fetchBufferSize = 2 * this->fetchSize;
+    this->fetchBuffer = new InstructionPacket[this->fetchBufferSize];
+    this->rob = new OutOfOrderCoreRobEntry[this->robSize];
+
+    this->renameTable = new unsigned short[1 << 16];
+    for (long i = 0; i < (1 << 16); ++i) {
+        this->renameTable[i] = OUT_OF_ORDER_CORE_RETIRED;
+    }
+    this->freeRegisters = new unsigned short[this->physicalRegisters];
+    for (unsigned long i = 0; i < this->physicalRegisters; ++i) {
+        this->freeRegisters[i] = i;
+    }
+    this->numberOfFreeRegisters = this->physicalRegisters;
+    this->readyRegisters =
+        new unsigned long[(this->physicalRegisters + 63) / 64]();
+
+    this->queues = new OutOfOrderCoreIssueQueue[this->numberOfQueues];
+    for (int i = 0; i < this->numberOfQueues; ++i) {
+        this->queues[i].usedMask = 0;
+        this->queues[i].readyMask = 0;
+        this->queues[i].occupation = 0;
+    }
+    this->waiters =
+        new unsigned long[this->physicalRegisters * this->numberOfQueues]();
+
+    // Room for every read of a full ROB, in at least a bucket per entry.
+    unsigned long loads = this->robSize * MAX_MEM_OPERATIONS;
+    this->loadTable = new OutOfOrderCoreLoad[loads];
+    for (unsigned long i = 0; i < loads; ++i) this->loadTable[i].next = i + 1;
+    this->loadTable[loads - 1].next = -1;
+    this->freeLoads = 0;
+    this->loadBucketBits = 1;
+    while ((1UL << this->loadBucketBits) < this->robSize) {
+        ++this->loadBucketBits;
+    }
+    this->loadBuckets = new int[1UL << this->loadBucketBits];
+    memset(this->loadBuckets, -1,
+           sizeof(*this->loadBuckets) << this->loadBucketBits);
+
+    // What completes in a cycle was issued with one of the three latencies.
+    unsigned long maxLatency = aluLatency;
+    if ((unsigned long)branchLatency > maxLatency) maxLatency = branchLatency;
+    if ((unsigned long)loadLatency > maxLatency) maxLatency = loadLatency;
+    this->wheelSlots = maxLatency + 1;
+    this->wheelSlotSize = 3 * totalPorts;
+    this->completionWheel =
+        new unsigned long[this->wheelSlots * this->wheelSlotSize];
+    this->completionWheelOccupation = new int[this->wheelSlots]();
+
+    return 0;
+}
+
+void OutOfOrderCore::Schedule(unsigned long robIndex, unsigned long latency) {
+    unsigned long slot = (this->cycle + latency) % this->wheelSlots;
+    assert(this->completionWheelOccupation[slot] < this->wheelSlotSize);
+    this->completionWheel[slot * this->wheelSlotSize +
+                          this->completionWheelOccupation[slot]] = robIndex;
+    ++this->completionWheelOccupation[slot];
+}
+
+void OutOfOrderCore::Complete(unsigned long robIndex) {
+    OutOfOrderCoreRobEntry* entry = &this->rob[robIndex];
+    entry->completed = true;
+
+    const StaticInstructionInfo* info = entry->instruction.staticInfo;
+    for (int i = 0; i < info->numberOfWriteRegs; ++i) {
+        unsigned short reg = entry->destinations[i];
+        this->readyRegisters[reg / 64] |= 1UL << (reg % 64);
+
+        for (int q = 0; q < this->numberOfQueues; ++q) {
+            OutOfOrderCoreIssueQueue* queue = &this->queues[q];
+            unsigned long* waiting =
+                &this->waiters[reg * this->numberOfQueues + q];
+            for (unsigned long mask = *waiting; mask != 0; mask &= mask - 1) {
+                int slot = __builtin_ctzl(mask);
+                if (--queue->entries[slot].pendingSources == 0) {
+                    queue->readyMask |= 1UL << slot;
+                }
+            }
+            *waiting = 0;
+        }
+    }
+}
+
+int OutOfOrderCore::Dispatch(const InstructionPacket* instruction) {
+    const StaticInstructionInfo* info = instruction->staticInfo;
+
+    OutOfOrderCoreUnit unit = OutOfOrderCoreUnitAlu;
+    if (info->instReadsMemory || info->instWritesMemory) {
+        unit = OutOfOrderCoreUnitMemory;
+    } else if (info->branchType != BranchNone) {
+        unit = OutOfOrderCoreUnitBranch;
+    }
+    OutOfOrderCoreIssueQueue* queue = this->Queue(unit);
+
+    if (this->robOccupation == this->robSize) {
+        ++this->robFullCycles;
+        return 1;
+    }
+    if (queue->occupation == this->issueQueueSize) {
+        ++this->queueFullCycles;
+        return 1;
+    }
+    if (this->numberOfFreeRegisters < info->numberOfWriteRegs) {
+        ++this->registersFullCycles;
+        return 1;
+    }
+
+    unsigned long robIndex =
+        (this->robStart + this->robOccupation) % this->robSize;
+    ++this->robOccupation;
+    OutOfOrderCoreRobEntry* entry = &this->rob[robIndex];
+    entry->instruction = *instruction;
+    entry->pendingReads = 0;
+    entry->completed = false;
+
+    // There is a free entry below issueQueueSize, as the used ones are always
+    // the lowest free.
+    int slot = __builtin_ctzl(~queue->usedMask);
+    unsigned long bit = 1UL << slot;
+    OutOfOrderCoreQueueEntry* queueEntry = &queue->entries[slot];
+    queueEntry->robIndex = robIndex;
+    queueEntry->pendingSources = 0;
+    queueEntry->unit = unit;
+    // Instructions are dispatched in program order, the youngest goes last.
+    queue->order[queue->occupation] = slot;
+    queue->usedMask |= bit;
+    ++queue->occupation;
+
+    // Sources are renamed before the destinations, an instruction may read
+    // and write the same register.
+    long queueIndex = queue - this->queues;
+    for (int i = 0; i < info->numberOfReadRegs; ++i) {
+        unsigned short reg = this->renameTable[info->readRegsArray[i]];
+        if (reg == OUT_OF_ORDER_CORE_RETIRED || this->IsReady(reg)) continue;
+        unsigned long* waiting =
+            &this->waiters[reg * this->numberOfQueues + queueIndex];
+        if (*waiting & bit) continue;
+        *waiting |= bit;
+        ++queueEntry->pendingSources;
+    }
+    if (queueEntry->pendingSources == 0) queue->readyMask |= bit;
+
+    for (int i = 0; i < info->numberOfWriteRegs; ++i) {
+        unsigned short reg = this->freeRegisters[this->freeRegistersStart];
+        this->freeRegistersStart =
+            (this->freeRegistersStart + 1) % this->physicalRegisters;
+        --this->numberOfFreeRegisters;
+        this->readyRegisters[reg / 64] &= ~(1UL << (reg % 64));
+        this->renameTable[info->writtenRegsArray[i]] = reg;
+        entry->destinations[i] = reg;
+    }
+
+    return 0;
+}
+
+void OutOfOrderCore::Issue(OutOfOrderCoreIssueQueue* queue, int slot) {
+    OutOfOrderCoreQueueEntry* queueEntry = &queue->entries[slot];
+    unsigned long bit = 1UL << slot;
+    queue->usedMask &= ~bit;
+    queue->readyMask &= ~bit;
+
+    unsigned long robIndex = queueEntry->robIndex;
+    OutOfOrderCoreRobEntry* entry = &this->rob[robIndex];
+    const DynamicInstructionInfo* dynamic = &entry->instruction.dynamicInfo;
+    if (queueEntry->unit != OutOfOrderCoreUnitMemory ||
+        dynamic->numReadings == 0) {
+        this->Schedule(robIndex, this->latencies[queueEntry->unit]);
+        return;
+    }
+
+    ++this->loads;
+    if (this->dataMemory == NULL) {
+        this->Schedule(robIndex, this->loadLatency);
+        return;
+    }
+
+    MemoryPacket packet;
+    packet.instAddress = entry->instruction.staticInfo->instAddress;
+    packet.type = MemoryPacketTypeRead;
+    for (int i = 0; i < dynamic->numReadings; ++i) {
+        packet.address = dynamic->readsAddr[i];
+        this->dataMemory->SendRequest(this->dataMemoryID, &packet);
+        entry->pendingReads |= 1U << i;
+
+        // Appended to the bucket, so the older reads of an address come
+        // first. There is always a free entry, each ROB entry has room for
+        // its reads.
+        int load = this->freeLoads;
+        assert(load != -1);
+        this->freeLoads = this->loadTable[load].next;
+        this->loadTable[load].address = packet.address;
+        this->loadTable[load].robIndex = robIndex;
+        this->loadTable[load].read = i;
+        this->loadTable[load].next = -1;
+        int* link = this->LoadBucket(packet.address);
+        while (*link != -1) link = &this->loadTable[*link].next;
+        *link = load;
+    }
+}
+
+void OutOfOrderCore::ClockReceiveLoads() {
+    if (this->dataMemory == NULL) return;
+
+    MemoryPacket packet;
+    while (this->dataMemory->ReceiveResponse(this->dataMemoryID, &packet) ==
+           0) {
+        if (packet.type != MemoryPacketTypeRead) continue;
+
+        int* link = this->LoadBucket(packet.address);
+        while (*link != -1 && this->loadTable[*link].address != packet.address)
+            link = &this->loadTable[*link].next;
+        if (*link == -1) continue;
+
+        int load = *link;
+        OutOfOrderCoreLoad* entry = &this->loadTable[load];
+        *link = entry->next;
+        entry->next = this->freeLoads;
+        this->freeLoads = load;
+
+        OutOfOrderCoreRobEntry* robEntry = &this->rob[entry->robIndex];
+        robEntry->pendingReads &= ~(1U << entry->read);
+        if (robEntry->pendingReads == 0) this->Complete(entry->robIndex);
+    }
+}
+
+void OutOfOrderCore::ClockComplete() {
+    unsigned long slot = this->cycle % this->wheelSlots;
+    unsigned long* completed =
+        &this->completionWheel[slot * this->wheelSlotSize];
+    for (int i = 0; i < this->completionWheelOccupation[slot]; ++i) {
+        this->Complete(completed[i]);
+    }
+    this->completionWheelOccupation[slot] = 0;
+}
+
+void OutOfOrderCore::ClockRetire() {
+    for (unsigned long i = 0; i < this->width && this->robOccupation > 0;
+         ++i) {
+        OutOfOrderCoreRobEntry* entry = &this->rob[this->robStart];
+        if (!entry->completed) return;
+
+        const StaticInstructionInfo* info = entry->instruction.staticInfo;
+        for (int r = 0; r < info->numberOfWriteRegs; ++r) {
+            unsigned short reg = entry->destinations[r];
+            // The value goes to the architectural state, unless a younger
+            // instruction already renamed the register again.
+            if (this->renameTable[info->writtenRegsArray[r]] == reg) {
+                this->renameTable[info->writtenRegsArray[r]] =
+                    OUT_OF_ORDER_CORE_RETIRED;
+            }
+            this->freeRegisters[(this->freeRegistersStart +
+                                 this->numberOfFreeRegisters) %
+                                this->physicalRegisters] = reg;
+            ++this->numberOfFreeRegisters;
+        }
+
+        const DynamicInstructionInfo* dynamic = &entry->instruction.dynamicInfo;
+        this->stores += dynamic->numWritings;
+        if (this->dataMemory != NULL) {
+            MemoryPacket packet;
+            packet.instAddress = info->instAddress;
+            packet.type = MemoryPacketTypeWrite;
+            for (int w = 0; w < dynamic->numWritings; ++w) {
+                packet.address = dynamic->writesAddr[w];
+                this->dataMemory->SendRequest(this->dataMemoryID, &packet);
+            }
+        }
+
+        this->robStart = (this->robStart + 1) % this->robSize;
+        --this->robOccupation;
+        ++this->retiredInstructions;
+    }
+}
+
+void OutOfOrderCore::ClockIssue() {
+    long portsLeft[OUT_OF_ORDER_CORE_UNITS];
+    memcpy(portsLeft, this->ports, sizeof(portsLeft));
+    long totalPortsLeft = 0;
+    for (int i = 0; i < OUT_OF_ORDER_CORE_UNITS; ++i) {
+        totalPortsLeft += portsLeft[i];
+    }
+
+    for (int q = 0; q < this->numberOfQueues && totalPortsLeft > 0; ++q) {
+        OutOfOrderCoreIssueQueue* queue = &this->queues[q];
+        // Walks the slots oldest first, compacting the order over the issued
+        // ones, until no ready entry or port is left.
+        unsigned long candidates = queue->readyMask;
+        long kept = 0;
+        long i = 0;
+        for (; i < queue->occupation && candidates != 0 && totalPortsLeft > 0;
+             ++i) {
+            int slot = queue->order[i];
+            unsigned long bit = 1UL << slot;
+            OutOfOrderCoreUnit unit = queue->entries[slot].unit;
+            if ((candidates & bit) && portsLeft[unit] > 0) {
+                candidates &= ~bit;
+                --portsLeft[unit];
+                --totalPortsLeft;
+                this->Issue(queue, slot);
+                continue;
+            }
+            candidates &= ~bit;
+            queue->order[kept++] = slot;
+        }
+        if (kept == i) continue;
+        memmove(&queue->order[kept], &queue->order[i],
+                (queue->occupation - i) * sizeof(*queue->order));
+        queue->occupation -= i - kept;
+    }
+}
+
+void OutOfOrderCore::ClockRename() {
+    for (unsigned long i = 0; i < this->width && this->fetchBufferUsage > 0;
+         ++i) {
+        if (this->Dispatch(&this->fetchBuffer[this->fetchBufferStart])) return;
+        this->fetchBufferStart =
+            (this->fetchBufferStart + 1) % this->fetchBufferSize;
+        --this->fetchBufferUsage;
+    }
+}
+
+void OutOfOrderCore::ClockFetch() {
+    FetchPacket packet;
+    while (this->fetching->ReceiveResponse(this->fetchingID, &packet) == 0) {
+        assert(this->fetchBufferUsage < this->fetchBufferSize);
+        unsigned long i = (this->fetchBufferStart + this->fetchBufferUsage) %
+                          this->fetchBufferSize;
+        this->fetchBuffer[i] = packet.response;
+        ++this->fetchBufferUsage;
+    }
+}
+
+void OutOfOrderCore::ClockRequestFetch() {
+    // The answers come in the cycle after the next one, so the bytes asked
+    // last cycle are still on their way. The buffer has room for both.
+    unsigned long usage = this->previousRequest;
+    for (unsigned long i = 0; i < this->fetchBufferUsage; ++i) {
+        usage += this->fetchBuffer[(this->fetchBufferStart + i) %
+                                   this->fetchBufferSize]
+                     .staticInfo->instSize;
+    }
+
+    this->previousRequest = 0;
+    if (usage >= this->fetchBufferSize) return;
+    unsigned long request = this->fetchBufferSize - usage;
+    if (request > this->fetchSize) request = this->fetchSize;
+
+    FetchPacket packet;
+    packet.request = request;
+    if (this->fetching->SendRequest(this->fetchingID, &packet) == 0) {
+        this->previousRequest = request;
+    }
+}
+
+void OutOfOrderCore::Clock() {
+    this->ClockReceiveLoads();
+    this->ClockComplete();
+    this->ClockRetire();
+    this->ClockIssue();
+    this->ClockRename();
+    this->ClockFetch();
+    this->ClockRequestFetch();
+    ++this->cycle;
+}
+
+void OutOfOrderCore::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("OutOfOrderCore [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Cycles [%lu], retired instructions [%lu]\n",
+                       this->cycle, this->retiredInstructions);
+    SINUCA3_LOG_PRINTF(
+        "    IPC [%.3f]\n",
+        this->cycle == 0
+            ? 0.0
+            : (double)this->retiredInstructions / (double)this->cycle);
+    SINUCA3_LOG_PRINTF("    Loads [%lu], stores [%lu]\n", this->loads,
+                       this->stores);
+    SINUCA3_LOG_PRINTF("    Rename stalls: ROB full [%lu], issue queue full "
+                       "[%lu], registers full [%lu]\n",
+                       this->robFullCycles, this->queueFullCycles,
+                       this->registersFullCycles);
+}
+
+OutOfOrderCore::~OutOfOrderCore() {
+    if (this->fetchBuffer != NULL) delete[] this->fetchBuffer;
+    if (this->rob != NULL) delete[] this->rob;
+    if (this->renameTable != NULL) delete[] this->renameTable;
+    if (this->freeRegisters != NULL) delete[] this->freeRegisters;
+    if (this->readyRegisters != NULL) delete[] this->readyRegisters;
+    if (this->queues != NULL) delete[] this->queues;
+    if (this->waiters != NULL) delete[] this->waiters;
+    if (this->loadTable != NULL) delete[] this->loadTable;
+    if (this->loadBuckets != NULL) delete[] this->loadBuckets;
+    if (this->completionWheel != NULL) delete[] this->completionWheel;
+    if (this->completionWheelOccupation != NULL) {
+        delete[] this->completionWheelOccupation;
+    }
+}
+
+#ifndef NDEBUG
+
+/**
+ * @return Cycles to retire the [size] [instructions], each reading memory
+ * [reads] times from [addresses] lines, -1 if they are not retired in 1000
+ * cycles. The config may use [memory] as dataMemory.
+ */
+static long OutOfOrderCoreTestRun(const char* config,
+                                  const StaticInstructionInfo* instructions,
+                                  unsigned long size, unsigned short reads,
+                                  unsigned long addresses,
+                                  OutOfOrderCoreTesterMemory* memory) {
+    OutOfOrderCore core;
+    OutOfOrderCoreTesterFetching fetching;
+    fetching.Reset(instructions, size);
+    fetching.reads = reads;
+    fetching.addresses = addresses;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    aliases.Insert("fetching", &fetching);
+    if (memory != NULL) aliases.Insert("memory", memory);
+    if (core.Configure(CreateFakeConfig(&parser, config, &aliases))) return -1;
+
+    for (long cycle = 1; cycle <= 1000; ++cycle) {
+        fetching.Clock();
+        if (memory != NULL) memory->Clock();
+        core.Clock();
+        fetching.PosClock();
+        if (memory != NULL) memory->PosClock();
+        core.PosClock();
+        if (core.GetRetiredInstructions() == size) return cycle;
+    }
+    return -1;
+}
+
+int TestOutOfOrderCore() {
+    const unsigned long size = 60;
+    StaticInstructionInfo dependent[size];
+    StaticInstructionInfo independent[size];
+    for (unsigned long i = 0; i < size; ++i) {
+        dependent[i].instAddress = 0x1000 + 4 * i;
+        dependent[i].instSize = 4;
+        dependent[i].numberOfReadRegs = 1;
+        dependent[i].readRegsArray[0] = 7;
+        dependent[i].numberOfWriteRegs = 1;
+        dependent[i].writtenRegsArray[0] = 7;
+
+        independent[i] = dependent[i];
+        independent[i].numberOfReadRegs = 0;
+        independent[i].writtenRegsArray[0] = i % 8;
+    }
+
+    const char* unified =
+        "fetching: *fetching\n"
+        "fetchSize: 16\n"
+        "width: 4\n"
+        "aluPorts: 3\n";
+
+    // A chain of dependent instructions executes one per cycle, independent
+    // ones use the three alu ports.
+    long chain = OutOfOrderCoreTestRun(unified, dependent, size, 0, 0, NULL);
+    if (chain < (long)size) return 1;
+    long parallel =
+        OutOfOrderCoreTestRun(unified, independent, size, 0, 0, NULL);
+    if (parallel < 0 || parallel > (long)size / 3 + 10) return 2;
+
+    // Split queues and a latency of 3 make the chain three times slower.
+    long split = OutOfOrderCoreTestRun(
+        "fetching: *fetching\n"
+        "issueQueues: split\n"
+        "issueQueueSize: 4\n"
+        "aluLatency: 3\n",
+        dependent, size, 0, 0, NULL);
+    if (split < 3 * (long)size) return 3;
+
+    // Few registers and a small ROB only slow the independent instructions
+    // down.
+    long small = OutOfOrderCoreTestRun(
+        "fetching: *fetching\n"
+        "robSize: 2\n"
+        "physicalRegisters: 1\n",
+        independent, size, 0, 0, NULL);
+    if (small < (long)size || small > 2 * (long)size + 10) return 4;
+
+    // Loads wait loadLatency cycles without a dataMemory.
+    StaticInstructionInfo loads[size];
+    for (unsigned long i = 0; i < size; ++i) {
+        loads[i] = dependent[i];
+        loads[i].instReadsMemory = true;
+    }
+    long loaded = OutOfOrderCoreTestRun(
+        "fetching: *fetching\n"
+        "loadLatency: 5\n",
+        loads, size, 1, 0, NULL);
+    if (loaded < 5 * (long)size || loaded > 5 * (long)size + 10) return 5;
+
+    // Every load completes when dataMemory answers out of order, to reads of
+    // the same address from one or many loads.
+    for (unsigned long i = 0; i < size; ++i) {
+        loads[i] = independent[i];
+        loads[i].instReadsMemory = true;
+    }
+    const char* withMemory =
+        "fetching: *fetching\n"
+        "dataMemory: *memory\n";
+    const unsigned long addresses[] = {1, 5, 64};
+    for (unsigned long i = 0; i < 3; ++i) {
+        OutOfOrderCoreTesterMemory memory;
+        memory.period = 7;
+        long answered = OutOfOrderCoreTestRun(withMemory, loads, size, 2,
+                                              addresses[i], &memory);
+        if (answered < 0) return 6;
+        if (memory.numberOfAnswers != 2 * size) return 7;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef SINUCA3_OUT_OF_ORDER_CORE_HPP_
+#define SINUCA3_OUT_OF_ORDER_CORE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file out_of_order_core.hpp
+ * @brief API of the OutOfOrderCore, a superscalar out-of-order core with
+ * register renaming, issue queues and in-order retirement.
+ */
+
+#include <sinuca3.hpp>
+
+/** @brief Kinds of execution ports, each instruction uses one. */
+enum OutOfOrderCoreUnit {
+    OutOfOrderCoreUnitAlu,
+    OutOfOrderCoreUnitMemory,
+    OutOfOrderCoreUnitBranch,
+};
+
+const int OUT_OF_ORDER_CORE_UNITS = 3;
+/** @brief Most entries of an issue queue, the bits of its masks. */
+const int OUT_OF_ORDER_CORE_MAX_QUEUE = 64;
+/** @brief Rename table entry of a register whose value is retired. */
+const unsigned short OUT_OF_ORDER_CORE_RETIRED = 0xffff;
+
+struct OutOfOrderCoreRobEntry {
+    InstructionPacket instruction;
+    unsigned short destinations[MAX_REGISTERS]; /**< Physical registers. */
+    unsigned int pendingReads; /**< Bit i for readsAddr[i] not answered. */
+    bool completed;
+};
+
+struct OutOfOrderCoreQueueEntry {
+    unsigned long robIndex;
+    int pendingSources;
+    OutOfOrderCoreUnit unit;
+};
+
+struct OutOfOrderCoreIssueQueue {
+    OutOfOrderCoreQueueEntry entries[OUT_OF_ORDER_CORE_MAX_QUEUE];
+    unsigned char order[OUT_OF_ORDER_CORE_MAX_QUEUE]; /**< Used slots, oldest
+                                                        first. */
+    unsigned long usedMask;
+    unsigned long readyMask; /**< Entries with every source ready. */
+    long occupation;
+};
+
+/** @brief A read sent to dataMemory and not answered yet. */
+struct OutOfOrderCoreLoad {
+    unsigned long address;
+    unsigned long robIndex;
+    int read; /**< Index in readsAddr. */
+    int next; /**< Next load of the bucket or of the free list, -1 ends. */
+};
+
+/**
+ * @brief The OutOfOrderCore fetches instructions from `fetching`, renames
+ * their registers, waits for their sources in the issue queues and executes
+ * them out of order, retiring them in order from the reorder buffer (ROB).
+ *
+ * @details Registers are renamed with the ids of readRegsArray and
+ * writtenRegsArray. Each result gets a physical register that is freed at
+ * retirement, when the value goes to the architectural state, so
+ * physicalRegisters bounds the results in flight. A merged register file of N
+ * registers is modeled with N minus the architectural registers.
+ *
+ * An instruction is a memory one if it reads or writes memory, a branch one if
+ * it has a branch type and an alu one otherwise, and issues to a port of its
+ * kind. In a unified issue queue all kinds share issueQueueSize entries, split
+ * queues have issueQueueSize entries for each kind. The oldest entries with
+ * every source ready are selected each cycle, up to the ports of each kind.
+ * Each queue keeps its slots in age order, so the selection walks it once and
+ * stops when the ports or the ready entries run out. The wakeup is done with,
+ * for each physical register, a mask of the entries waiting for it.
+ *
+ * Loads are sent to dataMemory at issue and complete when every read is
+ * answered, or after loadLatency cycles without dataMemory. They do not wait
+ * for older stores. Reads waiting for an answer are kept in a table hashed by
+ * address, the oldest read of an address takes its answer. Stores are sent to
+ * dataMemory at retirement. Branches were predicted by the front end, which
+ * pays for the mispredictions.
+ *
+ * It accepts the following parameters:
+ * - fetching (required): Component<FetchPacket> from which to fetch
+ *   instructions, the engine or a FetchUnit.
+ * - dataMemory: Component<MemoryPacket>.
+ * - fetchSize: Bytes asked from `fetching` per cycle. Defaults to 32.
+ * - width: Instructions renamed and retired per cycle. Defaults to 4.
+ * - robSize: Defaults to 128.
+ * - physicalRegisters: Defaults to 128.
+ * - issueQueues: string, unified (default) or split.
+ * - issueQueueSize: Up to 64. Defaults to 32.
+ * - aluPorts, memoryPorts, branchPorts: Default to 3, 2 and 1.
+ * - aluLatency, branchLatency, loadLatency: Cycles, default to 1, 1 and 4.
+ */
+class OutOfOrderCore : public Component<int> {
+  private:
+    Component<FetchPacket>* fetching;
+    Component<MemoryPacket>* dataMemory;
+    int fetchingID;
+    int dataMemoryID;
+
+    InstructionPacket* fetchBuffer; /**< Circular, room for two requests of
+                                       fetchSize bytes. */
+    unsigned long fetchBufferSize;
+    unsigned long fetchBufferStart;
+    unsigned long fetchBufferUsage;
+    unsigned long fetchSize;
+    unsigned long previousRequest; /**< Bytes asked last cycle, arriving in
+                                      the next one. */
+    unsigned long width;
+
+    OutOfOrderCoreRobEntry* rob; /**< Circular, oldest first. */
+    unsigned long robSize;
+    unsigned long robStart;
+    unsigned long robOccupation;
+
+    unsigned short* renameTable; /**< Physical register of each register id,
+                                    or OUT_OF_ORDER_CORE_RETIRED. */
+    unsigned short* freeRegisters; /**< Circular. */
+    unsigned long physicalRegisters;
+    unsigned long freeRegistersStart;
+    unsigned long numberOfFreeRegisters;
+    unsigned long* readyRegisters; /**< Bit per physical register. */
+
+    OutOfOrderCoreIssueQueue* queues;
+    int numberOfQueues; /**< 1 if unified, a queue per unit if split. */
+    long issueQueueSize;
+    unsigned long* waiters; /**< Per physical register and queue, the
+                               entries waiting for it. */
+    long ports[OUT_OF_ORDER_CORE_UNITS];
+    unsigned long latencies[OUT_OF_ORDER_CORE_UNITS];
+    unsigned long loadLatency;
+
+    OutOfOrderCoreLoad* loadTable; /**< robSize x MAX_MEM_OPERATIONS. */
+    int* loadBuckets;              /**< First load of each bucket. */
+    int loadBucketBits;
+    int freeLoads; /**< First free entry of loadTable. */
+
+    /**
+     * @brief ROB indices completing at each cycle, slot (cycle % wheelSlots)
+     * completes at that cycle. Each slot has room for the issues of a cycle
+     * with each latency.
+     */
+    unsigned long* completionWheel;
+    int* completionWheelOccupation;
+    unsigned long wheelSlots;
+    int wheelSlotSize;
+
+    unsigned long cycle;
+    unsigned long retiredInstructions;
+    unsigned long robFullCycles;
+    unsigned long queueFullCycles;
+    unsigned long registersFullCycles;
+    unsigned long loads;
+    unsigned long stores;
+
+    inline bool IsReady(unsigned short reg) const {
+        return (this->readyRegisters[reg / 64] >> (reg % 64)) & 1;
+    }
+
+    /** @brief The issue queue instructions of [unit] go to. */
+    inline OutOfOrderCoreIssueQueue* Queue(OutOfOrderCoreUnit unit) {
+        return &this->queues[this->numberOfQueues == 1 ? 0 : unit];
+    }
+
+    /** @brief Marks [robIndex] done and wakes up its dependents. */
+    void Complete(unsigned long robIndex);
+    inline int* LoadBucket(unsigned long address) {
+        return &this->loadBuckets[(address * 0x9e3779b97f4a7c15UL) >>
+                                  (64 - this->loadBucketBits)];
+    }
+
+    /** @brief Executes entry [slot] of [queue], removing it from the queue. */
+    void Issue(OutOfOrderCoreIssueQueue* queue, int slot);
+    /** @brief Completes [robIndex] in [latency] cycles. */
+    void Schedule(unsigned long robIndex, unsigned long latency);
+    /** @brief Renames [instruction] and puts it in the ROB and a queue.
+     * @return 1 if there is no room for it. */
+    int Dispatch(const InstructionPacket* instruction);
+
+    /** @brief Helper to receive the answers of the loads. */
+    void ClockReceiveLoads();
+    /** @brief Helper to complete what finished this cycle. */
+    void ClockComplete();
+    /** @brief Helper to retire from the head of the ROB. */
+    void ClockRetire();
+    /** @brief Helper to select and issue ready instructions. */
+    void ClockIssue();
+    /** @brief Helper to rename the fetched instructions. */
+    void ClockRename();
+    /** @brief Helper to get the fetched instructions. */
+    void ClockFetch();
+    /** @brief Helper to ask `fetching` for instructions. */
+    void ClockRequestFetch();
+
+  public:
+    inline OutOfOrderCore()
+        : fetching(NULL),
+          dataMemory(NULL),
+          fetchBuffer(NULL),
+          fetchBufferSize(0),
+          fetchBufferStart(0),
+          fetchBufferUsage(0),
+          fetchSize(32),
+          previousRequest(0),
+          width(4),
+          rob(NULL),
+          robSize(128),
+          robStart(0),
+          robOccupation(0),
+          renameTable(NULL),
+          freeRegisters(NULL),
+          physicalRegisters(128),
+          freeRegistersStart(0),
+          numberOfFreeRegisters(0),
+          readyRegisters(NULL),
+          queues(NULL),
+          numberOfQueues(1),
+          issueQueueSize(32),
+          waiters(NULL),
+          loadLatency(4),
+          loadTable(NULL),
+          loadBuckets(NULL),
+          loadBucketBits(0),
+          freeLoads(-1),
+          completionWheel(NULL),
+          completionWheelOccupation(NULL),
+          wheelSlots(0),
+          wheelSlotSize(0),
+          cycle(0),
+          retiredInstructions(0),
+          robFullCycles(0),
+          queueFullCycles(0),
+          registersFullCycles(0),
+          loads(0),
+          stores(0) {}
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+
+    virtual ~OutOfOrderCore();
+
+#ifndef NDEBUG
+    inline unsigned long GetRetiredInstructions() const {
+        return this->retiredInstructions;
+    }
+#endif
+};
+
+#ifndef NDEBUG
+/**
+ * @brief Answers fetches as the engine does, with a fixed run of
+ * instructions.
+ */
+class OutOfOrderCoreTesterFetching : public Component<FetchPacket> {
+  public:
+    const StaticInstructionInfo* instructions;
+    unsigned long size;
+    unsigned long next;
+    unsigned short reads; /**< Of each instruction. */
+    /**
+     * @brief Read r of instruction n reads line (n * reads + r) % addresses,
+     * every read is at address 0 if 0.
+     */
+    unsigned long addresses;
+
+    inline OutOfOrderCoreTesterFetching()
+        : instructions(NULL), size(0), next(0), reads(0), addresses(0) {}
+    inline void Reset(const StaticInstructionInfo* instructions,
+                      unsigned long size) {
+        this->instructions = instructions;
+        this->size = size;
+        this->next = 0;
+        this->reads = 0;
+        this->addresses = 0;
+    }
+    virtual int Configure(Config config) {
+        (void)config;
+        return 0;
+    }
+    virtual void Clock() {
+        FetchPacket packet;
+        long numberOfConnections = this->GetNumberOfConnections();
+        for (long c = 0; c < numberOfConnections; ++c) {
+            if (this->ReceiveRequestFromConnection(c, &packet) != 0) continue;
+            // The answers share the packet.
+            long request = packet.request;
+            long bytes = 0;
+            while (this->next < this->size) {
+                const StaticInstructionInfo* info =
+                    &this->instructions[this->next];
+                bytes += info->instSize;
+                if (bytes > request) break;
+                packet.response.staticInfo = info;
+                packet.response.dynamicInfo.numReadings = this->reads;
+                packet.response.dynamicInfo.numWritings = 0;
+                memset(packet.response.dynamicInfo.readsAddr, 0,
+                       sizeof(packet.response.dynamicInfo.readsAddr));
+                for (unsigned short r = 0; r < this->reads; ++r) {
+                    if (this->addresses == 0) break;
+                    packet.response.dynamicInfo.readsAddr[r] =
+                        ((this->next * this->reads + r) % this->addresses)
+                        << 6;
+                }
+                packet.response.nextInstruction =
+                    info->instAddress + info->instSize;
+                this->SendResponseToConnection(c, &packet);
+                ++this->next;
+            }
+        }
+    }
+    virtual void PrintStatistics() {}
+    virtual ~OutOfOrderCoreTesterFetching() {}
+};
+
+/**
+ * @brief Holds the reads it gets and answers all of them every period
+ * cycles, the youngest first.
+ */
+class OutOfOrderCoreTesterMemory : public Component<MemoryPacket> {
+  public:
+    MemoryPacket held[1024];
+    unsigned long numberOfHeld;
+    unsigned long period;
+    unsigned long cycle;
+    unsigned long numberOfAnswers;
+
+    inline OutOfOrderCoreTesterMemory()
+        : numberOfHeld(0), period(1), cycle(0), numberOfAnswers(0) {}
+    virtual int Configure(Config config) {
+        (void)config;
+        return 0;
+    }
+    virtual void Clock() {
+        MemoryPacket packet;
+        while (this->ReceiveRequestFromConnection(0, &packet) == 0) {
+            if (packet.type != MemoryPacketTypeRead) continue;
+            assert(this->numberOfHeld < sizeof(this->held) /
+                                            sizeof(*this->held));
+            this->held[this->numberOfHeld++] = packet;
+        }
+        if (++this->cycle % this->period != 0) return;
+        while (this->numberOfHeld > 0) {
+            --this->numberOfHeld;
+            this->SendResponseToConnection(0,
+                                           &this->held[this->numberOfHeld]);
+            ++this->numberOfAnswers;
+        }
+    }
+    virtual void PrintStatistics() {}
+    virtual ~OutOfOrderCoreTesterMemory() {}
+};
+
+int TestOutOfOrderCore();
+#endif
+
+#endif  // SINUCA3_OUT_OF_ORDER_CORE_HPP_
@@ -32,12 +32,15 @@ int SimpleCore::Configure(Config config) {
                                   &this->instructionMemory))
         return 1;
     if (config.ComponentReference("dataMemory", &this->dataMemory)) return 1;
+    if (config.ComponentReference("dataTLB", &this->dataTLB)) return 1;
     if (config.ComponentReference("fetching", &this->fetching, true)) return 1;
 
     if (this->instructionMemory != NULL)
         this->instructionConnectionID = this->instructionMemory->Connect(0);
     if (this->dataMemory != NULL)
         this->dataConnectionID = this->dataMemory->Connect(0);
+    if (this->dataTLB != NULL)
+        this->dataTLBConnectionID = this->dataTLB->Connect(0);
     this->fetchingConnectionID = this->fetching->Connect(0);
 
     return 0;
@@ -51,27 +54,48 @@ void SimpleCore::Clock() {
         0) {
         ++this->numFetchedInstructions;
         if (this->instructionMemory != NULL) {
-            MemoryPacket fetchPacket = fetch.response.staticInfo->instAddress;
+            MemoryPacket fetchPacket;
+            fetchPacket.address = fetch.response.staticInfo->instAddress;
+            fetchPacket.instAddress = fetchPacket.address;
+            fetchPacket.type = MemoryPacketTypeRead;
             this->instructionMemory->SendRequest(this->instructionConnectionID,
                                                  &fetchPacket);
             if (this->dataMemory != NULL) {
+                MemoryPacket dataPacket;
+                dataPacket.instAddress =
+                    fetch.response.staticInfo->instAddress;
+                dataPacket.type = MemoryPacketTypeRead;
                 for (long i = 0; i < fetch.response.dynamicInfo.numReadings;
                      ++i) {
-                    this->dataMemory->SendRequest(
-                        this->dataConnectionID,
-                        (unsigned long*)&(
-                            fetch.response.dynamicInfo.readsAddr[i]));
+                    dataPacket.address =
+                        fetch.response.dynamicInfo.readsAddr[i];
+                    this->dataMemory->SendRequest(this->dataConnectionID,
+                                                  &dataPacket);
                 }
 
+                dataPacket.type = MemoryPacketTypeWrite;
                 for (long i = 0; i < fetch.response.dynamicInfo.numWritings;
                      ++i) {
-                    this->dataMemory->SendRequest(
-                        this->dataConnectionID,
-                        (unsigned long*)&(
-                            fetch.response.dynamicInfo.writesAddr[i]));
+                    dataPacket.address =
+                        fetch.response.dynamicInfo.writesAddr[i];
+                    this->dataMemory->SendRequest(this->dataConnectionID,
+                                                  &dataPacket);
                 }
             }
         }
+        if (this->dataTLB != NULL) {
+            TranslationPacket translation;
+            for (long i = 0; i < fetch.response.dynamicInfo.numReadings; ++i) {
+                translation.address = fetch.response.dynamicInfo.readsAddr[i];
+                this->dataTLB->SendRequest(this->dataTLBConnectionID,
+                                           &translation);
+            }
+            for (long i = 0; i < fetch.response.dynamicInfo.numWritings; ++i) {
+                translation.address = fetch.response.dynamicInfo.writesAddr[i];
+                this->dataTLB->SendRequest(this->dataTLBConnectionID,
+                                           &translation);
+            }
+        }
     }
 }
 
@@ -31,13 +31,15 @@
  * `fetching`, a Component<InstructionPacket> and optionally queries two
  * memories (without caring with the result at all) with the instruction. The
  * two memories are passed as the Component<MemoryPacket> parameters
- * `instructionMemory` and `dataMemory`.
+ * `instructionMemory` and `dataMemory`. Data addresses are also translated by
+ * the optional Component<TranslationPacket> `dataTLB`, again without waiting.
  */
 class SimpleCore : public Component<InstructionPacket> {
   private:
     Component<MemoryPacket>*
         instructionMemory;               /** @brief The instruction memory. */
     Component<MemoryPacket>* dataMemory; /** @brief The data memory. */
+    Component<TranslationPacket>* dataTLB; /** @brief The data TLB. */
     Component<FetchPacket>* fetching;    /** @brief The fetching. */
 
     unsigned long numFetchedInstructions; /** @brief The number of fetched
@@ -45,12 +47,14 @@ class SimpleCore : public Component<InstructionPacket> {
     int instructionConnectionID;          /** @brief The connection ID of
                                              instructionMemory. */
     int dataConnectionID;     /** @brief The connection ID of dataMemory. */
+    int dataTLBConnectionID;  /** @brief The connection ID of dataTLB. */
     int fetchingConnectionID; /** @brief The connection ID of fetching. */
 
   public:
     inline SimpleCore()
         : instructionMemory(NULL),
           dataMemory(NULL),
+          dataTLB(NULL),
           fetching(NULL),
           numFetchedInstructions(0) {}
     virtual int Configure(Config config);
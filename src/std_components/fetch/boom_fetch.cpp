@@ -25,6 +25,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <sinuca3.hpp>
 #include <std_components/predictors/interleavedBTB.hpp>
 
@@ -93,62 +94,58 @@ void binprintf(int v) {
     printf("\n");
 }
 
-bool BoomFetch::SentToRas(unsigned long i) {
-    PredictorPacket rasPacket;
-    if (this->fetchBuffer[i].instruction.staticInfo->branchType == BranchCall) {
-        /* Fills the packet with the instruction and target info. */
-        /*
-         * We found a call instruction and want to insert its target into
-         * the ras.
-         */
-        rasPacket.type = PredictorPacketTypeRequestTargetUpdate;
-        rasPacket.data.targetUpdate.instruction =
-            this->fetchBuffer[i].instruction;
-        rasPacket.data.targetUpdate.target =
-            this->fetchBuffer[i].instruction.nextInstruction;
-        this->ras->SendRequest(this->rasID, &rasPacket);
-
-        return true;
-    } else if (this->fetchBuffer[i].instruction.staticInfo->branchType ==
-               BranchRet) {
-        /*
-         * We found a return statement, so we unstacked the most recent
-         * target from the ras.
-         */
-        rasPacket.type = PredictorPacketTypeRequestQuery;
-        rasPacket.data.requestQuery = this->fetchBuffer[i].instruction;
-        this->ras->SendRequest(this->rasID, &rasPacket);
-
-        return true;
-    }
-
-    return false;
-}
-
-bool BoomFetch::SentToBTB(unsigned long i) {
-    BTBPacket btbPacket;
+void BoomFetch::SendBlock(PredictorPacket* block, unsigned long end,
+                          bool toRas, bool toBTB) {
+    unsigned long first = end - block->data.blockQuery.numberOfInstructions;
+    block->data.blockQuery.startAddress =
+        block->data.blockQuery.instructions[0]->instAddress;
+    block->data.blockQuery.nextAddress =
+        this->fetchBuffer[end - 1].instruction.nextInstruction;
 
-    if (this->fetchBuffer[i].instruction.staticInfo->branchType != BranchNone) {
-        btbPacket.type = BTBPacketTypeRequestQuery;
-        btbPacket.data.requestQuery =
-            this->fetchBuffer[i].instruction.staticInfo;
+    this->predictor->SendRequest(this->predictorID, block);
+    /*
+     * Blocks without calls and returns would only get unknown predictions
+     * from the ras, so they are not sent.
+     */
+    if (toRas) {
+        this->ras->SendRequest(this->rasID, block);
+        for (unsigned long i = first; i < end; ++i) {
+            this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsSentToRas;
+        }
+    }
+    /* Likewise, blocks without branches would only miss in the btb. */
+    if (toBTB) {
+        BTBPacket btbPacket;
+        btbPacket.type = BTBPacketTypeRequestBlockQuery;
+        memcpy(btbPacket.data.requestBlockQuery.instructions,
+               block->data.blockQuery.instructions,
+               sizeof(*block->data.blockQuery.instructions) *
+                   block->data.blockQuery.numberOfInstructions);
+        btbPacket.data.requestBlockQuery.startAddress =
+            block->data.blockQuery.startAddress;
+        btbPacket.data.requestBlockQuery.numberOfInstructions =
+            block->data.blockQuery.numberOfInstructions;
         this->btb->SendRequest(this->btbID, &btbPacket);
-        this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsSentToBTB;
-
-        return true;
+        for (unsigned long i = first; i < end; ++i) {
+            this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsSentToBTB;
+        }
     }
-
-    return false;
+    block->data.blockQuery.numberOfInstructions = 0;
 }
 
 void BoomFetch::ClockSendBuffered() {
     unsigned long i;
     bool instMemAvailable;
-    bool predictorAvailable;
-    bool btbAvailable;
-    bool rasAvailable;
+    bool toRas = false;
+    bool toBTB = false;
 
-    PredictorPacket predictorPacket;
+    /*
+     * The instructions are sent to the predictor, the ras and the btb in
+     * blocks of up to MAX_FETCH_BLOCK_INSTRUCTIONS, a single message for each.
+     */
+    PredictorPacket block;
+    block.type = PredictorPacketTypeRequestBlockQuery;
+    block.data.blockQuery.numberOfInstructions = 0;
 
     /* Skip instructions we already sent. */
     i = 0;
@@ -159,40 +156,70 @@ void BoomFetch::ClockSendBuffered() {
         instMemAvailable = this->instructionMemory->IsComponentAvailable(
             this->instructionMemoryID);
 
-        predictorAvailable =
-            this->predictor->IsComponentAvailable(this->predictorID);
+        if (!(instMemAvailable)) break;
 
-        rasAvailable = this->ras->IsComponentAvailable(this->rasID);
-
-        btbAvailable = this->btb->IsComponentAvailable(this->btbID);
-
-        if (!(instMemAvailable) || !(predictorAvailable) || !(rasAvailable) ||
-            !(btbAvailable)) {
+        /* A new block needs room in the predictor, ras and btb channels. */
+        if (block.data.blockQuery.numberOfInstructions == 0 &&
+            (!this->predictor->IsComponentAvailable(this->predictorID) ||
+             !this->ras->IsComponentAvailable(this->rasID) ||
+             !this->btb->IsComponentAvailable(this->btbID))) {
             break;
         }
 
-        SINUCA3_DEBUG_PRINTF("BoomFetch sending [%lx] %s\n", this->fetchBuffer[i].instruction.staticInfo->instAddress, this->fetchBuffer[i].instruction.staticInfo->instMnemonic);
+        const StaticInstructionInfo* info =
+            this->fetchBuffer[i].instruction.staticInfo;
+        SINUCA3_DEBUG_PRINTF("BoomFetch sending [%lx] %s\n",
+                             info->instAddress, info->instMnemonic);
 
         this->instructionMemory->SendRequest(this->instructionMemoryID,
                                              &this->fetchBuffer[i].instruction);
 
-        predictorPacket.type = PredictorPacketTypeRequestQuery;
-        predictorPacket.data.requestQuery = this->fetchBuffer[i].instruction;
-        this->predictor->SendRequest(this->predictorID, &predictorPacket);
+        block.data.blockQuery
+            .instructions[block.data.blockQuery.numberOfInstructions++] = info;
+        if (info->branchType == BranchCall || info->branchType == BranchRet) {
+            toRas = true;
+        }
+        if (info->branchType != BranchNone) toBTB = true;
 
         this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsSentToMemory;
         this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsSentToPredictor;
 
-        if (this->SentToRas(i)) {
-            this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsSentToRas;
-        }
+        i++;
 
-        if (this->SentToBTB(i)) {
-            this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsSentToBTB;
+        if (block.data.blockQuery.numberOfInstructions ==
+            (unsigned int)MAX_FETCH_BLOCK_INSTRUCTIONS) {
+            this->SendBlock(&block, i, toRas, toBTB);
+            toRas = false;
+            toBTB = false;
         }
+    }
 
-        i++;
+    if (block.data.blockQuery.numberOfInstructions > 0) {
+        this->SendBlock(&block, i, toRas, toBTB);
+    }
+}
+
+void BoomFetch::SendUpdate(const InstructionPacket* instruction) {
+    /*
+     * The trace only has the correct path, so the branch is resolved as soon
+     * as its prediction is checked.
+     */
+    PredictorPacket update;
+    if (instruction->staticInfo->branchType == BranchCond) {
+        update.type = PredictorPacketTypeRequestDirectionUpdate;
+        update.data.directionUpdate.instruction = *instruction;
+        update.data.directionUpdate.taken =
+            instruction->nextInstruction !=
+            instruction->staticInfo->instAddress +
+                instruction->staticInfo->instSize;
+    } else if (instruction->staticInfo->isIndirectControlFlowInst) {
+        update.type = PredictorPacketTypeRequestTargetUpdate;
+        update.data.targetUpdate.instruction = *instruction;
+        update.data.targetUpdate.target = instruction->nextInstruction;
+    } else {
+        return;
     }
+    this->predictor->SendRequest(this->predictorID, &update);
 }
 
 int BoomFetch::ClockCheckPredictor() {
@@ -205,45 +232,56 @@ int BoomFetch::ClockCheckPredictor() {
     while (this->fetchBuffer[i].flags & BoomFetchBufferEntryFlagsPredictorCheck)
         ++i;
 
-    bool cont = this->predictor->ReceiveResponse(this->predictorID, &response) == 0; 
+    bool cont =
+        this->predictor->ReceiveResponse(this->predictorID, &response) == 0;
     if (!cont) return 1;
 
 
     /*
      * We depend on the predictor sending the responses in order and, of course,
-     * sending only what we actually asked for.
+     * sending only what we actually asked for: one block response per block,
+     * covering the next instructions of the buffer.
      */
 
     while (cont) {
-        /*
-         * We had a bug here that’s probably the reason Djikstra hated early returns.
-         */
-        assert(this->fetchBuffer[i].instruction.staticInfo ==
-               response.data.targetResponse.instruction.staticInfo);
-
-        SINUCA3_DEBUG_PRINTF("Predictor Check [%lx] %s\n", this->fetchBuffer[i].instruction.staticInfo->instAddress, this->fetchBuffer[i].instruction.staticInfo->instMnemonic);
-
-        unsigned long target =
-            this->fetchBuffer[i].instruction.staticInfo->instAddress +
-            this->fetchBuffer[i].instruction.staticInfo->instSize;
-
-        this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsPredictorCheck;
+        assert(response.type == PredictorPacketTypeResponseBlock);
+        assert(this->fetchBuffer[i].instruction.staticInfo->instAddress ==
+               response.data.blockResponse.startAddress);
+
+        for (unsigned int slot = 0;
+             slot < response.data.blockResponse.numberOfInstructions; ++slot) {
+            const InstructionPacket* instruction =
+                &this->fetchBuffer[i].instruction;
+
+            SINUCA3_DEBUG_PRINTF("Predictor Check [%lx] %s\n",
+                                 instruction->staticInfo->instAddress,
+                                 instruction->staticInfo->instMnemonic);
+
+            unsigned long target = instruction->staticInfo->instAddress +
+                                   instruction->staticInfo->instSize;
+
+            this->fetchBuffer[i].flags |=
+                BoomFetchBufferEntryFlagsPredictorCheck;
+
+            /*
+             * "Redirect" the fetch only if the predictor has an address,
+             * otherwise expect the instruction to be at the next logical PC.
+             */
+            if (response.data.blockResponse.targetMask & (1U << slot)) {
+                target = response.data.blockResponse.targets[slot];
+            }
 
-        /*
-         * "Redirect" the fetch only if the predictor has an address, otherwise
-         * expect the instruction to be at the next logical PC.
-         */
-        if (response.type == PredictorPacketTypeResponseTakeToAddress) {
-            target = response.data.targetResponse.target;
-        }
+            /* If a missprediction happened. */
+            if (target != instruction->nextInstruction) {
+                ret = 1;
+            }
+            this->SendUpdate(instruction);
 
-        /* If a missprediction happened. */
-        if (target != this->fetchBuffer[i].instruction.nextInstruction) {
-            ret = 1;
+            ++i;
         }
 
-        ++i;
-        cont = this->predictor->ReceiveResponse(this->predictorID, &response) == 0;
+        cont =
+            this->predictor->ReceiveResponse(this->predictorID, &response) == 0;
     }
 
     return ret;
@@ -263,12 +301,45 @@ int BoomFetch::ClockCheckRas() {
     if (!cont) return 1;
 
     while (cont) {
-        target = response.data.targetResponse.target;
+        /* The first block sent to the ras and not checked yet. */
+        unsigned long i = 0;
+        while ((this->fetchBuffer[i].flags &
+                (BoomFetchBufferEntryFlagsSentToRas |
+                 BoomFetchBufferEntryFlagsRasCheck)) !=
+               BoomFetchBufferEntryFlagsSentToRas) {
+            ++i;
+        }
+        assert(this->fetchBuffer[i].instruction.staticInfo->instAddress ==
+               response.data.blockResponse.startAddress);
+
+        for (unsigned int slot = 0;
+             slot < response.data.blockResponse.numberOfInstructions;
+             ++slot, ++i) {
+            const InstructionPacket* instruction =
+                &this->fetchBuffer[i].instruction;
+            Branch type = instruction->staticInfo->branchType;
+            this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsRasCheck;
+            if (type != BranchCall && type != BranchRet) continue;
+
+            if (type == BranchRet) {
+                target = instruction->staticInfo->instAddress +
+                         instruction->staticInfo->instSize;
+                if (response.data.blockResponse.targetMask & (1U << slot)) {
+                    target = response.data.blockResponse.targets[slot];
+                }
+                /* The return address does not match the next address */
+                if (instruction->nextInstruction != target) {
+                    ret = 1;
+                }
+            }
 
-        /* The return address does not match the next address */
-        if (response.data.targetResponse.instruction.nextInstruction !=
-            target) {
-            ret = 1;
+            PredictorPacket update;
+            update.type = PredictorPacketTypeRequestTargetUpdate;
+            update.data.targetUpdate.instruction = *instruction;
+            update.data.targetUpdate.target = instruction->nextInstruction;
+            if (this->ras->IsComponentAvailable(this->rasID)) {
+                this->ras->SendRequest(this->rasID, &update);
+            }
         }
 
         cont = this->ras->ReceiveResponse(this->rasID, &response) == 0;
@@ -284,65 +355,68 @@ int BoomFetch::ClockCheckBTB() {
     BTBPacket updateRequest;
 
     int ret = 0;
-    bool btbAvailable, taken;
-    unsigned int i, next;
 
     this->btb->Clock();
     this->btb->PosClock();
 
-    next = 0;
     bool cont = this->btb->ReceiveResponse(this->btbID, &response) == 0;
-    
+
     if (!cont) return 1;
     while (cont) {
-        i = 0;
-        while (
-            ((this->fetchBuffer[i].flags &
-              BoomFetchBufferEntryFlagsSentToBTB) !=
-             BoomFetchBufferEntryFlagsSentToBTB) ||
-            (this->fetchBuffer[i].flags & BoomFetchBufferEntryFlagsBTBCheck) ==
-                BoomFetchBufferEntryFlagsBTBCheck) {
+        assert(response.type == BTBPacketTypeResponseBlock);
+        /* The first block sent to the btb and not checked yet. */
+        unsigned long i = 0;
+        while ((this->fetchBuffer[i].flags &
+                (BoomFetchBufferEntryFlagsSentToBTB |
+                 BoomFetchBufferEntryFlagsBTBCheck)) !=
+               BoomFetchBufferEntryFlagsSentToBTB) {
             ++i;
+            assert(i < this->fetchBufferUsage);
         }
-
-        this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsBTBCheck;
-
-        assert(this->fetchBuffer[i].instruction.staticInfo ==
-               response.data.response.instruction);
-
-        btbAvailable = this->btb->IsComponentAvailable(this->btbID);
-
-        next = this->fetchBuffer[i].instruction.nextInstruction;
-
-        if (response.type == BTBPacketTypeResponseBTBHit) {
-            updateRequest.type = BTBPacketTypeRequestUpdate;
-            updateRequest.data.requestUpdate.instruction =
-                this->fetchBuffer[i].instruction.staticInfo;
-
-            taken = (next !=
-                     this->fetchBuffer[i].instruction.staticInfo->instAddress +
-                         this->fetchBuffer[i].instruction.staticInfo->instSize);
-
-            updateRequest.data.requestUpdate.branchState = taken;
-
-            if (btbAvailable)
-                this->btb->SendRequest(this->btbID, &updateRequest);
-
-            if (next != response.data.response.target) {
-                ret = 1;
+        assert(this->fetchBuffer[i].instruction.staticInfo->instAddress ==
+               response.data.blockResponse.startAddress);
+
+        for (unsigned int slot = 0;
+             slot < response.data.blockResponse.numberOfInstructions;
+             ++slot, ++i) {
+            const InstructionPacket* instruction =
+                &this->fetchBuffer[i].instruction;
+            this->fetchBuffer[i].flags |= BoomFetchBufferEntryFlagsBTBCheck;
+            if (instruction->staticInfo->branchType == BranchNone) continue;
+
+            unsigned int bit = 1U << slot;
+            unsigned long next = instruction->nextInstruction;
+            unsigned long fallthrough = instruction->staticInfo->instAddress +
+                                        instruction->staticInfo->instSize;
+            bool hit = response.data.blockResponse.hitMask & bit;
+            bool taken = next != fallthrough;
+
+            unsigned long target = fallthrough;
+            if (response.data.blockResponse.takenMask & bit) {
+                target = response.data.blockResponse.targets[slot];
+            }
+            if (next != target) ret = 1;
+
+            /*
+             * Taken branches the btb misses or sends elsewhere get their
+             * target, the other hits train their direction.
+             */
+            if (taken && (!hit || response.data.blockResponse.targets[slot] !=
+                                      next)) {
+                updateRequest.type = BTBPacketTypeRequestAddEntry;
+                updateRequest.data.requestAddEntry.instruction =
+                    instruction->staticInfo;
+                updateRequest.data.requestAddEntry.target = next;
+            } else if (hit) {
+                updateRequest.type = BTBPacketTypeRequestUpdate;
+                updateRequest.data.requestUpdate.instruction =
+                    instruction->staticInfo;
+                updateRequest.data.requestUpdate.branchState = taken;
+            } else {
+                continue;
             }
-        } else {
-            updateRequest.type = BTBPacketTypeRequestAddEntry;
-            updateRequest.data.requestAddEntry.instruction =
-                this->fetchBuffer[i].instruction.staticInfo;
-            updateRequest.data.requestAddEntry.target =
-                this->fetchBuffer[i].instruction.nextInstruction;
-
-            if (btbAvailable)
+            if (this->btb->IsComponentAvailable(this->btbID)) {
                 this->btb->SendRequest(this->btbID, &updateRequest);
-
-            if (next != response.data.response.target) {
-                ret = 1;
             }
         }
 
@@ -364,6 +438,11 @@ void BoomFetch::ClockUnbuffer() {
             ((this->fetchBuffer[i].flags & BoomFetchBufferEntryFlagsBTBCheck) !=
              BoomFetchBufferEntryFlagsBTBCheck))
             break;
+        if ((this->fetchBuffer[i].flags &
+             (BoomFetchBufferEntryFlagsSentToRas |
+              BoomFetchBufferEntryFlagsRasCheck)) ==
+            BoomFetchBufferEntryFlagsSentToRas)
+            break;
         ++i;
     }
 
@@ -51,6 +51,9 @@ const BoomFetchBufferEntryFlags BoomFetchBufferEntryFlagsBTBCheck = (1 << 4);
 const BoomFetchBufferEntryFlags BoomFetchBufferEntryFlagsSentToMemory =
     (1 << 5);
 
+/** @brief This instruction was checked for ras. */
+const BoomFetchBufferEntryFlags BoomFetchBufferEntryFlagsRasCheck = (1 << 6);
+
 struct BoomFetchBufferEntry {
     InstructionPacket instruction;   /**< Fetched instruction >*/
     BoomFetchBufferEntryFlags flags; /**< Flags for the entry >*/
@@ -114,16 +117,22 @@ class BoomFetch : public Component<FetchPacket> {
    instruction was predicted. If there's no predictor, we
    don't need to check anything >*/
 
-    /** @brief Helper for sending instructions to the RAS. */
-    bool SentToRas(unsigned long i);
-    /** @brief Helper for sending instructions to the RAS. */
-    bool SentToBTB(unsigned long i);
+    /**
+     * @brief Helper for sending a block query to the predictor and, if it has
+     * calls or returns, to the RAS, and if it has branches, to the BTB.
+     * @param end Index of the buffer entry after the last one of the block.
+     */
+    void SendBlock(PredictorPacket* block, unsigned long end, bool toRas,
+                   bool toBTB);
 
     /** @brief Helper to send the fetched instructions to the memory, predictor
      * and btb. */
     void ClockSendBuffered();
     /** @brief Helper to check predicted instructions. */
     int ClockCheckPredictor();
+    /** @brief Tells the predictor the direction of a conditional branch or
+     * the target of an indirect one. */
+    void SendUpdate(const InstructionPacket* instruction);
     /** @brief Helper to check ras responses. */
     int ClockCheckRas();
     /** @brief Helper to check predicted instructions via BTB */
@@ -0,0 +1,640 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file branch_prediction_unit.cpp
+ * @brief Implementation of the BranchPredictionUnit.
+ */
+
+#include "branch_prediction_unit.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <sinuca3.hpp>
+
+int BranchPredictionUnit::Configure(Config config) {
+    if (config.ComponentReference("fetch", &this->fetch, true)) return 1;
+    if (config.ComponentReference("predictor", &this->predictor)) return 1;
+    if (config.ComponentReference("ras", &this->ras)) return 1;
+    if (config.ComponentReference("btb", &this->btb)) return 1;
+
+    long fetchSize = this->fetchSize;
+    if (config.Integer("fetchSize", &fetchSize)) return 1;
+    if (fetchSize <= 0) return config.Error("fetchSize", "is not > 0.");
+    this->fetchSize = fetchSize;
+
+    long blockSize = this->blockSize;
+    if (config.Integer("blockSize", &blockSize)) return 1;
+    if (blockSize <= 0 || blockSize > MAX_FETCH_BLOCK_INSTRUCTIONS) {
+        return config.Error("blockSize",
+                            "is not between 1 and "
+                            "MAX_FETCH_BLOCK_INSTRUCTIONS.");
+    }
+    this->blockSize = blockSize;
+
+    long queueSize = this->queueSize;
+    if (config.Integer("queueSize", &queueSize)) return 1;
+    if (queueSize <= 0) return config.Error("queueSize", "is not > 0.");
+    this->queueSize = queueSize;
+
+    long misspredictPenalty = 0;
+    if (config.Integer("misspredictPenalty", &misspredictPenalty)) return 1;
+    if (misspredictPenalty <= 0)
+        return config.Error("misspredictPenalty", "is not > 0.");
+    this->misspredictPenalty = misspredictPenalty;
+
+    // The queries are bounded by queueSize but every branch is updated on its
+    // own, so the predictors are connected without limits.
+    this->fetchID = this->fetch->Connect(0);
+    if (this->predictor != NULL) {
+        this->predictorID = this->predictor->Connect(0);
+    }
+    if (this->ras != NULL) this->rasID = this->ras->Connect(0);
+    if (this->btb != NULL) this->btbID = this->btb->Connect(0);
+
+    this->fetchBuffer = new InstructionPacket[2 * this->fetchSize];
+    this->queue = new BranchPredictionUnitEntry[this->queueSize];
+
+    return 0;
+}
+
+void BranchPredictionUnit::ClockFetch() {
+    FetchPacket packet;
+    while (this->fetch->ReceiveResponse(this->fetchID, &packet) == 0) {
+        this->fetchBuffer[this->fetchBufferUsage] = packet.response;
+        ++this->fetchBufferUsage;
+    }
+}
+
+void BranchPredictionUnit::ClockRequestFetch() {
+    // The engine answers in the cycle after the next one, so the bytes asked
+    // last cycle are still on their way. The buffer has room for both.
+    unsigned long usage = this->previousRequest;
+    for (unsigned long i = 0; i < this->fetchBufferUsage; ++i) {
+        usage += this->fetchBuffer[i].staticInfo->instSize;
+    }
+
+    this->previousRequest = 0;
+    if (usage >= 2 * this->fetchSize) return;
+    unsigned long request = 2 * this->fetchSize - usage;
+    if (request > this->fetchSize) request = this->fetchSize;
+
+    FetchPacket packet;
+    packet.request = request;
+    if (this->fetch->SendRequest(this->fetchID, &packet) == 0) {
+        this->previousRequest = request;
+    }
+}
+
+void BranchPredictionUnit::ClockFormBlock() {
+    if (this->fetchBufferUsage == 0) return;
+    if (this->queueOccupation == this->queueSize) return;
+
+    BranchPredictionUnitEntry* entry = this->Entry(this->queueOccupation);
+    FetchTargetPacket* block = &entry->block;
+
+    unsigned long size = 0;
+    unsigned int operations = 0;
+    while (size < this->blockSize && size < this->fetchBufferUsage) {
+        const InstructionPacket* instruction = &this->fetchBuffer[size];
+        const DynamicInstructionInfo* dynamicInfo = &instruction->dynamicInfo;
+        if (operations + dynamicInfo->numReadings + dynamicInfo->numWritings >
+            (unsigned int)MAX_FETCH_BLOCK_MEMORY_OPERATIONS) {
+            break;
+        }
+        for (unsigned short i = 0; i < dynamicInfo->numReadings; ++i) {
+            block->memoryAddresses[operations] = dynamicInfo->readsAddr[i];
+            block->memorySizes[operations] = dynamicInfo->readsSize[i];
+            ++operations;
+        }
+        for (unsigned short i = 0; i < dynamicInfo->numWritings; ++i) {
+            block->memoryAddresses[operations] = dynamicInfo->writesAddr[i];
+            block->memorySizes[operations] = dynamicInfo->writesSize[i];
+            ++operations;
+        }
+        block->instructions[size] = instruction->staticInfo;
+        block->numReadings[size] = dynamicInfo->numReadings;
+        block->numWritings[size] = dynamicInfo->numWritings;
+        block->nextAddress = instruction->nextInstruction;
+        ++size;
+        if (instruction->nextInstruction !=
+            instruction->staticInfo->instAddress +
+                instruction->staticInfo->instSize) {
+            break;
+        }
+    }
+
+    const StaticInstructionInfo* last = block->instructions[size - 1];
+    block->startAddress = block->instructions[0]->instAddress;
+    block->endAddress = last->instAddress + last->instSize;
+    block->numberOfInstructions = size;
+    block->numberOfMemoryOperations = operations;
+    block->mispredicted = false;
+    entry->takenMask = 0;
+    entry->targetMask = 0;
+    entry->btbMask = 0;
+    entry->waitingRas = false;
+    entry->waitingBtb = false;
+    ++this->queueOccupation;
+
+    this->fetchBufferUsage -= size;
+    if (this->fetchBufferUsage > 0) {
+        memmove(this->fetchBuffer, &this->fetchBuffer[size],
+                sizeof(*this->fetchBuffer) * this->fetchBufferUsage);
+    }
+}
+
+void BranchPredictionUnit::ClockQuery() {
+    while (this->numberOfQueried < this->queueOccupation) {
+        BranchPredictionUnitEntry* entry = this->Entry(this->numberOfQueried);
+        const FetchTargetPacket* block = &entry->block;
+
+        bool toRas = false;
+        bool toBtb = false;
+        for (unsigned int i = 0; i < block->numberOfInstructions; ++i) {
+            Branch type = block->instructions[i]->branchType;
+            if (type == BranchCall || type == BranchRet) toRas = true;
+            if (type != BranchNone) toBtb = true;
+        }
+        toRas = toRas && this->ras != NULL;
+        toBtb = toBtb && this->btb != NULL;
+
+        if (this->predictor != NULL &&
+            !this->predictor->IsComponentAvailable(this->predictorID)) {
+            return;
+        }
+        if (toRas && !this->ras->IsComponentAvailable(this->rasID)) return;
+        if (toBtb && !this->btb->IsComponentAvailable(this->btbID)) return;
+
+        PredictorPacket query;
+        query.type = PredictorPacketTypeRequestBlockQuery;
+        memcpy(query.data.blockQuery.instructions, block->instructions,
+               sizeof(*block->instructions) * block->numberOfInstructions);
+        query.data.blockQuery.startAddress = block->startAddress;
+        query.data.blockQuery.nextAddress = block->nextAddress;
+        query.data.blockQuery.numberOfInstructions =
+            block->numberOfInstructions;
+
+        if (this->predictor != NULL) {
+            this->predictor->SendRequest(this->predictorID, &query);
+        } else {
+            // Without a predictor, every block is predicted not taken right
+            // away.
+            ++this->numberOfPredicted;
+        }
+        if (toRas) {
+            this->ras->SendRequest(this->rasID, &query);
+            entry->waitingRas = true;
+        }
+        if (toBtb) {
+            BTBPacket btbQuery;
+            btbQuery.type = BTBPacketTypeRequestBlockQuery;
+            memcpy(btbQuery.data.requestBlockQuery.instructions,
+                   block->instructions,
+                   sizeof(*block->instructions) * block->numberOfInstructions);
+            btbQuery.data.requestBlockQuery.startAddress = block->startAddress;
+            btbQuery.data.requestBlockQuery.numberOfInstructions =
+                block->numberOfInstructions;
+            this->btb->SendRequest(this->btbID, &btbQuery);
+            entry->waitingBtb = true;
+        }
+        ++this->numberOfQueried;
+    }
+}
+
+void BranchPredictionUnit::ClockCheckPredictor() {
+    if (this->predictor == NULL) return;
+
+    PredictorPacket response;
+    // Responses come in order, one per block query.
+    while (this->predictor->ReceiveResponse(this->predictorID, &response) ==
+           0) {
+        assert(response.type == PredictorPacketTypeResponseBlock);
+        assert(this->numberOfPredicted < this->numberOfQueried);
+        BranchPredictionUnitEntry* entry =
+            this->Entry(this->numberOfPredicted);
+        assert(entry->block.startAddress ==
+               response.data.blockResponse.startAddress);
+
+        for (unsigned int i = 0; i < entry->block.numberOfInstructions; ++i) {
+            // The returns are left to the ras.
+            if (this->ras != NULL &&
+                entry->block.instructions[i]->branchType == BranchRet) {
+                continue;
+            }
+            unsigned int bit = 1U << i;
+            entry->takenMask |= response.data.blockResponse.takenMask & bit;
+            if (response.data.blockResponse.targetMask & bit) {
+                entry->targetMask |= bit;
+                entry->targets[i] = response.data.blockResponse.targets[i];
+            }
+        }
+        ++this->numberOfPredicted;
+    }
+}
+
+void BranchPredictionUnit::ClockCheckRas() {
+    if (this->ras == NULL) return;
+
+    PredictorPacket response;
+    while (this->ras->ReceiveResponse(this->rasID, &response) == 0) {
+        assert(response.type == PredictorPacketTypeResponseBlock);
+        // The oldest block waiting for the ras.
+        unsigned long i = 0;
+        while (i < this->numberOfQueried && !this->Entry(i)->waitingRas) ++i;
+        assert(i < this->numberOfQueried);
+        BranchPredictionUnitEntry* entry = this->Entry(i);
+        assert(entry->block.startAddress ==
+               response.data.blockResponse.startAddress);
+
+        for (unsigned int slot = 0; slot < entry->block.numberOfInstructions;
+             ++slot) {
+            unsigned int bit = 1U << slot;
+            if (entry->block.instructions[slot]->branchType == BranchRet &&
+                (response.data.blockResponse.targetMask & bit)) {
+                entry->takenMask |= bit;
+                entry->targetMask |= bit;
+                entry->targets[slot] =
+                    response.data.blockResponse.targets[slot];
+            }
+        }
+        entry->waitingRas = false;
+    }
+}
+
+void BranchPredictionUnit::ClockCheckBtb() {
+    if (this->btb == NULL) return;
+
+    BTBPacket response;
+    while (this->btb->ReceiveResponse(this->btbID, &response) == 0) {
+        assert(response.type == BTBPacketTypeResponseBlock);
+        // The oldest block waiting for the btb.
+        unsigned long i = 0;
+        while (i < this->numberOfQueried && !this->Entry(i)->waitingBtb) ++i;
+        assert(i < this->numberOfQueried);
+        BranchPredictionUnitEntry* entry = this->Entry(i);
+        assert(entry->block.startAddress ==
+               response.data.blockResponse.startAddress);
+
+        entry->btbMask = response.data.blockResponse.hitMask;
+        for (unsigned int slot = 0; slot < entry->block.numberOfInstructions;
+             ++slot) {
+            unsigned int bit = 1U << slot;
+            if (!(entry->btbMask & bit)) continue;
+            entry->btbTargets[slot] = response.data.blockResponse.targets[slot];
+            if (this->predictor == NULL &&
+                entry->block.instructions[slot]->branchType == BranchCond &&
+                (response.data.blockResponse.takenMask & bit)) {
+                entry->takenMask |= bit;
+            }
+        }
+        entry->waitingBtb = false;
+    }
+}
+
+void BranchPredictionUnit::SendBtbUpdate(const StaticInstructionInfo* info,
+                                         unsigned long next, bool hit,
+                                         unsigned long btbTarget) {
+    if (this->btb == NULL || info->branchType == BranchNone) return;
+
+    bool taken = next != info->instAddress + info->instSize;
+    BTBPacket update;
+    if (taken && (!hit || btbTarget != next)) {
+        update.type = BTBPacketTypeRequestAddEntry;
+        update.data.requestAddEntry.instruction = info;
+        update.data.requestAddEntry.target = next;
+    } else if (hit) {
+        update.type = BTBPacketTypeRequestUpdate;
+        update.data.requestUpdate.instruction = info;
+        update.data.requestUpdate.branchState = taken;
+    } else {
+        return;
+    }
+    this->btb->SendRequest(this->btbID, &update);
+}
+
+void BranchPredictionUnit::SendUpdate(const StaticInstructionInfo* info,
+                                      unsigned long next, bool toRas) {
+    // The predictors only look at the static information and at where the
+    // instruction went.
+    InstructionPacket instruction;
+    instruction.staticInfo = info;
+    instruction.dynamicInfo.numReadings = 0;
+    instruction.dynamicInfo.numWritings = 0;
+    instruction.nextInstruction = next;
+
+    PredictorPacket update;
+    if (toRas &&
+        (info->branchType == BranchCall || info->branchType == BranchRet)) {
+        update.type = PredictorPacketTypeRequestTargetUpdate;
+        update.data.targetUpdate.instruction = instruction;
+        update.data.targetUpdate.target = next;
+        this->ras->SendRequest(this->rasID, &update);
+    }
+
+    if (this->predictor == NULL) return;
+    if (info->branchType == BranchCond) {
+        update.type = PredictorPacketTypeRequestDirectionUpdate;
+        update.data.directionUpdate.instruction = instruction;
+        update.data.directionUpdate.taken =
+            next != info->instAddress + info->instSize;
+    } else if (info->isIndirectControlFlowInst) {
+        update.type = PredictorPacketTypeRequestTargetUpdate;
+        update.data.targetUpdate.instruction = instruction;
+        update.data.targetUpdate.target = next;
+    } else {
+        return;
+    }
+    this->predictor->SendRequest(this->predictorID, &update);
+}
+
+bool BranchPredictionUnit::CheckBlock(BranchPredictionUnitEntry* entry) {
+    bool toRas = false;
+    if (this->ras != NULL) {
+        for (unsigned int i = 0; i < entry->block.numberOfInstructions; ++i) {
+            Branch type = entry->block.instructions[i]->branchType;
+            if (type == BranchCall || type == BranchRet) toRas = true;
+        }
+    }
+
+    bool mispredicted = false;
+    unsigned int last = entry->block.numberOfInstructions - 1;
+    for (unsigned int i = 0; i <= last; ++i) {
+        const StaticInstructionInfo* info = entry->block.instructions[i];
+        unsigned long fallthrough = info->instAddress + info->instSize;
+        unsigned long next = (i == last) ? entry->block.nextAddress
+                                         : fallthrough;
+        unsigned int bit = 1U << i;
+
+        bool taken = next != fallthrough;
+        bool direct = !info->isIndirectControlFlowInst;
+        bool hit = (entry->btbMask & bit) != 0;
+
+        // Where a taken prediction would send the fetch, if anywhere.
+        bool known;
+        unsigned long target;
+        if (entry->targetMask & bit) {
+            known = true;
+            target = entry->targets[i];
+        } else if (this->btb != NULL) {
+            known = hit;
+            target = entry->btbTargets[i];
+        } else {
+            known = direct;
+            target = next;
+        }
+        bool predictedTaken =
+            known && ((entry->takenMask & bit) ||
+                      (direct && (info->branchType == BranchUncond ||
+                                  info->branchType == BranchCall)));
+
+        if (taken != predictedTaken || (taken && target != next)) {
+            mispredicted = true;
+        }
+
+        // The trace only has the correct path, so the branches are resolved
+        // as soon as they are checked.
+        this->SendUpdate(info, next, toRas);
+        this->SendBtbUpdate(info, next, hit, entry->btbTargets[i]);
+    }
+
+    return mispredicted;
+}
+
+void BranchPredictionUnit::ClockReceiveRequests() {
+    FetchTargetPacket request;
+    long numberOfConnections = this->GetNumberOfConnections();
+    for (long i = 0; i < numberOfConnections; ++i) {
+        while (this->ReceiveRequestFromConnection(i, &request) == 0) {
+            if (request.type == FetchTargetPacketTypeRequestBlock) {
+                ++this->credits;
+            } else if (request.type == FetchTargetPacketTypeRequestRedirect) {
+                this->waitingRedirect = false;
+                this->currentPenalty = this->misspredictPenalty;
+            }
+        }
+    }
+}
+
+void BranchPredictionUnit::ClockSendBlocks() {
+    while (this->credits > 0 && this->numberOfPredicted > 0) {
+        if (this->waitingRedirect || this->currentPenalty > 0) {
+            ++this->stalledCycles;
+            return;
+        }
+
+        BranchPredictionUnitEntry* entry = this->Entry(0);
+        if (entry->waitingRas || entry->waitingBtb) return;
+
+        entry->block.mispredicted = this->CheckBlock(entry);
+        entry->block.type = FetchTargetPacketTypeResponseBlock;
+        this->SendResponseToConnection(0, &entry->block);
+
+        ++this->blocks;
+        this->instructions += entry->block.numberOfInstructions;
+        if (entry->block.mispredicted) {
+            ++this->misspredictions;
+            this->waitingRedirect = true;
+        }
+
+        --this->credits;
+        this->queueStart = (this->queueStart + 1) % this->queueSize;
+        --this->queueOccupation;
+        --this->numberOfQueried;
+        --this->numberOfPredicted;
+    }
+}
+
+void BranchPredictionUnit::Clock() {
+    if (this->currentPenalty > 0) --this->currentPenalty;
+
+    this->ClockReceiveRequests();
+    this->ClockCheckPredictor();
+    this->ClockCheckRas();
+    this->ClockCheckBtb();
+    this->ClockSendBlocks();
+    this->ClockFetch();
+    this->ClockFormBlock();
+    this->ClockQuery();
+    this->ClockRequestFetch();
+}
+
+void BranchPredictionUnit::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("BranchPredictionUnit [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Blocks [%lu], instructions [%lu]\n", this->blocks,
+                       this->instructions);
+    SINUCA3_LOG_PRINTF("    Mispredicted blocks [%lu]\n",
+                       this->misspredictions);
+    SINUCA3_LOG_PRINTF("    Stalled cycles [%lu]\n", this->stalledCycles);
+}
+
+BranchPredictionUnit::~BranchPredictionUnit() {
+    if (this->fetchBuffer != NULL) delete[] this->fetchBuffer;
+    if (this->queue != NULL) delete[] this->queue;
+}
+
+#ifndef NDEBUG
+
+/**
+ * @brief Records a block handed out by the unit at a cycle.
+ */
+struct BranchPredictionUnitTestBlock {
+    unsigned long startAddress;
+    long cycle;
+    bool mispredicted;
+};
+
+/**
+ * @brief Runs [unit] over the [size] instructions of [trace] as a FetchUnit
+ * with four FTQ entries that fetches a block as soon as it arrives and
+ * redirects [redirectDelay] cycles after a mispredicted one. [btb] is clocked
+ * with it if not NULL.
+ * @return Blocks handed out, up to [maxBlocks] of them in [blocks].
+ */
+static unsigned long BranchPredictionUnitTestRun(
+    const char* config, const InstructionPacket* trace, unsigned long size,
+    BranchTargetBuffer* btb, long redirectDelay,
+    BranchPredictionUnitTestBlock* blocks, unsigned long maxBlocks) {
+    BranchPredictionUnit unit;
+    BranchPredictionUnitTesterFetching fetching;
+    fetching.trace = trace;
+    fetching.size = size;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    aliases.Insert("fetching", &fetching);
+    if (btb != NULL) {
+        aliases.Insert("btb", btb);
+        if (btb->Configure(CreateFakeConfig(&parser,
+                                            "interleavingFactor: 16\n"
+                                            "numberOfEntries: 64\n",
+                                            &aliases))) {
+            return 0;
+        }
+    }
+    if (unit.Configure(CreateFakeConfig(&parser, config, &aliases))) return 0;
+    int id = unit.Connect(0);
+
+    FetchTargetPacket packet;
+    packet.type = FetchTargetPacketTypeRequestBlock;
+    for (int i = 0; i < 4; ++i) unit.SendRequest(id, &packet);
+
+    unsigned long numberOfBlocks = 0;
+    unsigned long instructions = 0;
+    long redirectAt = -1;
+    for (long cycle = 1; cycle <= 1000 && instructions < size; ++cycle) {
+        fetching.Clock();
+        if (btb != NULL) btb->Clock();
+        unit.Clock();
+        fetching.PosClock();
+        if (btb != NULL) btb->PosClock();
+        unit.PosClock();
+
+        if (cycle == redirectAt) {
+            packet.type = FetchTargetPacketTypeRequestRedirect;
+            unit.SendRequest(id, &packet);
+        }
+        while (unit.ReceiveResponse(id, &packet) == 0) {
+            if (numberOfBlocks < maxBlocks) {
+                blocks[numberOfBlocks].startAddress = packet.startAddress;
+                blocks[numberOfBlocks].cycle = cycle;
+                blocks[numberOfBlocks].mispredicted = packet.mispredicted;
+            }
+            ++numberOfBlocks;
+            instructions += packet.numberOfInstructions;
+            if (packet.mispredicted) redirectAt = cycle + redirectDelay;
+            packet.type = FetchTargetPacketTypeRequestBlock;
+            unit.SendRequest(id, &packet);
+        }
+    }
+    return numberOfBlocks;
+}
+
+int TestBranchPredictionUnit() {
+    // Straight code at 0x1000 with a conditional branch as its tenth
+    // instruction, taken to 0x2000.
+    const unsigned long size = 40;
+    StaticInstructionInfo code[size];
+    InstructionPacket trace[size];
+    memset(trace, 0, sizeof(trace));
+    for (unsigned long i = 0; i < size; ++i) {
+        code[i].instAddress = (i < 10 ? 0x1000 : 0x2000 - 40) + 4 * i;
+        code[i].instSize = 4;
+        trace[i].staticInfo = &code[i];
+        trace[i].nextInstruction = code[i].instAddress + 4;
+    }
+    code[9].branchType = BranchCond;
+    trace[9].nextInstruction = 0x2000;
+
+    const char* config =
+        "fetch: *fetching\n"
+        "misspredictPenalty: 12\n";
+    const long redirectDelay = 20;
+
+    // Without a predictor the branch is predicted not taken. The block
+    // ending at it is the only mispredicted one, and no block is handed out
+    // until the redirect and the penalty passed.
+    BranchPredictionUnitTestBlock blocks[16];
+    unsigned long numberOfBlocks = BranchPredictionUnitTestRun(
+        config, trace, size, NULL, redirectDelay, blocks, 16);
+    if (numberOfBlocks != 6) return 1;
+    if (blocks[0].startAddress != 0x1000 || blocks[0].mispredicted) return 2;
+    if (blocks[1].startAddress != 0x1020 || !blocks[1].mispredicted) return 3;
+    if (blocks[2].startAddress != 0x2000 || blocks[2].mispredicted) return 4;
+    long stall = blocks[2].cycle - blocks[1].cycle;
+    if (stall < redirectDelay + 12 || stall > redirectDelay + 12 + 2) {
+        return 5;
+    }
+
+    // A loop of four instructions closed by a direct jump. Without a btb
+    // the target is always known, with one only after the jump was taken
+    // once.
+    const unsigned long iterations = 16;
+    StaticInstructionInfo loop[4];
+    InstructionPacket loopTrace[4 * iterations];
+    memset(loopTrace, 0, sizeof(loopTrace));
+    for (unsigned long i = 0; i < 4; ++i) {
+        loop[i].instAddress = 0x3000 + 4 * i;
+        loop[i].instSize = 4;
+    }
+    loop[3].branchType = BranchUncond;
+    for (unsigned long i = 0; i < 4 * iterations; ++i) {
+        loopTrace[i].staticInfo = &loop[i % 4];
+        loopTrace[i].nextInstruction =
+            (i % 4 == 3) ? 0x3000 : loop[i % 4].instAddress + 4;
+    }
+
+    numberOfBlocks = BranchPredictionUnitTestRun(
+        config, loopTrace, 4 * iterations, NULL, 1, blocks, 16);
+    if (numberOfBlocks != iterations) return 6;
+    for (unsigned long i = 0; i < iterations; ++i) {
+        if (blocks[i].mispredicted) return 7;
+    }
+
+    BranchTargetBuffer btb;
+    numberOfBlocks = BranchPredictionUnitTestRun(
+        "fetch: *fetching\n"
+        "btb: *btb\n"
+        "misspredictPenalty: 12\n",
+        loopTrace, 4 * iterations, &btb, 1, blocks, 16);
+    if (numberOfBlocks != iterations) return 8;
+    if (!blocks[0].mispredicted) return 9;
+    if (blocks[iterations - 1].mispredicted) return 10;
+
+    return 0;
+}
+
+#endif
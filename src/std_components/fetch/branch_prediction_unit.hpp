@@ -0,0 +1,233 @@
+#ifndef SINUCA3_BRANCH_PREDICTION_UNIT_HPP_
+#define SINUCA3_BRANCH_PREDICTION_UNIT_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file branch_prediction_unit.hpp
+ * @brief API of the BranchPredictionUnit, the predicting half of a decoupled
+ * front end. It runs ahead of the FetchUnit, filling its fetch target queue.
+ */
+
+#include <sinuca3.hpp>
+#include <std_components/predictors/interleavedBTB.hpp>
+
+/**
+ * @brief A fetch block between its creation and its entry in the FTQ.
+ */
+struct BranchPredictionUnitEntry {
+    FetchTargetPacket block;
+    unsigned long targets[MAX_FETCH_BLOCK_INSTRUCTIONS];
+    unsigned long btbTargets[MAX_FETCH_BLOCK_INSTRUCTIONS];
+    unsigned int takenMask;  /**< Slots predicted taken. */
+    unsigned int targetMask; /**< Slots with a predicted target. */
+    unsigned int btbMask;    /**< Slots the btb holds, see btbTargets. */
+    bool waitingRas;         /**< Sent to the ras and not answered yet. */
+    bool waitingBtb;         /**< Sent to the btb and not answered yet. */
+};
+
+/**
+ * @brief The BranchPredictionUnit reads the trace, splits it in fetch blocks
+ * and predicts each block with a single block query, then hands the blocks to
+ * the FetchUnit connected to it as it frees FTQ entries (see
+ * FetchTargetPacket).
+ *
+ * @details A block is a run of up to blockSize instructions that ends at a
+ * taken branch, or earlier when the memory operations of its instructions
+ * fill the FetchTargetPacket. At most one block is formed per cycle, with what
+ * `fetch` delivered, so fetchSize also bounds the bytes of a block.
+ *
+ * A block is mispredicted when a branch in it goes another way than the
+ * prediction. A branch is only predicted taken when its target is known, from
+ * the predictor, the ras or the btb, and direct jumps and calls with a known
+ * target are always predicted taken. Without a btb the targets of direct
+ * branches are always known, as if they came from a perfect BTB. The btb
+ * learns the targets of the taken branches as the blocks are checked, and
+ * without a predictor its counters predict the conditional branches. After a
+ * mispredicted block, no block is
+ * handed to the FetchUnit until it fetched that block and misspredictPenalty
+ * cycles passed, the time the branch takes to resolve and the front end to be
+ * redirected. Blocks formed in the meantime wait in the queue. As the trace
+ * only has the correct path, they are the blocks the front end would predict
+ * after the redirect.
+ *
+ * It accepts the following parameters:
+ * - fetch (required): Component<FetchPacket> from which to fetch
+ *   instructions.
+ * - predictor: Component<PredictorPacket> answering block queries.
+ * - ras: Component<PredictorPacket>, predicts the returns. Blocks with calls
+ *   or returns are also queried to it.
+ * - btb: BranchTargetBuffer, answering block queries of the blocks with
+ *   branches.
+ * - fetchSize: Bytes fetched from `fetch` per cycle. Defaults to 32.
+ * - blockSize: Most instructions in a block, up to
+ *   MAX_FETCH_BLOCK_INSTRUCTIONS. Defaults to 8.
+ * - queueSize: Blocks formed and not in the FTQ yet. Defaults to 4.
+ * - misspredictPenalty (required): Integer amount of cycles to redirect the
+ *   front end after a mispredicted block is fetched.
+ *
+ * It serves a single FetchUnit.
+ */
+class BranchPredictionUnit : public Component<FetchTargetPacket> {
+  private:
+    Component<FetchPacket>* fetch; /**< Component from which to fetch
+                                      instructions. */
+    Component<PredictorPacket>* predictor;
+    Component<PredictorPacket>* ras;
+    Component<BTBPacket>* btb;
+    InstructionPacket* fetchBuffer; /**< Fetched instructions, room for two
+                                       requests of fetchSize bytes. */
+    unsigned long fetchBufferUsage;
+    unsigned long fetchSize;
+    unsigned long previousRequest; /**< Bytes asked last cycle, arriving in
+                                      the next one. */
+    unsigned long blockSize;
+
+    BranchPredictionUnitEntry* queue; /**< Circular, oldest block first. */
+    unsigned long queueSize;
+    unsigned long queueStart;
+    unsigned long queueOccupation;
+    unsigned long numberOfQueried;   /**< Oldest blocks already queried. */
+    unsigned long numberOfPredicted; /**< Oldest blocks the predictor
+                                        answered. */
+
+    unsigned long credits; /**< FTQ entries free in the FetchUnit. */
+    unsigned long misspredictPenalty;
+    unsigned long currentPenalty;
+    bool waitingRedirect; /**< A mispredicted block was not fetched yet. */
+
+    unsigned long blocks;
+    unsigned long instructions;
+    unsigned long misspredictions;
+    unsigned long stalledCycles; /**< Without handing blocks after a
+                                    misprediction. */
+
+    int fetchID;
+    int predictorID;
+    int rasID;
+    int btbID;
+
+    inline BranchPredictionUnitEntry* Entry(unsigned long i) {
+        return &this->queue[(this->queueStart + i) % this->queueSize];
+    }
+
+    /** @brief Helper to get the instructions asked to `fetch`. */
+    void ClockFetch();
+    /** @brief Helper to ask `fetch` for instructions. */
+    void ClockRequestFetch();
+    /** @brief Helper to split a block from the fetched instructions. */
+    void ClockFormBlock();
+    /** @brief Helper to send block queries. */
+    void ClockQuery();
+    /** @brief Helpers to receive the predictions. */
+    void ClockCheckPredictor();
+    void ClockCheckRas();
+    void ClockCheckBtb();
+    /** @brief Helper to receive the credits and redirects of the FetchUnit. */
+    void ClockReceiveRequests();
+    /** @brief Helper to hand the predicted blocks to the FetchUnit. */
+    void ClockSendBlocks();
+    /**
+     * @brief Compares the predictions of [entry] with the trace and resolves
+     * its branches in the predictors.
+     * @return true if a branch was mispredicted.
+     */
+    bool CheckBlock(BranchPredictionUnitEntry* entry);
+    /** @brief Tells the predictors [info] went to [next]. */
+    void SendUpdate(const StaticInstructionInfo* info, unsigned long next,
+                    bool toRas);
+    /**
+     * @brief Teaches the btb the target of [info] if it went to a [next]
+     * the btb does not have, or else the direction if the btb holds it.
+     */
+    void SendBtbUpdate(const StaticInstructionInfo* info, unsigned long next,
+                       bool hit, unsigned long btbTarget);
+
+  public:
+    inline BranchPredictionUnit()
+        : fetch(NULL),
+          predictor(NULL),
+          ras(NULL),
+          btb(NULL),
+          fetchBuffer(NULL),
+          fetchBufferUsage(0),
+          fetchSize(32),
+          previousRequest(0),
+          blockSize(8),
+          queue(NULL),
+          queueSize(4),
+          queueStart(0),
+          queueOccupation(0),
+          numberOfQueried(0),
+          numberOfPredicted(0),
+          credits(0),
+          misspredictPenalty(0),
+          currentPenalty(0),
+          waitingRedirect(false),
+          blocks(0),
+          instructions(0),
+          misspredictions(0),
+          stalledCycles(0) {}
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+
+    virtual ~BranchPredictionUnit();
+};
+
+#ifndef NDEBUG
+/**
+ * @brief Answers fetches as the engine does, with a fixed trace.
+ */
+class BranchPredictionUnitTesterFetching : public Component<FetchPacket> {
+  public:
+    const InstructionPacket* trace;
+    unsigned long size;
+    unsigned long next;
+
+    inline BranchPredictionUnitTesterFetching()
+        : trace(NULL), size(0), next(0) {}
+    virtual int Configure(Config config) {
+        (void)config;
+        return 0;
+    }
+    virtual void Clock() {
+        FetchPacket packet;
+        long numberOfConnections = this->GetNumberOfConnections();
+        for (long c = 0; c < numberOfConnections; ++c) {
+            if (this->ReceiveRequestFromConnection(c, &packet) != 0) continue;
+            // The answers share the packet.
+            long request = packet.request;
+            long bytes = 0;
+            while (this->next < this->size) {
+                bytes += this->trace[this->next].staticInfo->instSize;
+                if (bytes > request) break;
+                packet.response = this->trace[this->next];
+                this->SendResponseToConnection(c, &packet);
+                ++this->next;
+            }
+        }
+    }
+    virtual void PrintStatistics() {}
+    virtual ~BranchPredictionUnitTesterFetching() {}
+};
+
+int TestBranchPredictionUnit();
+#endif
+
+#endif  // SINUCA3_BRANCH_PREDICTION_UNIT_HPP_
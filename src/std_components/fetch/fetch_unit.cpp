@@ -0,0 +1,369 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file fetch_unit.cpp
+ * @brief Implementation of the FetchUnit.
+ */
+
+#include "fetch_unit.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <sinuca3.hpp>
+
+int FetchUnit::Configure(Config config) {
+    if (config.ComponentReference("predictionUnit", &this->predictionUnit,
+                                  true))
+        return 1;
+    if (config.ComponentReference("instructionMemory",
+                                  &this->instructionMemory))
+        return 1;
+
+    long ftqEntries = this->ftqEntries;
+    if (config.Integer("ftqEntries", &ftqEntries)) return 1;
+    if (ftqEntries <= 0) return config.Error("ftqEntries", "is not > 0.");
+    this->ftqEntries = ftqEntries;
+
+    long prefetchEntries = ftqEntries;
+    if (config.Integer("prefetchEntries", &prefetchEntries)) return 1;
+    if (prefetchEntries <= 0 || prefetchEntries > ftqEntries) {
+        return config.Error("prefetchEntries",
+                            "is not between 1 and ftqEntries.");
+    }
+    this->prefetchEntries = prefetchEntries;
+
+    long fetchWidth = this->fetchWidth;
+    if (config.Integer("fetchWidth", &fetchWidth)) return 1;
+    if (fetchWidth <= 0) return config.Error("fetchWidth", "is not > 0.");
+    this->fetchWidth = fetchWidth;
+
+    long lineSize = this->lineSize;
+    if (config.Integer("lineSize", &lineSize)) return 1;
+    if (lineSize < 16 || (lineSize & (lineSize - 1)) != 0) {
+        return config.Error("lineSize", "is not a power of two >= 16.");
+    }
+    this->lineSize = lineSize;
+
+    this->predictionUnitID = this->predictionUnit->Connect(0);
+    if (this->instructionMemory != NULL) {
+        this->instructionMemoryID = this->instructionMemory->Connect(0);
+    }
+
+    this->ftq = new FetchUnitEntry[this->ftqEntries];
+
+    return 0;
+}
+
+void FetchUnit::ClockReceiveBlocks() {
+    FetchTargetPacket block;
+    while (this->predictionUnit->ReceiveResponse(this->predictionUnitID,
+                                                 &block) == 0) {
+        assert(block.type == FetchTargetPacketTypeResponseBlock);
+        // There is room, a block is only asked for a free entry.
+        assert(this->ftqOccupation < this->ftqEntries);
+        FetchUnitEntry* entry = this->Entry(this->ftqOccupation);
+        entry->block = block;
+        entry->pendingLines = 0;
+        entry->delivered = 0;
+        entry->deliveredOperations = 0;
+        entry->requested = false;
+        ++this->ftqOccupation;
+        --this->requestedBlocks;
+    }
+}
+
+void FetchUnit::ClockReceiveLines() {
+    if (this->instructionMemory == NULL) return;
+
+    MemoryPacket packet;
+    while (this->instructionMemory->ReceiveResponse(this->instructionMemoryID,
+                                                    &packet) == 0) {
+        if (packet.type != MemoryPacketTypeRead) continue;
+        // The oldest block waiting for the line.
+        for (unsigned long i = 0; i < this->ftqOccupation; ++i) {
+            FetchUnitEntry* entry = this->Entry(i);
+            if (!entry->requested || packet.address < entry->firstLine) {
+                continue;
+            }
+            unsigned long line =
+                (packet.address - entry->firstLine) / this->lineSize;
+            if (line < 32 && (entry->pendingLines & (1U << line))) {
+                entry->pendingLines &= ~(1U << line);
+                break;
+            }
+        }
+    }
+}
+
+void FetchUnit::ClockRequestLines() {
+    const unsigned long mask = ~(this->lineSize - 1);
+    for (unsigned long i = 0;
+         i < this->ftqOccupation && i < this->prefetchEntries; ++i) {
+        FetchUnitEntry* entry = this->Entry(i);
+        if (entry->requested) continue;
+        entry->requested = true;
+        entry->firstLine = entry->block.startAddress & mask;
+        if (this->instructionMemory == NULL) continue;
+
+        unsigned long lastLine = (entry->block.endAddress - 1) & mask;
+        MemoryPacket packet;
+        packet.type = MemoryPacketTypeRead;
+        packet.instAddress = entry->block.startAddress;
+        for (unsigned long line = entry->firstLine; line <= lastLine;
+             line += this->lineSize) {
+            packet.address = line;
+            this->instructionMemory->SendRequest(this->instructionMemoryID,
+                                                 &packet);
+            unsigned long bit = (line - entry->firstLine) / this->lineSize;
+            entry->pendingLines |= 1U << bit;
+            ++this->lineRequests;
+            if (i > 0) ++this->prefetches;
+        }
+    }
+}
+
+void FetchUnit::Unpack(FetchUnitEntry* entry, InstructionPacket* instruction) {
+    const FetchTargetPacket* block = &entry->block;
+    unsigned int slot = entry->delivered;
+    const StaticInstructionInfo* info = block->instructions[slot];
+    DynamicInstructionInfo* dynamicInfo = &instruction->dynamicInfo;
+
+    instruction->staticInfo = info;
+    instruction->nextInstruction = (slot + 1 == block->numberOfInstructions)
+                                       ? block->nextAddress
+                                       : info->instAddress + info->instSize;
+    unsigned int operation = entry->deliveredOperations;
+    dynamicInfo->numReadings = block->numReadings[slot];
+    for (unsigned short i = 0; i < dynamicInfo->numReadings; ++i) {
+        dynamicInfo->readsAddr[i] = block->memoryAddresses[operation];
+        dynamicInfo->readsSize[i] = block->memorySizes[operation];
+        ++operation;
+    }
+    dynamicInfo->numWritings = block->numWritings[slot];
+    for (unsigned short i = 0; i < dynamicInfo->numWritings; ++i) {
+        dynamicInfo->writesAddr[i] = block->memoryAddresses[operation];
+        dynamicInfo->writesSize[i] = block->memorySizes[operation];
+        ++operation;
+    }
+    entry->deliveredOperations = operation;
+    ++entry->delivered;
+}
+
+void FetchUnit::ClockFetch() {
+    FetchPacket request;
+    long numberOfConnections = this->GetNumberOfConnections();
+    for (long c = 0; c < numberOfConnections; ++c) {
+        if (this->ReceiveRequestFromConnection(c, &request) != 0) continue;
+
+        if (this->ftqOccupation == 0) {
+            ++this->emptyCycles;
+            continue;
+        }
+        FetchUnitEntry* head = this->Entry(0);
+        if (!head->requested || head->pendingLines != 0) {
+            ++this->missCycles;
+            continue;
+        }
+
+        // Only the head block is fetched in a cycle.
+        unsigned long fetched = 0;
+        long bytes = 0;
+        FetchPacket response;
+        while (head->delivered < head->block.numberOfInstructions &&
+               fetched < this->fetchWidth) {
+            bytes += head->block.instructions[head->delivered]->instSize;
+            if (request.request == 0 ? fetched == 1 : bytes > request.request) {
+                break;
+            }
+            this->Unpack(head, &response.response);
+            this->SendResponseToConnection(c, &response);
+            ++fetched;
+        }
+        this->fetchedInstructions += fetched;
+
+        if (head->delivered < head->block.numberOfInstructions) continue;
+        if (head->block.mispredicted) {
+            FetchTargetPacket redirect;
+            redirect.type = FetchTargetPacketTypeRequestRedirect;
+            this->predictionUnit->SendRequest(this->predictionUnitID,
+                                              &redirect);
+        }
+        ++this->blocks;
+        this->ftqStart = (this->ftqStart + 1) % this->ftqEntries;
+        --this->ftqOccupation;
+    }
+}
+
+void FetchUnit::ClockRequestBlocks() {
+    FetchTargetPacket request;
+    request.type = FetchTargetPacketTypeRequestBlock;
+    while (this->ftqOccupation + this->requestedBlocks < this->ftqEntries) {
+        if (this->predictionUnit->SendRequest(this->predictionUnitID,
+                                              &request) != 0) {
+            break;
+        }
+        ++this->requestedBlocks;
+    }
+}
+
+void FetchUnit::Clock() {
+    this->ClockReceiveBlocks();
+    this->ClockReceiveLines();
+    this->ClockRequestLines();
+    this->ClockFetch();
+    this->ClockRequestBlocks();
+}
+
+void FetchUnit::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("FetchUnit [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Blocks [%lu], instructions [%lu]\n", this->blocks,
+                       this->fetchedInstructions);
+    SINUCA3_LOG_PRINTF("    Line requests [%lu], prefetches [%lu]\n",
+                       this->lineRequests, this->prefetches);
+    SINUCA3_LOG_PRINTF("    Cycles with the FTQ empty [%lu]\n",
+                       this->emptyCycles);
+    SINUCA3_LOG_PRINTF("    Cycles waiting for lines [%lu]\n",
+                       this->missCycles);
+}
+
+FetchUnit::~FetchUnit() {
+    if (this->ftq != NULL) delete[] this->ftq;
+}
+
+#ifndef NDEBUG
+
+/**
+ * @brief Fetches the [size] [blocks] from a FetchUnit with [config], asking
+ * 16 bytes per cycle and checking the instructions come in order. The config
+ * may use [memory] as instructionMemory.
+ * @return Cycles to fetch them all, -1 if they are not fetched in 1000 cycles
+ * or come wrong.
+ */
+static long FetchUnitTestRun(const char* config,
+                             const FetchTargetPacket* blocks,
+                             unsigned long size,
+                             FetchUnitTesterPredictionUnit* predictionUnit,
+                             FetchUnitTesterMemory* memory) {
+    FetchUnit fetchUnit;
+    predictionUnit->blocks = blocks;
+    predictionUnit->size = size;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    aliases.Insert("predictionUnit", predictionUnit);
+    if (memory != NULL) aliases.Insert("memory", memory);
+    if (fetchUnit.Configure(CreateFakeConfig(&parser, config, &aliases))) {
+        return -1;
+    }
+    int id = fetchUnit.Connect(0);
+
+    unsigned long block = 0;
+    unsigned int slot = 0;
+    FetchPacket packet;
+    for (long cycle = 1; cycle <= 1000; ++cycle) {
+        predictionUnit->Clock();
+        if (memory != NULL) memory->Clock();
+        fetchUnit.Clock();
+        predictionUnit->PosClock();
+        if (memory != NULL) memory->PosClock();
+        fetchUnit.PosClock();
+
+        while (fetchUnit.ReceiveResponse(id, &packet) == 0) {
+            if (block == size) return -1;
+            const FetchTargetPacket* expected = &blocks[block];
+            const StaticInstructionInfo* info = expected->instructions[slot];
+            if (packet.response.staticInfo != info) return -1;
+            ++slot;
+            unsigned long next = (slot == expected->numberOfInstructions)
+                                     ? expected->nextAddress
+                                     : info->instAddress + info->instSize;
+            if (packet.response.nextInstruction != next) return -1;
+            if (slot == expected->numberOfInstructions) {
+                ++block;
+                slot = 0;
+            }
+        }
+        if (block == size) return cycle;
+
+        packet.request = 16;
+        fetchUnit.SendRequest(id, &packet);
+    }
+    return -1;
+}
+
+int TestFetchUnit() {
+    // Eight blocks of four instructions, each in its own line and jumping to
+    // the next one.
+    const unsigned long size = 8;
+    StaticInstructionInfo code[4 * size];
+    FetchTargetPacket blocks[size];
+    memset(blocks, 0, sizeof(blocks));
+    for (unsigned long b = 0; b < size; ++b) {
+        FetchTargetPacket* block = &blocks[b];
+        block->type = FetchTargetPacketTypeResponseBlock;
+        block->startAddress = 0x1000 + 0x100 * b;
+        block->endAddress = block->startAddress + 16;
+        block->nextAddress = block->startAddress + 0x100;
+        block->numberOfInstructions = 4;
+        for (unsigned long i = 0; i < 4; ++i) {
+            StaticInstructionInfo* info = &code[4 * b + i];
+            info->instAddress = block->startAddress + 4 * i;
+            info->instSize = 4;
+            info->branchType = (i == 3) ? BranchUncond : BranchNone;
+            block->instructions[i] = info;
+        }
+    }
+    blocks[2].mispredicted = true;
+
+    // Without an instructionMemory a block is fetched per cycle, and the
+    // mispredicted one is redirected once.
+    FetchUnitTesterPredictionUnit predictionUnit;
+    long perfect = FetchUnitTestRun("predictionUnit: *predictionUnit\n",
+                                    blocks, size, &predictionUnit, NULL);
+    if (perfect < 0 || perfect > (long)size + 10) return 1;
+    if (predictionUnit.numberOfRedirects != 1) return 2;
+
+    // Reading only the lines of the head pays the latency once per block,
+    // prefetching the lines of the blocks behind it overlaps the misses.
+    const unsigned long latency = 20;
+    FetchUnitTesterPredictionUnit serialUnit;
+    FetchUnitTesterMemory serialMemory;
+    serialMemory.latency = latency;
+    long serial = FetchUnitTestRun(
+        "predictionUnit: *predictionUnit\n"
+        "instructionMemory: *memory\n"
+        "prefetchEntries: 1\n",
+        blocks, size, &serialUnit, &serialMemory);
+    if (serial < (long)(size * latency)) return 3;
+    if (serialMemory.mostHeld != 1) return 4;
+
+    FetchUnitTesterPredictionUnit overlappedUnit;
+    FetchUnitTesterMemory overlappedMemory;
+    overlappedMemory.latency = latency;
+    long overlapped = FetchUnitTestRun(
+        "predictionUnit: *predictionUnit\n"
+        "instructionMemory: *memory\n"
+        "prefetchEntries: 8\n",
+        blocks, size, &overlappedUnit, &overlappedMemory);
+    if (overlapped < (long)latency) return 5;
+    if (overlapped > (long)(latency + size) + 10) return 6;
+    if (overlappedMemory.mostHeld < 2) return 7;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef SINUCA3_FETCH_UNIT_HPP_
+#define SINUCA3_FETCH_UNIT_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file fetch_unit.hpp
+ * @brief API of the FetchUnit, the fetching half of a decoupled front end. It
+ * holds the fetch target queue filled by a BranchPredictionUnit.
+ */
+
+#include <sinuca3.hpp>
+
+/**
+ * @brief An entry of the fetch target queue.
+ */
+struct FetchUnitEntry {
+    FetchTargetPacket block;
+    unsigned long firstLine;
+    unsigned int pendingLines; /**< Bit i for line firstLine + i * lineSize,
+                                  requested and not arrived. */
+    unsigned int delivered;    /**< Instructions already fetched. */
+    unsigned int deliveredOperations; /**< Their memory operations. */
+    bool requested;                   /**< Its lines were requested. */
+};
+
+/**
+ * @brief The FetchUnit keeps the fetch target queue (FTQ) of predicted blocks
+ * and fetches their instructions, serving them as the engine does to the
+ * component fetching from it.
+ *
+ * @details The lines of the first prefetchEntries blocks of the FTQ are read
+ * from instructionMemory as soon as the blocks arrive, so the misses of the
+ * blocks behind the head overlap with the fetch of the head
+ * (fetch-directed prefetching). Instructions are fetched only from the head
+ * block, once all its lines arrived, up to fetchWidth instructions per cycle.
+ *
+ * Requests are FetchPacket as the engine's: a request of N bytes is answered
+ * with the instructions that fit in N bytes, 0 asks for a single instruction.
+ * The answers come in the next cycle. It serves a single component.
+ *
+ * It accepts the following parameters:
+ * - predictionUnit (required): Component<FetchTargetPacket> from which to
+ *   receive the predicted blocks.
+ * - instructionMemory: Component<MemoryPacket>, the instruction cache. Without
+ *   it, the lines are always present.
+ * - ftqEntries: Integer size of the FTQ. Defaults to 16.
+ * - prefetchEntries: Integer amount of blocks, the head included, whose lines
+ *   are read ahead. 1 disables the prefetching. Defaults to ftqEntries.
+ * - fetchWidth: Integer most instructions fetched per cycle. Defaults to 4.
+ * - lineSize: Integer, bytes per line of instructionMemory, a power of two of
+ *   at least 16. Defaults to 64.
+ */
+class FetchUnit : public Component<FetchPacket> {
+  private:
+    Component<FetchTargetPacket>* predictionUnit;
+    Component<MemoryPacket>* instructionMemory;
+
+    FetchUnitEntry* ftq; /**< Circular, oldest block first. */
+    unsigned long ftqEntries;
+    unsigned long ftqStart;
+    unsigned long ftqOccupation;
+    unsigned long requestedBlocks; /**< Asked and not received. */
+    unsigned long prefetchEntries;
+    unsigned long fetchWidth;
+    unsigned long lineSize;
+
+    unsigned long blocks;
+    unsigned long fetchedInstructions;
+    unsigned long lineRequests;
+    unsigned long prefetches; /**< Line requests of blocks behind the head. */
+    unsigned long emptyCycles;  /**< Asked for instructions with the FTQ
+                                   empty. */
+    unsigned long missCycles;   /**< Asked for instructions with the lines of
+                                   the head missing. */
+
+    int predictionUnitID;
+    int instructionMemoryID;
+
+    inline FetchUnitEntry* Entry(unsigned long i) {
+        return &this->ftq[(this->ftqStart + i) % this->ftqEntries];
+    }
+
+    /** @brief Helper to put the arriving blocks in the FTQ. */
+    void ClockReceiveBlocks();
+    /** @brief Helper to receive the lines from instructionMemory. */
+    void ClockReceiveLines();
+    /** @brief Helper to read the lines of the blocks near the head. */
+    void ClockRequestLines();
+    /** @brief Rebuilds the next instruction of [entry] into [instruction]. */
+    void Unpack(FetchUnitEntry* entry, InstructionPacket* instruction);
+    /** @brief Helper to answer the requests for instructions. */
+    void ClockFetch();
+    /** @brief Helper to ask a block for each free FTQ entry. */
+    void ClockRequestBlocks();
+
+  public:
+    inline FetchUnit()
+        : predictionUnit(NULL),
+          instructionMemory(NULL),
+          ftq(NULL),
+          ftqEntries(16),
+          ftqStart(0),
+          ftqOccupation(0),
+          requestedBlocks(0),
+          prefetchEntries(0),
+          fetchWidth(4),
+          lineSize(64),
+          blocks(0),
+          fetchedInstructions(0),
+          lineRequests(0),
+          prefetches(0),
+          emptyCycles(0),
+          missCycles(0) {}
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+
+    virtual ~FetchUnit();
+};
+
+#ifndef NDEBUG
+/**
+ * @brief Answers each block request with the next of a fixed run of blocks
+ * and counts the redirects.
+ */
+class FetchUnitTesterPredictionUnit : public Component<FetchTargetPacket> {
+  public:
+    const FetchTargetPacket* blocks;
+    unsigned long size;
+    unsigned long next;
+    unsigned long numberOfRedirects;
+
+    inline FetchUnitTesterPredictionUnit()
+        : blocks(NULL), size(0), next(0), numberOfRedirects(0) {}
+    virtual int Configure(Config config) {
+        (void)config;
+        return 0;
+    }
+    virtual void Clock() {
+        FetchTargetPacket packet;
+        while (this->ReceiveRequestFromConnection(0, &packet) == 0) {
+            if (packet.type == FetchTargetPacketTypeRequestRedirect) {
+                ++this->numberOfRedirects;
+            } else if (this->next < this->size) {
+                packet = this->blocks[this->next++];
+                this->SendResponseToConnection(0, &packet);
+            }
+        }
+    }
+    virtual void PrintStatistics() {}
+    virtual ~FetchUnitTesterPredictionUnit() {}
+};
+
+/**
+ * @brief Answers each read latency cycles after it arrives and keeps the
+ * most reads it had in flight.
+ */
+class FetchUnitTesterMemory : public Component<MemoryPacket> {
+  public:
+    MemoryPacket held[64];
+    unsigned long answerAt[64];
+    unsigned long numberOfHeld;
+    unsigned long latency;
+    unsigned long cycle;
+    unsigned long mostHeld;
+
+    inline FetchUnitTesterMemory()
+        : numberOfHeld(0), latency(1), cycle(0), mostHeld(0) {}
+    virtual int Configure(Config config) {
+        (void)config;
+        return 0;
+    }
+    virtual void Clock() {
+        ++this->cycle;
+        MemoryPacket packet;
+        while (this->ReceiveRequestFromConnection(0, &packet) == 0) {
+            if (packet.type != MemoryPacketTypeRead) continue;
+            assert(this->numberOfHeld < sizeof(this->held) /
+                                            sizeof(*this->held));
+            this->held[this->numberOfHeld] = packet;
+            this->answerAt[this->numberOfHeld] = this->cycle + this->latency;
+            ++this->numberOfHeld;
+        }
+        if (this->numberOfHeld > this->mostHeld) {
+            this->mostHeld = this->numberOfHeld;
+        }
+        unsigned long kept = 0;
+        for (unsigned long i = 0; i < this->numberOfHeld; ++i) {
+            if (this->answerAt[i] <= this->cycle) {
+                this->SendResponseToConnection(0, &this->held[i]);
+                continue;
+            }
+            this->held[kept] = this->held[i];
+            this->answerAt[kept] = this->answerAt[i];
+            ++kept;
+        }
+        this->numberOfHeld = kept;
+    }
+    virtual void PrintStatistics() {}
+    virtual ~FetchUnitTesterMemory() {}
+};
+
+int TestFetchUnit();
+#endif
+
+#endif  // SINUCA3_FETCH_UNIT_HPP_
@@ -100,6 +100,27 @@ void Fetcher::ClockSendBuffered() {
     }
 }
 
+void Fetcher::SendUpdate(const InstructionPacket* instruction) {
+    // The trace only has the correct path, so the branch is resolved as soon
+    // as its prediction is checked.
+    PredictorPacket update;
+    if (instruction->staticInfo->branchType == BranchCond) {
+        update.type = PredictorPacketTypeRequestDirectionUpdate;
+        update.data.directionUpdate.instruction = *instruction;
+        update.data.directionUpdate.taken =
+            instruction->nextInstruction !=
+            instruction->staticInfo->instAddress +
+                instruction->staticInfo->instSize;
+    } else if (instruction->staticInfo->isIndirectControlFlowInst) {
+        update.type = PredictorPacketTypeRequestTargetUpdate;
+        update.data.targetUpdate.instruction = *instruction;
+        update.data.targetUpdate.target = instruction->nextInstruction;
+    } else {
+        return;
+    }
+    this->predictor->SendRequest(this->predictorID, &update);
+}
+
 int Fetcher::ClockCheckPredictor() {
     if (this->predictor == NULL) return 0;
 
@@ -128,6 +149,7 @@ int Fetcher::ClockCheckPredictor() {
         if (target != this->fetchBuffer[i].instruction.nextInstruction) {
             ret = 1;
         }
+        this->SendUpdate(&this->fetchBuffer[i].instruction);
         ++i;
         cont =
             this->predictor->ReceiveResponse(this->predictorID, &response) == 0;
@@ -104,6 +104,9 @@ class Fetcher : public Component<int> {
     void ClockSendBuffered();
     /** @brief Helper to check predicted instructions. */
     int ClockCheckPredictor();
+    /** @brief Tells the predictor the direction of a conditional branch or
+     * the target of an indirect one. */
+    void SendUpdate(const InstructionPacket* instruction);
     /** @brief Helper to remove instructions from the buffer. */
     void ClockUnbuffer();
     /** @brief Helper to request instructions to `fetch`. */
@@ -0,0 +1,85 @@
+#ifndef SINUCA3_BANKED_CACHE_HPP_
+#define SINUCA3_BANKED_CACHE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file banked_cache.hpp
+ * @details Public API of the BankedCache, which splits a shared cache in
+ * address-interleaved banks.
+ */
+
+#include <sinuca3.hpp>
+#include <vector>
+
+/** @brief Upper limit of the banks parameter. */
+static const long BANKED_CACHE_MAX_BANKS = 256;
+
+/** @brief A read or write sent to a bank and not answered yet. */
+struct BankedCacheRequest {
+    unsigned long address;
+    MemoryPacketType type;
+    int connectionID; /**< Of the BankedCache it came from. */
+};
+
+/**
+ * @details BankedCache sends each request to the bank of its address and the
+ * responses of the banks back to the connection that made the request, adding
+ * a cycle each way, like a crossbar. The banks are independent components,
+ * usually Caches, and a line always maps to the same bank, so they do not
+ * share any state. Invalidate responses of a bank reach every connection of
+ * the BankedCache. Caches used as banks should set interleavedBanks and
+ * interleaving as the BankedCache does, or the bank bits select their sets
+ * too and each bank uses only one of every `banks` sets. It accepts the
+ * following parameters:
+ * - bank (required): Component<MemoryPacket> definition, instantiated once
+ * per bank. Must not be an alias, as each bank needs its own instance.
+ * - banks: integer, power of two, number of banks, 4 by default.
+ * - interleaving: integer, power of two, bytes mapped to a bank before moving
+ * to the next one, 64 by default.
+ */
+class BankedCache : public Component<MemoryPacket> {
+  private:
+    std::vector<Component<MemoryPacket>*> banks;
+    std::vector<int> bankConnections; /**< One per bank. */
+    /** @brief Per bank, the reads and writes it has not answered yet, oldest
+     * first, to send each response to the connection that asked for it. */
+    std::vector<std::vector<BankedCacheRequest> > inFlight;
+    int interleavingBits;
+    unsigned long* numRequests; /**< Per bank. */
+
+    inline unsigned long BankOf(unsigned long address) const {
+        return (address >> this->interleavingBits) & (this->banks.size() - 1);
+    }
+
+    /** @brief Connection that sent the request answered by [response]. */
+    int ConnectionOf(unsigned long bank, const MemoryPacket* response);
+
+  public:
+    inline BankedCache() : interleavingBits(0), numRequests(NULL) {}
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+    virtual ~BankedCache();
+};
+
+#ifndef NDEBUG
+int TestBankedCache();
+#endif
+
+#endif  // SINUCA3_BANKED_CACHE_HPP_
@@ -0,0 +1,684 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file cache.cpp
+ * @brief Implementation of the Cache.
+ */
+
+#include "cache.hpp"
+
+#include <cstring>
+#include <sinuca3.hpp>
+
+int Cache::Configure(Config config) {
+    long size = 0;
+    long associativity = 0;
+    const char* policy = "lru";
+    const char* inclusion = "nine";
+    const char* prefetcher = "none";
+    long prefetchDegree = 2;
+    long prefetchDistance = 4;
+    long prefetchTable = 0;
+    long interleavedBanks = 1;
+    long interleaving = 0;
+
+    if (config.ComponentReference("nextLevel", &this->nextLevel, true))
+        return 1;
+    if (config.Integer("size", &size, true)) return 1;
+    if (config.Integer("associativity", &associativity, true)) return 1;
+    if (config.Integer("lineSize", &this->lineSize)) return 1;
+    if (config.String("policy", &policy)) return 1;
+    if (config.Integer("hitLatency", &this->hitLatency)) return 1;
+    if (config.Integer("mshrs", &this->numMshrs)) return 1;
+    if (config.Integer("mshrTargets", &this->mshrTargets)) return 1;
+    if (config.Integer("ports", &this->ports)) return 1;
+    if (config.String("inclusion", &inclusion)) return 1;
+    if (config.String("prefetcher", &prefetcher)) return 1;
+    if (config.Integer("prefetchDegree", &prefetchDegree)) return 1;
+    if (config.Integer("prefetchDistance", &prefetchDistance)) return 1;
+    if (config.Integer("prefetchTable", &prefetchTable)) return 1;
+    if (config.Integer("interleavedBanks", &interleavedBanks)) return 1;
+    if (config.Integer("interleaving", &interleaving)) return 1;
+
+    if (size <= 0) return config.Error("size", "should be > 0");
+    if (associativity <= 0) {
+        return config.Error("associativity", "should be > 0");
+    }
+    if (this->lineSize <= 0 || (this->lineSize & (this->lineSize - 1))) {
+        return config.Error("lineSize", "should be a power of two");
+    }
+    if (this->hitLatency < 0) {
+        return config.Error("hitLatency", "should be >= 0");
+    }
+    if (this->numMshrs <= 0 || this->numMshrs > CACHE_MAX_MSHRS) {
+        return config.Error("mshrs", "should be between 1 and 64");
+    }
+    if (this->mshrTargets <= 0) {
+        return config.Error("mshrTargets", "should be > 0");
+    }
+    if (this->ports <= 0) return config.Error("ports", "should be > 0");
+    if (interleavedBanks <= 0 || (interleavedBanks & (interleavedBanks - 1))) {
+        return config.Error("interleavedBanks", "should be a power of two");
+    }
+    if (interleaving == 0) interleaving = this->lineSize;
+    if (interleaving < this->lineSize || (interleaving & (interleaving - 1))) {
+        return config.Error("interleaving",
+                            "should be a power of two >= lineSize");
+    }
+    this->bankShift = __builtin_ctzl(interleaving);
+    this->bankBits = __builtin_ctzl(interleavedBanks);
+
+    if (strcmp(inclusion, "nine") == 0) {
+        this->inclusion = CacheInclusionNine;
+    } else if (strcmp(inclusion, "inclusive") == 0) {
+        this->inclusion = CacheInclusionInclusive;
+    } else if (strcmp(inclusion, "exclusive") == 0) {
+        this->inclusion = CacheInclusionExclusive;
+    } else {
+        return config.Error("inclusion",
+                            "should be nine, inclusive or exclusive");
+    }
+
+    if (strcmp(prefetcher, "none") != 0) {
+        if (prefetchDegree <= 0 || prefetchDegree > PREFETCHER_MAX_DEGREE) {
+            return config.Error("prefetchDegree", "should be between 1 and 16");
+        }
+        if (prefetchDistance <= 0) {
+            return config.Error("prefetchDistance", "should be > 0");
+        }
+        if (prefetchTable == 0) {
+            prefetchTable = (strcmp(prefetcher, "stream") == 0) ? 16 : 256;
+        }
+        if (strcmp(prefetcher, "ipstride") == 0 &&
+            (prefetchTable < 4 || (prefetchTable & (prefetchTable - 1)))) {
+            return config.Error("prefetchTable",
+                                "should be a power of two >= 4");
+        }
+        this->prefetcher =
+            CreatePrefetcher(prefetcher, this->lineSize, prefetchDegree,
+                             prefetchDistance, prefetchTable);
+        if (this->prefetcher == NULL) {
+            return config.Error("prefetcher",
+                                "should be none, nextline, ipstride or stream");
+        }
+    }
+
+    this->cache = CacheMemory<CacheBlock>::fromCacheSize(
+        size, this->lineSize, associativity, policy);
+    if (this->cache == NULL) {
+        SINUCA3_ERROR_PRINTF("Cache: Failed to alocate CacheMemory\n");
+        return 1;
+    }
+
+    this->nextLevelID = this->nextLevel->Connect(0);
+    this->pendingRequests.Allocate(0, sizeof(CacheTarget));
+
+    this->hits.Allocate(this->hitLatency, this->ports);
+    this->mshrs.Allocate(this->numMshrs, this->mshrTargets);
+
+    return 0;
+}
+
+void Cache::SendToNextLevel(unsigned long line, MemoryPacketType type) {
+    MemoryPacket packet;
+    packet.address = line;
+    packet.instAddress = 0;
+    packet.type = type;
+    this->nextLevel->SendRequest(this->nextLevelID, &packet);
+}
+
+void Cache::SendWriteBack(unsigned long line) {
+    this->SendToNextLevel(line, MemoryPacketTypeWriteBack);
+    ++this->numWriteBacks;
+}
+
+void Cache::BackInvalidate(unsigned long line) {
+    MemoryPacket packet;
+    packet.address = line;
+    packet.instAddress = 0;
+    packet.type = MemoryPacketTypeInvalidate;
+
+    long numberOfConnections = this->GetNumberOfConnections();
+    for (long i = 0; i < numberOfConnections; ++i) {
+        this->SendResponseToConnection(i, &packet);
+    }
+    ++this->numBackInvalidations;
+}
+
+void Cache::Install(unsigned long line, bool dirty, bool prefetched) {
+    CacheBlock block;
+    block.lineAddress = line;
+    block.dirty = dirty;
+    block.prefetched = prefetched;
+
+    CacheBlock evicted;
+    if (!this->cache->Write(this->SetAddress(line), &block, &evicted)) return;
+
+    if (evicted.prefetched) ++this->numUselessPrefetches;
+    if (evicted.dirty) {
+        this->SendWriteBack(evicted.lineAddress);
+    } else {
+        this->SendToNextLevel(evicted.lineAddress, MemoryPacketTypeEvict);
+    }
+    if (this->inclusion == CacheInclusionInclusive) {
+        this->BackInvalidate(evicted.lineAddress);
+    }
+}
+
+void Cache::ProcessWriteBack(unsigned long line) {
+    ++this->numWriteBacksReceived;
+
+    CacheBlock* block = this->cache->ReadForUpdate(this->SetAddress(line));
+    if (block != NULL) {
+        block->dirty = true;
+        return;
+    }
+
+    // The whole line is written, so there is nothing to fetch. If the line is
+    // already on its way, it is just installed dirty.
+    int mshr = this->mshrs.Find(line);
+    if (mshr >= 0 && this->inclusion != CacheInclusionExclusive) {
+        this->mshrDirty |= 1UL << mshr;
+    } else if (this->inclusion == CacheInclusionInclusive) {
+        // Only lines this level invalidated can be missing from it.
+        this->SendWriteBack(line);
+    } else {
+        this->Install(line, true, false);
+    }
+}
+
+void Cache::ProcessEvict(unsigned long line) {
+    if (this->inclusion != CacheInclusionExclusive) return;
+    if (this->cache->Peek(this->SetAddress(line)) == NULL) {
+        this->Install(line, false, false);
+    }
+}
+
+void Cache::ProcessInvalidate(unsigned long line) {
+    ++this->numInvalidationsReceived;
+
+    CacheBlock block;
+    bool present = this->cache->Invalidate(this->SetAddress(line), &block);
+    if (present && block.dirty) this->SendWriteBack(line);
+    // An inclusive level without the line knows the levels above lack it too.
+    if (present || this->inclusion != CacheInclusionInclusive) {
+        this->BackInvalidate(line);
+    }
+}
+
+int Cache::AllocateMshr(unsigned long line, unsigned long instAddress) {
+    int mshr = this->mshrs.Take(line);
+
+    // Write-allocate: stores fetch the line like loads.
+    MemoryPacket fill;
+    fill.address = line;
+    fill.instAddress = instAddress;
+    fill.type = MemoryPacketTypeRead;
+    this->nextLevel->SendRequest(this->nextLevelID, &fill);
+
+    return mshr;
+}
+
+void Cache::Prefetch(unsigned long line, unsigned long instAddress,
+                     bool hit) {
+    unsigned long candidates[PREFETCHER_MAX_DEGREE];
+    int numCandidates =
+        this->prefetcher->Access(line, instAddress, hit, candidates);
+
+    for (int i = 0; i < numCandidates; ++i) {
+        unsigned long target = this->LineOf(candidates[i]);
+        if (!this->SameBank(target, line)) continue;
+        if (this->cache->Peek(this->SetAddress(target)) != NULL ||
+            this->mshrs.Find(target) >= 0) {
+            continue;
+        }
+        // The last free MSHR is kept for the demand misses.
+        unsigned long freeMshrs = this->mshrs.Free();
+        if ((freeMshrs & (freeMshrs - 1)) == 0) return;
+
+        int mshr = this->AllocateMshr(target, instAddress);
+        this->mshrPrefetch |= 1UL << mshr;
+        ++this->numPrefetches;
+    }
+}
+
+int Cache::ProcessRequest(CacheTarget* request) {
+    if (request->packet.type == MemoryPacketTypeWriteBack) {
+        this->ProcessWriteBack(this->LineOf(request->packet.address));
+        return 0;
+    }
+    if (request->packet.type == MemoryPacketTypeEvict) {
+        this->ProcessEvict(this->LineOf(request->packet.address));
+        return 0;
+    }
+
+    bool isWrite = (request->packet.type == MemoryPacketTypeWrite);
+    unsigned long line = this->LineOf(request->packet.address);
+
+    CacheBlock* block = this->cache->ReadForUpdate(this->SetAddress(line));
+    bool hit = (block != NULL);
+    if (hit) {
+        if (isWrite) block->dirty = true;
+        if (block->prefetched) {
+            block->prefetched = false;
+            ++this->numUsefulPrefetches;
+            hit = false;
+        }
+        this->hits.Schedule(this->cycle, request);
+        ++this->numHits;
+
+        if (this->inclusion == CacheInclusionExclusive) {
+            bool dirty = block->dirty;
+            this->cache->Invalidate(this->SetAddress(line), NULL);
+            if (dirty) this->SendWriteBack(line);
+        }
+    } else {
+        int mshr = this->mshrs.Find(line);
+        if (mshr >= 0) {
+            if (this->mshrs.IsFull(mshr)) {
+                ++this->numTargetFullStalls;
+                return 1;
+            }
+            ++this->numMerges;
+            if (this->mshrPrefetch & (1UL << mshr)) {
+                this->mshrPrefetch &= ~(1UL << mshr);
+                ++this->numLatePrefetches;
+            }
+        } else {
+            if (this->mshrs.Free() == 0) {
+                ++this->numMshrFullStalls;
+                return 1;
+            }
+            mshr = this->AllocateMshr(line, request->packet.instAddress);
+        }
+
+        if (isWrite) this->mshrDirty |= 1UL << mshr;
+        this->mshrs.AddTarget(mshr, request);
+        ++this->numMisses;
+    }
+
+    if (isWrite) {
+        ++this->numWrites;
+    } else {
+        ++this->numReads;
+    }
+
+    if (this->prefetcher != NULL) {
+        this->Prefetch(line, request->packet.instAddress, hit);
+    }
+    return 0;
+}
+
+void Cache::ProcessFill(unsigned long line) {
+    int mshr = this->mshrs.Find(line);
+    if (mshr < 0) return;
+    unsigned long bit = 1UL << mshr;
+
+    if (this->inclusion != CacheInclusionExclusive) {
+        this->Install(line, this->mshrDirty & bit, this->mshrPrefetch & bit);
+    }
+
+    CacheTarget* targets = this->mshrs.GetTargets(mshr);
+    for (int i = 0; i < this->mshrs.GetNumTargets(mshr); ++i) {
+        this->SendResponseToConnection(targets[i].connectionID,
+                                       &targets[i].packet);
+    }
+
+    this->mshrs.Release(mshr);
+    this->mshrDirty &= ~bit;
+    this->mshrPrefetch &= ~bit;
+}
+
+void Cache::Clock() {
+    // Fills first, so the MSHRs they free can be used in this cycle.
+    MemoryPacket response;
+    while (this->nextLevel->ReceiveResponse(this->nextLevelID, &response) ==
+           0) {
+        if (response.type == MemoryPacketTypeInvalidate) {
+            this->ProcessInvalidate(this->LineOf(response.address));
+        } else if (response.type == MemoryPacketTypeRead) {
+            this->ProcessFill(this->LineOf(response.address));
+        }
+    }
+
+    long numberOfConnections = this->GetNumberOfConnections();
+    CacheTarget request;
+    for (long i = 0; i < numberOfConnections; ++i) {
+        while (this->ReceiveRequestFromConnection(i, &request.packet) == 0) {
+            request.connectionID = i;
+            this->pendingRequests.Enqueue(&request);
+        }
+    }
+
+    for (long port = 0; port < this->ports; ++port) {
+        if (!this->hasStalledRequest) {
+            if (this->pendingRequests.Dequeue(&this->stalledRequest)) break;
+            this->hasStalledRequest = true;
+        }
+        if (this->ProcessRequest(&this->stalledRequest)) break;
+        this->hasStalledRequest = false;
+    }
+
+    int numDue;
+    CacheTarget* hits = this->hits.Complete(this->cycle, &numDue);
+    for (int i = 0; i < numDue; ++i) {
+        this->SendResponseToConnection(hits[i].connectionID, &hits[i].packet);
+    }
+
+    ++this->cycle;
+}
+
+void Cache::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("Cache [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Reads: %lu\n", this->numReads);
+    SINUCA3_LOG_PRINTF("    Writes: %lu\n", this->numWrites);
+    SINUCA3_LOG_PRINTF("    Hits: %lu\n", this->numHits);
+    SINUCA3_LOG_PRINTF("    Misses: %lu\n", this->numMisses);
+    SINUCA3_LOG_PRINTF("    MSHR merges: %lu\n", this->numMerges);
+    SINUCA3_LOG_PRINTF("    MSHR full stalls: %lu\n", this->numMshrFullStalls);
+    SINUCA3_LOG_PRINTF("    MSHR target full stalls: %lu\n",
+                       this->numTargetFullStalls);
+    SINUCA3_LOG_PRINTF("    Write-backs received: %lu\n",
+                       this->numWriteBacksReceived);
+    SINUCA3_LOG_PRINTF("    Write-backs sent: %lu\n", this->numWriteBacks);
+    SINUCA3_LOG_PRINTF("    Invalidations received: %lu\n",
+                       this->numInvalidationsReceived);
+    SINUCA3_LOG_PRINTF("    Back-invalidations sent: %lu\n",
+                       this->numBackInvalidations);
+    if (this->prefetcher != NULL) {
+        SINUCA3_LOG_PRINTF("    Prefetches: %lu\n", this->numPrefetches);
+        SINUCA3_LOG_PRINTF("    Useful prefetches: %lu\n",
+                           this->numUsefulPrefetches);
+        SINUCA3_LOG_PRINTF("    Late prefetches: %lu\n",
+                           this->numLatePrefetches);
+        SINUCA3_LOG_PRINTF("    Useless prefetches: %lu\n",
+                           this->numUselessPrefetches);
+    }
+}
+
+Cache::~Cache() {
+    delete this->cache;
+    delete this->prefetcher;
+}
+
+#ifndef NDEBUG
+
+static void CacheTestStep(Cache* cache, CacheTesterMemory* memory) {
+    cache->Clock();
+    memory->Clock();
+    cache->PosClock();
+    memory->PosClock();
+}
+
+/** @brief Steps until a response arrives, returns the number of steps. */
+static int CacheTestWait(Cache* cache, CacheTesterMemory* memory, int id,
+                         MemoryPacket* response) {
+    for (int steps = 1; steps < 100; ++steps) {
+        CacheTestStep(cache, memory);
+        if (cache->ReceiveResponse(id, response) == 0) return steps;
+    }
+    return -1;
+}
+
+int TestCache() {
+    Cache cache;
+    CacheTesterMemory memory;
+
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    aliases.Insert("memory", &memory);
+
+    // 4 sets of 2 ways, so lines 256 bytes apart share a set.
+    if (cache.Configure(CreateFakeConfig(&parser,
+                                         "nextLevel: *memory\n"
+                                         "size: 512\n"
+                                         "associativity: 2\n"
+                                         "hitLatency: 3\n"
+                                         "mshrs: 2\n"
+                                         "mshrTargets: 2\n"
+                                         "ports: 4\n",
+                                         &aliases))) {
+        return 1;
+    }
+    int id = cache.Connect(0);
+
+    // Two misses to the same line share a MSHR, a third line takes the other
+    // one and a fourth waits for a free MSHR.
+    MemoryPacket packet;
+    packet.instAddress = 0;
+    packet.type = MemoryPacketTypeRead;
+    unsigned long addresses[] = {0x1000, 0x1008, 0x1040, 0x1080};
+    for (int i = 0; i < 4; ++i) {
+        packet.address = addresses[i];
+        cache.SendRequest(id, &packet);
+    }
+    int received = 0;
+    for (int steps = 0; steps < 100 && received < 4; ++steps) {
+        CacheTestStep(&cache, &memory);
+        while (cache.ReceiveResponse(id, &packet) == 0) {
+            if (packet.address != addresses[received]) return 2;
+            ++received;
+        }
+    }
+    if (received != 4) return 3;
+    if (memory.numReads != 3) return 4;
+    if (cache.GetNumMerges() != 1) return 5;
+    if (cache.GetNumMshrFullStalls() == 0) return 6;
+
+    // Going through the cache takes two steps, hits add hitLatency to it and
+    // misses the two steps of the trip to the memory.
+    packet.address = 0x1010;
+    packet.type = MemoryPacketTypeWrite;
+    cache.SendRequest(id, &packet);
+    int hitSteps = CacheTestWait(&cache, &memory, id, &packet);
+    if (hitSteps != 2 + 3 || packet.address != 0x1010) return 7;
+    if (cache.GetNumHits() != 1) return 8;
+
+    // Bringing two more lines to the set of 0x1000 evicts it, now dirty.
+    packet.type = MemoryPacketTypeRead;
+    packet.address = 0x1100;
+    cache.SendRequest(id, &packet);
+    if (CacheTestWait(&cache, &memory, id, &packet) != 2 + 2) return 9;
+    packet.address = 0x1200;
+    cache.SendRequest(id, &packet);
+    if (CacheTestWait(&cache, &memory, id, &packet) < 0) return 10;
+    CacheTestStep(&cache, &memory);
+    if (memory.numWriteBacks != 1 || memory.lastWriteBack != 0x1000) {
+        return 11;
+    }
+
+    // A write-back from above allocates without fetching.
+    unsigned long reads = memory.numReads;
+    packet.address = 0x2000;
+    packet.type = MemoryPacketTypeWriteBack;
+    cache.SendRequest(id, &packet);
+    for (int i = 0; i < 4; ++i) CacheTestStep(&cache, &memory);
+    if (memory.numReads != reads) return 12;
+    packet.address = 0x2000;
+    packet.type = MemoryPacketTypeRead;
+    cache.SendRequest(id, &packet);
+    if (CacheTestWait(&cache, &memory, id, &packet) != hitSteps) return 13;
+
+    return 0;
+}
+
+/** @brief Clocks the components, then runs their PosClock. */
+static void CacheTestStepAll(Linkable** components, int count, int steps) {
+    for (int step = 0; step < steps; ++step) {
+        for (int i = 0; i < count; ++i) components[i]->Clock();
+        for (int i = 0; i < count; ++i) components[i]->PosClock();
+    }
+}
+
+/** @brief Reads [address] through [l1] and runs until it is answered. */
+static int CacheTestRead(Cache* l1, int id, Linkable** components, int count,
+                         unsigned long address) {
+    MemoryPacket packet;
+    packet.address = address;
+    packet.instAddress = 0;
+    packet.type = MemoryPacketTypeRead;
+    l1->SendRequest(id, &packet);
+    for (int steps = 0; steps < 100; ++steps) {
+        CacheTestStepAll(components, count, 1);
+        if (l1->ReceiveResponse(id, &packet) == 0) {
+            // Let the evictions and invalidations settle.
+            CacheTestStepAll(components, count, 4);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int TestCacheInclusion() {
+    const char* l1Config =
+        "nextLevel: *l2\n"
+        "size: 256\n"
+        "associativity: 1\n"
+        "hitLatency: 1\n";
+
+    // Two lines in different sets of the L1 but in the same set of a smaller
+    // inclusive L2: the second one evicts the first from the L2, and so from
+    // the L1 as well.
+    {
+        Cache l1, l2;
+        CacheTesterMemory memory;
+        Map<Linkable*> aliases;
+        yaml::Parser parser;
+        aliases.Insert("l2", &l2);
+        aliases.Insert("memory", &memory);
+        if (l2.Configure(CreateFakeConfig(&parser,
+                                          "nextLevel: *memory\n"
+                                          "size: 128\n"
+                                          "associativity: 1\n"
+                                          "inclusion: inclusive\n",
+                                          &aliases))) {
+            return 1;
+        }
+        if (l1.Configure(CreateFakeConfig(&parser, l1Config, &aliases))) {
+            return 2;
+        }
+        int id = l1.Connect(0);
+        Linkable* components[] = {&l1, &l2, &memory};
+
+        if (CacheTestRead(&l1, id, components, 3, 0x0)) return 3;
+        if (CacheTestRead(&l1, id, components, 3, 0x80)) return 4;
+        if (l1.Contains(0x0) || !l1.Contains(0x80)) return 5;
+        if (l2.GetNumBackInvalidations() != 1) return 6;
+    }
+
+    // With an exclusive L2, lines only get there when evicted from the L1,
+    // and leave it when the L1 asks for them again.
+    {
+        Cache l1, l2;
+        CacheTesterMemory memory;
+        Map<Linkable*> aliases;
+        yaml::Parser parser;
+        aliases.Insert("l2", &l2);
+        aliases.Insert("memory", &memory);
+        if (l2.Configure(CreateFakeConfig(&parser,
+                                          "nextLevel: *memory\n"
+                                          "size: 512\n"
+                                          "associativity: 2\n"
+                                          "inclusion: exclusive\n",
+                                          &aliases))) {
+            return 11;
+        }
+        if (l1.Configure(CreateFakeConfig(&parser, l1Config, &aliases))) {
+            return 12;
+        }
+        int id = l1.Connect(0);
+        Linkable* components[] = {&l1, &l2, &memory};
+
+        if (CacheTestRead(&l1, id, components, 3, 0x0)) return 13;
+        if (!l1.Contains(0x0) || l2.Contains(0x0)) return 14;
+        if (CacheTestRead(&l1, id, components, 3, 0x100)) return 15;
+        if (l1.Contains(0x0) || !l2.Contains(0x0)) return 16;
+        if (CacheTestRead(&l1, id, components, 3, 0x0)) return 17;
+        if (!l1.Contains(0x0) || l2.Contains(0x0)) return 18;
+        if (!l2.Contains(0x100)) return 19;
+        if (memory.numReads != 2 || l2.GetNumHits() != 1) return 20;
+    }
+
+    return 0;
+}
+
+int TestCachePrefetch() {
+    const char* config =
+        "nextLevel: *memory\n"
+        "size: 512\n"
+        "associativity: 2\n"
+        "mshrs: 4\n"
+        "prefetcher: nextline\n"
+        "prefetchDegree: 1\n"
+        "prefetchDistance: 1\n";
+
+    {
+        Cache cache;
+        CacheTesterMemory memory;
+        Map<Linkable*> aliases;
+        yaml::Parser parser;
+        aliases.Insert("memory", &memory);
+        if (cache.Configure(CreateFakeConfig(&parser, config, &aliases))) {
+            return 1;
+        }
+        int id = cache.Connect(0);
+        Linkable* components[] = {&cache, &memory};
+
+        // The miss brings the next line, whose first hit brings the one
+        // after it. Asking for that one in the next cycle merges in its MSHR.
+        if (CacheTestRead(&cache, id, components, 2, 0x0)) return 2;
+        if (!cache.Contains(0x40)) return 3;
+        MemoryPacket packet;
+        packet.instAddress = 0;
+        packet.type = MemoryPacketTypeRead;
+        packet.address = 0x40;
+        cache.SendRequest(id, &packet);
+        packet.address = 0x80;
+        cache.SendRequest(id, &packet);
+        CacheTestStepAll(components, 2, 20);
+        if (cache.GetNumUsefulPrefetches() != 1) return 4;
+        if (cache.GetNumLatePrefetches() != 1) return 5;
+        if (cache.GetNumPrefetches() != 3 || memory.numReads != 4) return 6;
+    }
+
+    {
+        Cache cache;
+        CacheTesterMemory memory;
+        Map<Linkable*> aliases;
+        yaml::Parser parser;
+        aliases.Insert("memory", &memory);
+        if (cache.Configure(CreateFakeConfig(&parser, config, &aliases))) {
+            return 11;
+        }
+        int id = cache.Connect(0);
+        Linkable* components[] = {&cache, &memory};
+
+        // 4 sets: 0x40, 0x140 and 0x240 share a set, so the prefetched 0x40
+        // is the LRU line when 0x240 arrives.
+        if (CacheTestRead(&cache, id, components, 2, 0x0)) return 12;
+        if (CacheTestRead(&cache, id, components, 2, 0x140)) return 13;
+        if (CacheTestRead(&cache, id, components, 2, 0x240)) return 14;
+        if (cache.Contains(0x40)) return 15;
+        if (cache.GetNumUselessPrefetches() != 1) return 16;
+        if (cache.GetNumUsefulPrefetches() != 0) return 17;
+    }
+
+    return 0;
+}
+
+#endif
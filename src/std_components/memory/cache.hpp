@@ -0,0 +1,290 @@
+#ifndef SINUCA3_CACHE_HPP_
+#define SINUCA3_CACHE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file cache.hpp
+ * @details Public API of the Cache, a non-blocking set-associative cache.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/mshr_file.hpp>
+#include <utils/prefetchers/prefetcher.hpp>
+
+#include "utils/circular_buffer.hpp"
+
+/** @brief Upper limit of the mshrs parameter, one bit per entry. */
+static const int CACHE_MAX_MSHRS = MSHR_FILE_MAX_ENTRIES;
+
+/** @brief What the Cache keeps for each line. */
+struct CacheBlock {
+    unsigned long lineAddress;
+    bool dirty;
+    bool prefetched; /**< Brought by a prefetch and not used yet. */
+};
+
+/** @brief How the lines of a Cache relate to the ones of the levels above. */
+enum CacheInclusion {
+    CacheInclusionNine, /**< Non-inclusive non-exclusive, no enforcement. */
+    CacheInclusionInclusive,
+    CacheInclusionExclusive
+};
+
+/** @brief A request and the connection it came from. */
+struct CacheTarget {
+    MemoryPacket packet;
+    int connectionID;
+};
+
+/**
+ * @details Cache is a non-blocking, write-back and write-allocate cache built
+ * on CacheMemory. Hits are answered hitLatency cycles after being processed.
+ * Misses allocate a MSHR (miss status holding register) and request the line
+ * to nextLevel; further misses to the same line are merged in the MSHR and
+ * all of them are answered when the line arrives. When every MSHR is busy, or
+ * the MSHR of the line has no free target, the request stalls and so do the
+ * ones behind it. Dirty lines are sent to nextLevel as WriteBack packets when
+ * evicted, and WriteBack packets received make the line dirty, allocating it
+ * without a fetch on a miss. Clean evictions are sent as Evict packets.
+ *
+ * The inclusion parameter sets how the cache relates to the levels connected
+ * to it:
+ * - nine: nothing is enforced, Evict packets are ignored.
+ * - inclusive: every line evicted is invalidated in the levels above with an
+ * Invalidate response on every connection. Write-backs of lines no longer
+ * present go straight to nextLevel.
+ * - exclusive: lines are only filled by evictions from above, a miss is
+ * answered without keeping the line and a hit moves the line up, writing it
+ * back first if dirty.
+ * Invalidate responses received from nextLevel drop the line and are
+ * forwarded up, so a inclusive level is enforced across all the levels above.
+ *
+ * A prefetcher (see utils/prefetchers/prefetcher.hpp) may be hosted. It sees
+ * every read and write and its candidates that are neither cached nor in a
+ * MSHR get a MSHR without targets, as long as another MSHR stays free for the
+ * demand misses. Prefetches are useful when a demand hits the line, late
+ * when a demand miss merges in their MSHR and useless when the line is
+ * evicted unused.
+ *
+ * It accepts the following parameters:
+ * - nextLevel (required): Component<MemoryPacket> the misses go to.
+ * - size (required): integer, capacity in bytes.
+ * - associativity (required): integer, ways per set.
+ * - lineSize: integer, bytes per line, 64 by default.
+ * - policy: string, replacement policy of CacheMemory, lru by default.
+ * - hitLatency: integer, 1 by default.
+ * - mshrs: integer from 1 to 64, outstanding misses, 8 by default.
+ * - mshrTargets: integer, requests merged per MSHR, 4 by default.
+ * - ports: integer, requests processed per cycle, 1 by default.
+ * - inclusion: string, nine (default), inclusive or exclusive.
+ * - prefetcher: string, none (default), nextline, ipstride or stream.
+ * - prefetchDegree: integer, lines prefetched per access, 2 by default.
+ * - prefetchDistance: integer, lines ahead of the access, 4 by default.
+ * - prefetchTable: integer, entries of the ipstride table (256 by default)
+ * or streams tracked (16 by default).
+ * - interleavedBanks: integer, power of two, 1 by default. Banks of the
+ * BankedCache this cache is a bank of. The bits that select the bank are left
+ * out of the set index and prefetches to the other banks are dropped.
+ * - interleaving: integer, power of two of at least lineSize, the interleaving
+ * of that BankedCache. lineSize by default.
+ */
+class Cache : public Component<MemoryPacket> {
+  private:
+    Component<MemoryPacket>* nextLevel;
+    CacheMemory<CacheBlock>* cache;
+    Prefetcher* prefetcher;
+    int nextLevelID;
+
+    long lineSize;
+    long hitLatency;
+    long ports;
+    long numMshrs;
+    long mshrTargets;
+    int bankShift;
+    int bankBits;
+    CacheInclusion inclusion;
+    unsigned long cycle;
+
+    CircularBuffer pendingRequests; /**< Requests not processed yet. */
+    CacheTarget stalledRequest;     /**< Head of pendingRequests. */
+    bool hasStalledRequest;
+
+    CompletionWheel<CacheTarget> hits; /**< Waiting for hitLatency. */
+    MshrFile<CacheTarget> mshrs;       /**< Keyed by line. */
+    unsigned long mshrDirty;    /**< A write or write-back is waiting. */
+    unsigned long mshrPrefetch; /**< No demand waits for the line yet. */
+
+    unsigned long numReads;
+    unsigned long numWrites;
+    unsigned long numWriteBacksReceived;
+    unsigned long numHits;
+    unsigned long numMisses;
+    unsigned long numMerges;
+    unsigned long numMshrFullStalls;
+    unsigned long numTargetFullStalls;
+    unsigned long numWriteBacks;
+    unsigned long numBackInvalidations;
+    unsigned long numInvalidationsReceived;
+    unsigned long numPrefetches;
+    unsigned long numUsefulPrefetches;
+    unsigned long numLatePrefetches;
+    unsigned long numUselessPrefetches;
+
+    inline unsigned long LineOf(unsigned long address) const {
+        return address & ~(unsigned long)(this->lineSize - 1);
+    }
+
+    /**
+     * @brief [address] as seen by the CacheMemory, without the bits that
+     * select the bank. They are the same in every line of the bank and would
+     * leave all but one of each interleavedBanks sets unused.
+     */
+    inline unsigned long SetAddress(unsigned long address) const {
+        unsigned long low = (1UL << this->bankShift) - 1;
+        return ((address >> this->bankBits) & ~low) | (address & low);
+    }
+
+    /** @brief Whether [a] and [b] map to the same bank. */
+    inline bool SameBank(unsigned long a, unsigned long b) const {
+        return (((a ^ b) >> this->bankShift) &
+                ((1UL << this->bankBits) - 1)) == 0;
+    }
+
+    /** @return 1 if the request must be retried in the next cycle. */
+    int ProcessRequest(CacheTarget* request);
+    void ProcessWriteBack(unsigned long line);
+    void ProcessEvict(unsigned long line);
+    void ProcessFill(unsigned long line);
+    void ProcessInvalidate(unsigned long line);
+    /** @brief Takes a free MSHR for [line] and requests it. */
+    int AllocateMshr(unsigned long line, unsigned long instAddress);
+    void Prefetch(unsigned long line, unsigned long instAddress, bool hit);
+    void Install(unsigned long line, bool dirty, bool prefetched);
+    void SendToNextLevel(unsigned long line, MemoryPacketType type);
+    void SendWriteBack(unsigned long line);
+    void BackInvalidate(unsigned long line);
+
+  public:
+    inline Cache()
+        : nextLevel(NULL),
+          cache(NULL),
+          prefetcher(NULL),
+          lineSize(64),
+          hitLatency(1),
+          ports(1),
+          numMshrs(8),
+          mshrTargets(4),
+          bankShift(0),
+          bankBits(0),
+          inclusion(CacheInclusionNine),
+          cycle(0),
+          hasStalledRequest(false),
+          mshrDirty(0),
+          mshrPrefetch(0),
+          numReads(0),
+          numWrites(0),
+          numWriteBacksReceived(0),
+          numHits(0),
+          numMisses(0),
+          numMerges(0),
+          numMshrFullStalls(0),
+          numTargetFullStalls(0),
+          numWriteBacks(0),
+          numBackInvalidations(0),
+          numInvalidationsReceived(0),
+          numPrefetches(0),
+          numUsefulPrefetches(0),
+          numLatePrefetches(0),
+          numUselessPrefetches(0) {}
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+    virtual ~Cache();
+
+    inline unsigned long GetNumHits() const { return this->numHits; }
+    inline unsigned long GetNumMisses() const { return this->numMisses; }
+    inline unsigned long GetNumMerges() const { return this->numMerges; }
+    inline unsigned long GetNumMshrFullStalls() const {
+        return this->numMshrFullStalls;
+    }
+    inline unsigned long GetNumWriteBacks() const {
+        return this->numWriteBacks;
+    }
+    inline unsigned long GetNumBackInvalidations() const {
+        return this->numBackInvalidations;
+    }
+    inline unsigned long GetNumPrefetches() const {
+        return this->numPrefetches;
+    }
+    inline unsigned long GetNumUsefulPrefetches() const {
+        return this->numUsefulPrefetches;
+    }
+    inline unsigned long GetNumLatePrefetches() const {
+        return this->numLatePrefetches;
+    }
+    inline unsigned long GetNumUselessPrefetches() const {
+        return this->numUselessPrefetches;
+    }
+    /** @brief Whether [address] is cached, without touching the policy. */
+    inline bool Contains(unsigned long address) const {
+        return this->cache->Peek(this->SetAddress(address)) != NULL;
+    }
+};
+
+#ifndef NDEBUG
+/** @brief Memory for the tests, answers reads and counts what it gets. */
+class CacheTesterMemory : public Component<MemoryPacket> {
+  public:
+    unsigned long numReads;
+    unsigned long numWriteBacks;
+    unsigned long lastWriteBack;
+
+    inline CacheTesterMemory()
+        : numReads(0), numWriteBacks(0), lastWriteBack(0) {}
+    virtual int Configure(Config config) {
+        (void)config;
+        return 0;
+    }
+    virtual void Clock() {
+        MemoryPacket packet;
+        long numberOfConnections = this->GetNumberOfConnections();
+        for (long i = 0; i < numberOfConnections; ++i) {
+            while (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+                if (packet.type == MemoryPacketTypeEvict) continue;
+                if (packet.type == MemoryPacketTypeWriteBack) {
+                    ++this->numWriteBacks;
+                    this->lastWriteBack = packet.address;
+                } else {
+                    ++this->numReads;
+                    this->SendResponseToConnection(i, &packet);
+                }
+            }
+        }
+    }
+    virtual void PrintStatistics() {}
+    virtual ~CacheTesterMemory() {}
+};
+
+int TestCache();
+int TestCacheInclusion();
+int TestCachePrefetch();
+#endif
+
+#endif  // SINUCA3_CACHE_HPP_
@@ -0,0 +1,615 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file dram_controller.cpp
+ * @brief Implementation of the DramController.
+ */
+
+#include "dram_controller.hpp"
+
+#include <cstring>
+#include <sinuca3.hpp>
+
+static inline bool IsPowerOfTwo(long value) {
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+int DramController::Configure(Config config) {
+    const char* mapping = "rowinterleaved";
+    const char* rowPolicy = "open";
+
+    if (config.Integer("channels", &this->numChannels)) return 1;
+    if (config.Integer("ranks", &this->numRanks)) return 1;
+    if (config.Integer("banks", &this->numBanks)) return 1;
+    if (config.Integer("rowSize", &this->rowSize)) return 1;
+    if (config.Integer("lineSize", &this->lineSize)) return 1;
+    if (config.String("mapping", &mapping)) return 1;
+    if (config.String("rowPolicy", &rowPolicy)) return 1;
+    if (config.Integer("tRCD", &this->tRCD)) return 1;
+    if (config.Integer("tCAS", &this->tCAS)) return 1;
+    if (config.Integer("tRP", &this->tRP)) return 1;
+    if (config.Integer("tRAS", &this->tRAS)) return 1;
+    if (config.Integer("tWR", &this->tWR)) return 1;
+    if (config.Integer("tBurst", &this->tBurst)) return 1;
+    if (config.Integer("tREFI", &this->tREFI)) return 1;
+    if (config.Integer("tRFC", &this->tRFC)) return 1;
+    if (config.Integer("readQueueSize", &this->readQueueSize)) return 1;
+    if (config.Integer("writeQueueSize", &this->writeQueueSize)) return 1;
+
+    if (!IsPowerOfTwo(this->numChannels)) {
+        return config.Error("channels", "should be a power of two");
+    }
+    if (!IsPowerOfTwo(this->numRanks)) {
+        return config.Error("ranks", "should be a power of two");
+    }
+    if (!IsPowerOfTwo(this->numBanks)) {
+        return config.Error("banks", "should be a power of two");
+    }
+    if (!IsPowerOfTwo(this->lineSize)) {
+        return config.Error("lineSize", "should be a power of two");
+    }
+    if (!IsPowerOfTwo(this->rowSize) || this->rowSize < this->lineSize) {
+        return config.Error("rowSize",
+                            "should be a power of two >= lineSize");
+    }
+    if (this->tRCD < 0 || this->tCAS < 0 || this->tRP < 0 || this->tRAS < 0 ||
+        this->tWR < 0 || this->tREFI < 0 || this->tRFC < 0) {
+        return config.Error("timings", "should be >= 0");
+    }
+    if (this->tBurst <= 0) return config.Error("tBurst", "should be > 0");
+    if (this->tREFI > 0 && this->tRFC >= this->tREFI) {
+        return config.Error("tRFC", "should be < tREFI");
+    }
+    if (this->readQueueSize <= 0) {
+        return config.Error("readQueueSize", "should be > 0");
+    }
+    if (this->writeQueueSize <= 0) {
+        return config.Error("writeQueueSize", "should be > 0");
+    }
+
+    if (strcmp(mapping, "rowinterleaved") == 0) {
+        this->mapping = DramMappingRowInterleaved;
+    } else if (strcmp(mapping, "lineinterleaved") == 0) {
+        this->mapping = DramMappingLineInterleaved;
+    } else if (strcmp(mapping, "permutation") == 0) {
+        this->mapping = DramMappingPermutation;
+    } else {
+        return config.Error("mapping",
+                            "should be rowinterleaved, lineinterleaved or "
+                            "permutation");
+    }
+    if (strcmp(rowPolicy, "open") == 0) {
+        this->closedRows = false;
+    } else if (strcmp(rowPolicy, "closed") == 0) {
+        this->closedRows = true;
+    } else {
+        return config.Error("rowPolicy", "should be open or closed");
+    }
+
+    this->lineBits = __builtin_ctzl(this->lineSize);
+    this->columnBits = __builtin_ctzl(this->rowSize / this->lineSize);
+    this->channelBits = __builtin_ctzl(this->numChannels);
+    this->rankBits = __builtin_ctzl(this->numRanks);
+    this->bankBits = __builtin_ctzl(this->numBanks);
+
+    long totalRanks = this->numChannels * this->numRanks;
+    long totalBanks = totalRanks * this->numBanks;
+    long perBank = this->readQueueSize + this->writeQueueSize;
+
+    this->channels = new DramChannel[this->numChannels];
+    for (long c = 0; c < this->numChannels; ++c) {
+        DramChannel* channel = &this->channels[c];
+        channel->responses.Allocate(0, sizeof(DramResponse));
+        channel->hasNextResponse = false;
+        channel->pendingRequests.Allocate(0, sizeof(DramRequest));
+        channel->hasStalledRequest = false;
+        channel->dataBusFree = 0;
+        channel->numReads = 0;
+        channel->numWrites = 0;
+        channel->draining = false;
+    }
+
+    // Refreshes are staggered, so the ranks are not all busy at once.
+    this->ranks = new DramRank[totalRanks];
+    for (long r = 0; r < totalRanks; ++r) {
+        this->ranks[r].nextRefresh =
+            this->tREFI + (this->tREFI * (r % this->numRanks)) / this->numRanks;
+        this->ranks[r].refreshPending = false;
+    }
+
+    // Any bank may get all the requests of its channel.
+    this->queueStorage = new DramRequest[totalBanks * perBank];
+    this->banks = new DramBank[totalBanks];
+    for (long b = 0; b < totalBanks; ++b) {
+        DramBank* bank = &this->banks[b];
+        DramRequest* storage = &this->queueStorage[b * perBank];
+        bank->queues[DramQueueRead].requests = storage;
+        bank->queues[DramQueueWrite].requests = storage + this->readQueueSize;
+        for (int kind = 0; kind < DramQueueKinds; ++kind) {
+            bank->queues[kind].size = 0;
+            bank->queues[kind].rowHits = 0;
+        }
+        bank->openRow = -1;
+        bank->nextActivate = 0;
+        bank->nextColumn = 0;
+        bank->nextPrecharge = 0;
+        bank->activated = false;
+    }
+
+    return 0;
+}
+
+int DramController::Decode(unsigned long address, unsigned long* row) const {
+    unsigned long line = address >> this->lineBits;
+    unsigned long channel;
+
+    if (this->mapping == DramMappingLineInterleaved) {
+        channel = line & (this->numChannels - 1);
+        line >>= this->channelBits + this->columnBits;
+    } else {
+        line >>= this->columnBits;
+        channel = line & (this->numChannels - 1);
+        line >>= this->channelBits;
+    }
+    unsigned long bank = line & (this->numBanks - 1);
+    line >>= this->bankBits;
+    unsigned long rank = line & (this->numRanks - 1);
+    *row = line >> this->rankBits;
+
+    // Rows that would conflict in a bank are spread over all of them.
+    if (this->mapping == DramMappingPermutation) {
+        bank ^= *row & (this->numBanks - 1);
+    }
+
+    return (channel * this->numRanks + rank) * this->numBanks + bank;
+}
+
+int DramController::Accept(DramRequest* request) {
+    DramChannel* channel =
+        &this->channels[request->bank / (this->numRanks * this->numBanks)];
+    if (this->KindOf(&request->packet) == DramQueueRead) {
+        if (channel->numReads == this->readQueueSize) return 1;
+        ++channel->numReads;
+    } else {
+        if (channel->numWrites == this->writeQueueSize) return 1;
+        ++channel->numWrites;
+    }
+    this->Enqueue(request);
+    return 0;
+}
+
+void DramController::Enqueue(DramRequest* request) {
+    DramBank* bank = &this->banks[request->bank];
+    DramBankQueue* queue = &bank->queues[this->KindOf(&request->packet)];
+    queue->requests[queue->size] = *request;
+    ++queue->size;
+    if ((long)request->row == bank->openRow) ++queue->rowHits;
+}
+
+void DramController::AcceptPending(long channelIndex) {
+    DramChannel* channel = &this->channels[channelIndex];
+    for (;;) {
+        if (!channel->hasStalledRequest) {
+            if (channel->pendingRequests.Dequeue(&channel->stalledRequest)) {
+                return;
+            }
+            channel->hasStalledRequest = true;
+        }
+        if (this->Accept(&channel->stalledRequest)) {
+            ++this->numQueueFullStalls;
+            return;
+        }
+        channel->hasStalledRequest = false;
+    }
+}
+
+void DramController::Activate(DramBank* bank, long row) {
+    bank->openRow = row;
+    bank->nextColumn = this->cycle + this->tRCD;
+    bank->nextPrecharge = this->cycle + this->tRAS;
+    bank->activated = true;
+
+    for (int kind = 0; kind < DramQueueKinds; ++kind) {
+        DramBankQueue* queue = &bank->queues[kind];
+        queue->rowHits = 0;
+        for (int i = 0; i < queue->size; ++i) {
+            if ((long)queue->requests[i].row == row) ++queue->rowHits;
+        }
+    }
+}
+
+void DramController::Precharge(DramBank* bank) {
+    bank->openRow = -1;
+    bank->nextActivate = this->cycle + this->tRP;
+    bank->queues[DramQueueRead].rowHits = 0;
+    bank->queues[DramQueueWrite].rowHits = 0;
+}
+
+void DramController::IssueColumn(long channel, DramBank* bank,
+                                 DramBankQueue* queue) {
+    int i = 0;
+    while ((long)queue->requests[i].row != bank->openRow) ++i;
+    DramRequest request = queue->requests[i];
+    --queue->size;
+    memmove(&queue->requests[i], &queue->requests[i + 1],
+            (queue->size - i) * sizeof(*queue->requests));
+    --queue->rowHits;
+
+    unsigned long end = this->cycle + this->tCAS + this->tBurst;
+    this->channels[channel].dataBusFree = end;
+    bank->nextColumn = this->cycle + this->tBurst;
+    if (!bank->activated) ++this->numRowHits;
+    bank->activated = false;
+
+    if (request.packet.type == MemoryPacketTypeRead) {
+        --this->channels[channel].numReads;
+        ++this->numReads;
+        this->totalReadLatency += end - request.arrival;
+    } else {
+        --this->channels[channel].numWrites;
+        ++this->numWrites;
+        if (bank->nextPrecharge < end + this->tWR) {
+            bank->nextPrecharge = end + this->tWR;
+        }
+    }
+
+    if (request.packet.type != MemoryPacketTypeWriteBack) {
+        DramResponse response;
+        response.ready = end;
+        response.packet = request.packet;
+        response.connectionID = request.connectionID;
+        this->channels[channel].responses.Enqueue(&response);
+    }
+
+    // Auto-precharge, which is not a command of its own.
+    if (this->closedRows && bank->queues[DramQueueRead].rowHits == 0 &&
+        bank->queues[DramQueueWrite].rowHits == 0) {
+        unsigned long precharge = this->cycle + this->tBurst;
+        if (precharge < bank->nextPrecharge) precharge = bank->nextPrecharge;
+        bank->openRow = -1;
+        bank->nextActivate = precharge + this->tRP;
+    }
+}
+
+int DramController::ScheduleRefresh(long channel) {
+    if (this->tREFI == 0) return 0;
+
+    for (long r = 0; r < this->numRanks; ++r) {
+        long rankIndex = channel * this->numRanks + r;
+        DramRank* rank = &this->ranks[rankIndex];
+        if (this->cycle >= rank->nextRefresh) rank->refreshPending = true;
+        if (!rank->refreshPending) continue;
+
+        DramBank* banks = &this->banks[rankIndex * this->numBanks];
+        bool ready = true;
+        for (long b = 0; b < this->numBanks; ++b) {
+            if (banks[b].openRow >= 0) {
+                if (this->cycle < banks[b].nextPrecharge) {
+                    ready = false;
+                    continue;
+                }
+                this->Precharge(&banks[b]);
+                return 1;
+            }
+            if (this->cycle < banks[b].nextActivate) ready = false;
+        }
+        if (!ready) continue;
+
+        for (long b = 0; b < this->numBanks; ++b) {
+            banks[b].nextActivate = this->cycle + this->tRFC;
+        }
+        rank->refreshPending = false;
+        rank->nextRefresh += this->tREFI;
+        ++this->numRefreshes;
+        return 1;
+    }
+
+    return 0;
+}
+
+void DramController::Schedule(long channelIndex) {
+    DramChannel* channel = &this->channels[channelIndex];
+    if (channel->draining) {
+        if (channel->numWrites <= this->writeQueueSize / 4 &&
+            channel->numReads > 0) {
+            channel->draining = false;
+        }
+    } else if (channel->numWrites >= (this->writeQueueSize * 3) / 4 ||
+               (channel->numReads == 0 && channel->numWrites > 0)) {
+        channel->draining = true;
+    }
+    int kind = channel->draining ? DramQueueWrite : DramQueueRead;
+
+    if (this->ScheduleRefresh(channelIndex)) return;
+
+    // One look at each bank: the oldest ready column command wins, then the
+    // oldest activate or precharge.
+    DramBank* columnBank = NULL;
+    DramBank* rowBank = NULL;
+    unsigned long columnArrival = 0;
+    unsigned long rowArrival = 0;
+    bool busReady = channel->dataBusFree <= this->cycle + this->tCAS;
+    long first = channelIndex * this->numRanks * this->numBanks;
+
+    for (long r = 0; r < this->numRanks; ++r) {
+        if (this->ranks[channelIndex * this->numRanks + r].refreshPending) {
+            continue;
+        }
+        DramBank* banks = &this->banks[first + r * this->numBanks];
+        for (long b = 0; b < this->numBanks; ++b) {
+            DramBank* bank = &banks[b];
+            DramBankQueue* queue = &bank->queues[kind];
+            if (queue->size == 0) continue;
+            unsigned long arrival = queue->requests[0].arrival;
+
+            if (queue->rowHits > 0) {
+                if (busReady && this->cycle >= bank->nextColumn &&
+                    (columnBank == NULL || arrival < columnArrival)) {
+                    columnBank = bank;
+                    columnArrival = arrival;
+                }
+            } else if (this->cycle >= ((bank->openRow < 0)
+                                           ? bank->nextActivate
+                                           : bank->nextPrecharge)) {
+                if (rowBank == NULL || arrival < rowArrival) {
+                    rowBank = bank;
+                    rowArrival = arrival;
+                }
+            }
+        }
+    }
+
+    if (columnBank != NULL) {
+        this->IssueColumn(channelIndex, columnBank,
+                          &columnBank->queues[kind]);
+    } else if (rowBank != NULL) {
+        if (rowBank->openRow < 0) {
+            ++this->numActivates;
+            this->Activate(rowBank, rowBank->queues[kind].requests[0].row);
+        } else {
+            ++this->numRowConflicts;
+            this->Precharge(rowBank);
+        }
+    }
+}
+
+void DramController::SendResponses(long channelIndex) {
+    DramChannel* channel = &this->channels[channelIndex];
+    for (;;) {
+        if (!channel->hasNextResponse) {
+            if (channel->responses.Dequeue(&channel->nextResponse)) return;
+            channel->hasNextResponse = true;
+        }
+        if (channel->nextResponse.ready > this->cycle) return;
+        this->SendResponseToConnection(channel->nextResponse.connectionID,
+                                       &channel->nextResponse.packet);
+        channel->hasNextResponse = false;
+    }
+}
+
+void DramController::Clock() {
+    long numberOfConnections = this->GetNumberOfConnections();
+    long banksPerChannel = this->numRanks * this->numBanks;
+    DramRequest request;
+    request.arrival = this->cycle;
+    for (long i = 0; i < numberOfConnections; ++i) {
+        while (this->ReceiveRequestFromConnection(i, &request.packet) == 0) {
+            if (request.packet.type == MemoryPacketTypeEvict) continue;
+            request.connectionID = i;
+            request.bank = this->Decode(request.packet.address, &request.row);
+            this->channels[request.bank / banksPerChannel]
+                .pendingRequests.Enqueue(&request);
+        }
+    }
+
+    for (long c = 0; c < this->numChannels; ++c) {
+        this->AcceptPending(c);
+        this->Schedule(c);
+        this->SendResponses(c);
+    }
+
+    ++this->cycle;
+}
+
+void DramController::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("DramController [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Reads: %lu\n", this->numReads);
+    SINUCA3_LOG_PRINTF("    Writes: %lu\n", this->numWrites);
+    SINUCA3_LOG_PRINTF("    Row hits: %lu\n", this->numRowHits);
+    SINUCA3_LOG_PRINTF("    Row empty: %lu\n", this->GetNumRowEmpty());
+    SINUCA3_LOG_PRINTF("    Row conflicts: %lu\n", this->numRowConflicts);
+    SINUCA3_LOG_PRINTF("    Refreshes: %lu\n", this->numRefreshes);
+    SINUCA3_LOG_PRINTF("    Queue full stalls: %lu\n",
+                       this->numQueueFullStalls);
+    if (this->numReads > 0) {
+        SINUCA3_LOG_PRINTF("    Average read latency: %.2f\n",
+                           (double)this->totalReadLatency / this->numReads);
+    }
+}
+
+DramController::~DramController() {
+    delete[] this->channels;
+    delete[] this->ranks;
+    delete[] this->banks;
+    delete[] this->queueStorage;
+}
+
+#ifndef NDEBUG
+
+/** @brief Reads [address] and returns the cycles until the response. */
+static long DramTestLatency(DramController* dram, int id,
+                            unsigned long address) {
+    MemoryPacket packet;
+    packet.address = address;
+    packet.type = MemoryPacketTypeRead;
+    dram->SendRequest(id, &packet);
+    for (long steps = 1; steps < 1000; ++steps) {
+        dram->Clock();
+        dram->PosClock();
+        if (dram->ReceiveResponse(id, &packet) == 0) return steps;
+    }
+    return -1;
+}
+
+static void DramTestIdle(DramController* dram, int steps) {
+    for (int i = 0; i < steps; ++i) {
+        dram->Clock();
+        dram->PosClock();
+    }
+}
+
+int TestDramController() {
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+
+    // Rows of 1KiB and 2 banks: 0x0, 0x40 share a row, 0x800 is another row
+    // of the same bank and 0x400 is in the other bank.
+    const char* timings =
+        "banks: 2\n"
+        "rowSize: 1024\n"
+        "tRCD: 10\n"
+        "tCAS: 20\n"
+        "tRP: 30\n"
+        "tRAS: 0\n"
+        "tBurst: 4\n"
+        "tREFI: 0\n";
+
+    {
+        DramController dram;
+        if (dram.Configure(CreateFakeConfig(&parser, timings, &aliases))) {
+            return 1;
+        }
+        int id = dram.Connect(0);
+
+        long empty = DramTestLatency(&dram, id, 0x0);
+        long hit = DramTestLatency(&dram, id, 0x40);
+        long conflict = DramTestLatency(&dram, id, 0x800);
+        long otherBank = DramTestLatency(&dram, id, 0x400);
+        if (hit != 20 + 4 + 2) return 2;
+        if (empty != hit + 10) return 3;
+        if (conflict != empty + 30) return 4;
+        if (otherBank != empty) return 5;
+        if (dram.GetNumRowHits() != 1 || dram.GetNumRowConflicts() != 1) {
+            return 6;
+        }
+
+        // The younger request to the open row goes first.
+        MemoryPacket packet;
+        packet.type = MemoryPacketTypeRead;
+        packet.address = 0x0;
+        dram.SendRequest(id, &packet);
+        packet.address = 0x840;
+        dram.SendRequest(id, &packet);
+        unsigned long order[2];
+        int received = 0;
+        for (int steps = 0; steps < 1000 && received < 2; ++steps) {
+            DramTestIdle(&dram, 1);
+            if (dram.ReceiveResponse(id, &packet) == 0) {
+                order[received++] = packet.address;
+            }
+        }
+        if (received != 2 || order[0] != 0x840 || order[1] != 0x0) return 7;
+    }
+
+    // Closed rows pay the activate even when the same row is reused.
+    {
+        DramController dram;
+        const char* closed = "rowPolicy: closed\n";
+        char content[256];
+        strcpy(content, timings);
+        strcat(content, closed);
+        if (dram.Configure(CreateFakeConfig(&parser, content, &aliases))) {
+            return 11;
+        }
+        int id = dram.Connect(0);
+
+        long first = DramTestLatency(&dram, id, 0x0);
+        DramTestIdle(&dram, 100);
+        if (DramTestLatency(&dram, id, 0x40) != first) return 12;
+        if (dram.GetNumRowHits() != 0) return 13;
+    }
+
+    // Refreshes happen every tREFI cycles, delaying the requests behind them.
+    {
+        DramController dram;
+        if (dram.Configure(CreateFakeConfig(&parser,
+                                            "tREFI: 100\n"
+                                            "tRFC: 50\n",
+                                            &aliases))) {
+            return 21;
+        }
+        int id = dram.Connect(0);
+
+        long idle = DramTestLatency(&dram, id, 0x0);
+        DramTestIdle(&dram, 1000 - idle);
+        if (dram.GetNumRefreshes() != 9) return 22;
+        // The request arrives a cycle after the tenth refresh starts.
+        if (DramTestLatency(&dram, id, 0x0) != idle + 50 - 1) return 23;
+    }
+
+    // A channel with full queues does not hold back requests to the others.
+    {
+        DramController dram;
+        char content[256];
+        strcpy(content, timings);
+        strcat(content, "channels: 2\nreadQueueSize: 1\n");
+        if (dram.Configure(CreateFakeConfig(&parser, content, &aliases))) {
+            return 41;
+        }
+        int id = dram.Connect(0);
+
+        // 0x0, 0x40 and 0x80 are in channel 0 and 0x400 in channel 1.
+        MemoryPacket packet;
+        packet.type = MemoryPacketTypeRead;
+        unsigned long addresses[] = {0x0, 0x40, 0x80, 0x400};
+        for (int i = 0; i < 4; ++i) {
+            packet.address = addresses[i];
+            dram.SendRequest(id, &packet);
+        }
+        long otherChannel = -1;
+        for (long steps = 1; steps < 1000 && otherChannel < 0; ++steps) {
+            DramTestIdle(&dram, 1);
+            while (dram.ReceiveResponse(id, &packet) == 0) {
+                if (packet.address == 0x400) otherChannel = steps;
+            }
+        }
+        if (otherChannel != 20 + 4 + 2 + 10) return 42;
+    }
+
+    // WriteBack packets are written but not answered.
+    {
+        DramController dram;
+        if (dram.Configure(CreateFakeConfig(&parser, timings, &aliases))) {
+            return 31;
+        }
+        int id = dram.Connect(0);
+        MemoryPacket packet;
+        packet.address = 0x0;
+        packet.type = MemoryPacketTypeWriteBack;
+        dram.SendRequest(id, &packet);
+        for (int steps = 0; steps < 200; ++steps) {
+            DramTestIdle(&dram, 1);
+            if (dram.ReceiveResponse(id, &packet) == 0) return 32;
+        }
+        if (DramTestLatency(&dram, id, 0x40) != 20 + 4 + 2) return 33;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef SINUCA3_DRAM_CONTROLLER_HPP_
+#define SINUCA3_DRAM_CONTROLLER_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+/**
+ * @file dram_controller.hpp
+ * @details Public API of the DramController, a cycle-level model of a DRAM
+ * memory controller and the devices behind it.
+ */
+
+#include <sinuca3.hpp>
+
+#include "utils/circular_buffer.hpp"
+
+/** @brief How DramController splits a line address among the devices. */
+enum DramMapping {
+    DramMappingRowInterleaved,  /**< row:rank:bank:channel:column */
+    DramMappingLineInterleaved, /**< row:rank:bank:column:channel */
+    DramMappingPermutation      /**< Row interleaved, bank ^= row. */
+};
+
+/** @brief A request waiting in a bank queue. */
+struct DramRequest {
+    MemoryPacket packet;
+    unsigned long row;
+    unsigned long arrival; /**< Cycle it entered the controller. */
+    int bank;              /**< Global index, decoded when received. */
+    int connectionID;
+};
+
+/** @brief Requests of one kind waiting for a bank, oldest first. */
+struct DramBankQueue {
+    DramRequest* requests;
+    int size;
+    int rowHits; /**< How many of them are to the open row. */
+};
+
+/** @brief Read and write queues of a bank. */
+enum DramQueueKind { DramQueueRead, DramQueueWrite, DramQueueKinds };
+
+struct DramBank {
+    DramBankQueue queues[DramQueueKinds];
+    long openRow; /**< -1 when precharged. */
+    unsigned long nextActivate;
+    unsigned long nextColumn;
+    unsigned long nextPrecharge;
+    bool activated; /**< No column command since the last activate. */
+};
+
+struct DramRank {
+    unsigned long nextRefresh;
+    bool refreshPending;
+};
+
+/** @brief A read whose data is on the bus. */
+struct DramResponse {
+    unsigned long ready;
+    MemoryPacket packet;
+    int connectionID;
+};
+
+struct DramChannel {
+    /** @brief Responses in the order their bursts end, which is the order
+     * they are scheduled, as the data bus is shared by the channel. */
+    CircularBuffer responses;
+    DramResponse nextResponse; /**< Head of responses. */
+    bool hasNextResponse;
+    CircularBuffer pendingRequests; /**< Waiting for room in a queue. */
+    DramRequest stalledRequest;     /**< Head of pendingRequests. */
+    bool hasStalledRequest;
+    unsigned long dataBusFree;
+    int numReads;  /**< In the read queues of the banks. */
+    int numWrites; /**< In the write queues of the banks. */
+    bool draining; /**< Writes are being scheduled instead of reads. */
+};
+
+/**
+ * @details DramController models the channels, ranks and banks of a DRAM
+ * memory, one command per channel per cycle. Every timing is in cycles of the
+ * controller.
+ *
+ * Requests go to per bank read and write queues, limited per channel by
+ * readQueueSize and writeQueueSize; when they are full, incoming requests
+ * wait in order in their channel, so a full channel does not hold back the
+ * others. Reads and writes are answered when their burst ends,
+ * WriteBack packets are not answered and Evict packets are ignored. Writes
+ * are only scheduled while the channel drains them: draining starts when the
+ * writes reach 3/4 of writeQueueSize or when there are no reads, and stops
+ * when they fall to 1/4 of it while reads wait.
+ *
+ * The scheduler is FR-FCFS (first ready, first come first served): a column
+ * command to an open row wins over activates and precharges, and between two
+ * banks the one with the oldest request wins. Each bank tracks how many of
+ * its requests hit the open row, so the scheduler only looks at each bank
+ * once per cycle and only walks the queue of the chosen bank.
+ *
+ * Each rank is refreshed every tREFI cycles: its banks are precharged and
+ * become unavailable for tRFC cycles.
+ *
+ * It accepts the following parameters:
+ * - channels: integer, power of two, 1 by default.
+ * - ranks: integer, power of two, ranks per channel, 1 by default.
+ * - banks: integer, power of two, banks per rank, 8 by default.
+ * - rowSize: integer, power of two, bytes per row of a bank, 8192 by default.
+ * - lineSize: integer, power of two, bytes per request, 64 by default.
+ * - mapping: string, rowinterleaved (default), lineinterleaved or
+ * permutation. See DramMapping.
+ * - rowPolicy: string, open (default) keeps rows open until another row is
+ * needed, closed precharges once no request to the row is waiting.
+ * - tRCD, tCAS, tRP, tRAS, tWR, tBurst: integers, 14, 14, 14, 33, 15 and 4
+ * by default.
+ * - tREFI, tRFC: integers, 7800 and 350 by default. tREFI 0 disables refresh.
+ * - readQueueSize, writeQueueSize: integers, per channel, 32 by default.
+ */
+class DramController : public Component<MemoryPacket> {
+  private:
+    DramChannel* channels;
+    DramRank* ranks; /**< [channels x ranks] */
+    DramBank* banks; /**< [channels x ranks x banks] */
+    DramRequest* queueStorage;
+
+    long numChannels;
+    long numRanks;
+    long numBanks;
+    long rowSize;
+    long lineSize;
+    DramMapping mapping;
+    bool closedRows;
+
+    long tRCD;
+    long tCAS;
+    long tRP;
+    long tRAS;
+    long tWR;
+    long tBurst;
+    long tREFI;
+    long tRFC;
+    long readQueueSize;
+    long writeQueueSize;
+
+    int lineBits;
+    int columnBits;
+    int channelBits;
+    int rankBits;
+    int bankBits;
+
+    unsigned long cycle;
+
+    unsigned long numReads;
+    unsigned long numWrites;
+    unsigned long numRowHits;
+    unsigned long numActivates;
+    unsigned long numRowConflicts; /**< Precharges to open another row. */
+    unsigned long numRefreshes;
+    unsigned long numQueueFullStalls;
+    unsigned long totalReadLatency;
+
+    /** @brief Global index of the bank of [address], sets [row]. */
+    int Decode(unsigned long address, unsigned long* row) const;
+    /** @return 1 if the request did not fit. */
+    int Accept(DramRequest* request);
+    void Enqueue(DramRequest* request);
+    void AcceptPending(long channel);
+    void Activate(DramBank* bank, long row);
+    void Precharge(DramBank* bank);
+    void IssueColumn(long channel, DramBank* bank, DramBankQueue* queue);
+    /** @return 1 if a command was issued. */
+    int ScheduleRefresh(long channel);
+    void Schedule(long channel);
+    void SendResponses(long channel);
+
+    inline DramQueueKind KindOf(const MemoryPacket* packet) const {
+        return (packet->type == MemoryPacketTypeRead) ? DramQueueRead
+                                                      : DramQueueWrite;
+    }
+
+  public:
+    inline DramController()
+        : channels(NULL),
+          ranks(NULL),
+          banks(NULL),
+          queueStorage(NULL),
+          numChannels(1),
+          numRanks(1),
+          numBanks(8),
+          rowSize(8192),
+          lineSize(64),
+          mapping(DramMappingRowInterleaved),
+          closedRows(false),
+          tRCD(14),
+          tCAS(14),
+          tRP(14),
+          tRAS(33),
+          tWR(15),
+          tBurst(4),
+          tREFI(7800),
+          tRFC(350),
+          readQueueSize(32),
+          writeQueueSize(32),
+          cycle(0),
+          numReads(0),
+          numWrites(0),
+          numRowHits(0),
+          numActivates(0),
+          numRowConflicts(0),
+          numRefreshes(0),
+          numQueueFullStalls(0),
+          totalReadLatency(0) {}
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+    virtual ~DramController();
+
+    inline unsigned long GetNumRowHits() const { return this->numRowHits; }
+    /** @brief Activates on banks that were already precharged. */
+    inline unsigned long GetNumRowEmpty() const {
+        return this->numActivates - this->numRowConflicts;
+    }
+    inline unsigned long GetNumRowConflicts() const {
+        return this->numRowConflicts;
+    }
+    inline unsigned long GetNumRefreshes() const { return this->numRefreshes; }
+    inline unsigned long GetNumReads() const { return this->numReads; }
+};
+
+#ifndef NDEBUG
+int TestDramController();
+#endif
+
+#endif  // SINUCA3_DRAM_CONTROLLER_HPP_
@@ -39,6 +39,8 @@ int iTLB::Configure(Config config) {
     // Optional
     if (config.String("policy", &tempStr_Policy)) return 1;
     if (config.Integer("pageSize", (long*)&this->pageSize)) return 1;
+    if (config.Integer("mshrs", &this->numMshrs)) return 1;
+    if (config.Integer("mshrTargets", &this->mshrTargets)) return 1;
 
     if (this->entries == 0) {
         SINUCA3_ERROR_PRINTF(
@@ -54,6 +56,16 @@ int iTLB::Configure(Config config) {
         return 1;
     }
 
+    if ((long)this->missPenalty < 0) {
+        return config.Error("missPenalty", "should be >= 0");
+    }
+    if (this->numMshrs <= 0 || this->numMshrs > ITLB_MAX_MSHRS) {
+        return config.Error("mshrs", "should be between 1 and 64");
+    }
+    if (this->mshrTargets <= 0) {
+        return config.Error("mshrTargets", "should be > 0");
+    }
+
     unsigned int numSets = this->entries / this->numWays;
     this->cache = CacheMemory<unsigned long>::fromNumSets(
         numSets, this->pageSize, this->numWays, tempStr_Policy);
@@ -64,16 +76,69 @@ int iTLB::Configure(Config config) {
 
     this->pendingRequests.Allocate(0, sizeof(struct TLBRequest));
 
+    this->missWheel.Allocate(this->missPenalty, 1);
+    this->mshrs.Allocate(this->numMshrs, this->mshrTargets);
+
+    return 0;
+}
+
+int iTLB::ProcessRequest(struct TLBRequest* request) {
+    // We dont have (and dont need) data to send back, so
+    // the same address is send back to to signal
+    // that the iTLB's operation has been completed.
+
+    // Read() returns NULL if it was a miss.
+    if (this->cache->Read(request->addr)) {
+        SINUCA3_DEBUG_PRINTF("%p: iTLB (%p) HIT Sending response!\n", this,
+                             (void*)request->addr);
+        this->SendResponseToConnection(request->id, &request->addr);
+        ++this->numHits;
+        return 0;
+    }
+
+    unsigned long page = request->addr / this->pageSize;
+    int mshr = this->mshrs.Find(page);
+    if (mshr >= 0) {
+        if (this->mshrs.IsFull(mshr)) {
+            ++this->numMshrFullStalls;
+            return 1;
+        }
+        ++this->numMerges;
+    } else {
+        if (this->mshrs.Free() == 0) {
+            ++this->numMshrFullStalls;
+            return 1;
+        }
+
+        SINUCA3_DEBUG_PRINTF("%p: iTLB (%p) MISS Waiting %lu cycles!\n", this,
+                             (void*)request->addr, this->missPenalty);
+        mshr = this->mshrs.Take(page);
+        this->missWheel.Schedule(this->cycle, &mshr);
+    }
+
+    this->mshrs.AddTarget(mshr, request);
+    ++this->numMisses;
     return 0;
 }
 
+void iTLB::CompleteMiss(int mshr) {
+    struct TLBRequest* targets = this->mshrs.GetTargets(mshr);
+    this->cache->Write(targets[0].addr, &targets[0].addr);
+
+    SINUCA3_DEBUG_PRINTF("%p: iTLB Waiting ended! Sending response\n", this);
+    for (int i = 0; i < this->mshrs.GetNumTargets(mshr); ++i) {
+        this->SendResponseToConnection(targets[i].id, &targets[i].addr);
+    }
+    this->mshrs.Release(mshr);
+}
+
 void iTLB::Clock() {
     SINUCA3_DEBUG_PRINTF("%p: iTLB Clock!\n", this);
 
     long numberOfConnections = this->GetNumberOfConnections();
     for (int id = 0; id < numberOfConnections; ++id) {
         struct TLBRequest newRequest;
-        if (this->ReceiveRequestFromConnection(id, &newRequest.addr) == 0) {
+        while (this->ReceiveRequestFromConnection(id, &newRequest.addr) == 0) {
             ++this->numberOfRequests;
             newRequest.id = id;
             this->pendingRequests.Enqueue(&newRequest);
@@ -82,53 +147,101 @@ void iTLB::Clock() {
         }
     }
 
-    /* If paying a miss penalty */
-    if (this->currentPenalty > 0) {
-        --this->currentPenalty;
+    // One request per cycle, hits are served under outstanding misses.
+    if (!this->hasStalledRequest &&
+        this->pendingRequests.Dequeue(&this->stalledRequest) == 0) {
+        this->hasStalledRequest = true;
+    }
+    if (this->hasStalledRequest &&
+        this->ProcessRequest(&this->stalledRequest) == 0) {
+        this->hasStalledRequest = false;
+    }
 
-        if (this->currentPenalty == 0) {
-            this->currentPenalty = NO_PENALTY;
-            SINUCA3_DEBUG_PRINTF("%p: iTLB Waiting ended! Sending response\n",
-                                 this);
-            this->SendResponseToConnection(this->curRequest.id,
-                                           &this->curRequest.addr);
-        }
+    int numDue;
+    int* misses = this->missWheel.Complete(this->cycle, &numDue);
+    for (int i = 0; i < numDue; ++i) this->CompleteMiss(misses[i]);
 
-        return;
-    }
+    ++this->cycle;
+}
 
-    struct TLBRequest request;
-    if (this->pendingRequests.Dequeue(&request)) {
-        SINUCA3_DEBUG_PRINTF("%p: iTLB No work avaliable: Stall.\n", this);
-        return;
-    }
-    this->curRequest = request;
+void iTLB::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("iTLB [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Requests: %u\n", this->numberOfRequests);
+    SINUCA3_LOG_PRINTF("    Hits: %lu\n", this->numHits);
+    SINUCA3_LOG_PRINTF("    Misses: %lu\n", this->numMisses);
+    SINUCA3_LOG_PRINTF("    Miss merges: %lu\n", this->numMerges);
+    SINUCA3_LOG_PRINTF("    Miss table full stalls: %lu\n",
+                       this->numMshrFullStalls);
+    SINUCA3_LOG_PRINTF("    Evictions: %lu\n", this->cache->getStatEvaction());
+}
 
-    // We dont have (and dont need) data to send back, so
-    // the same address is send back to to signal
-    // that the iTLB's operation has been completed.
+iTLB::~iTLB() {
+    delete this->cache;
+}
 
-    // Read() returns NULL if it was a miss.
-    if (this->cache->Read(this->curRequest.addr)) {
-        SINUCA3_DEBUG_PRINTF("%p: iTLB (%p) HIT Sending response!\n", this,
-                             (void*)this->curRequest.addr);
-        this->SendResponseToConnection(this->curRequest.id,
-                                       &this->curRequest.addr);
-    } else {
-        SINUCA3_DEBUG_PRINTF("%p: iTLB (%p) MISS Waiting %lu cycles!\n", this,
-                             (void*)this->curRequest.addr, this->missPenalty);
-        this->currentPenalty = this->missPenalty;
-        this->cache->Write(this->curRequest.addr, &this->curRequest.addr);
+#ifndef NDEBUG
+
+/** @brief Runs [itlb] until [count] responses arrive or [maxSteps] pass. */
+static int ItlbTestRun(iTLB* itlb, int id, Address* responses, int count,
+                       int maxSteps) {
+    int received = 0;
+    int steps = 0;
+    for (; steps < maxSteps && received < count; ++steps) {
+        itlb->Clock();
+        itlb->PosClock();
+        while (received < count &&
+               itlb->ReceiveResponse(id, &responses[received]) == 0) {
+            ++received;
+        }
     }
-
-    return;
+    return (received == count) ? steps : -1;
 }
 
-void iTLB::PrintStatistics() {
-    SINUCA3_DEBUG_PRINTF(
-        "%p: iTLB Stats:\n\tMiss: %lu\n\tHit: %lu\n\tAcces: "
-        "%lu\n\tEvaction: %lu\n\tValidProp: %.3f\n",
-        this, this->cache->getStatMiss(), this->cache->getStatHit(),
-        this->cache->getStatAcess(), this->cache->getStatEvaction(),
-        this->cache->getStatValidProp());
+int TestItlb() {
+    iTLB itlb;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    if (itlb.Configure(CreateFakeConfig(&parser,
+                                        "entries: 16\n"
+                                        "associativity: 4\n"
+                                        "missPenalty: 10\n"
+                                        "mshrs: 2\n",
+                                        &aliases))) {
+        return 1;
+    }
+    int id = itlb.Connect(0);
+    Address responses[4];
+
+    // A miss takes missPenalty cycles more than a hit.
+    Address address = 0x1000;
+    itlb.SendRequest(id, &address);
+    int missSteps = ItlbTestRun(&itlb, id, responses, 1, 100);
+    itlb.SendRequest(id, &address);
+    int hitSteps = ItlbTestRun(&itlb, id, responses, 1, 100);
+    if (missSteps < 0 || hitSteps < 0) return 2;
+    if (missSteps != hitSteps + 10) return 3;
+
+    // Two misses to a page are merged and a hit is served under them.
+    Address addresses[] = {0x5000, 0x5040, 0x1008};
+    for (int i = 0; i < 3; ++i) itlb.SendRequest(id, &addresses[i]);
+    if (ItlbTestRun(&itlb, id, responses, 3, 100) < 0) return 4;
+    if (responses[0] != 0x1008 || responses[1] != 0x5000 ||
+        responses[2] != 0x5040) {
+        return 5;
+    }
+    if (itlb.GetNumMerges() != 1 || itlb.GetNumMisses() != 3) return 6;
+
+    // Misses to different pages overlap, a third one waits for a free
+    // entry.
+    Address pages[] = {0x10000, 0x20000, 0x30000};
+    for (int i = 0; i < 3; ++i) itlb.SendRequest(id, &pages[i]);
+    int steps = ItlbTestRun(&itlb, id, responses, 2, 100);
+    if (steps != missSteps + 1) return 7;
+    if (ItlbTestRun(&itlb, id, responses, 1, 100) < 0) return 8;
+    if (responses[0] != 0x30000) return 9;
+    if (itlb.GetNumHits() != 2) return 10;
+
+    return 0;
 }
+
+#endif
@@ -20,11 +20,22 @@
 
 /**
  * @file itlb.hpp
- * @details Implementation of a instruction TLB.
+ * @details Implementation of a instruction TLB. Misses are kept in a small
+ * miss table keyed by page, so misses to the same page are merged and hits
+ * are served while misses are outstanding. A miss completes missPenalty
+ * cycles after it is allocated, tracked by a wheel indexed by the cycle.
+ *
+ * Parameters:
+ * - entries, associativity, missPenalty: integers, required.
+ * - policy: string, replacement policy of CacheMemory, lru by default.
+ * - pageSize: integer, 4096 by default.
+ * - mshrs: integer from 1 to 64, outstanding misses, 4 by default.
+ * - mshrTargets: integer, requests merged per miss, 4 by default.
  */
 
 #include <sinuca3.hpp>
 #include <utils/cache/cacheMemory.hpp>
+#include <utils/mshr_file.hpp>
 
 #include "config/config.hpp"
 #include "engine/component.hpp"
@@ -32,7 +43,7 @@
 
 typedef unsigned long Address;
 
-static const int NO_PENALTY = -1;
+static const int ITLB_MAX_MSHRS = MSHR_FILE_MAX_ENTRIES;
 
 struct TLBRequest {
     int id;
@@ -46,15 +57,28 @@ class iTLB : public Component<Address> {
           entries(0),
           numWays(0),
           pageSize(4096),
-          currentPenalty(NO_PENALTY),
           missPenalty(0),
+          numMshrs(4),
+          mshrTargets(4),
+          cycle(0),
+          hasStalledRequest(false),
+          numHits(0),
+          numMisses(0),
+          numMerges(0),
+          numMshrFullStalls(0),
           cache(NULL) {};
-    virtual ~iTLB() {};
+    virtual ~iTLB();
 
     virtual int Configure(Config config);
     virtual void Clock();
     virtual void PrintStatistics();
 
+#ifndef NDEBUG
+    inline unsigned long GetNumHits() const { return this->numHits; }
+    inline unsigned long GetNumMisses() const { return this->numMisses; }
+    inline unsigned long GetNumMerges() const { return this->numMerges; }
+#endif
+
   private:
     unsigned int numberOfRequests;
 
@@ -62,17 +86,36 @@ class iTLB : public Component<Address> {
     unsigned long numWays;
     unsigned long pageSize;  // default 4 KiB
 
-    long currentPenalty; /**< Counter to control the paying of penalties >*/
-    unsigned long missPenalty; /**< Amount of cycles to idle when a
-                                  miss happens >*/
-
-    struct TLBRequest
-        curRequest; /**< Address currently being processed by the iTLB >*/
+    unsigned long missPenalty; /**< Cycles until a miss is answered. >*/
+    long numMshrs;
+    long mshrTargets;
+    unsigned long cycle;
 
     CircularBuffer pendingRequests; /**< Stores requests that have not yet been
                                        processed. >*/
+    struct TLBRequest stalledRequest; /**< Head of pendingRequests. >*/
+    bool hasStalledRequest;
+
+    /** @brief The miss table entries completing missPenalty cycles after
+     * they are taken. At most one request is processed per cycle, so one
+     * miss per cycle is enough. */
+    CompletionWheel<int> missWheel;
+    MshrFile<struct TLBRequest> mshrs; /**< Keyed by page. */
+
+    unsigned long numHits;
+    unsigned long numMisses;
+    unsigned long numMerges;
+    unsigned long numMshrFullStalls;
 
     CacheMemory<Address>* cache;
+
+    /** @return 1 if the request must be retried in the next cycle. */
+    int ProcessRequest(struct TLBRequest* request);
+    void CompleteMiss(int mshr);
 };
 
+#ifndef NDEBUG
+int TestItlb();
+#endif
+
 #endif
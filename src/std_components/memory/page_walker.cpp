@@ -0,0 +1,188 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file page_walker.cpp
+ * @brief Implementation of the PageWalker.
+ */
+
+#include "page_walker.hpp"
+
+#include <sinuca3.hpp>
+
+/** @brief Bits below the ones that index each level. */
+static const int LEVEL_SHIFT[PageWalkLevels] = {39, 30, 21, 12};
+
+int PageWalker::Configure(Config config) {
+    const char* names[PageWalkLevelPt] = {"pml4CacheEntries",
+                                          "pdptCacheEntries", "pdCacheEntries"};
+    long entries[PageWalkLevelPt] = {2, 4, 32};
+
+    if (config.ComponentReference("memory", &this->memory, true)) return 1;
+    if (config.Integer("walks", &this->numWalks)) return 1;
+    if (config.Integer("largePageRatio", &this->largePageRatio)) return 1;
+    for (int level = 0; level < PageWalkLevelPt; ++level) {
+        if (config.Integer(names[level], &entries[level])) return 1;
+    }
+
+    if (this->numWalks <= 0 || this->numWalks > PAGE_WALKER_MAX_WALKS) {
+        return config.Error("walks", "should be between 1 and 64");
+    }
+    if (this->largePageRatio < 0 || this->largePageRatio > 100) {
+        return config.Error("largePageRatio", "should be between 0 and 100");
+    }
+    for (int level = 0; level < PageWalkLevelPt; ++level) {
+        if (entries[level] < 0 || entries[level] > maxNumWays) {
+            return config.Error(names[level], "should be between 0 and 64");
+        }
+        if (entries[level] == 0) continue;
+        // Fully associative, the tag is the part of the address walked.
+        this->walkCaches[level] = CacheMemory<unsigned long>::fromBits(
+            0, LEVEL_SHIFT[level], entries[level], "lru");
+        if (this->walkCaches[level] == NULL) {
+            SINUCA3_ERROR_PRINTF("PageWalker: Failed to alocate CacheMemory\n");
+            return 1;
+        }
+    }
+
+    this->memoryID = this->memory->Connect(0);
+    this->walks = new PageWalk[this->numWalks];
+    this->pendingRequests.Allocate(0, sizeof(PageWalk));
+
+    return 0;
+}
+
+bool PageWalker::IsLargePage(unsigned long address) const {
+    if (this->largePageRatio == 0) return false;
+    unsigned long hash = (address >> 21) * 0x9e3779b97f4a7c15UL;
+    return (long)((hash >> 32) % 100) < this->largePageRatio;
+}
+
+void PageWalker::Read(PageWalk* walk) {
+    MemoryPacket packet;
+    packet.address = EntryAddress(walk->level, walk->packet.address);
+    packet.instAddress = 0;
+    packet.type = MemoryPacketTypeRead;
+    walk->pending = packet.address;
+    this->memory->SendRequest(this->memoryID, &packet);
+    ++this->numEntriesRead;
+}
+
+void PageWalker::Start(PageWalk* walk) {
+    unsigned long address = walk->packet.address;
+    walk->packet.largePage = this->IsLargePage(address);
+    walk->start = this->cycle;
+    walk->level = PageWalkLevelPml4;
+
+    // The deepest entry cached is where the walk starts. Large pages have no
+    // PT, so their PD entries are never cached.
+    for (int level = PageWalkLevelPd; level >= 0; --level) {
+        if (this->walkCaches[level] != NULL &&
+            this->walkCaches[level]->Read(address) != NULL) {
+            ++this->numWalkCacheHits[level];
+            walk->level = level + 1;
+            break;
+        }
+    }
+
+    ++this->numRequests;
+    if (walk->packet.largePage) ++this->numLargePages;
+    this->Read(walk);
+}
+
+void PageWalker::Advance(PageWalk* walk) {
+    unsigned long address = walk->packet.address;
+    bool leaf = walk->level == PageWalkLevelPt ||
+                (walk->level == PageWalkLevelPd && walk->packet.largePage);
+
+    if (!leaf) {
+        if (this->walkCaches[walk->level] != NULL) {
+            this->walkCaches[walk->level]->Write(address, &walk->pending);
+        }
+        ++walk->level;
+        this->Read(walk);
+        return;
+    }
+
+    this->totalWalkLatency += this->cycle - walk->start;
+    this->SendResponseToConnection(walk->connectionID, &walk->packet);
+    this->activeWalks &= ~(1UL << (walk - this->walks));
+}
+
+void PageWalker::Clock() {
+    MemoryPacket response;
+    while (this->memory->ReceiveResponse(this->memoryID, &response) == 0) {
+        if (response.type != MemoryPacketTypeRead) continue;
+        unsigned long active = this->activeWalks;
+        while (active != 0) {
+            PageWalk* walk = &this->walks[__builtin_ctzl(active)];
+            active &= active - 1;
+            if (walk->pending == response.address) {
+                this->Advance(walk);
+                break;
+            }
+        }
+    }
+
+    long numberOfConnections = this->GetNumberOfConnections();
+    PageWalk request;
+    for (long i = 0; i < numberOfConnections; ++i) {
+        while (this->ReceiveRequestFromConnection(i, &request.packet) == 0) {
+            request.connectionID = i;
+            this->pendingRequests.Enqueue(&request);
+        }
+    }
+
+    unsigned long allWalks = (this->numWalks == PAGE_WALKER_MAX_WALKS)
+                                 ? ~0UL
+                                 : (1UL << this->numWalks) - 1;
+    unsigned long freeWalks = ~this->activeWalks & allWalks;
+    while (freeWalks != 0) {
+        int index = __builtin_ctzl(freeWalks);
+        PageWalk* walk = &this->walks[index];
+        if (this->pendingRequests.Dequeue(walk)) break;
+        freeWalks &= freeWalks - 1;
+        this->activeWalks |= 1UL << index;
+        this->Start(walk);
+    }
+
+    ++this->cycle;
+}
+
+void PageWalker::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("PageWalker [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Walks: %lu\n", this->numRequests);
+    SINUCA3_LOG_PRINTF("    Large pages: %lu\n", this->numLargePages);
+    SINUCA3_LOG_PRINTF("    Entries read: %lu\n", this->numEntriesRead);
+    SINUCA3_LOG_PRINTF("    PML4 cache hits: %lu\n",
+                       this->numWalkCacheHits[PageWalkLevelPml4]);
+    SINUCA3_LOG_PRINTF("    PDPT cache hits: %lu\n",
+                       this->numWalkCacheHits[PageWalkLevelPdpt]);
+    SINUCA3_LOG_PRINTF("    PD cache hits: %lu\n",
+                       this->numWalkCacheHits[PageWalkLevelPd]);
+    if (this->numRequests > 0) {
+        SINUCA3_LOG_PRINTF("    Average walk latency: %.2f\n",
+                           (double)this->totalWalkLatency / this->numRequests);
+    }
+}
+
+PageWalker::~PageWalker() {
+    for (int level = 0; level < PageWalkLevelPt; ++level) {
+        delete this->walkCaches[level];
+    }
+    delete[] this->walks;
+}
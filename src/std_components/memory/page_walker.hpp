@@ -0,0 +1,143 @@
+#ifndef SINUCA3_PAGE_WALKER_HPP_
+#define SINUCA3_PAGE_WALKER_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+/**
+ * @file page_walker.hpp
+ * @details Public API of the PageWalker, which walks x86-64 4-level page
+ * tables through the cache hierarchy.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/cache/cacheMemory.hpp>
+
+#include "utils/circular_buffer.hpp"
+
+/** @brief Levels of the page table, in the order they are walked. */
+enum PageWalkLevel {
+    PageWalkLevelPml4,
+    PageWalkLevelPdpt,
+    PageWalkLevelPd,
+    PageWalkLevelPt,
+    PageWalkLevels
+};
+
+/** @brief Upper limit of the walks parameter. */
+static const long PAGE_WALKER_MAX_WALKS = 64;
+/** @brief The page tables live above any virtual address of a trace. */
+static const unsigned long PAGE_TABLE_BASE = 1UL << 52;
+
+struct PageWalk {
+    TranslationPacket packet;
+    unsigned long pending; /**< Entry being read. */
+    unsigned long start;
+    int connectionID;
+    int level; /**< PageWalkLevel being read. */
+};
+
+/**
+ * @details PageWalker answers TranslationPackets by walking a 4-level x86-64
+ * page table. Each level read is a MemoryPacket sent to memory, usually a
+ * cache, at a deterministic address: the table of a level is identified by
+ * the bits of the virtual address above the ones that index it, so nearby
+ * pages share the lines of their entries.
+ *
+ * Page-walk caches keep the PML4, PDPT and PD entries read, so a walk starts
+ * at the deepest level it finds: a PD cache hit only reads the PT entry.
+ * They are fully associative CacheMemory instances indexed by the bits of the
+ * virtual address that lead to each entry.
+ *
+ * Since traces carry no page table, the 2 MiB regions mapped by large pages
+ * are chosen by a hash of the region, with probability largePageRatio. Their
+ * walks end at the PD entry.
+ *
+ * It accepts the following parameters:
+ * - memory (required): Component<MemoryPacket> the entries are read from.
+ * - walks: integer from 1 to 64, walks in parallel, 4 by default.
+ * - pml4CacheEntries, pdptCacheEntries, pdCacheEntries: integers from 0
+ * (disabled) to 64, 2, 4 and 32 by default.
+ * - largePageRatio: integer, percentage of the 2 MiB regions mapped by large
+ * pages, 0 by default.
+ */
+class PageWalker : public Component<TranslationPacket> {
+  private:
+    Component<MemoryPacket>* memory;
+    int memoryID;
+    /** @brief Indexed by PageWalkLevel, none for the PT. */
+    CacheMemory<unsigned long>* walkCaches[PageWalkLevelPt];
+
+    PageWalk* walks;
+    unsigned long activeWalks; /**< Bit per walk in progress. */
+    long numWalks;
+    long largePageRatio;
+    unsigned long cycle;
+
+    CircularBuffer pendingRequests; /**< Waiting for a free walk. */
+
+    unsigned long numRequests;
+    unsigned long numLargePages;
+    unsigned long numEntriesRead;
+    unsigned long numWalkCacheHits[PageWalkLevelPt];
+    unsigned long totalWalkLatency;
+
+    /** @brief Address of the entry of [level] that maps [address]. */
+    static inline unsigned long EntryAddress(int level,
+                                             unsigned long address) {
+        int indexShift = 39 - 9 * level;
+        unsigned long table = address >> (indexShift + 9);
+        unsigned long index = (address >> indexShift) & 511;
+        return PAGE_TABLE_BASE + ((unsigned long)level << 48) + (table << 12) +
+               index * 8;
+    }
+
+    bool IsLargePage(unsigned long address) const;
+    void Start(PageWalk* walk);
+    void Read(PageWalk* walk);
+    void Advance(PageWalk* walk);
+
+  public:
+    inline PageWalker()
+        : memory(NULL),
+          walks(NULL),
+          activeWalks(0),
+          numWalks(4),
+          largePageRatio(0),
+          cycle(0),
+          numRequests(0),
+          numLargePages(0),
+          numEntriesRead(0),
+          totalWalkLatency(0) {
+        for (int level = 0; level < PageWalkLevelPt; ++level) {
+            this->walkCaches[level] = NULL;
+            this->numWalkCacheHits[level] = 0;
+        }
+    }
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+    virtual ~PageWalker();
+
+    inline unsigned long GetNumEntriesRead() const {
+        return this->numEntriesRead;
+    }
+    inline unsigned long GetNumRequests() const { return this->numRequests; }
+};
+
+#endif  // SINUCA3_PAGE_WALKER_HPP_
@@ -33,9 +33,12 @@ void SimpleMemory::Clock() {
     long numberOfConnections = this->GetNumberOfConnections();
     MemoryPacket packet;
     for (long i = 0; i < numberOfConnections; ++i) {
-        if (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+        while (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+            if (packet.type == MemoryPacketTypeEvict) continue;
             ++this->numberOfRequests;
-            this->SendResponseToConnection(i, &packet);
+            if (packet.type != MemoryPacketTypeWriteBack) {
+                this->SendResponseToConnection(i, &packet);
+            }
         }
     }
 }
@@ -0,0 +1,335 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file tlb.cpp
+ * @brief Implementation of the TLB.
+ */
+
+#include "tlb.hpp"
+
+#include <sinuca3.hpp>
+
+#ifndef NDEBUG
+#include <std_components/memory/cache.hpp>
+#include <std_components/memory/page_walker.hpp>
+#endif  // NDEBUG
+
+int TLB::Configure(Config config) {
+    long entries = 0;
+    long associativity = 0;
+    long largeEntries = 0;
+    long largeAssociativity = 4;
+    const char* policy = "lru";
+
+    if (config.ComponentReference("nextLevel", &this->nextLevel, true))
+        return 1;
+    if (config.Integer("entries", &entries, true)) return 1;
+    if (config.Integer("associativity", &associativity, true)) return 1;
+    if (config.Integer("largeEntries", &largeEntries)) return 1;
+    if (config.Integer("largeAssociativity", &largeAssociativity)) return 1;
+    if (config.String("policy", &policy)) return 1;
+    if (config.Integer("hitLatency", &this->hitLatency)) return 1;
+    if (config.Integer("mshrs", &this->numMshrs)) return 1;
+    if (config.Integer("mshrTargets", &this->mshrTargets)) return 1;
+    if (config.Integer("ports", &this->ports)) return 1;
+
+    if (associativity <= 0) {
+        return config.Error("associativity", "should be > 0");
+    }
+    if (entries <= 0 || entries % associativity) {
+        return config.Error("entries",
+                            "should be a positive multiple of associativity");
+    }
+    if (largeEntries < 0) {
+        return config.Error("largeEntries", "should be >= 0");
+    }
+    if (largeEntries > 0 &&
+        (largeAssociativity <= 0 || largeEntries % largeAssociativity)) {
+        return config.Error("largeAssociativity",
+                            "should be > 0 and divide largeEntries");
+    }
+    if (this->hitLatency < 0) {
+        return config.Error("hitLatency", "should be >= 0");
+    }
+    if (this->numMshrs <= 0 || this->numMshrs > TLB_MAX_MSHRS) {
+        return config.Error("mshrs", "should be between 1 and 64");
+    }
+    if (this->mshrTargets <= 0) {
+        return config.Error("mshrTargets", "should be > 0");
+    }
+    if (this->ports <= 0) return config.Error("ports", "should be > 0");
+
+    this->pages = CacheMemory<unsigned long>::fromNumSets(
+        entries / associativity, 1 << TLB_PAGE_BITS, associativity, policy);
+    if (this->pages == NULL) {
+        SINUCA3_ERROR_PRINTF("TLB: Failed to alocate CacheMemory\n");
+        return 1;
+    }
+    if (largeEntries > 0) {
+        this->largePages = CacheMemory<unsigned long>::fromNumSets(
+            largeEntries / largeAssociativity, 1 << TLB_LARGE_PAGE_BITS,
+            largeAssociativity, policy);
+        if (this->largePages == NULL) {
+            SINUCA3_ERROR_PRINTF("TLB: Failed to alocate CacheMemory\n");
+            return 1;
+        }
+    }
+
+    this->nextLevelID = this->nextLevel->Connect(0);
+    this->pendingRequests.Allocate(0, sizeof(TLBTarget));
+
+    this->hits.Allocate(this->hitLatency, this->ports);
+    this->mshrs.Allocate(this->numMshrs, this->mshrTargets);
+
+    return 0;
+}
+
+int TLB::ProcessRequest(TLBTarget* request) {
+    unsigned long address = request->packet.address;
+    unsigned long page = address >> TLB_PAGE_BITS;
+
+    bool hit = this->pages->Read(address) != NULL;
+    request->packet.largePage = false;
+    if (!hit && this->largePages != NULL &&
+        this->largePages->Read(address) != NULL) {
+        hit = true;
+        request->packet.largePage = true;
+        ++this->numLargeHits;
+    }
+
+    if (hit) {
+        this->hits.Schedule(this->cycle, request);
+        ++this->numHits;
+    } else {
+        int mshr = this->mshrs.Find(page);
+        if (mshr >= 0) {
+            if (this->mshrs.IsFull(mshr)) {
+                ++this->numMshrFullStalls;
+                return 1;
+            }
+            ++this->numMerges;
+        } else {
+            if (this->mshrs.Free() == 0) {
+                ++this->numMshrFullStalls;
+                return 1;
+            }
+            mshr = this->mshrs.Take(page);
+            this->nextLevel->SendRequest(this->nextLevelID, &request->packet);
+        }
+
+        this->mshrs.AddTarget(mshr, request);
+        ++this->numMisses;
+    }
+
+    ++this->numAccesses;
+    return 0;
+}
+
+void TLB::ProcessFill(TranslationPacket* response) {
+    int mshr = this->mshrs.Find(response->address >> TLB_PAGE_BITS);
+    if (mshr < 0) return;
+
+    unsigned long page = response->address >> TLB_PAGE_BITS;
+    if (response->largePage && this->largePages != NULL) {
+        this->largePages->Write(response->address, &page);
+    } else {
+        this->pages->Write(response->address, &page);
+    }
+
+    TLBTarget* targets = this->mshrs.GetTargets(mshr);
+    for (int i = 0; i < this->mshrs.GetNumTargets(mshr); ++i) {
+        targets[i].packet.largePage = response->largePage;
+        this->SendResponseToConnection(targets[i].connectionID,
+                                       &targets[i].packet);
+    }
+    this->mshrs.Release(mshr);
+}
+
+void TLB::Clock() {
+    TranslationPacket response;
+    while (this->nextLevel->ReceiveResponse(this->nextLevelID, &response) ==
+           0) {
+        this->ProcessFill(&response);
+    }
+
+    long numberOfConnections = this->GetNumberOfConnections();
+    TLBTarget request;
+    for (long i = 0; i < numberOfConnections; ++i) {
+        while (this->ReceiveRequestFromConnection(i, &request.packet) == 0) {
+            request.connectionID = i;
+            this->pendingRequests.Enqueue(&request);
+        }
+    }
+
+    for (long port = 0; port < this->ports; ++port) {
+        if (!this->hasStalledRequest) {
+            if (this->pendingRequests.Dequeue(&this->stalledRequest)) break;
+            this->hasStalledRequest = true;
+        }
+        if (this->ProcessRequest(&this->stalledRequest)) break;
+        this->hasStalledRequest = false;
+    }
+
+    int numDue;
+    TLBTarget* hits = this->hits.Complete(this->cycle, &numDue);
+    for (int i = 0; i < numDue; ++i) {
+        this->SendResponseToConnection(hits[i].connectionID, &hits[i].packet);
+    }
+
+    ++this->cycle;
+}
+
+void TLB::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("TLB [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Accesses: %lu\n", this->numAccesses);
+    SINUCA3_LOG_PRINTF("    Hits: %lu\n", this->numHits);
+    SINUCA3_LOG_PRINTF("    Large page hits: %lu\n", this->numLargeHits);
+    SINUCA3_LOG_PRINTF("    Misses: %lu\n", this->numMisses);
+    SINUCA3_LOG_PRINTF("    MSHR merges: %lu\n", this->numMerges);
+    SINUCA3_LOG_PRINTF("    MSHR full stalls: %lu\n", this->numMshrFullStalls);
+}
+
+TLB::~TLB() {
+    delete this->pages;
+    delete this->largePages;
+}
+
+#ifndef NDEBUG
+
+/** @brief Translates [address] and runs until it is answered. */
+static int TlbTestTranslate(TLB* tlb, int id, Linkable** components,
+                            int count, unsigned long address,
+                            bool* largePage) {
+    TranslationPacket packet;
+    packet.address = address;
+    tlb->SendRequest(id, &packet);
+    for (int steps = 0; steps < 100; ++steps) {
+        for (int i = 0; i < count; ++i) components[i]->Clock();
+        for (int i = 0; i < count; ++i) components[i]->PosClock();
+        if (tlb->ReceiveResponse(id, &packet) == 0) {
+            if (packet.address != address) return 1;
+            *largePage = packet.largePage;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int TestTlb() {
+    const char* tlbConfig =
+        "nextLevel: *walker\n"
+        "entries: 16\n"
+        "associativity: 4\n"
+        "largeEntries: 8\n"
+        "mshrs: 2\n";
+    bool largePage;
+
+    {
+        TLB tlb;
+        PageWalker walker;
+        CacheTesterMemory memory;
+        Map<Linkable*> aliases;
+        yaml::Parser parser;
+        aliases.Insert("walker", &walker);
+        aliases.Insert("memory", &memory);
+        if (walker.Configure(
+                CreateFakeConfig(&parser, "memory: *memory\n", &aliases))) {
+            return 1;
+        }
+        if (tlb.Configure(CreateFakeConfig(&parser, tlbConfig, &aliases))) {
+            return 2;
+        }
+        int id = tlb.Connect(0);
+        Linkable* components[] = {&tlb, &walker, &memory};
+
+        // A cold walk reads the four levels, the next page only its PT entry
+        // thanks to the PD cache, and then the TLB hits.
+        if (TlbTestTranslate(&tlb, id, components, 3, 0x7f0000001008,
+                             &largePage)) {
+            return 3;
+        }
+        if (largePage || memory.numReads != 4) return 4;
+        if (TlbTestTranslate(&tlb, id, components, 3, 0x7f0000002000,
+                             &largePage)) {
+            return 5;
+        }
+        if (memory.numReads != 5) return 6;
+        if (TlbTestTranslate(&tlb, id, components, 3, 0x7f0000001ff8,
+                             &largePage)) {
+            return 7;
+        }
+        if (memory.numReads != 5 || tlb.GetNumHits() != 1) return 8;
+
+        // Two misses to a page share the walk, and a hit is served while it
+        // is in progress.
+        TranslationPacket packet;
+        unsigned long addresses[] = {0x7f0000003000, 0x7f0000003040,
+                                     0x7f0000002040};
+        for (int i = 0; i < 3; ++i) {
+            packet.address = addresses[i];
+            tlb.SendRequest(id, &packet);
+        }
+        unsigned long order[3];
+        int received = 0;
+        for (int steps = 0; steps < 100 && received < 3; ++steps) {
+            for (int i = 0; i < 3; ++i) components[i]->Clock();
+            for (int i = 0; i < 3; ++i) components[i]->PosClock();
+            while (tlb.ReceiveResponse(id, &packet) == 0) {
+                order[received++] = packet.address;
+            }
+        }
+        if (received != 3 || order[0] != 0x7f0000002040) return 9;
+        if (tlb.GetNumMerges() != 1 || memory.numReads != 6) return 10;
+    }
+
+    {
+        TLB tlb;
+        PageWalker walker;
+        CacheTesterMemory memory;
+        Map<Linkable*> aliases;
+        yaml::Parser parser;
+        aliases.Insert("walker", &walker);
+        aliases.Insert("memory", &memory);
+        if (walker.Configure(CreateFakeConfig(&parser,
+                                              "memory: *memory\n"
+                                              "largePageRatio: 100\n",
+                                              &aliases))) {
+            return 11;
+        }
+        if (tlb.Configure(CreateFakeConfig(&parser, tlbConfig, &aliases))) {
+            return 12;
+        }
+        int id = tlb.Connect(0);
+        Linkable* components[] = {&tlb, &walker, &memory};
+
+        // Large pages end the walk at the PD and cover the whole 2 MiB.
+        if (TlbTestTranslate(&tlb, id, components, 3, 0x200000, &largePage)) {
+            return 13;
+        }
+        if (!largePage || memory.numReads != 3) return 14;
+        if (TlbTestTranslate(&tlb, id, components, 3, 0x3ff000, &largePage)) {
+            return 15;
+        }
+        if (!largePage || memory.numReads != 3) return 16;
+        if (tlb.GetNumLargeHits() != 1) return 17;
+    }
+
+    return 0;
+}
+
+#endif
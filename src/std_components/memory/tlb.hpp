@@ -0,0 +1,132 @@
+#ifndef SINUCA3_TLB_HPP_
+#define SINUCA3_TLB_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+/**
+ * @file tlb.hpp
+ * @details Public API of the TLB, a non-blocking translation lookaside
+ * buffer for 4 KiB and 2 MiB pages.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/mshr_file.hpp>
+
+#include "utils/circular_buffer.hpp"
+
+/** @brief Upper limit of the mshrs parameter, one bit per entry. */
+static const int TLB_MAX_MSHRS = MSHR_FILE_MAX_ENTRIES;
+static const int TLB_PAGE_BITS = 12;
+static const int TLB_LARGE_PAGE_BITS = 21;
+
+/** @brief A request and the connection it came from. */
+struct TLBTarget {
+    TranslationPacket packet;
+    int connectionID;
+};
+
+/**
+ * @details TLB caches translations in a CacheMemory of 4 KiB pages and,
+ * optionally, another one of 2 MiB pages; both are looked up on each access.
+ * Hits are answered hitLatency cycles after being processed. Misses take a
+ * MSHR, keyed by 4 KiB page so misses to the same page merge, and ask
+ * nextLevel, another TLB or a PageWalker; the TLB keeps serving hits while
+ * they are outstanding. The responses say whether the page is large, and
+ * without a 2 MiB array large translations are kept as 4 KiB ones.
+ *
+ * Used as a dTLB in front of a unified L2 TLB in front of a PageWalker, it
+ * gives the usual x86-64 translation hierarchy.
+ *
+ * It accepts the following parameters:
+ * - nextLevel (required): Component<TranslationPacket> the misses go to.
+ * - entries (required): integer, 4 KiB translations.
+ * - associativity (required): integer, ways per set.
+ * - largeEntries: integer, 2 MiB translations, 0 (no array) by default.
+ * - largeAssociativity: integer, 4 by default.
+ * - policy: string, replacement policy of CacheMemory, lru by default.
+ * - hitLatency: integer, 1 by default.
+ * - mshrs: integer from 1 to 64, outstanding misses, 4 by default.
+ * - mshrTargets: integer, requests merged per MSHR, 4 by default.
+ * - ports: integer, requests processed per cycle, 1 by default.
+ */
+class TLB : public Component<TranslationPacket> {
+  private:
+    Component<TranslationPacket>* nextLevel;
+    CacheMemory<unsigned long>* pages;
+    CacheMemory<unsigned long>* largePages;
+    int nextLevelID;
+
+    long hitLatency;
+    long ports;
+    long numMshrs;
+    long mshrTargets;
+    unsigned long cycle;
+
+    CircularBuffer pendingRequests; /**< Requests not processed yet. */
+    TLBTarget stalledRequest;       /**< Head of pendingRequests. */
+    bool hasStalledRequest;
+
+    CompletionWheel<TLBTarget> hits; /**< Waiting for hitLatency. */
+    MshrFile<TLBTarget> mshrs;       /**< Keyed by 4 KiB page. */
+
+    unsigned long numAccesses;
+    unsigned long numHits;
+    unsigned long numLargeHits;
+    unsigned long numMisses;
+    unsigned long numMerges;
+    unsigned long numMshrFullStalls;
+
+    /** @return 1 if the request must be retried in the next cycle. */
+    int ProcessRequest(TLBTarget* request);
+    void ProcessFill(TranslationPacket* response);
+
+  public:
+    inline TLB()
+        : nextLevel(NULL),
+          pages(NULL),
+          largePages(NULL),
+          hitLatency(1),
+          ports(1),
+          numMshrs(4),
+          mshrTargets(4),
+          cycle(0),
+          hasStalledRequest(false),
+          numAccesses(0),
+          numHits(0),
+          numLargeHits(0),
+          numMisses(0),
+          numMerges(0),
+          numMshrFullStalls(0) {}
+    virtual int Configure(Config config);
+    virtual void Clock();
+    virtual void PrintStatistics();
+    virtual ~TLB();
+
+    inline unsigned long GetNumHits() const { return this->numHits; }
+    inline unsigned long GetNumLargeHits() const { return this->numLargeHits; }
+    inline unsigned long GetNumMisses() const { return this->numMisses; }
+    inline unsigned long GetNumMerges() const { return this->numMerges; }
+};
+
+#ifndef NDEBUG
+int TestTlb();
+#endif
+
+#endif  // SINUCA3_TLB_HPP_
@@ -0,0 +1,91 @@
+#ifndef SINUCA3_BLOCK_QUERY_HPP_
+#define SINUCA3_BLOCK_QUERY_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file block_query.hpp
+ * @brief Helper for predictors to answer a RequestBlockQuery with the code
+ * that answers a single RequestQuery.
+ */
+
+#include <cstring>
+#include <sinuca3.hpp>
+
+/**
+ * @brief Answers the block query in [packet], in place, by running [query] on
+ * each slot in order, so the speculative state of [predictor] advances as if
+ * the instructions were queried one by one.
+ * @param query Turns a RequestQuery packet into its response, as the Query
+ * methods of the predictors do.
+ */
+template <class Predictor>
+inline void AnswerBlockQuery(Predictor* predictor,
+                             void (Predictor::*query)(PredictorPacket*),
+                             PredictorPacket* packet) {
+    // The response shares the storage of the request.
+    unsigned int size = packet->data.blockQuery.numberOfInstructions;
+    const StaticInstructionInfo* instructions[MAX_FETCH_BLOCK_INSTRUCTIONS];
+    memcpy(instructions, packet->data.blockQuery.instructions,
+           size * sizeof(*instructions));
+    unsigned long startAddress = packet->data.blockQuery.startAddress;
+    unsigned long nextAddress = packet->data.blockQuery.nextAddress;
+
+    packet->type = PredictorPacketTypeResponseBlock;
+    packet->data.blockResponse.startAddress = startAddress;
+    packet->data.blockResponse.numberOfInstructions = size;
+    packet->data.blockResponse.knownMask = 0;
+    packet->data.blockResponse.takenMask = 0;
+    packet->data.blockResponse.targetMask = 0;
+
+    PredictorPacket slot;
+    slot.data.requestQuery.dynamicInfo.numReadings = 0;
+    slot.data.requestQuery.dynamicInfo.numWritings = 0;
+    slot.data.targetResponse.target = 0;
+    for (unsigned int i = 0; i < size; ++i) {
+        slot.type = PredictorPacketTypeRequestQuery;
+        slot.data.requestQuery.staticInfo = instructions[i];
+        // The block is a run of the trace, each instruction is followed by
+        // the next one.
+        slot.data.requestQuery.nextInstruction =
+            (i + 1 < size) ? instructions[i + 1]->instAddress : nextAddress;
+        (predictor->*query)(&slot);
+
+        unsigned int bit = 1U << i;
+        switch (slot.type) {
+            case PredictorPacketTypeResponseTakeToAddress:
+                packet->data.blockResponse.targetMask |= bit;
+                packet->data.blockResponse.targets[i] =
+                    slot.data.targetResponse.target;
+                packet->data.blockResponse.takenMask |= bit;
+                packet->data.blockResponse.knownMask |= bit;
+                break;
+            case PredictorPacketTypeResponseTake:
+                packet->data.blockResponse.takenMask |= bit;
+                packet->data.blockResponse.knownMask |= bit;
+                break;
+            case PredictorPacketTypeResponseDontTake:
+                packet->data.blockResponse.knownMask |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+#endif  // SINUCA3_BLOCK_QUERY_HPP_
@@ -17,43 +17,24 @@
 
 #include "gshare_predictor.hpp"
 
-#include <cassert>
 #include <cmath>
 #include <sinuca3.hpp>
+#include <std_components/predictors/block_query.hpp>
 
 GsharePredictor::GsharePredictor()
-    : entries(NULL),
-      globalBranchHistReg(0),
+    : globalBranchHistReg(0),
+      historyMask(0),
       numberOfEntries(0),
-      numberOfPredictions(0),
-      numberOfWrongPredictions(0),
-      indexQueueSize(0),
+      historyLength(0),
       indexBitsSize(0),
-      sendTo(NULL) {}
-
-GsharePredictor::~GsharePredictor() { this->Deallocate(); }
-
-int GsharePredictor::Allocate() {
-    this->entries = new BimodalCounter[this->numberOfEntries];
-    if (!this->entries) {
-        SINUCA3_ERROR_PRINTF("Gshare failed to allocate table\n");
-        return 1;
-    }
-    this->indexQueue.Allocate(this->indexQueueSize, sizeof(this->currentIndex));
-    return 0;
-}
+      sendTo(NULL),
+      sendToId(0),
+      numberOfQueries(0),
+      numberOfPredictions(0),
+      numberOfUpdates(0),
+      numberOfWrongPredictions(0) {}
 
-void GsharePredictor::Deallocate() {
-    if (this->entries) {
-        delete[] this->entries;
-        this->entries = NULL;
-    }
-    if (!this->indexQueue.IsEmpty()) {
-        SINUCA3_WARNING_PRINTF(
-            "Gshare index queue not empty when it was expected to be\n");
-    }
-    this->indexQueue.Deallocate();
-}
+GsharePredictor::~GsharePredictor() {}
 
 int GsharePredictor::RoundNumberOfEntries(unsigned long requestedSize) {
     unsigned int bits = (unsigned int)floor(log2(requestedSize));
@@ -65,203 +46,282 @@ int GsharePredictor::RoundNumberOfEntries(unsigned long requestedSize) {
     return 0;
 }
 
-void GsharePredictor::PreparePacket(PredictorPacket* pkt) {
-    if (this->wasPredictedToBeTaken) {
-        pkt->type = PredictorPacketTypeResponseTake;
-    } else {
-        pkt->type = PredictorPacketTypeResponseDontTake;
+unsigned long GsharePredictor::CalculateIndex(unsigned long addr,
+                                              unsigned long history) {
+    // Histories longer than the index are folded onto it.
+    unsigned long index = addr;
+    for (history &= this->historyMask; history != 0;
+         history >>= this->indexBitsSize) {
+        index ^= history;
     }
+    index &= this->numberOfEntries - 1;
+    SINUCA3_DEBUG_PRINTF("Gshare Idx [%ld]\n", index);
+    return index;
 }
 
-int GsharePredictor::EnqueueIndex() {
-    bool ret = this->indexQueue.Enqueue(&this->currentIndex);
-    SINUCA3_DEBUG_PRINTF("Gshare Enq [%ld]\n", this->currentIndex);
-    return ret;
-}
+void GsharePredictor::Query(PredictorPacket* pkt) {
+    ++this->numberOfQueries;
+    const StaticInstructionInfo* instruction =
+        pkt->data.requestQuery.staticInfo;
+    if (instruction->branchType != BranchCond) {
+        pkt->type = PredictorPacketTypeResponseUnknown;
+        return;
+    }
 
-int GsharePredictor::DequeueIndex() {
-    bool ret = this->indexQueue.Dequeue(&this->currentIndex);
-    SINUCA3_DEBUG_PRINTF("Gshare Deq [%ld]\n", this->currentIndex);
-    return ret;
-}
+    GshareCheckpoint* checkpoint = this->checkpoints.Push(instruction);
+    checkpoint->history = this->globalBranchHistReg;
+    checkpoint->index = this->CalculateIndex(instruction->instAddress,
+                                             this->globalBranchHistReg);
+    checkpoint->predictedTaken = this->entries.GetPrediction(checkpoint->index);
 
-void GsharePredictor::UpdateEntry() {
-    bool pred = this->entries[this->currentIndex].GetPrediction();
-    if (pred != this->wasBranchTaken) {
-        this->numberOfWrongPredictions++;
-    }
-    this->entries[this->currentIndex].UpdatePrediction(this->wasBranchTaken);
+    this->globalBranchHistReg =
+        (this->globalBranchHistReg << 1) | checkpoint->predictedTaken;
+    ++this->numberOfPredictions;
+
+    pkt->type = checkpoint->predictedTaken
+                    ? PredictorPacketTypeResponseTake
+                    : PredictorPacketTypeResponseDontTake;
 }
 
-void GsharePredictor::UpdateGlobBranchHistReg() {
-    SINUCA3_DEBUG_PRINTF("Gshare Gbhr Bef [%ld]\n", this->globalBranchHistReg);
-    this->globalBranchHistReg <<= 1;
-    if (this->wasBranchTaken) {
-        this->globalBranchHistReg |= 1;
-    }
-    SINUCA3_DEBUG_PRINTF("Gshare Gbhr Aft [%ld]\n", this->globalBranchHistReg);
+void GsharePredictor::ReplayBranch(GshareCheckpoint* checkpoint) {
+    checkpoint->history = this->globalBranchHistReg;
+    this->globalBranchHistReg =
+        (this->globalBranchHistReg << 1) | checkpoint->predictedTaken;
 }
 
-void GsharePredictor::Update() {
-    if (this->DequeueIndex()) {
-        SINUCA3_ERROR_PRINTF("Gshare table was not updated\n");
+void GsharePredictor::Update(const PredictorPacket* pkt) {
+    const StaticInstructionInfo* instruction =
+        pkt->data.directionUpdate.instruction.staticInfo;
+    bool taken = pkt->data.directionUpdate.taken;
+
+    GshareCheckpoint* checkpoint = this->checkpoints.Resolve(instruction);
+    if (checkpoint == NULL) {
+        SINUCA3_DEBUG_PRINTF("Gshare update without a prediction\n");
         return;
     }
-    this->UpdateEntry();
-    this->UpdateGlobBranchHistReg();
-}
 
-void GsharePredictor::QueryEntry() {
-    this->numberOfPredictions++;
-    this->wasPredictedToBeTaken =
-        this->entries[this->currentIndex].GetPrediction();
-}
+    ++this->numberOfUpdates;
+    this->entries.Update(checkpoint->index, taken);
 
-void GsharePredictor::Query(PredictorPacket* pkt, unsigned long addr) {
-    this->CalculateIndex(addr);
-    this->QueryEntry();
-    this->PreparePacket(pkt);
-    if (this->EnqueueIndex()) {
-        SINUCA3_WARNING_PRINTF("Gshare index queue full\n");
+    if (checkpoint->predictedTaken != taken) {
+        ++this->numberOfWrongPredictions;
+        this->globalBranchHistReg = (checkpoint->history << 1) | taken;
+        this->checkpoints.Replay(this, &GsharePredictor::ReplayBranch);
+        SINUCA3_DEBUG_PRINTF("Gshare Gbhr repaired [%ld]\n",
+                             this->globalBranchHistReg);
     }
-}
 
-void GsharePredictor::CalculateIndex(unsigned long addr) {
-    unsigned long mask = (1 << this->indexBitsSize) - 1;
-    this->currentIndex = (this->globalBranchHistReg ^ addr) & mask;
-    SINUCA3_DEBUG_PRINTF("Gshare Idx [%ld]\n", this->currentIndex);
+    this->checkpoints.Pop();
 }
 
 int GsharePredictor::Configure(Config config) {
     long numberOfEntries = 0;
     if (config.Integer("numberOfEntries", &numberOfEntries, true)) return 1;
-    if (numberOfEntries <= 0)
-        return config.Error("numberOfEntries", "is not > 0.");
-    this->numberOfEntries = numberOfEntries;
-
-    long indexQueueSize = 1;
-    if (config.Integer("indexQueueSize", &indexQueueSize)) return 1;
-    if (indexQueueSize <= 0)
-        return config.Error("indexQueueSize", "is not > 0.");
-    this->indexQueueSize = indexQueueSize;
+    if (numberOfEntries <= 1)
+        return config.Error("numberOfEntries", "is not > 1.");
+    this->RoundNumberOfEntries(numberOfEntries);
+
+    long historyLength = this->indexBitsSize;
+    if (config.Integer("historyLength", &historyLength)) return 1;
+    if (historyLength <= 0 || historyLength > 64)
+        return config.Error("historyLength", "is not between 1 and 64.");
+    this->historyLength = historyLength;
+    this->historyMask =
+        (historyLength == 64) ? ~0UL : (1UL << historyLength) - 1;
+
+    long checkpoints = 64;
+    if (config.Integer("checkpoints", &checkpoints)) return 1;
+    if (checkpoints <= 0) return config.Error("checkpoints", "is not > 0.");
 
     if (config.ComponentReference("sendTo", &this->sendTo)) return 1;
     if (this->sendTo != NULL) this->sendToId = this->sendTo->Connect(0);
 
-    return this->Allocate();
+    if (this->entries.Allocate(this->numberOfEntries)) {
+        SINUCA3_ERROR_PRINTF("Gshare failed to allocate table\n");
+        return 1;
+    }
+    this->checkpoints.Allocate(checkpoints);
+
+    return 0;
 }
 
 void GsharePredictor::PrintStatistics() {
-    double fraction =
-        ((double)this->numberOfWrongPredictions / this->numberOfPredictions);
-    SINUCA3_LOG_PRINTF("Gshare table size [%lu] & number of index bits [%u]\n",
+    SINUCA3_LOG_PRINTF("Gshare [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Table size [%lu] & number of index bits [%u]\n",
                        this->numberOfEntries, this->indexBitsSize);
-    SINUCA3_LOG_PRINTF("Gshare number of predictions [%lu]\n",
+    SINUCA3_LOG_PRINTF("    History length [%u]\n", this->historyLength);
+    SINUCA3_LOG_PRINTF("    Queries [%lu]\n", this->numberOfQueries);
+    SINUCA3_LOG_PRINTF("    Conditional branches predicted [%lu]\n",
                        this->numberOfPredictions);
-    SINUCA3_LOG_PRINTF("Gshare number of wrong predictions [%lu]\n",
+    SINUCA3_LOG_PRINTF("    Conditional branches resolved [%lu]\n",
+                       this->numberOfUpdates);
+    SINUCA3_LOG_PRINTF("    Wrong predictions [%lu]\n",
                        this->numberOfWrongPredictions);
-    SINUCA3_LOG_PRINTF("Gshare rate of wrong predictions [%.0lf]%%\n",
-                       fraction * 100);
+    SINUCA3_LOG_PRINTF("    Dropped checkpoints [%lu]\n",
+                       this->checkpoints.GetNumberOfDropped());
+    if (this->numberOfUpdates > 0) {
+        SINUCA3_LOG_PRINTF("    Rate of wrong predictions [%.2lf]%%\n",
+                           100.0 * this->numberOfWrongPredictions /
+                               this->numberOfUpdates);
+    }
 }
 
 void GsharePredictor::Clock() {
     PredictorPacket packet;
-    unsigned long addr;
     long totalConnections = this->GetNumberOfConnections();
     for (long i = 0; i < totalConnections; i++) {
         while (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+            if (packet.type == PredictorPacketTypeRequestDirectionUpdate) {
+                this->Update(&packet);
+                continue;
+            }
             if (packet.type == PredictorPacketTypeRequestQuery) {
-                addr = packet.data.requestQuery.staticInfo->instAddress;
-                this->Query(&packet, addr);
-                if (this->sendTo == NULL) {
-                    this->SendResponseToConnection(i, &packet);
-                } else {
-                    this->sendTo->SendRequest(sendToId, &packet);
-                }
+                this->Query(&packet);
+            } else if (packet.type == PredictorPacketTypeRequestBlockQuery) {
+                AnswerBlockQuery(this, &GsharePredictor::Query, &packet);
+            } else {
+                continue;
             }
-            if (packet.type == PredictorPacketTypeRequestDirectionUpdate) {
-                this->wasBranchTaken = packet.data.directionUpdate.taken;
-                this->Update();
+            if (this->sendTo == NULL) {
+                this->SendResponseToConnection(i, &packet);
+            } else {
+                this->sendTo->SendRequest(sendToId, &packet);
             }
         }
     }
 }
 
 #ifndef NDEBUG
-const int testSize = 2;
 
-int TestGshare() {
-    GsharePredictor predictor;
-    PredictorPacket sendPackets[testSize * 2];
-    PredictorPacket recvPackets[testSize];
-    StaticInstructionInfo ins[testSize];
-    const long addrs[] = {0x1, 0x2};
-    const bool taken[] = {false, true};
-
-    for (int i = 0; i < testSize; ++i) {
-        sendPackets[i].type = PredictorPacketTypeRequestQuery;
-        sendPackets[i].data.requestQuery.staticInfo = &ins[i];
-        ins[i].instAddress = addrs[i];
+/** @brief Predicts [instruction] and waits for the answer. */
+static int GshareTestQuery(GsharePredictor* predictor, int id,
+                           const InstructionPacket* instruction) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestQuery;
+    packet.data.requestQuery = *instruction;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 10; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+        if (predictor->ReceiveResponse(id, &packet) == 0) {
+            return packet.type;
+        }
     }
-    for (int i = testSize; i < testSize * 2; ++i) {
-        sendPackets[i].type = PredictorPacketTypeRequestDirectionUpdate;
-        sendPackets[i].data.directionUpdate.taken = taken[i - testSize];
+    return -1;
+}
+
+static void GshareTestUpdate(GsharePredictor* predictor, int id,
+                             const InstructionPacket* instruction,
+                             bool taken) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestDirectionUpdate;
+    packet.data.directionUpdate.instruction = *instruction;
+    packet.data.directionUpdate.taken = taken;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 2; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
     }
+}
 
+/** @brief Predicts a block of [size] instructions, returns its known mask. */
+static long GshareTestBlock(GsharePredictor* predictor, int id,
+                            const StaticInstructionInfo** instructions,
+                            unsigned int size) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestBlockQuery;
+    for (unsigned int i = 0; i < size; ++i) {
+        packet.data.blockQuery.instructions[i] = instructions[i];
+    }
+    packet.data.blockQuery.startAddress = instructions[0]->instAddress;
+    packet.data.blockQuery.nextAddress = 0;
+    packet.data.blockQuery.numberOfInstructions = size;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 10; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+        if (predictor->ReceiveResponse(id, &packet) == 0) {
+            if (packet.type != PredictorPacketTypeResponseBlock ||
+                packet.data.blockResponse.numberOfInstructions != size) {
+                return -1;
+            }
+            return packet.data.blockResponse.knownMask;
+        }
+    }
+    return -1;
+}
+
+int TestGshare() {
+    GsharePredictor predictor;
     Map<Linkable*> aliases;
     yaml::Parser parser;
-    predictor.Configure(
-        CreateFakeConfig(&parser, "numberOfEntries: 2\n", &aliases));
-    int id = predictor.Connect(testSize);
-
-    // clock 1 (predictor is empty)
-    for (int i = 0; i < testSize; ++i) {
-        predictor.SendRequest(id, &sendPackets[i]);
+    if (predictor.Configure(CreateFakeConfig(&parser,
+                                             "numberOfEntries: 1024\n"
+                                             "historyLength: 8\n",
+                                             &aliases))) {
+        return 1;
     }
-    predictor.Clock();
-    predictor.PosClock();
-
-    // clock 2 (predictor should not respond)
-    assert(predictor.ReceiveResponse(id, &recvPackets[0]) != 0);
-    predictor.Clock();
-    predictor.PosClock();
-
-    // clock 3 (predictor expected to respond)
-    for (int i = 0; i < testSize; ++i) {
-        assert(predictor.ReceiveResponse(id, &recvPackets[i]) == 0);
-        SINUCA3_DEBUG_PRINTF("Gshare Predicted [%d] for [%ld] ins addr\n",
-                         recvPackets[i].type, ins[i].instAddress);
-        predictor.SendRequest(id, &sendPackets[i + testSize]); // send update
+    int id = predictor.Connect(0);
+
+    StaticInstructionInfo loopInfo;
+    loopInfo.instAddress = 0x400;
+    loopInfo.branchType = BranchCond;
+    StaticInstructionInfo aluInfo;
+    aluInfo.instAddress = 0x404;
+    InstructionPacket loop;
+    loop.staticInfo = &loopInfo;
+    InstructionPacket alu;
+    alu.staticInfo = &aluInfo;
+
+    if (GshareTestQuery(&predictor, id, &alu) !=
+        PredictorPacketTypeResponseUnknown) {
+        return 2;
     }
-    predictor.Clock();
-    predictor.PosClock();
 
-    // clock 4 (query again)
-    for (int i = 0; i < testSize; ++i) {
-        predictor.SendRequest(id, &sendPackets[i]);
+    // A loop taken three times and then not taken is learned through the
+    // history.
+    for (int i = 0; i < 100; ++i) {
+        bool taken = (i % 4) != 3;
+        if (GshareTestQuery(&predictor, id, &loop) < 0) return 3;
+        GshareTestUpdate(&predictor, id, &loop, taken);
     }
-    predictor.Clock();
-    predictor.PosClock();
-
-    // clock 5 (predictor should not respond)
-    assert(predictor.ReceiveResponse(id, &recvPackets[0]) != 0);
-    predictor.Clock();
-    predictor.PosClock();
-
-    // clock 6 (predictor expected to respond)
-    for (int i = 0; i < testSize; ++i) {
-        assert(predictor.ReceiveResponse(id, &recvPackets[i]) == 0);
-        SINUCA3_DEBUG_PRINTF("Gshare Predicted [%d] for [%ld] ins addr\n",
-                         recvPackets[i].type, ins[i].instAddress);
-        predictor.SendRequest(id, &sendPackets[i + testSize]); // send update
+    unsigned long wrong = predictor.GetNumberOfWrongPredictions();
+    for (int i = 0; i < 20; ++i) {
+        bool taken = (i % 4) != 3;
+        int prediction = GshareTestQuery(&predictor, id, &loop);
+        if (prediction != (taken ? PredictorPacketTypeResponseTake
+                                 : PredictorPacketTypeResponseDontTake)) {
+            return 4;
+        }
+        GshareTestUpdate(&predictor, id, &loop, taken);
     }
-    predictor.Clock();
-    predictor.PosClock();
-
-    // clock 7 (process last update request)
-    predictor.Clock();
-    predictor.PrintStatistics();
+    if (predictor.GetNumberOfWrongPredictions() != wrong) return 5;
+
+    // The history is updated at prediction time and repaired when an older
+    // branch turns out mispredicted.
+    unsigned long history = predictor.GetHistory();
+    int first = GshareTestQuery(&predictor, id, &loop);
+    int second = GshareTestQuery(&predictor, id, &loop);
+    bool firstTaken = first == PredictorPacketTypeResponseTake;
+    bool secondTaken = second == PredictorPacketTypeResponseTake;
+    unsigned long expected = (history << 2) | (firstTaken << 1) | secondTaken;
+    if (predictor.GetHistory() != (expected & 0xff)) return 6;
+
+    GshareTestUpdate(&predictor, id, &loop, !firstTaken);
+    expected = (history << 2) | (!firstTaken << 1) | secondTaken;
+    if (predictor.GetHistory() != (expected & 0xff)) return 7;
+    if (predictor.GetNumberOfWrongPredictions() != wrong + 1) return 8;
+    GshareTestUpdate(&predictor, id, &loop, secondTaken);
+    if (predictor.GetHistory() != (expected & 0xff)) return 9;
+
+    // A block query predicts each slot and advances the history once per
+    // conditional branch, like the same queries sent one by one.
+    const StaticInstructionInfo* block[] = {&aluInfo, &loopInfo, &loopInfo};
+    history = predictor.GetHistory();
+    if (GshareTestBlock(&predictor, id, block, 3) != 0x6) return 10;
+    if (((predictor.GetHistory() >> 2) & 0x3f) != (history & 0x3f)) return 11;
 
     return 0;
 }
+
 #endif
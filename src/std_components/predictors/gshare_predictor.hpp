@@ -21,78 +21,83 @@
 /**
  * @file gshare_predictor.hpp
  * @brief Implementation of gshare predictor.
- * @details The gshare predictor uses a table of bimodal counters to make
+ * @details The gshare predictor uses a table of 2-bit counters to make
  * predictions on the direction the flow of execution will take. The table is
- * indexed by hashing the instruction address and the value stored in the
- * globalBranchHistReg attribute. The latter can store information of the
- * direction taken by up to sizeof(unsigned long) instructions. When
+ * indexed by hashing the instruction address and the last historyLength bits
+ * of the globalBranchHistReg, folded to the size of the index. When
  * instantiating the gshare, it will round the number of entries to the greatest
  * power of 2 less than the number requested, in such a way that bitwise
  * operations can be used to calculate the index.
  *
- * Note that when queried, this component stores the calculated index in a
- * queue to later update the right positions in the bimodal counter table.
+ * Only conditional branches are predicted, other instructions are answered
+ * with ResponseUnknown. The history is updated speculatively with each
+ * prediction, and a checkpoint with the history before the branch is kept
+ * until it is resolved by a RequestDirectionUpdate. Updates must arrive in
+ * program order. On a misprediction the history is rebuilt from the
+ * checkpoint with the right direction, followed by the predictions of the
+ * younger branches still in flight, which are not squashed since the trace
+ * only has the correct path.
+ *
+ * Parameters:
+ * - numberOfEntries: integer, required.
+ * - historyLength: integer from 1 to 64, the number of index bits by default.
+ * - checkpoints: integer, branches in flight, 64 by default. When full, the
+ * oldest checkpoint is dropped.
+ * - sendTo: component to which responses are sent instead, optional.
  */
 
 #include <sinuca3.hpp>
-#include <utils/bimodal_counter.hpp>
-#include <utils/circular_buffer.hpp>
+#include <utils/checkpoint_ring.hpp>
+#include <utils/counter_table.hpp>
+
+/** @brief State saved for a branch in flight. */
+struct GshareCheckpoint {
+    const StaticInstructionInfo* instruction;
+    unsigned long history; /**<The history before the branch. */
+    unsigned long index;   /**<The counter used for the prediction. */
+    bool predictedTaken;
+};
 
 /** @brief Refer to gshare_predictor.hpp documentation for details */
 class GsharePredictor : public Component<PredictorPacket> {
   private:
-    BimodalCounter* entries; /**<Bimodal counter table> */
-    CircularBuffer indexQueue;
-    unsigned long globalBranchHistReg;
-    unsigned long numberOfEntries;          /**<Size of table> */
-    unsigned long numberOfPredictions;      /**<Used for statistics> */
-    unsigned long numberOfWrongPredictions; /**<Used for statistics> */
-    unsigned long currentIndex;
-    unsigned int indexQueueSize; /**<Queue size. Default is unlimited size> */
-    unsigned int indexBitsSize;  /**<Number of bits used to address table> */
-    bool wasPredictedToBeTaken;
-    bool wasBranchTaken;
+    CounterTable entries; /**<Bimodal counter table> */
+    CheckpointRing<GshareCheckpoint> checkpoints; /**<Branches in flight. */
+    unsigned long globalBranchHistReg; /**<Speculative history. */
+    unsigned long historyMask;
+    unsigned long numberOfEntries; /**<Size of table> */
+    unsigned int historyLength;
+    unsigned int indexBitsSize; /**<Number of bits used to address table> */
 
     Component<PredictorPacket>* sendTo;
     int sendToId;
 
+    /* Statistics */
+    unsigned long numberOfQueries;          /**<Any instruction. */
+    unsigned long numberOfPredictions;      /**<Conditional branches. */
+    unsigned long numberOfUpdates;
+    unsigned long numberOfWrongPredictions;
+
     /**
      * @brief Round the number of entries to the greatest power of 2 less than
      * the value in requestedSize.
      */
     int RoundNumberOfEntries(unsigned long requestedSize);
+
+    unsigned long CalculateIndex(unsigned long addr, unsigned long history);
+    /** @brief Saves the history before [checkpoint] and shifts it in again. */
+    void ReplayBranch(GshareCheckpoint* checkpoint);
     /**
-     * @brief Fill response packet with predicted direction of execution.
-     */
-    void PreparePacket(PredictorPacket* pkt);
-    /**
-     * @brief Update the predictor table and gbhr.
-     */
-    void Update();
-    /**
-     * @brief Calculate index of access, save it and fill packet with prediction
-     * from table.
-     */
-    void Query(PredictorPacket* pkt, unsigned long addr);
-    /**
+     * @brief Predicts [pkt], saves a checkpoint and updates the history.
      * @note Since this predictor does not have a tag in each entry, when
-     * queried, it will always output a valid answer.
-     */
-    void QueryEntry();
-    /**
-     * @return 0 if successfuly, 1 otherwise.
+     * queried, it will always output a valid answer for conditional branches.
      */
-    int EnqueueIndex();
+    void Query(PredictorPacket* pkt);
     /**
-     * @return 0 if successfuly, 1 otherwise.
+     * @brief Trains the counter of the oldest branch in flight and repairs
+     * the history if it was mispredicted.
      */
-    int DequeueIndex();
-
-    int Allocate();
-    void Deallocate();
-    void CalculateIndex(unsigned long addr);
-    void UpdateGlobBranchHistReg();
-    void UpdateEntry();
+    void Update(const PredictorPacket* pkt);
 
   public:
     GsharePredictor();
@@ -100,6 +105,15 @@ class GsharePredictor : public Component<PredictorPacket> {
     virtual void PrintStatistics();
     virtual void Clock();
     virtual ~GsharePredictor();
+
+#ifndef NDEBUG
+    inline unsigned long GetHistory() const {
+        return this->globalBranchHistReg & this->historyMask;
+    }
+    inline unsigned long GetNumberOfWrongPredictions() const {
+        return this->numberOfWrongPredictions;
+    }
+#endif
 };
 
 #ifndef NDEBUG
@@ -25,7 +25,7 @@
 
 #include <cstring>
 #include <sinuca3.hpp>
-#include "engine/default_packets.hpp"
+#include <std_components/predictors/block_query.hpp>
 
 #include "engine/default_packets.hpp"
 
@@ -43,11 +43,8 @@ int HardwiredPredictor::Configure(Config config) {
     return 0;
 }
 
-void HardwiredPredictor::Respond(int id, PredictorPacket request) {
-    if (request.type == PredictorPacketTypeRequestTargetUpdate ||
-        request.type == PredictorPacketTypeRequestDirectionUpdate)
-        return;
-    const InstructionPacket instruction = request.data.requestQuery;
+void HardwiredPredictor::Predict(PredictorPacket* packet) {
+    const InstructionPacket instruction = packet->data.requestQuery;
     bool predict = true;
 
     // TODO: check if this is the right fix
@@ -85,19 +82,29 @@ void HardwiredPredictor::Respond(int id, PredictorPacket request) {
         }
     }
 
-    PredictorPacket response;
-    response.type = PredictorPacketTypeResponseTakeToAddress;
-    response.data.targetResponse.instruction = instruction;
+    packet->type = PredictorPacketTypeResponseTakeToAddress;
+    packet->data.targetResponse.instruction = instruction;
     if (predict) {
-        response.data.targetResponse.target = instruction.nextInstruction;
+        packet->data.targetResponse.target = instruction.nextInstruction;
     } else {
         // Fast way to create an address that isn't nextInstruction.
-        response.data.targetResponse.target = ~instruction.nextInstruction;
+        packet->data.targetResponse.target = ~instruction.nextInstruction;
+    }
+}
+
+void HardwiredPredictor::Respond(int id, PredictorPacket request) {
+    if (request.type == PredictorPacketTypeRequestTargetUpdate ||
+        request.type == PredictorPacketTypeRequestDirectionUpdate)
+        return;
+    if (request.type == PredictorPacketTypeRequestBlockQuery) {
+        AnswerBlockQuery(this, &HardwiredPredictor::Predict, &request);
+    } else {
+        this->Predict(&request);
     }
 
-    this->SendResponseToConnection(id, &response);
+    this->SendResponseToConnection(id, &request);
     if (this->sendTo != NULL) {
-        this->sendTo->SendRequest(this->sendToID, &response);
+        this->sendTo->SendRequest(this->sendToID, &request);
     }
 }
 
@@ -61,6 +61,8 @@ class HardwiredPredictor : public Component<PredictorPacket> {
     bool
         noBranch; /** @brief Wether to predict normal instructions correctly. */
 
+    /** @brief Turns a query in [packet] into its response. */
+    void Predict(PredictorPacket* packet);
     /**
      * @brief Helper to respond a request.
      * @param id The connection id of the client.
@@ -19,94 +19,24 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <sinuca3.hpp>
 
-BTBEntry::BTBEntry()
-    : valid(false),
-      numBanks(0),
-      entryTag(0),
+BranchTargetBuffer::BranchTargetBuffer()
+    : tags(NULL),
       targetArray(NULL),
       branchTypes(NULL),
-      predictorsArray(NULL) {}
-
-int BTBEntry::Allocate(unsigned int numBanks) {
-    this->numBanks = numBanks;
-    this->targetArray = new unsigned long[numBanks];
-    if (!(this->targetArray)) {
-        SINUCA3_ERROR_PRINTF("BTB entry could not be allocated");
-        return 1;
-    }
-
-    this->branchTypes = new BranchType[numBanks];
-    if (!(this->branchTypes)) {
-        delete[] this->targetArray;
-        SINUCA3_ERROR_PRINTF("BTB entry could not be allocated");
-        return 1;
-    }
-
-    this->predictorsArray = new BimodalCounter[numBanks];
-    if (!(this->predictorsArray)) {
-        delete[] this->targetArray;
-        delete[] this->branchTypes;
-        SINUCA3_ERROR_PRINTF("BTB entry could not be allocated");
-        return 1;
-    }
-
-    for (unsigned int i = 0; i < this->numBanks; ++i) {
-        this->targetArray[i] = 0;
-        this->branchTypes[i] = BranchTypeNone;
-    }
-
-    return 0;
-}
-
-int BTBEntry::NewEntry(unsigned long tag, unsigned int bank,
-                       unsigned long target,
-                       const StaticInstructionInfo* instruction) {
-    if (bank >= this->numBanks) return 1;
-
-    this->valid = true;
-    this->entryTag = tag;
-    this->targetArray[bank] = target;
-    this->branchTypes[bank] =
-        BranchTypeFromSinucaBranch(instruction->branchType);
-
-    return 0;
-}
-
-int BTBEntry::UpdateEntry(unsigned long bank, bool branchState) {
-    if ((bank >= this->numBanks) || this->entryTag == 0) return 1;
-
-    this->predictorsArray[bank].UpdatePrediction(branchState);
-    return 0;
-}
-
-BTBEntry::~BTBEntry() {
-    if (this->targetArray) {
-        delete[] this->targetArray;
-    }
-
-    if (this->branchTypes) {
-        delete[] this->branchTypes;
-    }
-
-    if (this->predictorsArray) {
-        delete[] this->predictorsArray;
-    }
-}
-
-BranchTargetBuffer::BranchTargetBuffer()
-    : btb(NULL),
+      allocatedEntries(0),
       sendTo(NULL),
       sendToID(0),
       interleavingFactor(0),
       numEntries(0),
+      associativity(1),
       interleavingBits(0),
       entriesBits(0),
       btbHits(0),
       totalBranch(0),
       queries(0),
-      occupation(0),
       replacements(0){};
 
 int BranchTargetBuffer::Configure(Config config) {
@@ -126,73 +56,96 @@ int BranchTargetBuffer::Configure(Config config) {
         return config.Error("numberOfEntries", "is not > 0.");
     this->numEntries = numberOfEntries;
 
+    long associativity = 1;
+    if (config.Integer("associativity", &associativity)) return 1;
+    if (associativity <= 0 || associativity > maxNumWays)
+        return config.Error("associativity", "is not between 1 and 64");
+
+    const char* policy = "lru";
+    if (config.String("policy", &policy)) return 1;
+
     this->sendTo = NULL;
     if (config.ComponentReference("sendTo", &this->sendTo)) return 1;
     if (this->sendTo != NULL) this->sendToID = this->sendTo->Connect(0);
 
     this->interleavingBits = floor(log2(this->interleavingFactor));
     this->entriesBits = floor(log2(this->numEntries));
+    unsigned int associativityBits = floor(log2(associativity));
+    if (associativityBits > this->entriesBits)
+        return config.Error("associativity", "is > numberOfEntries");
     this->interleavingFactor = (1 << this->interleavingBits);
     this->numEntries = (1 << this->entriesBits);
-    this->btb = new BTBEntry*[this->numEntries];
+    this->associativity = (1 << associativityBits);
 
-    for (unsigned int i = 0; i < this->numEntries; ++i) {
-        this->btb[i] = new BTBEntry;
-        this->btb[i]->Allocate(this->interleavingFactor);
+    this->tags = CacheMemory<unsigned int>::fromBits(
+        this->entriesBits - associativityBits, this->interleavingBits,
+        this->associativity, policy);
+    if (this->tags == NULL) {
+        SINUCA3_ERROR_PRINTF("BTB could not be allocated\n");
+        return 1;
     }
 
-    return 0;
-}
-
-unsigned int BranchTargetBuffer::CalculateBank(unsigned long address) {
-    unsigned long bank = address;
-    bank = bank & ((1 << this->interleavingBits) - 1);
-
-    return bank;
-}
-
-unsigned long BranchTargetBuffer::CalculateTag(unsigned long address) {
-    unsigned long tag = address;
-    tag = tag >> this->interleavingBits;
-
-    return tag;
-}
-
-unsigned long BranchTargetBuffer::CalculateIndex(unsigned long address) {
-    unsigned long index = address;
-
-    index = index >> this->interleavingBits;
-    index = index & ((1 << this->entriesBits) - 1);
+    unsigned long size = this->numEntries * this->interleavingFactor;
+    this->targetArray = new unsigned long[size];
+    this->branchTypes = new BranchType[size];
+    if (this->predictorsArray.Allocate(size)) return 1;
+    for (unsigned long i = 0; i < size; ++i) {
+        this->targetArray[i] = 0;
+        this->branchTypes[i] = BranchTypeNone;
+    }
 
-    return index;
+    return 0;
 }
 
 int BranchTargetBuffer::RegisterNewBranch(
     const StaticInstructionInfo* instruction, unsigned long target) {
-    unsigned long index = this->CalculateIndex(instruction->instAddress);
-    unsigned long tag = this->CalculateTag(instruction->instAddress);
-    unsigned int bank = this->CalculateBank(instruction->instAddress);
+    unsigned long address = instruction->instAddress;
+    unsigned int* entry = this->tags->Peek(address);
+
+    if (entry == NULL) {
+        unsigned int newEntry = this->allocatedEntries;
+        unsigned int evicted;
+        if (this->tags->Write(address, &newEntry, &evicted)) {
+            this->replacements++;
+            newEntry = evicted;
+        } else {
+            this->allocatedEntries++;
+        }
+        entry = this->tags->Peek(address);
+        *entry = newEntry;
 
-    if (this->btb[index]->GetValid()) {
-        this->replacements++;
+        // A new block starts with no branches, the counters are reset.
+        unsigned long base = newEntry * this->interleavingFactor;
+        for (unsigned int i = 0; i < this->interleavingFactor; ++i) {
+            this->branchTypes[base + i] = BranchTypeNone;
+            this->predictorsArray.Set(base + i, COUNTER_WEAKLY_TAKEN);
+        }
     }
 
-    return this->btb[index]->NewEntry(tag, bank, target, instruction);
+    unsigned long slot =
+        *entry * this->interleavingFactor + this->CalculateBank(address);
+    this->targetArray[slot] = target;
+    this->branchTypes[slot] =
+        BranchTypeFromSinucaBranch(instruction->branchType);
+
+    return 0;
 }
 
 int BranchTargetBuffer::UpdateBranch(const StaticInstructionInfo* instruction,
                                      bool branchState) {
-    unsigned long index = this->CalculateIndex(instruction->instAddress);
-    unsigned int bank = this->CalculateBank(instruction->instAddress);
+    unsigned long address = instruction->instAddress;
+    const unsigned int* entry = this->tags->Peek(address);
+    if (entry == NULL) return 1;
 
-    return this->btb[index]->UpdateEntry(bank, branchState);
+    this->predictorsArray.Update(
+        *entry * this->interleavingFactor + this->CalculateBank(address),
+        branchState);
+    return 0;
 }
 
 inline void BranchTargetBuffer::Query(const StaticInstructionInfo* instruction,
                                       int connectionID) {
     this->queries++;
-    unsigned long index = this->CalculateIndex(instruction->instAddress);
-    unsigned long tag = this->CalculateTag(instruction->instAddress);
     BTBPacket response;
 
     response.data.response.instruction = instruction;
@@ -203,8 +156,8 @@ inline void BranchTargetBuffer::Query(const StaticInstructionInfo* instruction,
     response.data.response.numberOfInstructions = this->interleavingFactor;
     response.data.response.interleavingBits = this->interleavingBits;
 
-    BTBEntry* currentEntry = btb[index];
-    if (currentEntry->GetTag() == tag) {
+    const unsigned int* entry = this->tags->Read(instruction->instAddress);
+    if (entry != NULL) {
         this->btbHits++;
         // BTB Hit
         /*
@@ -213,6 +166,7 @@ inline void BranchTargetBuffer::Query(const StaticInstructionInfo* instruction,
          * taken branch as valid.
          */
         bool branchTaken = false;
+        unsigned long base = *entry * this->interleavingFactor;
         response.data.response.instruction = instruction;
         response.data.response.target =
             instruction->instAddress + this->interleavingFactor;
@@ -222,11 +176,12 @@ inline void BranchTargetBuffer::Query(const StaticInstructionInfo* instruction,
 
         for (unsigned int i = 0; i < this->interleavingFactor; ++i) {
             if (!(branchTaken)) {
-                if ((currentEntry->GetBranchType(i) ==
+                if ((this->branchTypes[base + i] ==
                      BranchTypeUnconditional) ||
-                    (currentEntry->GetPrediction(i))) {
+                    (this->branchTypes[base + i] != BranchTypeNone &&
+                     this->predictorsArray.GetPrediction(base + i))) {
                     response.data.response.target =
-                        currentEntry->GetTargetAddress(i);
+                        this->targetArray[base + i];
                     branchTaken = true;
                 }
                 response.data.response.validBits[i] = true;
@@ -257,6 +212,53 @@ inline void BranchTargetBuffer::Query(const StaticInstructionInfo* instruction,
     }
 }
 
+inline void BranchTargetBuffer::QueryBlock(BTBPacket* packet,
+                                           int connectionID) {
+    // The response shares the storage of the request.
+    unsigned int size = packet->data.requestBlockQuery.numberOfInstructions;
+    const StaticInstructionInfo* instructions[MAX_FETCH_BLOCK_INSTRUCTIONS];
+    memcpy(instructions, packet->data.requestBlockQuery.instructions,
+           size * sizeof(*instructions));
+    unsigned long startAddress = packet->data.requestBlockQuery.startAddress;
+
+    packet->type = BTBPacketTypeResponseBlock;
+    packet->data.blockResponse.startAddress = startAddress;
+    packet->data.blockResponse.numberOfInstructions = size;
+    packet->data.blockResponse.hitMask = 0;
+    packet->data.blockResponse.takenMask = 0;
+
+    // The instructions of a group of interleavingFactor bytes are in the
+    // banks of a single entry, which is read once.
+    const unsigned int* entry = NULL;
+    unsigned long group = 0;
+    for (unsigned int i = 0; i < size; ++i) {
+        unsigned long address = instructions[i]->instAddress;
+        if (i == 0 || (address >> this->interleavingBits) != group) {
+            group = address >> this->interleavingBits;
+            entry = this->tags->Read(address);
+            this->queries++;
+            if (entry != NULL) this->btbHits++;
+        }
+        if (entry == NULL) continue;
+
+        unsigned long slot =
+            *entry * this->interleavingFactor + this->CalculateBank(address);
+        if (this->branchTypes[slot] == BranchTypeNone) continue;
+        unsigned int bit = 1U << i;
+        packet->data.blockResponse.hitMask |= bit;
+        packet->data.blockResponse.targets[i] = this->targetArray[slot];
+        if (this->branchTypes[slot] == BranchTypeUnconditional ||
+            this->predictorsArray.GetPrediction(slot)) {
+            packet->data.blockResponse.takenMask |= bit;
+        }
+    }
+
+    this->SendResponseToConnection(connectionID, packet);
+    if (this->sendTo != NULL) {
+        this->sendTo->SendRequest(this->sendToID, packet);
+    }
+}
+
 inline int BranchTargetBuffer::AddEntry(
     const StaticInstructionInfo* instruction, unsigned long targetAddress) {
     this->totalBranch++;
@@ -283,6 +285,10 @@ void BranchTargetBuffer::Clock() {
                     this->Query(packet.data.requestQuery, i);
                     break;
 
+                case BTBPacketTypeRequestBlockQuery:
+                    this->QueryBlock(&packet, i);
+                    break;
+
                 case BTBPacketTypeRequestAddEntry:
                     SINUCA3_DEBUG_PRINTF(
                         "[BranchTargetBuffer] %p: adding entry [%lx] %s\n",
@@ -303,6 +309,7 @@ void BranchTargetBuffer::Clock() {
 
                 case BTBPacketTypeResponseBTBHit:
                 case BTBPacketTypeResponseBTBMiss:
+                case BTBPacketTypeResponseBlock:
                     SINUCA3_WARNING_PRINTF(
                         "Connection %ld send a response type message to BTB.\n",
                         i);
@@ -316,32 +323,146 @@ void BranchTargetBuffer::Clock() {
 }
 
 void BranchTargetBuffer::PrintStatistics() {
-    for (unsigned int i = 0; i < this->numEntries; ++i) {
-        if (this->btb[i]->GetValid()) this->occupation++;
-    }
-
     SINUCA3_LOG_PRINTF("Branch Target Buffer [%p]\n", this);
     SINUCA3_LOG_PRINTF("    Entries: %d\n", this->numEntries);
+    SINUCA3_LOG_PRINTF("    Associativity: %d\n", this->associativity);
     SINUCA3_LOG_PRINTF("    Total Queries: %lu\n", this->queries);
     SINUCA3_LOG_PRINTF("    Total Branches: %lu\n", this->totalBranch);
     SINUCA3_LOG_PRINTF("    BTB Hits: %lu\n", this->btbHits);
-    SINUCA3_LOG_PRINTF("    BTB Occupation: %lu\n", this->occupation);
+    SINUCA3_LOG_PRINTF("    BTB Occupation: %u\n", this->allocatedEntries);
     SINUCA3_LOG_PRINTF("    Entry Replacements: %lu\n", this->replacements);
     SINUCA3_LOG_PRINTF("    Hit Ratio: %lf%%\n",
                        ((double)this->btbHits / (double)this->queries) * 100);
     SINUCA3_LOG_PRINTF(
         "    Occupation Ratio: %lf%%\n",
-        ((double)this->occupation / (double)this->numEntries) * 100);
+        ((double)this->allocatedEntries / (double)this->numEntries) * 100);
 }
 
 BranchTargetBuffer::~BranchTargetBuffer() {
-    if (!(this->btb)) return;
+    delete this->tags;
+    delete[] this->targetArray;
+    delete[] this->branchTypes;
+}
 
-    for (unsigned int i = 0; i < this->numEntries; ++i) {
-        if (this->btb[i]) {
-            delete this->btb[i];
-        }
+#ifndef NDEBUG
+
+/** @brief Sends [request] to [btb] and waits for the answer. */
+static int BtbTestSend(BranchTargetBuffer* btb, int id, BTBPacket* request,
+                       BTBPacket* response) {
+    btb->SendRequest(id, request);
+    for (int steps = 0; steps < 10; ++steps) {
+        btb->Clock();
+        btb->PosClock();
+        if (btb->ReceiveResponse(id, response) == 0) return 0;
+    }
+    return 1;
+}
+
+/** @brief Queries [btb] about [instruction] and waits for the answer. */
+static int BtbTestQuery(BranchTargetBuffer* btb, int id,
+                        const StaticInstructionInfo* instruction,
+                        BTBPacket* response) {
+    BTBPacket packet;
+    packet.type = BTBPacketTypeRequestQuery;
+    packet.data.requestQuery = instruction;
+    return BtbTestSend(btb, id, &packet, response);
+}
+
+static void BtbTestAdd(BranchTargetBuffer* btb, int id,
+                       const StaticInstructionInfo* instruction,
+                       unsigned long target) {
+    BTBPacket packet;
+    packet.type = BTBPacketTypeRequestAddEntry;
+    packet.data.requestAddEntry.instruction = instruction;
+    packet.data.requestAddEntry.target = target;
+    btb->SendRequest(id, &packet);
+    btb->Clock();
+    btb->PosClock();
+}
+
+int TestBranchTargetBuffer() {
+    BranchTargetBuffer btb;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    if (btb.Configure(CreateFakeConfig(&parser,
+                                       "interleavingFactor: 4\n"
+                                       "numberOfEntries: 4\n"
+                                       "associativity: 2\n",
+                                       &aliases))) {
+        return 1;
+    }
+    int id = btb.Connect(0);
+    BTBPacket response;
+
+    // Three blocks of the same set, an unconditional jump in each.
+    StaticInstructionInfo jumps[3];
+    for (int i = 0; i < 3; ++i) {
+        jumps[i].instAddress = 0x100 + 0x10 * i + ((i == 0) ? 3 : 1);
+        jumps[i].instSize = 1;
+        jumps[i].branchType = BranchUncond;
+    }
+    StaticInstructionInfo blockStart;
+    blockStart.instAddress = 0x110;
+
+    BtbTestAdd(&btb, id, &jumps[0], 0x1000);
+    BtbTestAdd(&btb, id, &jumps[1], 0x2000);
+    if (BtbTestQuery(&btb, id, &blockStart, &response)) return 2;
+    if (response.type != BTBPacketTypeResponseBTBHit) return 3;
+    if (response.data.response.target != 0x2000) return 4;
+    if (!response.data.response.validBits[1] ||
+        response.data.response.validBits[2]) {
+        return 5;
+    }
+
+    // Both fit in the set, the third evicts the least recently used.
+    if (BtbTestQuery(&btb, id, &jumps[0], &response)) return 6;
+    if (response.type != BTBPacketTypeResponseBTBHit) return 7;
+    if (BtbTestQuery(&btb, id, &blockStart, &response)) return 8;
+    BtbTestAdd(&btb, id, &jumps[2], 0x3000);
+    if (BtbTestQuery(&btb, id, &jumps[0], &response)) return 9;
+    if (response.type != BTBPacketTypeResponseBTBMiss) return 10;
+    if (BtbTestQuery(&btb, id, &jumps[2], &response)) return 11;
+    if (response.data.response.target != 0x3000) return 12;
+
+    // The first block comes back in the entry of the second one, without
+    // its jump.
+    BtbTestAdd(&btb, id, &jumps[0], 0x1000);
+    blockStart.instAddress = 0x100;
+    if (BtbTestQuery(&btb, id, &blockStart, &response)) return 13;
+    if (response.type != BTBPacketTypeResponseBTBHit) return 14;
+    if (response.data.response.target != 0x1000) return 15;
+    if (BtbTestQuery(&btb, id, &jumps[1], &response)) return 16;
+    if (response.type != BTBPacketTypeResponseBTBMiss) return 17;
+
+    // A block over two groups gets a single answer, with the jump of the
+    // first group and nothing from the group the BTB does not hold.
+    StaticInstructionInfo block[6];
+    for (int i = 0; i < 6; ++i) {
+        block[i].instAddress = 0x100 + i;
+        block[i].instSize = 1;
+    }
+    block[3].branchType = BranchUncond;
+    BTBPacket query;
+    query.type = BTBPacketTypeRequestBlockQuery;
+    for (int i = 0; i < 6; ++i) {
+        query.data.requestBlockQuery.instructions[i] = &block[i];
+    }
+    query.data.requestBlockQuery.startAddress = 0x100;
+    query.data.requestBlockQuery.numberOfInstructions = 6;
+    if (BtbTestSend(&btb, id, &query, &response)) return 18;
+    if (response.type != BTBPacketTypeResponseBlock) return 19;
+    if (response.data.blockResponse.startAddress != 0x100 ||
+        response.data.blockResponse.numberOfInstructions != 6) {
+        return 20;
     }
+    if (response.data.blockResponse.hitMask != (1U << 3) ||
+        response.data.blockResponse.takenMask != (1U << 3) ||
+        response.data.blockResponse.targets[3] != 0x1000) {
+        return 21;
+    }
+    if (btb.ReceiveResponse(id, &response) == 0) return 22;
 
-    delete[] this->btb;
+    return 0;
 }
+
+#endif
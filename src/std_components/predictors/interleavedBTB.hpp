@@ -23,10 +23,10 @@
  * @brief Implementation of Interleaved Branch Target Buffer.
  * @details The Interleaved BTB is a structure that stores branches and has a
  * certain interleaving factor that allows multiple queries in a single cycle.
- * In this implementation, it is mapped directly and each entry has a tag for
- * recognizing the block of instructions and vectors assimilated to the block,
- * where each element of the vector corresponds to information from one of the
- * instructions in the block. Although the parameters are configurable, for
+ * In this implementation, it is set-associative (direct mapped by default) and
+ * each entry has a tag for recognizing the block of instructions and vectors
+ * assimilated to the block, where each element of the vector corresponds to
+ * information from one of the instructions in the block. Although the parameters are configurable, for
  * optimization reasons, the BTB is limited to using parameters that are
  * multiples of 2, allowing bitwise operations to optimize the BTB's overall
  * running time. When defining the parameters, the BTB itself internally defines
@@ -37,10 +37,23 @@
  * in response messages. If you want a higher interleaving factor than the one
  * defined, simply change the value of the MAX_INTERLEAVING_FACTOR constant,
  * adjust the parameters in the configuration YAML and recompile with “make -B”.
+ *
+ * A fetcher may also send a RequestBlockQuery with the instructions of a fetch
+ * block in program order. The BTB reads the entry of each group of
+ * interleavingFactor bytes the block touches once and answers with a single
+ * ResponseBlock: the slots whose bank holds a branch, their targets and which
+ * of them the bank predicts taken.
+ *
+ * Parameters:
+ * - interleavingFactor, numberOfEntries: integers, required.
+ * - associativity: integer, 1 by default.
+ * - policy: string, replacement policy of CacheMemory, lru by default.
+ * - sendTo: component to which responses are also forwarded, optional.
  */
 
 #include <sinuca3.hpp>
-#include <utils/bimodal_counter.hpp>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/counter_table.hpp>
 
 const int MAX_INTERLEAVING_FACTOR = 16;
 
@@ -60,7 +73,9 @@ enum BTBPacketType {
     BTBPacketTypeRequestAddEntry,
     BTBPacketTypeRequestUpdate,
     BTBPacketTypeResponseBTBHit,
-    BTBPacketTypeResponseBTBMiss
+    BTBPacketTypeResponseBTBMiss,
+    BTBPacketTypeRequestBlockQuery,
+    BTBPacketTypeResponseBlock
 };
 
 struct BTBPacket {
@@ -95,96 +110,40 @@ struct BTBPacket {
             int interleavingBits; /**<The number of bits used to index
                                      instruction blocks. */
         } response;
-    } data;
-    BTBPacketType type;
-};
-
-struct BTBEntry {
-    bool valid;                      /**<The entry is valid. */
-    unsigned int numBanks;           /**<The number of banks. */
-    unsigned long entryTag;          /**<The entry tag. */
-    unsigned long* targetArray;      /**<The target address array. */
-    BranchType* branchTypes;         /**<The branch types array. */
-    BimodalCounter* predictorsArray; /**<The array of predictors. */
-
-  public:
-    BTBEntry();
-
-    /**
-     * @brief Allocates the BTB entry.
-     * @param numBanks The number of banks in an entry.
-     * @return 0 if successfuly, 1 otherwise.
-     */
-    int Allocate(unsigned int numBanks);
-
-    /**
-     * @brief Register a new entry.
-     * @param tag The tag of this entry's instruction block.
-     * @param bank The bank with which the branch will be registered.
-     * @param target The branch's target address.
-     * @param type The branch's type.
-     * @return 0 if successfuly, 1 otherwise.
-     */
-    int NewEntry(unsigned long tag, unsigned int bank, unsigned long target,
-                 const StaticInstructionInfo* instruction);
-
-    /**
-     * @brief Update the BTB entry.
-     * @param bank The bank containing the branch to be updated.
-     * @param branchState The state of the branch, whether it has been taken or
-     * not.
-     * @return 0 if successfuly, 1 otherwise.
-     */
-    int UpdateEntry(unsigned long bank, bool branchState);
-
-    /**
-     * @brief Gets the valid bit of entry.
-     */
-    inline bool GetValid() { return this->valid; };
-
-    /**
-     * @brief Gets the tag of the entry
-     */
-    inline unsigned long GetTag() { return this->entryTag; };
-
-    /**
-     * @brief Gets the branch target address.
-     * @param bank The bank containing the branch.
-     */
-    inline unsigned long GetTargetAddress(unsigned int bank) {
-        if (bank < this->numBanks) return this->targetArray[bank];
 
-        return 0;
-    };
-
-    /**
-     * @brief Gets the branch type.
-     * @param bank The bank containing the branch.
-     */
-    inline BranchType GetBranchType(unsigned int bank) {
-        if (bank < this->numBanks) return this->branchTypes[bank];
-
-        return BranchTypeNone;
-    };
-
-    /**
-     * @brief Gets the branch prediction.
-     * @param bank The bank containing the branch.
-     */
-    inline bool GetPrediction(unsigned int bank) {
-        if (bank < this->numBanks) {
-            return this->predictorsArray[bank].GetPrediction();
-        }
-
-        return false;
-    };
+        struct {
+            const StaticInstructionInfo*
+                instructions[MAX_FETCH_BLOCK_INSTRUCTIONS];
+            unsigned long startAddress; /**<Of the first instruction. */
+            unsigned int numberOfInstructions;
+        } requestBlockQuery; /**<A fetch block to look up. */
 
-    ~BTBEntry();
+        struct {
+            unsigned long targets[MAX_FETCH_BLOCK_INSTRUCTIONS]; /**<Of the
+                                                                    hits. */
+            unsigned long startAddress;
+            unsigned int numberOfInstructions;
+            unsigned int hitMask;   /**<Slots holding a branch. */
+            unsigned int takenMask; /**<Hits predicted taken. */
+        } blockResponse; /**<Per slot answer to a block query. */
+    } data;
+    BTBPacketType type;
 };
 
 class BranchTargetBuffer : public Component<struct BTBPacket> {
   private:
-    BTBEntry** btb; /**<The pointer to BTB struct. */
+    /**
+     * The BTB is stored as flat arrays indexed by [entry x bank]. The tags and
+     * the replacement state live in a CacheMemory whose value is the index of
+     * the entry in these arrays, so the associativity and replacement policy
+     * come from it. Entries are handed out in order and never freed, an
+     * eviction reuses the index of the victim.
+     */
+    CacheMemory<unsigned int>* tags;
+    unsigned long* targetArray;      /**<The target addresses. */
+    BranchType* branchTypes;         /**<The branch types. */
+    CounterTable predictorsArray;    /**<The direction predictors. */
+    unsigned int allocatedEntries;   /**<Entries handed out so far. */
 
     Component<BTBPacket>* sendTo; /**<Component to which forward responses.> */
 
@@ -195,6 +154,7 @@ class BranchTargetBuffer : public Component<struct BTBPacket> {
                               banks in which the BTB is interleaved. */
 
     unsigned int numEntries;       /**<The number of BTB entries. */
+    unsigned int associativity;    /**<The number of ways of each set. */
     unsigned int interleavingBits; /**< InterleavingFactor in bits. */
     unsigned int entriesBits;      /**<Number of entries in bits. */
 
@@ -203,7 +163,6 @@ class BranchTargetBuffer : public Component<struct BTBPacket> {
     unsigned long
         totalBranch;       /**<The total number of branch instructions added. */
     unsigned long queries; /**<The number of BTB queries. */
-    unsigned long occupation;   /**<The total occupancy of BTB. */
     unsigned long replacements; /**<The number of entries replaced. */
 
     /**
@@ -211,21 +170,9 @@ class BranchTargetBuffer : public Component<struct BTBPacket> {
      * @param address The address that will be used to calculate the bank.
      * @return Which bank the instruction is in.
      */
-    unsigned int CalculateBank(unsigned long address);
-
-    /**
-     * @brief Calculate the tag based on address.
-     * @param address The address that will be used to calculate the tag.
-     * @return The tag of instruction block.
-     */
-    unsigned long CalculateTag(unsigned long address);
-
-    /**
-     * @brief Calculate the index based on address.
-     * @param address The address that will be used to calculate the index.
-     * @return The index of branch, In which BTB entry is the branch located.
-     */
-    unsigned long CalculateIndex(unsigned long address);
+    inline unsigned int CalculateBank(unsigned long address) {
+        return address & (this->interleavingFactor - 1);
+    }
 
     /**
      * @brief Register a new branch in BTB.
@@ -264,6 +211,13 @@ class BranchTargetBuffer : public Component<struct BTBPacket> {
     inline void Query(const StaticInstructionInfo* instruction,
                       int connectionID);
 
+    /**
+     * @brief Method for RequestBlockQuery.
+     * @param packet The request, turned into the response in place.
+     * @param connectionID The ID of the connection that received the request.
+     */
+    inline void QueryBlock(BTBPacket* packet, int connectionID);
+
     /**
      * @brief Method for RequestAddEntry.
      * @param address The address of a branch instruction.
@@ -292,4 +246,8 @@ class BranchTargetBuffer : public Component<struct BTBPacket> {
     ~BranchTargetBuffer();
 };
 
+#ifndef NDEBUG
+int TestBranchTargetBuffer();
+#endif
+
 #endif
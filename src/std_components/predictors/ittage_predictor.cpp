@@ -0,0 +1,537 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file ittage_predictor.cpp
+ * @brief Implementation of the ITTAGE indirect branch target predictor.
+ */
+
+#include "ittage_predictor.hpp"
+
+#include <cmath>
+#include <sinuca3.hpp>
+#include <std_components/predictors/block_query.hpp>
+
+/** @brief Updates between two halvings of the useful counters. */
+static const unsigned long ITTAGE_USEFUL_RESET_PERIOD = 1UL << 18;
+
+IttagePredictor::IttagePredictor()
+    : baseTargets(NULL),
+      entries(NULL),
+      numTables(6),
+      tableBits(0),
+      baseBits(0),
+      history(NULL),
+      historyMask(0),
+      historyHead(0),
+      pathHistory(0),
+      updatesSinceReset(0),
+      randomState(1),
+      sendTo(NULL),
+      sendToId(0),
+      numberOfQueries(0),
+      numberOfPredictions(0),
+      numberOfUnknownTargets(0),
+      numberOfUpdates(0),
+      numberOfWrongPredictions(0),
+      numberOfAllocations(0),
+      numberOfFailedAllocations(0),
+      baseProvided(0) {
+    for (int i = 0; i < ITTAGE_MAX_TABLES; ++i) this->providerHits[i] = 0;
+}
+
+IttagePredictor::~IttagePredictor() {
+    delete[] this->baseTargets;
+    delete[] this->entries;
+    delete[] this->history;
+}
+
+int IttagePredictor::Configure(Config config) {
+    long baseEntries = 1024;
+    long tableEntries = 512;
+    long tables = this->numTables;
+    long minHistory = 4;
+    long maxHistory = 256;
+    long minTagBits = 9;
+    long maxTagBits = 15;
+    long checkpoints = 64;
+
+    if (config.Integer("baseEntries", &baseEntries)) return 1;
+    if (config.Integer("tables", &tables)) return 1;
+    if (config.Integer("tableEntries", &tableEntries)) return 1;
+    if (config.Integer("minHistory", &minHistory)) return 1;
+    if (config.Integer("maxHistory", &maxHistory)) return 1;
+    if (config.Integer("minTagBits", &minTagBits)) return 1;
+    if (config.Integer("maxTagBits", &maxTagBits)) return 1;
+    if (config.Integer("checkpoints", &checkpoints)) return 1;
+
+    if (baseEntries <= 1) return config.Error("baseEntries", "is not > 1.");
+    if (tables <= 0 || tables > ITTAGE_MAX_TABLES)
+        return config.Error("tables", "is not between 1 and 16.");
+    if (tableEntries <= 1)
+        return config.Error("tableEntries", "is not > 1.");
+    if (minHistory <= 0) return config.Error("minHistory", "is not > 0.");
+    if (maxHistory < minHistory || maxHistory > ITTAGE_MAX_HISTORY)
+        return config.Error("maxHistory",
+                            "is not between minHistory and 1024.");
+    if (minTagBits < 2) return config.Error("minTagBits", "is not >= 2.");
+    if (maxTagBits < minTagBits || maxTagBits > ITTAGE_MAX_TAG_BITS)
+        return config.Error("maxTagBits",
+                            "is not between minTagBits and 16.");
+    if (checkpoints <= 0) return config.Error("checkpoints", "is not > 0.");
+
+    this->numTables = tables;
+    this->baseBits = floor(log2(baseEntries));
+    this->tableBits = floor(log2(tableEntries));
+
+    for (int i = 0; i < this->numTables; ++i) {
+        double ratio = (this->numTables == 1)
+                           ? 0.0
+                           : (double)i / (double)(this->numTables - 1);
+        int length = (int)(minHistory *
+                               pow((double)maxHistory / minHistory, ratio) +
+                           0.5);
+        if (i > 0 && length <= this->historyLengths[i - 1]) {
+            length = this->historyLengths[i - 1] + 1;
+        }
+        this->historyLengths[i] = length;
+        this->tagBits[i] =
+            minTagBits + (int)((maxTagBits - minTagBits) * ratio + 0.5);
+
+        this->indexFolds[i].Configure(length, this->tableBits);
+        this->tagFolds[i].Configure(length, this->tagBits[i]);
+        this->tagFoldsShort[i].Configure(length, this->tagBits[i] - 1);
+    }
+
+    unsigned long historySize = 1;
+    while (historySize <= (unsigned long)this->historyLengths[tables - 1] +
+                              ITTAGE_BITS_PER_TARGET * checkpoints) {
+        historySize <<= 1;
+    }
+    this->historyMask = historySize - 1;
+    this->history = new unsigned char[historySize]();
+
+    if (config.ComponentReference("sendTo", &this->sendTo)) return 1;
+    if (this->sendTo != NULL) this->sendToId = this->sendTo->Connect(0);
+
+    this->baseTargets = new unsigned long[1UL << this->baseBits]();
+    this->entries =
+        new IttageEntry[(unsigned long)tables << this->tableBits]();
+    this->checkpoints.Allocate(checkpoints);
+
+    return 0;
+}
+
+void IttagePredictor::PushHistory(unsigned long target, unsigned long addr) {
+    unsigned long bits = target ^ (target >> 3) ^ (target >> 7);
+    for (int b = 0; b < ITTAGE_BITS_PER_TARGET; ++b) {
+        unsigned int bit = (bits >> b) & 1;
+        ++this->historyHead;
+        this->history[this->historyHead & this->historyMask] = bit;
+        for (int i = 0; i < this->numTables; ++i) {
+            unsigned int oldBit = this->HistoryBit(this->historyLengths[i]);
+            this->indexFolds[i].Update(bit, oldBit);
+            this->tagFolds[i].Update(bit, oldBit);
+            this->tagFoldsShort[i].Update(bit, oldBit);
+        }
+    }
+    this->pathHistory =
+        ((this->pathHistory << 1) | ((addr ^ (addr >> 2)) & 1)) &
+        ((1UL << ITTAGE_PATH_HISTORY_BITS) - 1);
+}
+
+void IttagePredictor::SaveHistory(IttageCheckpoint* checkpoint) {
+    checkpoint->historyHead = this->historyHead;
+    checkpoint->pathHistory = this->pathHistory;
+    for (int i = 0; i < this->numTables; ++i) {
+        checkpoint->indexFolds[i] = this->indexFolds[i].value;
+        checkpoint->tagFolds[i] = this->tagFolds[i].value;
+        checkpoint->tagFoldsShort[i] = this->tagFoldsShort[i].value;
+    }
+}
+
+void IttagePredictor::RestoreHistory(const IttageCheckpoint* checkpoint) {
+    this->historyHead = checkpoint->historyHead;
+    this->pathHistory = checkpoint->pathHistory;
+    for (int i = 0; i < this->numTables; ++i) {
+        this->indexFolds[i].value = checkpoint->indexFolds[i];
+        this->tagFolds[i].value = checkpoint->tagFolds[i];
+        this->tagFoldsShort[i].value = checkpoint->tagFoldsShort[i];
+    }
+}
+
+void IttagePredictor::ReplayBranch(IttageCheckpoint* checkpoint) {
+    this->SaveHistory(checkpoint);
+    this->PushHistory(checkpoint->predictedTarget,
+                      checkpoint->instruction->instAddress);
+}
+
+void IttagePredictor::Predict(unsigned long addr,
+                              IttageCheckpoint* checkpoint) {
+    unsigned long tableMask = (1UL << this->tableBits) - 1;
+    checkpoint->baseIndex = addr & ((1UL << this->baseBits) - 1);
+    checkpoint->provider = -1;
+    int alternate = -1;
+
+    for (int i = this->numTables - 1; i >= 0; --i) {
+        int pathBits = this->historyLengths[i] < ITTAGE_PATH_HISTORY_BITS
+                           ? this->historyLengths[i]
+                           : ITTAGE_PATH_HISTORY_BITS;
+        unsigned long path = this->pathHistory & ((1UL << pathBits) - 1);
+        unsigned int index =
+            (addr ^ (addr >> (this->tableBits - (i % this->tableBits))) ^
+             this->indexFolds[i].value ^ path ^ (path >> this->tableBits)) &
+            tableMask;
+        unsigned int tag = (addr ^ this->tagFolds[i].value ^
+                            (this->tagFoldsShort[i].value << 1)) &
+                           ((1U << this->tagBits[i]) - 1);
+        checkpoint->indices[i] = index;
+        checkpoint->tags[i] = tag;
+
+        if (this->Entry(i, index)->tag != tag) continue;
+        if (checkpoint->provider < 0) {
+            checkpoint->provider = i;
+        } else if (alternate < 0) {
+            alternate = i;
+        }
+    }
+
+    unsigned long baseTarget = this->baseTargets[checkpoint->baseIndex];
+    checkpoint->alternateTarget =
+        alternate < 0
+            ? baseTarget
+            : this->Entry(alternate, checkpoint->indices[alternate])->target;
+
+    if (checkpoint->provider < 0) {
+        checkpoint->predictedTarget = baseTarget;
+        return;
+    }
+
+    const IttageEntry* entry = this->Entry(
+        checkpoint->provider, checkpoint->indices[checkpoint->provider]);
+    checkpoint->predictedTarget =
+        (entry->confidence == 0 && checkpoint->alternateTarget != 0)
+            ? checkpoint->alternateTarget
+            : entry->target;
+}
+
+void IttagePredictor::Allocate(const IttageCheckpoint* checkpoint,
+                               unsigned long target) {
+    int start = checkpoint->provider + 1;
+    if (start < this->numTables - 1 && (this->Random() & 1)) ++start;
+
+    for (int i = start; i < this->numTables; ++i) {
+        IttageEntry* entry = this->Entry(i, checkpoint->indices[i]);
+        if (entry->useful == 0) {
+            entry->target = target;
+            entry->tag = checkpoint->tags[i];
+            entry->confidence = 0;
+            ++this->numberOfAllocations;
+            return;
+        }
+    }
+
+    ++this->numberOfFailedAllocations;
+    for (int i = start; i < this->numTables; ++i) {
+        IttageEntry* entry = this->Entry(i, checkpoint->indices[i]);
+        if (entry->useful > 0) --entry->useful;
+    }
+}
+
+void IttagePredictor::Train(const IttageCheckpoint* checkpoint,
+                            unsigned long target) {
+    int provider = checkpoint->provider;
+    IttageEntry* entry =
+        provider < 0 ? NULL
+                     : this->Entry(provider, checkpoint->indices[provider]);
+    if (entry != NULL && entry->tag != checkpoint->tags[provider]) {
+        entry = NULL;
+    }
+
+    bool allocate = checkpoint->predictedTarget != target &&
+                    provider < this->numTables - 1;
+    if (entry != NULL && entry->confidence == 0 && entry->target == target) {
+        allocate = false;
+    }
+    if (allocate) this->Allocate(checkpoint, target);
+
+    if (provider < 0) {
+        ++this->baseProvided;
+    } else {
+        ++this->providerHits[provider];
+    }
+    if (entry != NULL) {
+        if (entry->target == target) {
+            if (entry->confidence < 3) ++entry->confidence;
+            if (checkpoint->alternateTarget != target && entry->useful < 3) {
+                ++entry->useful;
+            }
+        } else {
+            // Targets are replaced only once the confidence is gone.
+            if (entry->confidence > 0) {
+                --entry->confidence;
+            } else {
+                entry->target = target;
+            }
+            if (checkpoint->alternateTarget == target && entry->useful > 0) {
+                --entry->useful;
+            }
+        }
+    }
+    // The base table is a plain target buffer, it keeps the last target.
+    this->baseTargets[checkpoint->baseIndex] = target;
+
+    if (++this->updatesSinceReset == ITTAGE_USEFUL_RESET_PERIOD) {
+        this->updatesSinceReset = 0;
+        unsigned long size = (unsigned long)this->numTables << this->tableBits;
+        for (unsigned long i = 0; i < size; ++i) {
+            this->entries[i].useful >>= 1;
+        }
+    }
+}
+
+void IttagePredictor::Query(PredictorPacket* pkt) {
+    ++this->numberOfQueries;
+    const StaticInstructionInfo* instruction =
+        pkt->data.requestQuery.staticInfo;
+    if (!IsPredicted(instruction)) {
+        pkt->type = PredictorPacketTypeResponseUnknown;
+        return;
+    }
+
+    IttageCheckpoint* checkpoint = this->checkpoints.Push(instruction);
+    this->SaveHistory(checkpoint);
+    this->Predict(instruction->instAddress, checkpoint);
+    this->PushHistory(checkpoint->predictedTarget, instruction->instAddress);
+    ++this->numberOfPredictions;
+
+    if (checkpoint->predictedTarget == 0) {
+        ++this->numberOfUnknownTargets;
+        pkt->type = PredictorPacketTypeResponseUnknown;
+        return;
+    }
+    InstructionPacket instructionPacket = pkt->data.requestQuery;
+    pkt->type = PredictorPacketTypeResponseTakeToAddress;
+    pkt->data.targetResponse.instruction = instructionPacket;
+    pkt->data.targetResponse.target = checkpoint->predictedTarget;
+}
+
+void IttagePredictor::Update(const PredictorPacket* pkt) {
+    const StaticInstructionInfo* instruction =
+        pkt->data.targetUpdate.instruction.staticInfo;
+    unsigned long target = pkt->data.targetUpdate.target;
+    // Updates of returns would otherwise drop every branch in flight.
+    if (!IsPredicted(instruction)) return;
+
+    IttageCheckpoint* checkpoint = this->checkpoints.Resolve(instruction);
+    if (checkpoint == NULL) {
+        SINUCA3_DEBUG_PRINTF("Ittage update without a prediction\n");
+        return;
+    }
+
+    ++this->numberOfUpdates;
+    this->Train(checkpoint, target);
+
+    if (checkpoint->predictedTarget != target) {
+        ++this->numberOfWrongPredictions;
+        this->RestoreHistory(checkpoint);
+        this->PushHistory(target, instruction->instAddress);
+        this->checkpoints.Replay(this, &IttagePredictor::ReplayBranch);
+    }
+
+    this->checkpoints.Pop();
+}
+
+void IttagePredictor::Clock() {
+    PredictorPacket packet;
+    long totalConnections = this->GetNumberOfConnections();
+    for (long i = 0; i < totalConnections; i++) {
+        while (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+            if (packet.type == PredictorPacketTypeRequestTargetUpdate) {
+                this->Update(&packet);
+                continue;
+            }
+            if (packet.type == PredictorPacketTypeRequestQuery) {
+                this->Query(&packet);
+            } else if (packet.type == PredictorPacketTypeRequestBlockQuery) {
+                AnswerBlockQuery(this, &IttagePredictor::Query, &packet);
+            } else {
+                continue;
+            }
+            if (this->sendTo == NULL) {
+                this->SendResponseToConnection(i, &packet);
+            } else {
+                this->sendTo->SendRequest(this->sendToId, &packet);
+            }
+        }
+    }
+}
+
+void IttagePredictor::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("Ittage [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Base table entries [%lu]\n", 1UL << this->baseBits);
+    for (int i = 0; i < this->numTables; ++i) {
+        SINUCA3_LOG_PRINTF(
+            "    Table %d: %lu entries, history %d, tag %d bits, provided "
+            "[%lu]\n",
+            i, 1UL << this->tableBits, this->historyLengths[i],
+            this->tagBits[i], this->providerHits[i]);
+    }
+    SINUCA3_LOG_PRINTF("    Base table provided [%lu]\n", this->baseProvided);
+    SINUCA3_LOG_PRINTF("    Queries [%lu]\n", this->numberOfQueries);
+    SINUCA3_LOG_PRINTF("    Indirect branches predicted [%lu]\n",
+                       this->numberOfPredictions);
+    SINUCA3_LOG_PRINTF("    Unknown targets [%lu]\n",
+                       this->numberOfUnknownTargets);
+    SINUCA3_LOG_PRINTF("    Indirect branches resolved [%lu]\n",
+                       this->numberOfUpdates);
+    SINUCA3_LOG_PRINTF("    Wrong targets [%lu]\n",
+                       this->numberOfWrongPredictions);
+    SINUCA3_LOG_PRINTF("    Allocations [%lu], failed [%lu]\n",
+                       this->numberOfAllocations,
+                       this->numberOfFailedAllocations);
+    SINUCA3_LOG_PRINTF("    Dropped checkpoints [%lu]\n",
+                       this->checkpoints.GetNumberOfDropped());
+    if (this->numberOfUpdates > 0) {
+        SINUCA3_LOG_PRINTF("    Rate of wrong targets [%.2lf]%%\n",
+                           100.0 * this->numberOfWrongPredictions /
+                               this->numberOfUpdates);
+    }
+}
+
+#ifndef NDEBUG
+
+bool IttagePredictor::FoldsAreConsistent() const {
+    const FoldedHistory* folds[] = {this->indexFolds, this->tagFolds,
+                                    this->tagFoldsShort};
+    for (int f = 0; f < 3; ++f) {
+        for (int i = 0; i < this->numTables; ++i) {
+            const FoldedHistory* fold = &folds[f][i];
+            unsigned int value = 0;
+            for (int d = fold->length - 1; d >= 0; --d) {
+                value = (value << 1) | this->HistoryBit(d);
+                value ^= value >> fold->width;
+                value &= (1U << fold->width) - 1;
+            }
+            if (value != fold->value) return false;
+        }
+    }
+    return true;
+}
+
+/** @return The predicted target, 0 if unknown and 1 without an answer. */
+static unsigned long IttageTestQuery(IttagePredictor* predictor, int id,
+                                     const InstructionPacket* instruction) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestQuery;
+    packet.data.requestQuery = *instruction;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 10; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+        if (predictor->ReceiveResponse(id, &packet) == 0) {
+            if (packet.type != PredictorPacketTypeResponseTakeToAddress) {
+                return 0;
+            }
+            return packet.data.targetResponse.target;
+        }
+    }
+    return 1;
+}
+
+static void IttageTestUpdate(IttagePredictor* predictor, int id,
+                             const InstructionPacket* instruction,
+                             unsigned long target) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestTargetUpdate;
+    packet.data.targetUpdate.instruction = *instruction;
+    packet.data.targetUpdate.target = target;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 2; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+    }
+}
+
+int TestIttage() {
+    IttagePredictor predictor;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    if (predictor.Configure(CreateFakeConfig(&parser,
+                                             "baseEntries: 256\n"
+                                             "tables: 4\n"
+                                             "tableEntries: 256\n"
+                                             "minHistory: 4\n"
+                                             "maxHistory: 64\n",
+                                             &aliases))) {
+        return 1;
+    }
+    int id = predictor.Connect(0);
+
+    StaticInstructionInfo dispatchInfo;
+    dispatchInfo.instAddress = 0x700;
+    dispatchInfo.branchType = BranchUncond;
+    dispatchInfo.isIndirectControlFlowInst = true;
+    StaticInstructionInfo returnInfo;
+    returnInfo.instAddress = 0x800;
+    returnInfo.branchType = BranchRet;
+    returnInfo.isIndirectControlFlowInst = true;
+    InstructionPacket dispatch;
+    dispatch.staticInfo = &dispatchInfo;
+    InstructionPacket ret;
+    ret.staticInfo = &returnInfo;
+
+    if (IttageTestQuery(&predictor, id, &ret) != 0) return 2;
+    if (IttageTestQuery(&predictor, id, &dispatch) != 0) return 3;
+    IttageTestUpdate(&predictor, id, &dispatch, 0x1000);
+    if (IttageTestQuery(&predictor, id, &dispatch) != 0x1000) return 4;
+    IttageTestUpdate(&predictor, id, &dispatch, 0x1000);
+
+    // An interpreter loop: the target of the dispatch depends on the previous
+    // targets, a target buffer misses every time.
+    const unsigned long targets[] = {0x1000, 0x1001, 0x1002, 0x1003};
+    for (int i = 0; i < 200; ++i) {
+        if (IttageTestQuery(&predictor, id, &dispatch) == 1) return 5;
+        IttageTestUpdate(&predictor, id, &dispatch, targets[i % 4]);
+    }
+    unsigned long wrong = predictor.GetNumberOfWrongPredictions();
+    for (int i = 0; i < 8; ++i) {
+        if (IttageTestQuery(&predictor, id, &dispatch) != targets[i % 4]) {
+            return 6;
+        }
+        IttageTestUpdate(&predictor, id, &dispatch, targets[i % 4]);
+    }
+    if (predictor.GetNumberOfWrongPredictions() != wrong) return 7;
+
+    // A wrong target with younger branches in flight repairs the history,
+    // returns do not disturb them.
+    unsigned long predictions[3];
+    for (int i = 0; i < 3; ++i) {
+        predictions[i] = IttageTestQuery(&predictor, id, &dispatch);
+    }
+    IttageTestUpdate(&predictor, id, &ret, 0x900);
+    IttageTestUpdate(&predictor, id, &dispatch, 0x2000);
+    if (predictor.GetNumberOfWrongPredictions() != wrong + 1) return 8;
+    if (!predictor.FoldsAreConsistent()) return 9;
+    IttageTestUpdate(&predictor, id, &dispatch, predictions[1]);
+    IttageTestUpdate(&predictor, id, &dispatch, predictions[2]);
+    if (predictor.GetNumberOfWrongPredictions() != wrong + 1) return 10;
+
+    return 0;
+}
+
+#endif
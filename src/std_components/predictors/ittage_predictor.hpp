@@ -0,0 +1,189 @@
+#ifndef SINUCA3_ITTAGE_PREDICTOR_HPP_
+#define SINUCA3_ITTAGE_PREDICTOR_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file ittage_predictor.hpp
+ * @brief Implementation of the ITTAGE indirect branch target predictor.
+ * @details ITTAGE (A. Seznec, "A 64-Kbytes ITTAGE indirect branch predictor")
+ * applies the TAGE organization to targets: a base table indexed by the
+ * address holds the last target of each branch, and tagged tables indexed
+ * with histories of geometrically increasing lengths hold a target and a
+ * 2-bit confidence counter. The provider is the hit with the longest history,
+ * its target is replaced by the alternate one while its confidence is 0.
+ * Allocation and the useful counters follow TagePredictor, and a provider
+ * replaced while its branch was in flight is not trained.
+ *
+ * The history is the path of indirect targets: each indirect branch shifts
+ * in 2 bits of its target, plus 1 bit of its address in a short path
+ * history, so it tells apart the call sites of interpreters and virtual
+ * dispatch.
+ *
+ * Indirect jumps and calls are predicted with ResponseTakeToAddress, or
+ * ResponseUnknown while no target is known; returns are left to the Ras and
+ * other instructions get ResponseUnknown. As in TagePredictor the history is
+ * updated at prediction time and checkpointed per branch in flight.
+ * RequestTargetUpdate messages with the actual target, in program order,
+ * train the tables and repair the history on mispredictions.
+ *
+ * Parameters:
+ * - baseEntries: integer, entries of the base table, 1024 by default.
+ * - tables: integer from 1 to 16, tagged tables, 6 by default.
+ * - tableEntries: integer, entries of each tagged table, 512 by default.
+ * - minHistory, maxHistory: integers, history lengths in bits of the first
+ * and last tagged tables, 4 and 256 by default, up to 1024.
+ * - minTagBits, maxTagBits: integers, tag widths of the first and last tagged
+ * tables, 9 and 15 by default, up to 16.
+ * - checkpoints: integer, branches in flight, 64 by default.
+ * - sendTo: component to which responses are sent instead, optional.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/checkpoint_ring.hpp>
+#include <utils/folded_history.hpp>
+
+static const int ITTAGE_MAX_TABLES = 16;
+static const int ITTAGE_MAX_HISTORY = 1024;
+static const int ITTAGE_MAX_TAG_BITS = 16;
+static const int ITTAGE_PATH_HISTORY_BITS = 16;
+/** @brief History bits shifted in by each indirect branch. */
+static const int ITTAGE_BITS_PER_TARGET = 2;
+
+struct IttageEntry {
+    unsigned long target;
+    unsigned short tag;
+    unsigned char confidence; /**<0 to 3. */
+    unsigned char useful;     /**<0 to 3. */
+};
+
+/** @brief State saved for a branch in flight. */
+struct IttageCheckpoint {
+    const StaticInstructionInfo* instruction;
+    unsigned long historyHead; /**<The history before the branch. */
+    unsigned long pathHistory;
+    unsigned int indexFolds[ITTAGE_MAX_TABLES];
+    unsigned int tagFolds[ITTAGE_MAX_TABLES];
+    unsigned int tagFoldsShort[ITTAGE_MAX_TABLES];
+
+    unsigned int indices[ITTAGE_MAX_TABLES];
+    unsigned int tags[ITTAGE_MAX_TABLES];
+    unsigned long baseIndex;
+    int provider;  /**<Table of the provider, -1 for the base table. */
+    unsigned long alternateTarget; /**<From the next hit or the base table. */
+    unsigned long predictedTarget; /**<0 if unknown. */
+};
+
+/** @brief Refer to ittage_predictor.hpp documentation for details */
+class IttagePredictor : public Component<PredictorPacket> {
+  private:
+    unsigned long* baseTargets;
+    IttageEntry* entries; /**<[tables x tableEntries] entries. */
+
+    int numTables;
+    unsigned int tableBits;
+    unsigned int baseBits;
+    int historyLengths[ITTAGE_MAX_TABLES];
+    int tagBits[ITTAGE_MAX_TABLES];
+
+    /** @brief Speculative target history, one bit per byte in a ring. */
+    unsigned char* history;
+    unsigned long historyMask;
+    unsigned long historyHead;
+    unsigned long pathHistory;
+    FoldedHistory indexFolds[ITTAGE_MAX_TABLES];
+    FoldedHistory tagFolds[ITTAGE_MAX_TABLES];
+    FoldedHistory tagFoldsShort[ITTAGE_MAX_TABLES];
+
+    CheckpointRing<IttageCheckpoint> checkpoints; /**<Branches in flight. */
+
+    unsigned long updatesSinceReset;
+    unsigned int randomState;
+
+    Component<PredictorPacket>* sendTo;
+    int sendToId;
+
+    /* Statistics */
+    unsigned long numberOfQueries;
+    unsigned long numberOfPredictions;
+    unsigned long numberOfUnknownTargets;
+    unsigned long numberOfUpdates;
+    unsigned long numberOfWrongPredictions;
+    unsigned long numberOfAllocations;
+    unsigned long numberOfFailedAllocations;
+    unsigned long providerHits[ITTAGE_MAX_TABLES];
+    unsigned long baseProvided;
+
+    inline IttageEntry* Entry(int table, unsigned int index) {
+        return &this->entries[((unsigned long)table << this->tableBits) +
+                              index];
+    }
+    /** @brief Bit [distance] bits ago, 0 is the newest. */
+    inline unsigned int HistoryBit(unsigned long distance) const {
+        return this->history[(this->historyHead - distance) &
+                             this->historyMask];
+    }
+    inline unsigned int Random() {
+        this->randomState = this->randomState * 1103515245 + 12345;
+        return this->randomState >> 16;
+    }
+    /** @return True for the branches this predictor answers. */
+    static inline bool IsPredicted(const StaticInstructionInfo* instruction) {
+        return instruction->isIndirectControlFlowInst &&
+               instruction->branchType != BranchRet &&
+               instruction->branchType != BranchSysret;
+    }
+
+    void PushHistory(unsigned long target, unsigned long addr);
+    void SaveHistory(IttageCheckpoint* checkpoint);
+    void RestoreHistory(const IttageCheckpoint* checkpoint);
+    /** @brief Saves the history before [checkpoint] and pushes it again. */
+    void ReplayBranch(IttageCheckpoint* checkpoint);
+    void Predict(unsigned long addr, IttageCheckpoint* checkpoint);
+    void Allocate(const IttageCheckpoint* checkpoint, unsigned long target);
+    void Train(const IttageCheckpoint* checkpoint, unsigned long target);
+
+    /** @brief Predicts [pkt], saves a checkpoint and updates the history. */
+    void Query(PredictorPacket* pkt);
+    /**
+     * @brief Trains the tables with the oldest branch in flight and repairs
+     * the history if it was mispredicted.
+     */
+    void Update(const PredictorPacket* pkt);
+
+  public:
+    IttagePredictor();
+    virtual int Configure(Config config);
+    virtual void PrintStatistics();
+    virtual void Clock();
+    virtual ~IttagePredictor();
+
+#ifndef NDEBUG
+    inline unsigned long GetNumberOfWrongPredictions() const {
+        return this->numberOfWrongPredictions;
+    }
+    /** @return True if every folded history matches the history ring. */
+    bool FoldsAreConsistent() const;
+#endif
+};
+
+#ifndef NDEBUG
+int TestIttage();
+#endif
+
+#endif  // SINUCA3_ITTAGE_PREDICTOR_HPP_
@@ -0,0 +1,464 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file perceptron_predictor.cpp
+ * @brief Implementation of the hashed perceptron conditional branch
+ * predictor.
+ */
+
+#include "perceptron_predictor.hpp"
+
+#include <cmath>
+#include <sinuca3.hpp>
+#include <std_components/predictors/block_query.hpp>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/** @brief Limit of the training threshold counter, as in O-GEHL. */
+static const int PERCEPTRON_THRESHOLD_COUNTER_MAX = 63;
+
+/**
+ * @brief Sums the weights at [offsets].
+ * @param count Multiple of 8, the extra offsets point to a zero weight.
+ */
+static inline int PerceptronSum(const signed char* weights, const int* offsets,
+                                int count) {
+#if defined(__AVX2__)
+    // Each lane gathers 4 bytes starting at its weight, the weight is the
+    // low byte and is sign extended in place.
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < count; i += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)&offsets[i]);
+        __m256i lanes = _mm256_i32gather_epi32((const int*)weights, index, 1);
+        sum = _mm256_add_epi32(
+            sum, _mm256_srai_epi32(_mm256_slli_epi32(lanes, 24), 24));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                 _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+    return _mm_cvtsi128_si32(half);
+#elif defined(__SSE4_1__)
+    // No gather, the weights are packed first and summed 16 at a time.
+    signed char packed[PERCEPTRON_MAX_TABLES] = {0};
+    for (int i = 0; i < count; ++i) packed[i] = weights[offsets[i]];
+    __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)&packed[i]);
+        sum = _mm_add_epi32(sum,
+                            _mm_madd_epi16(_mm_cvtepi8_epi16(bytes), ones));
+        sum = _mm_add_epi32(
+            sum, _mm_madd_epi16(_mm_cvtepi8_epi16(_mm_srli_si128(bytes, 8)),
+                                ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int sum = 0;
+    for (int i = 0; i < count; ++i) sum += weights[offsets[i]];
+    return sum;
+#endif
+}
+
+PerceptronPredictor::PerceptronPredictor()
+    : weights(NULL),
+      numTables(8),
+      paddedTables(8),
+      tableBits(0),
+      theta(0),
+      thresholdCounter(0),
+      history(NULL),
+      historyMask(0),
+      historyHead(0),
+      pathHistory(0),
+      sendTo(NULL),
+      sendToId(0),
+      numberOfQueries(0),
+      numberOfPredictions(0),
+      numberOfUpdates(0),
+      numberOfWrongPredictions(0),
+      numberOfTrainings(0) {}
+
+PerceptronPredictor::~PerceptronPredictor() {
+    delete[] this->weights;
+    delete[] this->history;
+}
+
+int PerceptronPredictor::Configure(Config config) {
+    long tables = this->numTables;
+    long tableEntries = 1024;
+    long minHistory = 3;
+    long maxHistory = 128;
+    long checkpoints = 64;
+
+    if (config.Integer("tables", &tables)) return 1;
+    if (config.Integer("tableEntries", &tableEntries)) return 1;
+    if (config.Integer("minHistory", &minHistory)) return 1;
+    if (config.Integer("maxHistory", &maxHistory)) return 1;
+    if (config.Integer("checkpoints", &checkpoints)) return 1;
+
+    if (tables <= 0 || tables > PERCEPTRON_MAX_TABLES)
+        return config.Error("tables", "is not between 1 and 32.");
+    if (tableEntries <= 1 || tableEntries > (1L << 24))
+        return config.Error("tableEntries", "is not between 2 and 2^24.");
+    if (minHistory <= 0) return config.Error("minHistory", "is not > 0.");
+    if (maxHistory < minHistory || maxHistory > PERCEPTRON_MAX_HISTORY)
+        return config.Error("maxHistory",
+                            "is not between minHistory and 1024.");
+    if (checkpoints <= 0) return config.Error("checkpoints", "is not > 0.");
+
+    this->numTables = tables;
+    this->paddedTables = (tables + 7) & ~7L;
+    this->tableBits = floor(log2(tableEntries));
+    // Initial threshold of O-GEHL, 1.93 * features + 14.
+    this->theta = (int)(1.93 * this->numTables + 14);
+
+    // The first table is the bias, the others use geometric history lengths.
+    this->historyLengths[0] = 0;
+    int longest = 0;
+    for (int i = 1; i < this->numTables; ++i) {
+        double ratio = (this->numTables <= 2)
+                           ? 0.0
+                           : (double)(i - 1) / (double)(this->numTables - 2);
+        int length = (int)(minHistory *
+                               pow((double)maxHistory / minHistory, ratio) +
+                           0.5);
+        if (i > 1 && length <= this->historyLengths[i - 1]) {
+            length = this->historyLengths[i - 1] + 1;
+        }
+        this->historyLengths[i] = length;
+        this->folds[i].Configure(length, this->tableBits);
+        longest = length;
+    }
+
+    unsigned long historySize = 1;
+    while (historySize <= (unsigned long)(longest + checkpoints)) {
+        historySize <<= 1;
+    }
+    this->historyMask = historySize - 1;
+    this->history = new unsigned char[historySize]();
+
+    if (config.ComponentReference("sendTo", &this->sendTo)) return 1;
+    if (this->sendTo != NULL) this->sendToId = this->sendTo->Connect(0);
+
+    // The weight after the tables is the zero the padding offsets point to,
+    // the 3 bytes after it keep the 4 byte gathers inside the array.
+    unsigned long size = (unsigned long)tables << this->tableBits;
+    this->weights = new signed char[size + 4]();
+    this->checkpoints.Allocate(checkpoints);
+
+    return 0;
+}
+
+void PerceptronPredictor::PushHistory(bool taken, unsigned long addr) {
+    ++this->historyHead;
+    this->history[this->historyHead & this->historyMask] = taken;
+    for (int i = 1; i < this->numTables; ++i) {
+        this->folds[i].Update(taken, this->HistoryBit(this->historyLengths[i]));
+    }
+    this->pathHistory =
+        ((this->pathHistory << 1) | ((addr ^ (addr >> 2)) & 1)) &
+        ((1UL << PERCEPTRON_PATH_HISTORY_BITS) - 1);
+}
+
+void PerceptronPredictor::SaveHistory(PerceptronCheckpoint* checkpoint) {
+    checkpoint->historyHead = this->historyHead;
+    checkpoint->pathHistory = this->pathHistory;
+    for (int i = 1; i < this->numTables; ++i) {
+        checkpoint->folds[i] = this->folds[i].value;
+    }
+}
+
+void PerceptronPredictor::RestoreHistory(
+    const PerceptronCheckpoint* checkpoint) {
+    this->historyHead = checkpoint->historyHead;
+    this->pathHistory = checkpoint->pathHistory;
+    for (int i = 1; i < this->numTables; ++i) {
+        this->folds[i].value = checkpoint->folds[i];
+    }
+}
+
+void PerceptronPredictor::ReplayBranch(PerceptronCheckpoint* checkpoint) {
+    this->SaveHistory(checkpoint);
+    this->PushHistory(checkpoint->predictedTaken,
+                      checkpoint->instruction->instAddress);
+}
+
+void PerceptronPredictor::Predict(unsigned long addr,
+                                  PerceptronCheckpoint* checkpoint) {
+    unsigned long tableMask = (1UL << this->tableBits) - 1;
+    unsigned long hashedAddr = addr ^ (addr >> this->tableBits);
+
+    checkpoint->offsets[0] = hashedAddr & tableMask;
+    for (int i = 1; i < this->numTables; ++i) {
+        unsigned long index = hashedAddr ^ this->folds[i].value;
+        // Half of the tables also see the path, as in the hashed perceptron.
+        if (i & 1) {
+            int pathBits =
+                this->historyLengths[i] < PERCEPTRON_PATH_HISTORY_BITS
+                    ? this->historyLengths[i]
+                    : PERCEPTRON_PATH_HISTORY_BITS;
+            unsigned long path = this->pathHistory & ((1UL << pathBits) - 1);
+            index ^= (path << 1) ^ (path >> this->tableBits);
+        }
+        checkpoint->offsets[i] =
+            ((unsigned long)i << this->tableBits) | (index & tableMask);
+    }
+    int zero = this->numTables << this->tableBits;
+    for (int i = this->numTables; i < this->paddedTables; ++i) {
+        checkpoint->offsets[i] = zero;
+    }
+
+    checkpoint->sum =
+        PerceptronSum(this->weights, checkpoint->offsets, this->paddedTables);
+    checkpoint->predictedTaken = checkpoint->sum >= 0;
+}
+
+void PerceptronPredictor::Train(const PerceptronCheckpoint* checkpoint,
+                                bool taken) {
+    bool wrong = checkpoint->predictedTaken != taken;
+    int magnitude = checkpoint->sum < 0 ? -checkpoint->sum : checkpoint->sum;
+    if (!wrong && magnitude > this->theta) return;
+
+    ++this->numberOfTrainings;
+    for (int i = 0; i < this->numTables; ++i) {
+        signed char* weight = &this->weights[checkpoint->offsets[i]];
+        if (taken && *weight < 127) ++*weight;
+        if (!taken && *weight > -127) --*weight;
+    }
+
+    // Too many mispredictions raise the threshold, too many trainings of
+    // correct predictions lower it.
+    if (wrong) {
+        if (++this->thresholdCounter >= PERCEPTRON_THRESHOLD_COUNTER_MAX) {
+            ++this->theta;
+            this->thresholdCounter = 0;
+        }
+    } else if (--this->thresholdCounter <=
+               -PERCEPTRON_THRESHOLD_COUNTER_MAX - 1) {
+        if (this->theta > 0) --this->theta;
+        this->thresholdCounter = 0;
+    }
+}
+
+void PerceptronPredictor::Query(PredictorPacket* pkt) {
+    ++this->numberOfQueries;
+    const StaticInstructionInfo* instruction =
+        pkt->data.requestQuery.staticInfo;
+    if (instruction->branchType != BranchCond) {
+        pkt->type = PredictorPacketTypeResponseUnknown;
+        return;
+    }
+
+    PerceptronCheckpoint* checkpoint = this->checkpoints.Push(instruction);
+    this->SaveHistory(checkpoint);
+    this->Predict(instruction->instAddress, checkpoint);
+    this->PushHistory(checkpoint->predictedTaken, instruction->instAddress);
+    ++this->numberOfPredictions;
+
+    pkt->type = checkpoint->predictedTaken
+                    ? PredictorPacketTypeResponseTake
+                    : PredictorPacketTypeResponseDontTake;
+}
+
+void PerceptronPredictor::Update(const PredictorPacket* pkt) {
+    const StaticInstructionInfo* instruction =
+        pkt->data.directionUpdate.instruction.staticInfo;
+    bool taken = pkt->data.directionUpdate.taken;
+
+    PerceptronCheckpoint* checkpoint = this->checkpoints.Resolve(instruction);
+    if (checkpoint == NULL) {
+        SINUCA3_DEBUG_PRINTF("Perceptron update without a prediction\n");
+        return;
+    }
+
+    ++this->numberOfUpdates;
+    this->Train(checkpoint, taken);
+
+    if (checkpoint->predictedTaken != taken) {
+        ++this->numberOfWrongPredictions;
+        this->RestoreHistory(checkpoint);
+        this->PushHistory(taken, instruction->instAddress);
+        this->checkpoints.Replay(this, &PerceptronPredictor::ReplayBranch);
+    }
+
+    this->checkpoints.Pop();
+}
+
+void PerceptronPredictor::Clock() {
+    PredictorPacket packet;
+    long totalConnections = this->GetNumberOfConnections();
+    for (long i = 0; i < totalConnections; i++) {
+        while (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+            if (packet.type == PredictorPacketTypeRequestDirectionUpdate) {
+                this->Update(&packet);
+                continue;
+            }
+            if (packet.type == PredictorPacketTypeRequestQuery) {
+                this->Query(&packet);
+            } else if (packet.type == PredictorPacketTypeRequestBlockQuery) {
+                AnswerBlockQuery(this, &PerceptronPredictor::Query, &packet);
+            } else {
+                continue;
+            }
+            if (this->sendTo == NULL) {
+                this->SendResponseToConnection(i, &packet);
+            } else {
+                this->sendTo->SendRequest(this->sendToId, &packet);
+            }
+        }
+    }
+}
+
+void PerceptronPredictor::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("Perceptron [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Tables [%d] of [%lu] weights\n", this->numTables,
+                       1UL << this->tableBits);
+    for (int i = 1; i < this->numTables; ++i) {
+        SINUCA3_LOG_PRINTF("    Table %d history [%d]\n", i,
+                           this->historyLengths[i]);
+    }
+    SINUCA3_LOG_PRINTF("    Queries [%lu]\n", this->numberOfQueries);
+    SINUCA3_LOG_PRINTF("    Conditional branches predicted [%lu]\n",
+                       this->numberOfPredictions);
+    SINUCA3_LOG_PRINTF("    Conditional branches resolved [%lu]\n",
+                       this->numberOfUpdates);
+    SINUCA3_LOG_PRINTF("    Wrong predictions [%lu]\n",
+                       this->numberOfWrongPredictions);
+    SINUCA3_LOG_PRINTF("    Trainings [%lu], final threshold [%d]\n",
+                       this->numberOfTrainings, this->theta);
+    SINUCA3_LOG_PRINTF("    Dropped checkpoints [%lu]\n",
+                       this->checkpoints.GetNumberOfDropped());
+    if (this->numberOfUpdates > 0) {
+        SINUCA3_LOG_PRINTF("    Rate of wrong predictions [%.2lf]%%\n",
+                           100.0 * this->numberOfWrongPredictions /
+                               this->numberOfUpdates);
+    }
+}
+
+#ifndef NDEBUG
+
+static int PerceptronTestQuery(PerceptronPredictor* predictor, int id,
+                               const InstructionPacket* instruction) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestQuery;
+    packet.data.requestQuery = *instruction;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 10; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+        if (predictor->ReceiveResponse(id, &packet) == 0) {
+            return packet.type;
+        }
+    }
+    return -1;
+}
+
+static void PerceptronTestUpdate(PerceptronPredictor* predictor, int id,
+                                 const InstructionPacket* instruction,
+                                 bool taken) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestDirectionUpdate;
+    packet.data.directionUpdate.instruction = *instruction;
+    packet.data.directionUpdate.taken = taken;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 2; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+    }
+}
+
+int TestPerceptron() {
+    PerceptronPredictor predictor;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    if (predictor.Configure(CreateFakeConfig(&parser,
+                                             "tables: 6\n"
+                                             "tableEntries: 256\n"
+                                             "minHistory: 2\n"
+                                             "maxHistory: 32\n",
+                                             &aliases))) {
+        return 1;
+    }
+    int id = predictor.Connect(0);
+
+    StaticInstructionInfo firstInfo;
+    firstInfo.instAddress = 0x500;
+    firstInfo.branchType = BranchCond;
+    StaticInstructionInfo secondInfo;
+    secondInfo.instAddress = 0x520;
+    secondInfo.branchType = BranchCond;
+    StaticInstructionInfo aluInfo;
+    aluInfo.instAddress = 0x504;
+    InstructionPacket first;
+    first.staticInfo = &firstInfo;
+    InstructionPacket second;
+    second.staticInfo = &secondInfo;
+    InstructionPacket alu;
+    alu.staticInfo = &aluInfo;
+
+    if (PerceptronTestQuery(&predictor, id, &alu) !=
+        PredictorPacketTypeResponseUnknown) {
+        return 2;
+    }
+
+    // The first branch is random and the second one repeats it, only the
+    // history can predict the second.
+    unsigned long random = 1;
+    int secondWrong = 0;
+    for (int i = 0; i < 600; ++i) {
+        random = random * 1103515245 + 12345;
+        bool taken = (random >> 16) & 1;
+        if (PerceptronTestQuery(&predictor, id, &first) < 0) return 3;
+        PerceptronTestUpdate(&predictor, id, &first, taken);
+
+        int prediction = PerceptronTestQuery(&predictor, id, &second);
+        if (prediction < 0) return 4;
+        int expected = taken ? PredictorPacketTypeResponseTake
+                             : PredictorPacketTypeResponseDontTake;
+        if (i >= 400 && prediction != expected) ++secondWrong;
+        PerceptronTestUpdate(&predictor, id, &second, taken);
+    }
+    if (secondWrong > 4) return 5;
+
+    // Same repair of the speculative history as the other predictors.
+    unsigned long history = predictor.GetRecentHistory(8);
+    int predictions[3];
+    for (int i = 0; i < 3; ++i) {
+        predictions[i] = PerceptronTestQuery(&predictor, id, &first) ==
+                         PredictorPacketTypeResponseTake;
+    }
+    unsigned long expected = (history << 3) | (predictions[0] << 2) |
+                             (predictions[1] << 1) | predictions[2];
+    if (predictor.GetRecentHistory(11) != expected) return 6;
+
+    PerceptronTestUpdate(&predictor, id, &first, !predictions[0]);
+    expected ^= 1 << 2;
+    if (predictor.GetRecentHistory(11) != expected) return 7;
+    PerceptronTestUpdate(&predictor, id, &first, predictions[1]);
+    PerceptronTestUpdate(&predictor, id, &first, predictions[2]);
+    if (predictor.GetRecentHistory(11) != expected) return 8;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef SINUCA3_PERCEPTRON_PREDICTOR_HPP_
+#define SINUCA3_PERCEPTRON_PREDICTOR_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file perceptron_predictor.hpp
+ * @brief Implementation of a hashed perceptron conditional branch predictor.
+ * @details The hashed perceptron (D. Tarjan and K. Skadron, "Merging path and
+ * gshare indexing in perceptron branch prediction") keeps one table of 8-bit
+ * weights per feature. Each feature hashes the branch address with a segment
+ * of the global history, of geometrically increasing length, and with the
+ * path history for the odd tables; the first table is indexed by the address
+ * alone and acts as a bias. The prediction is taken if the sum of the
+ * selected weights is not negative. The weights are trained on a
+ * misprediction or when the sum is below a threshold, which adapts as in
+ * O-GEHL.
+ *
+ * The sum is computed with an AVX2 gather of the weights, or with SSE4.1
+ * when AVX2 is not enabled, falling back to a scalar loop. As in TAGE the
+ * histories are folded onto the index width and updated incrementally.
+ *
+ * It speaks the same protocol as GsharePredictor: only conditional branches
+ * are predicted, the history is updated speculatively and checkpointed per
+ * branch in flight, and RequestDirectionUpdate messages, in program order,
+ * train the weights and repair the history on mispredictions.
+ *
+ * Parameters:
+ * - tables: integer from 1 to 32, 8 by default.
+ * - tableEntries: integer, weights per table, 1024 by default.
+ * - minHistory, maxHistory: integers, history lengths of the second and last
+ * tables, 3 and 128 by default, up to 1024.
+ * - checkpoints: integer, branches in flight, 64 by default.
+ * - sendTo: component to which responses are sent instead, optional.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/checkpoint_ring.hpp>
+#include <utils/folded_history.hpp>
+
+static const int PERCEPTRON_MAX_TABLES = 32;
+static const int PERCEPTRON_MAX_HISTORY = 1024;
+static const int PERCEPTRON_PATH_HISTORY_BITS = 16;
+
+/** @brief State saved for a branch in flight. */
+struct PerceptronCheckpoint {
+    const StaticInstructionInfo* instruction;
+    unsigned long historyHead; /**<The history before the branch. */
+    unsigned long pathHistory;
+    unsigned int folds[PERCEPTRON_MAX_TABLES];
+
+    /** @brief Weights used, as offsets in the flat array. Padded to a
+     * multiple of 8 with the offset of a zero weight. */
+    int offsets[PERCEPTRON_MAX_TABLES];
+    int sum;
+    bool predictedTaken;
+};
+
+/** @brief Refer to perceptron_predictor.hpp documentation for details */
+class PerceptronPredictor : public Component<PredictorPacket> {
+  private:
+    signed char* weights; /**<[tables x tableEntries], then padding. */
+    int numTables;
+    int paddedTables; /**<numTables rounded up to 8. */
+    unsigned int tableBits;
+    int historyLengths[PERCEPTRON_MAX_TABLES];
+
+    int theta; /**<Training threshold. */
+    int thresholdCounter;
+
+    /** @brief Speculative global history, one bit per byte in a ring. */
+    unsigned char* history;
+    unsigned long historyMask;
+    unsigned long historyHead;
+    unsigned long pathHistory;
+    FoldedHistory folds[PERCEPTRON_MAX_TABLES];
+
+    CheckpointRing<PerceptronCheckpoint> checkpoints; /**<Branches in flight. */
+
+    Component<PredictorPacket>* sendTo;
+    int sendToId;
+
+    /* Statistics */
+    unsigned long numberOfQueries;
+    unsigned long numberOfPredictions;
+    unsigned long numberOfUpdates;
+    unsigned long numberOfWrongPredictions;
+    unsigned long numberOfTrainings;
+
+    /** @brief Bit [distance] branches ago, 0 is the newest. */
+    inline unsigned int HistoryBit(unsigned long distance) const {
+        return this->history[(this->historyHead - distance) &
+                             this->historyMask];
+    }
+
+    void PushHistory(bool taken, unsigned long addr);
+    void SaveHistory(PerceptronCheckpoint* checkpoint);
+    void RestoreHistory(const PerceptronCheckpoint* checkpoint);
+    /** @brief Saves the history before [checkpoint] and pushes it again. */
+    void ReplayBranch(PerceptronCheckpoint* checkpoint);
+    void Predict(unsigned long addr, PerceptronCheckpoint* checkpoint);
+    void Train(const PerceptronCheckpoint* checkpoint, bool taken);
+
+    /** @brief Predicts [pkt], saves a checkpoint and updates the history. */
+    void Query(PredictorPacket* pkt);
+    /**
+     * @brief Trains the weights of the oldest branch in flight and repairs
+     * the history if it was mispredicted.
+     */
+    void Update(const PredictorPacket* pkt);
+
+  public:
+    PerceptronPredictor();
+    virtual int Configure(Config config);
+    virtual void PrintStatistics();
+    virtual void Clock();
+    virtual ~PerceptronPredictor();
+
+#ifndef NDEBUG
+    inline unsigned long GetNumberOfWrongPredictions() const {
+        return this->numberOfWrongPredictions;
+    }
+    /** @return The last [bits] bits of the history, newest in bit 0. */
+    inline unsigned long GetRecentHistory(int bits) const {
+        unsigned long recent = 0;
+        for (int i = bits - 1; i >= 0; --i) {
+            recent = (recent << 1) | this->HistoryBit(i);
+        }
+        return recent;
+    }
+#endif
+};
+
+#ifndef NDEBUG
+int TestPerceptron();
+#endif
+
+#endif  // SINUCA3_PERCEPTRON_PREDICTOR_HPP_
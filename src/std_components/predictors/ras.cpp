@@ -17,63 +17,167 @@
 
 /**
  * @file ras.cpp
- * @brief Implementation of the Ras, a simple return address stack.
+ * @brief Implementation of the Ras, a return address stack with speculative
+ * updates.
  */
 
 #include "ras.hpp"
 
+#include <cstring>
 #include <sinuca3.hpp>
+#include <std_components/predictors/block_query.hpp>
 
 int Ras::Configure(Config config) {
     long size;
+    long checkpoints = 64;
+    const char* overflow = "circular";
     if (config.Integer("size", &size, true)) return 1;
+    if (config.Integer("checkpoints", &checkpoints)) return 1;
+    if (config.String("overflow", &overflow)) return 1;
     if (size <= 0) return config.Error("size", "is not > 0.");
+    if (checkpoints <= 0) return config.Error("checkpoints", "is not > 0.");
+    if (strcmp(overflow, "circular") == 0) {
+        this->countOverflow = false;
+    } else if (strcmp(overflow, "counter") == 0) {
+        this->countOverflow = true;
+    } else {
+        return config.Error("overflow", "should be circular or counter");
+    }
     this->size = size;
 
     if (config.ComponentReference("sendTo", &this->sendTo)) return 1;
     if (this->sendTo != NULL) this->forwardToID = this->sendTo->Connect(0);
 
     this->buffer = new unsigned long[this->size]();
+    this->checkpoints.Allocate(checkpoints);
 
     return 0;
 }
 
-inline void Ras::RequestQuery(InstructionPacket instruction, int connectionID) {
-    unsigned long prediction = this->buffer[this->end];
-    --this->end;
-    if (this->end < 0) this->end = this->size - 1;
+void Ras::Push(unsigned long address) {
+    if (this->occupation == this->size) {
+        if (this->countOverflow) {
+            ++this->overflowed;
+            return;
+        }
+    } else {
+        ++this->occupation;
+    }
+    ++this->top;
+    if (this->top >= this->size) this->top = 0;
+    this->buffer[this->top] = address;
+}
 
-    PredictorPacket response;
-    response.type = PredictorPacketTypeResponseTakeToAddress;
-    response.data.targetResponse.instruction = instruction;
-    response.data.targetResponse.target = prediction;
+unsigned long Ras::Pop() {
+    // The frames of the calls that were not pushed return first.
+    if (this->overflowed > 0) {
+        --this->overflowed;
+        return 0;
+    }
+    if (this->occupation == 0) return 0;
+    unsigned long address = this->buffer[this->top];
+    --this->top;
+    if (this->top < 0) this->top = this->size - 1;
+    --this->occupation;
+    return address;
+}
+
+void Ras::SaveState(RasCheckpoint* checkpoint) {
+    checkpoint->top = this->top;
+    checkpoint->topEntry = this->buffer[this->top];
+    checkpoint->occupation = this->occupation;
+    checkpoint->overflowed = this->overflowed;
+}
 
-    this->SendResponseToConnection(connectionID, &response);
-    if (this->sendTo != NULL) {
-        this->sendTo->SendRequest(this->forwardToID, &response);
+void Ras::RestoreState(const RasCheckpoint* checkpoint) {
+    this->top = checkpoint->top;
+    this->buffer[this->top] = checkpoint->topEntry;
+    this->occupation = checkpoint->occupation;
+    this->overflowed = checkpoint->overflowed;
+}
+
+unsigned long Ras::Apply(RasCheckpoint* checkpoint) {
+    const StaticInstructionInfo* instruction = checkpoint->instruction;
+    this->SaveState(checkpoint);
+    if (instruction->branchType == BranchCall) {
+        this->Push(instruction->instAddress + instruction->instSize);
+        return 0;
     }
+    return this->Pop();
 }
 
-inline void Ras::RequestUpdate(unsigned long targetAddress) {
-    ++this->end;
-    if (this->end >= this->size) this->end = 0;
+inline void Ras::RequestQuery(PredictorPacket* packet) {
+    const StaticInstructionInfo* instruction =
+        packet->data.requestQuery.staticInfo;
+    packet->type = PredictorPacketTypeResponseUnknown;
+    if (!IsCallOrReturn(instruction)) return;
+
+    RasCheckpoint* checkpoint = this->checkpoints.Push(instruction);
+
+    // Counted here, the replays of a repair push and pop again.
+    if (instruction->branchType == BranchCall) {
+        ++this->numCalls;
+        if (this->occupation == this->size) ++this->numOverflows;
+    } else {
+        ++this->numReturns;
+        if (this->overflowed == 0 && this->occupation == 0) {
+            ++this->numUnderflows;
+        }
+    }
 
-    this->buffer[this->end] = targetAddress;
+    checkpoint->predictedTarget = this->Apply(checkpoint);
+    if (checkpoint->predictedTarget != 0) {
+        packet->type = PredictorPacketTypeResponseTakeToAddress;
+        packet->data.targetResponse.target = checkpoint->predictedTarget;
+    }
+}
+
+inline void Ras::RequestUpdate(const PredictorPacket* packet) {
+    const StaticInstructionInfo* instruction =
+        packet->data.targetUpdate.instruction.staticInfo;
+    if (!IsCallOrReturn(instruction)) return;
+
+    RasCheckpoint* checkpoint = this->checkpoints.Resolve(instruction);
+    if (checkpoint == NULL) {
+        SINUCA3_DEBUG_PRINTF("Ras update without a query\n");
+        return;
+    }
+
+    if (instruction->branchType == BranchRet &&
+        checkpoint->predictedTarget != packet->data.targetUpdate.target) {
+        ++this->numWrongReturns;
+        // The younger calls and returns were fetched after a wrong target,
+        // so the stack is rebuilt from this return on.
+        this->RestoreState(checkpoint);
+        this->Pop();
+        this->checkpoints.Replay(this, &Ras::Apply);
+    }
+    this->checkpoints.Pop();
 }
 
 void Ras::Clock() {
     long numberOfConnections = this->GetNumberOfConnections();
     PredictorPacket packet;
     for (long i = 0; i < numberOfConnections; ++i) {
-        if (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+        while (this->ReceiveRequestFromConnection(i, &packet) == 0) {
             switch (packet.type) {
                 case PredictorPacketTypeRequestQuery:
+                case PredictorPacketTypeRequestBlockQuery:
                     ++this->numQueries;
-                    this->RequestQuery(packet.data.requestQuery, i);
+                    if (packet.type == PredictorPacketTypeRequestQuery) {
+                        this->RequestQuery(&packet);
+                    } else {
+                        AnswerBlockQuery(this, &Ras::RequestQuery, &packet);
+                    }
+                    if (this->sendTo == NULL) {
+                        this->SendResponseToConnection(i, &packet);
+                    } else {
+                        this->sendTo->SendRequest(this->forwardToID, &packet);
+                    }
                     break;
                 case PredictorPacketTypeRequestTargetUpdate:
                     ++this->numUpdates;
-                    this->RequestUpdate(packet.data.targetUpdate.target);
+                    this->RequestUpdate(&packet);
                     break;
                 default:
                     SINUCA3_WARNING_PRINTF(
@@ -88,6 +192,13 @@ void Ras::PrintStatistics() {
     SINUCA3_LOG_PRINTF("Ras [%p]\n", this);
     SINUCA3_LOG_PRINTF("    Ras Queries: %lu\n", this->numQueries);
     SINUCA3_LOG_PRINTF("    Ras Updates: %lu\n", this->numUpdates);
+    SINUCA3_LOG_PRINTF("    Calls: %lu\n", this->numCalls);
+    SINUCA3_LOG_PRINTF("    Returns: %lu\n", this->numReturns);
+    SINUCA3_LOG_PRINTF("    Wrong returns: %lu\n", this->numWrongReturns);
+    SINUCA3_LOG_PRINTF("    Overflows: %lu\n", this->numOverflows);
+    SINUCA3_LOG_PRINTF("    Underflows: %lu\n", this->numUnderflows);
+    SINUCA3_LOG_PRINTF("    Dropped checkpoints: %lu\n",
+                       this->checkpoints.GetNumberOfDropped());
 }
 
 Ras::~Ras() {
@@ -96,111 +207,162 @@ Ras::~Ras() {
 
 #ifndef NDEBUG
 
-int TestRas() {
-    Ras ras;
-    Map<Linkable*> aliases;
-    yaml::Parser parser;
-
-    ras.Configure(CreateFakeConfig(&parser, "size: 5\n", &aliases));
-    int id = ras.Connect(1);
-
-    ras.Clock();
-    ras.PosClock();
-
-    PredictorPacket msg;
-    msg.type = PredictorPacketTypeRequestTargetUpdate;
-
-    ras.Clock();
-    msg.data.targetUpdate.target = 0xcafebabe;
-    ras.SendRequest(id, &msg);
-    ras.PosClock();
-
-    ras.Clock();
-    ras.PosClock();
-
-    ras.Clock();
-    msg.data.targetUpdate.target = 0xdeadbeef;
-    ras.SendRequest(id, &msg);
-    ras.PosClock();
-
-    ras.Clock();
-    ras.PosClock();
-
-    ras.Clock();
-    msg.type = PredictorPacketTypeRequestQuery;
-    ras.SendRequest(id, &msg);
-    ras.PosClock();
+/** @return The predicted target, 0 if unknown and 1 without an answer. */
+static unsigned long RasTestQuery(Ras* ras, int id,
+                                  const InstructionPacket* instruction) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestQuery;
+    packet.data.requestQuery = *instruction;
+    ras->SendRequest(id, &packet);
+    for (int steps = 0; steps < 10; ++steps) {
+        ras->Clock();
+        ras->PosClock();
+        if (ras->ReceiveResponse(id, &packet) == 0) {
+            if (packet.type != PredictorPacketTypeResponseTakeToAddress) {
+                return 0;
+            }
+            return packet.data.targetResponse.target;
+        }
+    }
+    return 1;
+}
 
-    ras.Clock();
-    ras.PosClock();
+static void RasTestUpdate(Ras* ras, int id,
+                          const InstructionPacket* instruction,
+                          unsigned long target) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestTargetUpdate;
+    packet.data.targetUpdate.instruction = *instruction;
+    packet.data.targetUpdate.target = target;
+    ras->SendRequest(id, &packet);
+    for (int steps = 0; steps < 2; ++steps) {
+        ras->Clock();
+        ras->PosClock();
+    }
+}
 
-    ras.Clock();
-    if (ras.ReceiveResponse(id, &msg)) {
-        SINUCA3_LOG_PRINTF("Ras did not respond first query!\n");
-        return 1;
+/** @return The target predicted for the last slot of the block, 0 if none. */
+static unsigned long RasTestBlock(Ras* ras, int id,
+                                  const StaticInstructionInfo** instructions,
+                                  unsigned int size) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestBlockQuery;
+    for (unsigned int i = 0; i < size; ++i) {
+        packet.data.blockQuery.instructions[i] = instructions[i];
     }
-    if (msg.data.targetResponse.target != 0xdeadbeef) {
-        SINUCA3_LOG_PRINTF(
-            "Ras responded first query with wrong address %ld!\n",
-            msg.data.targetResponse.target);
-        return 1;
+    packet.data.blockQuery.startAddress = instructions[0]->instAddress;
+    packet.data.blockQuery.nextAddress = 0;
+    packet.data.blockQuery.numberOfInstructions = size;
+    ras->SendRequest(id, &packet);
+    for (int steps = 0; steps < 10; ++steps) {
+        ras->Clock();
+        ras->PosClock();
+        if (ras->ReceiveResponse(id, &packet) == 0) {
+            unsigned int last = 1U << (size - 1);
+            if (packet.type != PredictorPacketTypeResponseBlock ||
+                packet.data.blockResponse.targetMask != last) {
+                return 0;
+            }
+            return packet.data.blockResponse.targets[size - 1];
+        }
     }
-    ras.PosClock();
-
-    ras.Clock();
-    ras.PosClock();
-
-    ras.Clock();
-    msg.type = PredictorPacketTypeRequestTargetUpdate;
-    msg.data.targetUpdate.target = 0xb16b00b5;
-    ras.SendRequest(id, &msg);
-    ras.PosClock();
-
-    ras.Clock();
-    ras.PosClock();
-
-    ras.Clock();
-    msg.type = PredictorPacketTypeRequestQuery;
-    ras.SendRequest(id, &msg);
-    ras.PosClock();
-
-    ras.Clock();
-    ras.PosClock();
+    return 1;
+}
 
-    if (ras.ReceiveResponse(id, &msg)) {
-        SINUCA3_LOG_PRINTF("Ras did not respond second query!\n");
-        return 1;
+/** @brief Three nested calls then their returns on a stack of size 2. */
+static int RasTestOverflow(const char* config, const unsigned long* expected) {
+    Ras ras;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    if (ras.Configure(CreateFakeConfig(&parser, config, &aliases))) return 1;
+    int id = ras.Connect(0);
+
+    StaticInstructionInfo callInfo[3];
+    InstructionPacket call[3];
+    StaticInstructionInfo returnInfo;
+    returnInfo.branchType = BranchRet;
+    InstructionPacket ret;
+    ret.staticInfo = &returnInfo;
+    for (int i = 0; i < 3; ++i) {
+        callInfo[i].instAddress = 0x1000 * (i + 1);
+        callInfo[i].instSize = 5;
+        callInfo[i].branchType = BranchCall;
+        call[i].staticInfo = &callInfo[i];
+        if (RasTestQuery(&ras, id, &call[i]) != 0) return 1;
     }
-    if (msg.data.targetResponse.target != 0xb16b00b5) {
-        SINUCA3_LOG_PRINTF(
-            "Ras responded second query with wrong address %ld!\n",
-            msg.data.targetResponse.target);
-        return 1;
+    for (int i = 0; i < 3; ++i) {
+        if (RasTestQuery(&ras, id, &ret) != expected[i]) return 1;
     }
 
-    ras.Clock();
-    ras.PosClock();
-
-    ras.Clock();
-    msg.type = PredictorPacketTypeRequestQuery;
-    ras.SendRequest(id, &msg);
-    ras.PosClock();
-
-    ras.Clock();
-    ras.PosClock();
+    return 0;
+}
 
-    if (ras.ReceiveResponse(id, &msg)) {
-        SINUCA3_LOG_PRINTF("Ras did not respond third query!\n");
-        return 1;
-    }
-    if (msg.data.targetResponse.target != 0xcafebabe) {
-        SINUCA3_LOG_PRINTF(
-            "Ras responded third query with wrong address %ld!\n",
-            msg.data.targetResponse.target);
+int TestRas() {
+    Ras ras;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    if (ras.Configure(CreateFakeConfig(&parser, "size: 5\n", &aliases))) {
         return 1;
     }
-
-    SINUCA3_LOG_PRINTF("Ras test was successful!\n");
+    int id = ras.Connect(0);
+
+    StaticInstructionInfo outerInfo;
+    outerInfo.instAddress = 0x400;
+    outerInfo.instSize = 5;
+    outerInfo.branchType = BranchCall;
+    StaticInstructionInfo innerInfo;
+    innerInfo.instAddress = 0x800;
+    innerInfo.instSize = 4;
+    innerInfo.branchType = BranchCall;
+    StaticInstructionInfo returnInfo;
+    returnInfo.instAddress = 0xc00;
+    returnInfo.branchType = BranchRet;
+    StaticInstructionInfo aluInfo;
+    InstructionPacket outer;
+    outer.staticInfo = &outerInfo;
+    InstructionPacket inner;
+    inner.staticInfo = &innerInfo;
+    InstructionPacket ret;
+    ret.staticInfo = &returnInfo;
+    InstructionPacket alu;
+    alu.staticInfo = &aluInfo;
+
+    if (RasTestQuery(&ras, id, &alu) != 0) return 2;
+    if (RasTestQuery(&ras, id, &ret) != 0) return 3;
+    RasTestUpdate(&ras, id, &ret, 0x100);
+    if (ras.GetNumberOfWrongReturns() != 1) return 4;
+
+    // Calls push their return address, not their target.
+    if (RasTestQuery(&ras, id, &outer) != 0) return 5;
+    if (RasTestQuery(&ras, id, &inner) != 0) return 6;
+    if (RasTestQuery(&ras, id, &ret) != 0x804) return 7;
+    if (RasTestQuery(&ras, id, &ret) != 0x405) return 8;
+    if (ras.GetOccupation() != 0) return 9;
+
+    // Branches in flight are resolved in order, a wrong return rebuilds the
+    // stack of the younger ones.
+    RasTestUpdate(&ras, id, &outer, 0x2000);
+    RasTestUpdate(&ras, id, &inner, 0x3000);
+    RasTestUpdate(&ras, id, &ret, 0x804);
+    if (ras.GetNumberOfWrongReturns() != 1) return 10;
+
+    if (RasTestQuery(&ras, id, &inner) != 0) return 11;
+    RasTestUpdate(&ras, id, &ret, 0x999);
+    if (ras.GetNumberOfWrongReturns() != 2) return 12;
+    if (ras.GetOccupation() != 1) return 13;
+    RasTestUpdate(&ras, id, &inner, 0x3000);
+    if (RasTestQuery(&ras, id, &ret) != 0x804) return 14;
+
+    // A circular stack loses the outermost frame, a counter stack the
+    // innermost one.
+    const unsigned long circular[] = {0x3005, 0x2005, 0};
+    if (RasTestOverflow("size: 2\n", circular)) return 15;
+    const unsigned long counter[] = {0, 0x2005, 0x1005};
+    if (RasTestOverflow("size: 2\noverflow: counter\n", counter)) return 16;
+
+    // Inside a block the return sees the call of an earlier slot.
+    const StaticInstructionInfo* block[] = {&aluInfo, &innerInfo, &returnInfo};
+    if (RasTestBlock(&ras, id, block, 3) != 0x804) return 17;
 
     return 0;
 }
@@ -20,20 +20,45 @@
 
 /**
  * @file ras.hpp
- * @brief API of the Ras. A simple, generic return address stack. It does not
- * care at all about wrong predictions.
+ * @brief API of the Ras, a return address stack with speculative updates.
  */
 
 #include <sinuca3.hpp>
+#include <utils/checkpoint_ring.hpp>
+
+/** @brief State saved for a call or return in flight. */
+struct RasCheckpoint {
+    const StaticInstructionInfo* instruction;
+    unsigned long topEntry; /**<The top entry before the branch. */
+    unsigned long predictedTarget; /**<Returns only, 0 if unknown. */
+    long top;
+    long occupation;
+    unsigned long overflowed;
+};
 
 /**
- * @brief API of the Ras. A simple, generic return address stack. It does not
- * care at all about wrong predictions.
+ * @brief API of the Ras, a return address stack with speculative updates.
+ *
+ * @details Queries are sent for calls and returns as they are fetched. A call
+ * pushes its return address and is answered with a ResponseUnknown, a return
+ * pops the stack and is answered with a ResponseTakeToAddress, or with a
+ * ResponseUnknown if the stack is empty. Other instructions get a
+ * ResponseUnknown and do not change the stack.
  *
- * @details It does not checks wether the branch is a return on queries.
- * Clients should make this check before sending a query request. It always
- * responds with a ResponseTakeToAddress. It accepts the following parameters:
+ * Each call and return in flight saves the top of stack pointer and the top
+ * entry, which is enough to undo the pops and pushes of younger branches.
+ * RequestTargetUpdate messages, in program order, resolve them with the
+ * actual target. A mispredicted return restores its checkpoint and replays
+ * the younger calls and returns, as the other predictors do with their
+ * histories.
+ *
+ * It accepts the following parameters:
  * - size (required): integer > 0, sets the ras buffer size.
+ * - overflow: circular or counter, circular by default. A circular stack
+ *   overwrites its oldest entry when a call finds it full. A counter stack
+ *   keeps its entries and counts the calls it could not push; their returns
+ *   are answered with a ResponseUnknown, and the outer frames stay correct.
+ * - checkpoints: integer, calls and returns in flight, 64 by default.
  * - sendTo: Component<PredictorPacket>, if exists, the Ras sends responses to
  *   this component instead of in the response channel.
  */
@@ -42,23 +67,67 @@ class Ras : public Component<PredictorPacket> {
     Component<PredictorPacket>* sendTo;
     unsigned long* buffer;
     long size;
-    long end;
+    long top;        /**<Index of the top entry. */
+    long occupation; /**<Valid entries, up to size. */
+    unsigned long overflowed; /**<Calls not pushed, counter mode only. */
+    bool countOverflow;
+
+    /** @brief Calls and returns in flight. */
+    CheckpointRing<RasCheckpoint> checkpoints;
+
     unsigned long numQueries;
     unsigned long numUpdates;
+    unsigned long numCalls;
+    unsigned long numReturns;
+    unsigned long numWrongReturns;
+    unsigned long numOverflows;
+    unsigned long numUnderflows;
 
     int forwardToID;
 
-    inline void RequestQuery(InstructionPacket instruction, int connectionID);
+    static inline bool IsCallOrReturn(const StaticInstructionInfo* info) {
+        return info->branchType == BranchCall || info->branchType == BranchRet;
+    }
+
+    void Push(unsigned long address);
+    /** @return The top entry, 0 if there is none. */
+    unsigned long Pop();
+    void SaveState(RasCheckpoint* checkpoint);
+    void RestoreState(const RasCheckpoint* checkpoint);
+    /** @brief Saves the state in [checkpoint] and pushes or pops. */
+    unsigned long Apply(RasCheckpoint* checkpoint);
 
-    inline void RequestUpdate(unsigned long targetAddress);
+    inline void RequestQuery(PredictorPacket* packet);
+    inline void RequestUpdate(const PredictorPacket* packet);
 
   public:
-    inline Ras() : sendTo(NULL), buffer(NULL), size(0), end(0) {}
+    inline Ras()
+        : sendTo(NULL),
+          buffer(NULL),
+          size(0),
+          top(0),
+          occupation(0),
+          overflowed(0),
+          countOverflow(false),
+          numQueries(0),
+          numUpdates(0),
+          numCalls(0),
+          numReturns(0),
+          numWrongReturns(0),
+          numOverflows(0),
+          numUnderflows(0) {}
     virtual int Configure(Config config);
     virtual void Clock();
     virtual void PrintStatistics();
 
     virtual ~Ras();
+
+#ifndef NDEBUG
+    inline unsigned long GetNumberOfWrongReturns() const {
+        return this->numWrongReturns;
+    }
+    inline long GetOccupation() const { return this->occupation; }
+#endif
 };
 
 #ifndef NDEBUG
@@ -0,0 +1,551 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file tage_predictor.cpp
+ * @brief Implementation of the TAGE conditional branch predictor.
+ */
+
+#include "tage_predictor.hpp"
+
+#include <cmath>
+#include <sinuca3.hpp>
+#include <std_components/predictors/block_query.hpp>
+
+/** @brief Updates between two halvings of the useful counters. */
+static const unsigned long TAGE_USEFUL_RESET_PERIOD = 1UL << 18;
+
+TagePredictor::TagePredictor()
+    : entries(NULL),
+      numTables(7),
+      tableBits(0),
+      baseBits(0),
+      history(NULL),
+      historyMask(0),
+      historyHead(0),
+      pathHistory(0),
+      useAltOnNewlyAllocated(8),
+      updatesSinceReset(0),
+      randomState(1),
+      sendTo(NULL),
+      sendToId(0),
+      numberOfQueries(0),
+      numberOfPredictions(0),
+      numberOfUpdates(0),
+      numberOfWrongPredictions(0),
+      numberOfAllocations(0),
+      numberOfFailedAllocations(0),
+      baseProvided(0) {
+    for (int i = 0; i < TAGE_MAX_TABLES; ++i) this->providerHits[i] = 0;
+}
+
+TagePredictor::~TagePredictor() {
+    delete[] this->entries;
+    delete[] this->history;
+}
+
+int TagePredictor::Configure(Config config) {
+    long baseEntries = 16384;
+    long tableEntries = 1024;
+    long tables = this->numTables;
+    long minHistory = 5;
+    long maxHistory = 130;
+    long minTagBits = 8;
+    long maxTagBits = 12;
+    long checkpoints = 64;
+
+    if (config.Integer("baseEntries", &baseEntries)) return 1;
+    if (config.Integer("tables", &tables)) return 1;
+    if (config.Integer("tableEntries", &tableEntries)) return 1;
+    if (config.Integer("minHistory", &minHistory)) return 1;
+    if (config.Integer("maxHistory", &maxHistory)) return 1;
+    if (config.Integer("minTagBits", &minTagBits)) return 1;
+    if (config.Integer("maxTagBits", &maxTagBits)) return 1;
+    if (config.Integer("checkpoints", &checkpoints)) return 1;
+
+    if (baseEntries <= 1) return config.Error("baseEntries", "is not > 1.");
+    if (tables <= 0 || tables > TAGE_MAX_TABLES)
+        return config.Error("tables", "is not between 1 and 16.");
+    if (tableEntries <= 1)
+        return config.Error("tableEntries", "is not > 1.");
+    if (minHistory <= 0) return config.Error("minHistory", "is not > 0.");
+    if (maxHistory < minHistory || maxHistory > TAGE_MAX_HISTORY)
+        return config.Error("maxHistory",
+                            "is not between minHistory and 1024.");
+    if (minTagBits < 2) return config.Error("minTagBits", "is not >= 2.");
+    if (maxTagBits < minTagBits || maxTagBits > TAGE_MAX_TAG_BITS)
+        return config.Error("maxTagBits",
+                            "is not between minTagBits and 16.");
+    if (checkpoints <= 0) return config.Error("checkpoints", "is not > 0.");
+
+    this->numTables = tables;
+    this->baseBits = floor(log2(baseEntries));
+    this->tableBits = floor(log2(tableEntries));
+
+    // Geometric history lengths, strictly increasing, and tag widths
+    // growing linearly from the first to the last table.
+    for (int i = 0; i < this->numTables; ++i) {
+        double ratio = (this->numTables == 1)
+                           ? 0.0
+                           : (double)i / (double)(this->numTables - 1);
+        int length = (int)(minHistory *
+                               pow((double)maxHistory / minHistory, ratio) +
+                           0.5);
+        if (i > 0 && length <= this->historyLengths[i - 1]) {
+            length = this->historyLengths[i - 1] + 1;
+        }
+        this->historyLengths[i] = length;
+        this->tagBits[i] =
+            minTagBits + (int)((maxTagBits - minTagBits) * ratio + 0.5);
+
+        this->indexFolds[i].Configure(length, this->tableBits);
+        this->tagFolds[i].Configure(length, this->tagBits[i]);
+        this->tagFoldsShort[i].Configure(length, this->tagBits[i] - 1);
+    }
+
+    // The ring keeps the bits of the branches in flight on top of the
+    // longest history, so a repair can still read the bits leaving it.
+    unsigned long historySize = 1;
+    while (historySize <= (unsigned long)this->historyLengths[tables - 1] +
+                              (unsigned long)checkpoints) {
+        historySize <<= 1;
+    }
+    this->historyMask = historySize - 1;
+    this->history = new unsigned char[historySize]();
+
+    if (config.ComponentReference("sendTo", &this->sendTo)) return 1;
+    if (this->sendTo != NULL) this->sendToId = this->sendTo->Connect(0);
+
+    if (this->base.Allocate(1UL << this->baseBits)) return 1;
+    this->entries =
+        new unsigned int[(unsigned long)tables << this->tableBits]();
+    this->checkpoints.Allocate(checkpoints);
+
+    return 0;
+}
+
+void TagePredictor::PushHistory(bool taken, unsigned long addr) {
+    ++this->historyHead;
+    this->history[this->historyHead & this->historyMask] = taken;
+    for (int i = 0; i < this->numTables; ++i) {
+        unsigned int oldBit = this->HistoryBit(this->historyLengths[i]);
+        this->indexFolds[i].Update(taken, oldBit);
+        this->tagFolds[i].Update(taken, oldBit);
+        this->tagFoldsShort[i].Update(taken, oldBit);
+    }
+    this->pathHistory =
+        ((this->pathHistory << 1) | ((addr ^ (addr >> 2)) & 1)) &
+        ((1UL << TAGE_PATH_HISTORY_BITS) - 1);
+}
+
+void TagePredictor::SaveHistory(TageCheckpoint* checkpoint) {
+    checkpoint->historyHead = this->historyHead;
+    checkpoint->pathHistory = this->pathHistory;
+    for (int i = 0; i < this->numTables; ++i) {
+        checkpoint->indexFolds[i] = this->indexFolds[i].value;
+        checkpoint->tagFolds[i] = this->tagFolds[i].value;
+        checkpoint->tagFoldsShort[i] = this->tagFoldsShort[i].value;
+    }
+}
+
+void TagePredictor::RestoreHistory(const TageCheckpoint* checkpoint) {
+    this->historyHead = checkpoint->historyHead;
+    this->pathHistory = checkpoint->pathHistory;
+    for (int i = 0; i < this->numTables; ++i) {
+        this->indexFolds[i].value = checkpoint->indexFolds[i];
+        this->tagFolds[i].value = checkpoint->tagFolds[i];
+        this->tagFoldsShort[i].value = checkpoint->tagFoldsShort[i];
+    }
+}
+
+void TagePredictor::ReplayBranch(TageCheckpoint* checkpoint) {
+    this->SaveHistory(checkpoint);
+    this->PushHistory(checkpoint->predictedTaken,
+                      checkpoint->instruction->instAddress);
+}
+
+void TagePredictor::Predict(unsigned long addr, TageCheckpoint* checkpoint) {
+    unsigned long tableMask = (1UL << this->tableBits) - 1;
+    checkpoint->baseIndex = addr & ((1UL << this->baseBits) - 1);
+    checkpoint->provider = -1;
+    checkpoint->alternate = -1;
+
+    for (int i = this->numTables - 1; i >= 0; --i) {
+        int pathBits = this->historyLengths[i] < TAGE_PATH_HISTORY_BITS
+                           ? this->historyLengths[i]
+                           : TAGE_PATH_HISTORY_BITS;
+        unsigned long path = this->pathHistory & ((1UL << pathBits) - 1);
+        unsigned int index =
+            (addr ^ (addr >> (this->tableBits - (i % this->tableBits))) ^
+             this->indexFolds[i].value ^ path ^ (path >> this->tableBits)) &
+            tableMask;
+        unsigned int tag = (addr ^ this->tagFolds[i].value ^
+                            (this->tagFoldsShort[i].value << 1)) &
+                           ((1U << this->tagBits[i]) - 1);
+        checkpoint->indices[i] = index;
+        checkpoint->tags[i] = tag;
+
+        if (Tag(*this->Entry(i, index)) != tag) continue;
+        if (checkpoint->provider < 0) {
+            checkpoint->provider = i;
+        } else if (checkpoint->alternate < 0) {
+            checkpoint->alternate = i;
+        }
+    }
+
+    bool baseTaken = this->base.GetPrediction(checkpoint->baseIndex);
+    checkpoint->alternateTaken = baseTaken;
+    if (checkpoint->alternate >= 0) {
+        checkpoint->alternateTaken =
+            Counter(*this->Entry(checkpoint->alternate,
+                                 checkpoint->indices[checkpoint->alternate])) >=
+            4;
+    }
+
+    if (checkpoint->provider < 0) {
+        checkpoint->providerTaken = baseTaken;
+        checkpoint->providerWeak = false;
+        checkpoint->predictedTaken = baseTaken;
+        return;
+    }
+
+    unsigned int counter = Counter(*this->Entry(
+        checkpoint->provider, checkpoint->indices[checkpoint->provider]));
+    checkpoint->providerTaken = counter >= 4;
+    checkpoint->providerWeak = counter == 3 || counter == 4;
+    checkpoint->predictedTaken =
+        (checkpoint->providerWeak && this->useAltOnNewlyAllocated >= 8)
+            ? checkpoint->alternateTaken
+            : checkpoint->providerTaken;
+}
+
+void TagePredictor::Allocate(const TageCheckpoint* checkpoint, bool taken) {
+    int start = checkpoint->provider + 1;
+    // Skipping a table half of the time spreads a burst of allocations.
+    if (start < this->numTables - 1 && (this->Random() & 1)) ++start;
+
+    for (int i = start; i < this->numTables; ++i) {
+        unsigned int* entry = this->Entry(i, checkpoint->indices[i]);
+        if (Useful(*entry) == 0) {
+            *entry = Pack(checkpoint->tags[i], 0, taken ? 4 : 3);
+            ++this->numberOfAllocations;
+            return;
+        }
+    }
+
+    ++this->numberOfFailedAllocations;
+    for (int i = start; i < this->numTables; ++i) {
+        unsigned int* entry = this->Entry(i, checkpoint->indices[i]);
+        if (Useful(*entry) > 0) *entry -= 1 << 3;
+    }
+}
+
+/** @brief Moves the counter of a packed entry towards [taken]. */
+static inline void TageUpdateCounter(unsigned int* entry, bool taken) {
+    unsigned int counter = *entry & 7;
+    if (taken && counter < 7) ++*entry;
+    if (!taken && counter > 0) --*entry;
+}
+
+void TagePredictor::Train(const TageCheckpoint* checkpoint, bool taken) {
+    int provider = checkpoint->provider;
+
+    bool allocate = checkpoint->predictedTaken != taken &&
+                    provider < this->numTables - 1;
+    // A new entry that was right while the alternate was used needs time,
+    // not another entry.
+    if (provider >= 0 && checkpoint->providerWeak &&
+        checkpoint->providerTaken == taken) {
+        allocate = false;
+    }
+    if (allocate) this->Allocate(checkpoint, taken);
+
+    if (provider < 0) {
+        ++this->baseProvided;
+        this->base.Update(checkpoint->baseIndex, taken);
+    } else {
+        ++this->providerHits[provider];
+        unsigned int* entry =
+            this->Entry(provider, checkpoint->indices[provider]);
+        // The entry may have been replaced while the branch was in flight.
+        if (Tag(*entry) == checkpoint->tags[provider]) {
+            if (checkpoint->providerWeak &&
+                checkpoint->providerTaken != checkpoint->alternateTaken) {
+                if (checkpoint->alternateTaken == taken) {
+                    if (this->useAltOnNewlyAllocated < 15)
+                        ++this->useAltOnNewlyAllocated;
+                } else if (this->useAltOnNewlyAllocated > 0) {
+                    --this->useAltOnNewlyAllocated;
+                }
+            }
+
+            if (checkpoint->providerWeak && Useful(*entry) == 0) {
+                if (checkpoint->alternate >= 0) {
+                    TageUpdateCounter(
+                        this->Entry(checkpoint->alternate,
+                                    checkpoint->indices[checkpoint->alternate]),
+                        taken);
+                } else {
+                    this->base.Update(checkpoint->baseIndex, taken);
+                }
+            }
+            TageUpdateCounter(entry, taken);
+
+            if (checkpoint->providerTaken != checkpoint->alternateTaken) {
+                if (checkpoint->providerTaken == taken) {
+                    if (Useful(*entry) < 3) *entry += 1 << 3;
+                } else if (Useful(*entry) > 0) {
+                    *entry -= 1 << 3;
+                }
+            }
+        }
+    }
+
+    // Useful counters age, so entries of old phases can be replaced.
+    if (++this->updatesSinceReset == TAGE_USEFUL_RESET_PERIOD) {
+        this->updatesSinceReset = 0;
+        unsigned long size = (unsigned long)this->numTables << this->tableBits;
+        for (unsigned long i = 0; i < size; ++i) {
+            unsigned int useful = Useful(this->entries[i]) >> 1;
+            this->entries[i] = (this->entries[i] & ~(3U << 3)) | (useful << 3);
+        }
+    }
+}
+
+void TagePredictor::Query(PredictorPacket* pkt) {
+    ++this->numberOfQueries;
+    const StaticInstructionInfo* instruction =
+        pkt->data.requestQuery.staticInfo;
+    if (instruction->branchType != BranchCond) {
+        pkt->type = PredictorPacketTypeResponseUnknown;
+        return;
+    }
+
+    TageCheckpoint* checkpoint = this->checkpoints.Push(instruction);
+    this->SaveHistory(checkpoint);
+    this->Predict(instruction->instAddress, checkpoint);
+    this->PushHistory(checkpoint->predictedTaken, instruction->instAddress);
+    ++this->numberOfPredictions;
+
+    pkt->type = checkpoint->predictedTaken
+                    ? PredictorPacketTypeResponseTake
+                    : PredictorPacketTypeResponseDontTake;
+}
+
+void TagePredictor::Update(const PredictorPacket* pkt) {
+    const StaticInstructionInfo* instruction =
+        pkt->data.directionUpdate.instruction.staticInfo;
+    bool taken = pkt->data.directionUpdate.taken;
+
+    TageCheckpoint* checkpoint = this->checkpoints.Resolve(instruction);
+    if (checkpoint == NULL) {
+        SINUCA3_DEBUG_PRINTF("Tage update without a prediction\n");
+        return;
+    }
+
+    ++this->numberOfUpdates;
+    this->Train(checkpoint, taken);
+
+    if (checkpoint->predictedTaken != taken) {
+        ++this->numberOfWrongPredictions;
+        this->RestoreHistory(checkpoint);
+        this->PushHistory(taken, instruction->instAddress);
+        this->checkpoints.Replay(this, &TagePredictor::ReplayBranch);
+    }
+
+    this->checkpoints.Pop();
+}
+
+void TagePredictor::Clock() {
+    PredictorPacket packet;
+    long totalConnections = this->GetNumberOfConnections();
+    for (long i = 0; i < totalConnections; i++) {
+        while (this->ReceiveRequestFromConnection(i, &packet) == 0) {
+            if (packet.type == PredictorPacketTypeRequestDirectionUpdate) {
+                this->Update(&packet);
+                continue;
+            }
+            if (packet.type == PredictorPacketTypeRequestQuery) {
+                this->Query(&packet);
+            } else if (packet.type == PredictorPacketTypeRequestBlockQuery) {
+                AnswerBlockQuery(this, &TagePredictor::Query, &packet);
+            } else {
+                continue;
+            }
+            if (this->sendTo == NULL) {
+                this->SendResponseToConnection(i, &packet);
+            } else {
+                this->sendTo->SendRequest(this->sendToId, &packet);
+            }
+        }
+    }
+}
+
+void TagePredictor::PrintStatistics() {
+    SINUCA3_LOG_PRINTF("Tage [%p]\n", this);
+    SINUCA3_LOG_PRINTF("    Base table entries [%lu]\n", 1UL << this->baseBits);
+    for (int i = 0; i < this->numTables; ++i) {
+        SINUCA3_LOG_PRINTF(
+            "    Table %d: %lu entries, history %d, tag %d bits, provided "
+            "[%lu]\n",
+            i, 1UL << this->tableBits, this->historyLengths[i],
+            this->tagBits[i], this->providerHits[i]);
+    }
+    SINUCA3_LOG_PRINTF("    Base table provided [%lu]\n", this->baseProvided);
+    SINUCA3_LOG_PRINTF("    Queries [%lu]\n", this->numberOfQueries);
+    SINUCA3_LOG_PRINTF("    Conditional branches predicted [%lu]\n",
+                       this->numberOfPredictions);
+    SINUCA3_LOG_PRINTF("    Conditional branches resolved [%lu]\n",
+                       this->numberOfUpdates);
+    SINUCA3_LOG_PRINTF("    Wrong predictions [%lu]\n",
+                       this->numberOfWrongPredictions);
+    SINUCA3_LOG_PRINTF("    Allocations [%lu], failed [%lu]\n",
+                       this->numberOfAllocations,
+                       this->numberOfFailedAllocations);
+    SINUCA3_LOG_PRINTF("    Dropped checkpoints [%lu]\n",
+                       this->checkpoints.GetNumberOfDropped());
+    if (this->numberOfUpdates > 0) {
+        SINUCA3_LOG_PRINTF("    Rate of wrong predictions [%.2lf]%%\n",
+                           100.0 * this->numberOfWrongPredictions /
+                               this->numberOfUpdates);
+    }
+}
+
+#ifndef NDEBUG
+
+bool TagePredictor::FoldsAreConsistent() const {
+    const FoldedHistory* folds[] = {this->indexFolds, this->tagFolds,
+                                        this->tagFoldsShort};
+    for (int f = 0; f < 3; ++f) {
+        for (int i = 0; i < this->numTables; ++i) {
+            const FoldedHistory* fold = &folds[f][i];
+            unsigned int value = 0;
+            for (int d = fold->length - 1; d >= 0; --d) {
+                value = (value << 1) | this->HistoryBit(d);
+                value ^= value >> fold->width;
+                value &= (1U << fold->width) - 1;
+            }
+            if (value != fold->value) return false;
+        }
+    }
+    return true;
+}
+
+/** @brief Predicts [instruction] and waits for the answer. */
+static int TageTestQuery(TagePredictor* predictor, int id,
+                         const InstructionPacket* instruction) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestQuery;
+    packet.data.requestQuery = *instruction;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 10; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+        if (predictor->ReceiveResponse(id, &packet) == 0) {
+            return packet.type;
+        }
+    }
+    return -1;
+}
+
+static void TageTestUpdate(TagePredictor* predictor, int id,
+                           const InstructionPacket* instruction, bool taken) {
+    PredictorPacket packet;
+    packet.type = PredictorPacketTypeRequestDirectionUpdate;
+    packet.data.directionUpdate.instruction = *instruction;
+    packet.data.directionUpdate.taken = taken;
+    predictor->SendRequest(id, &packet);
+    for (int steps = 0; steps < 2; ++steps) {
+        predictor->Clock();
+        predictor->PosClock();
+    }
+}
+
+int TestTage() {
+    TagePredictor predictor;
+    Map<Linkable*> aliases;
+    yaml::Parser parser;
+    if (predictor.Configure(CreateFakeConfig(&parser,
+                                             "baseEntries: 1024\n"
+                                             "tables: 4\n"
+                                             "tableEntries: 256\n"
+                                             "minHistory: 4\n"
+                                             "maxHistory: 64\n",
+                                             &aliases))) {
+        return 1;
+    }
+    int id = predictor.Connect(0);
+
+    StaticInstructionInfo loopInfo;
+    loopInfo.instAddress = 0x400;
+    loopInfo.branchType = BranchCond;
+    StaticInstructionInfo aluInfo;
+    aluInfo.instAddress = 0x404;
+    InstructionPacket loop;
+    loop.staticInfo = &loopInfo;
+    InstructionPacket alu;
+    alu.staticInfo = &aluInfo;
+
+    if (TageTestQuery(&predictor, id, &alu) !=
+        PredictorPacketTypeResponseUnknown) {
+        return 2;
+    }
+
+    // A loop of 32 iterations needs a history longer than its trip count,
+    // the base table alone misses every exit.
+    const int period = 33;
+    for (int i = 0; i < 80 * period; ++i) {
+        if (TageTestQuery(&predictor, id, &loop) < 0) return 3;
+        TageTestUpdate(&predictor, id, &loop, (i % period) != period - 1);
+    }
+    unsigned long wrong = predictor.GetNumberOfWrongPredictions();
+    for (int i = 0; i < 5 * period; ++i) {
+        bool taken = (i % period) != period - 1;
+        int prediction = TageTestQuery(&predictor, id, &loop);
+        if (prediction != (taken ? PredictorPacketTypeResponseTake
+                                 : PredictorPacketTypeResponseDontTake)) {
+            return 4;
+        }
+        TageTestUpdate(&predictor, id, &loop, taken);
+    }
+    if (predictor.GetNumberOfWrongPredictions() != wrong) return 5;
+    if (!predictor.FoldsAreConsistent()) return 6;
+
+    // The history is updated at prediction time and repaired when an older
+    // branch turns out mispredicted.
+    unsigned long history = predictor.GetRecentHistory(8);
+    int predictions[3];
+    for (int i = 0; i < 3; ++i) {
+        predictions[i] = TageTestQuery(&predictor, id, &loop) ==
+                         PredictorPacketTypeResponseTake;
+    }
+    unsigned long expected = (history << 3) | (predictions[0] << 2) |
+                             (predictions[1] << 1) | predictions[2];
+    if (predictor.GetRecentHistory(11) != expected) return 7;
+
+    TageTestUpdate(&predictor, id, &loop, !predictions[0]);
+    expected ^= 1 << 2;
+    if (predictor.GetRecentHistory(11) != expected) return 8;
+    if (!predictor.FoldsAreConsistent()) return 9;
+    TageTestUpdate(&predictor, id, &loop, predictions[1]);
+    TageTestUpdate(&predictor, id, &loop, predictions[2]);
+    if (predictor.GetRecentHistory(11) != expected) return 10;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef SINUCA3_TAGE_PREDICTOR_HPP_
+#define SINUCA3_TAGE_PREDICTOR_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file tage_predictor.hpp
+ * @brief Implementation of the TAGE conditional branch predictor.
+ * @details TAGE (A. Seznec, "A case for (partially) TAgged GEometric history
+ * length branch prediction") has a bimodal base table and a number of tagged
+ * tables indexed with global histories of geometrically increasing lengths.
+ * The prediction comes from the table with the longest history whose tag
+ * matches (the provider), or from the next one (the alternate prediction)
+ * when the provider entry was just allocated and such entries have been
+ * shown to be unreliable.
+ *
+ * Each tagged entry is packed in an unsigned int (3-bit counter, 2-bit
+ * useful counter and the tag) and all tables share one flat array. The
+ * histories are kept folded to the index and tag widths of each table, and
+ * updated incrementally when a bit enters the history, so a prediction
+ * costs O(tables).
+ *
+ * It speaks the same protocol as GsharePredictor: only conditional branches
+ * are predicted, the history is updated speculatively and checkpointed per
+ * branch in flight, and RequestDirectionUpdate messages, in program order,
+ * train the tables and repair the history on mispredictions.
+ *
+ * Parameters:
+ * - baseEntries: integer, entries of the bimodal table, 16384 by default.
+ * - tables: integer from 1 to 16, tagged tables, 7 by default.
+ * - tableEntries: integer, entries of each tagged table, 1024 by default.
+ * - minHistory, maxHistory: integers, history lengths of the first and last
+ * tagged tables, 5 and 130 by default, up to 1024.
+ * - minTagBits, maxTagBits: integers, tag widths of the first and last tagged
+ * tables, 8 and 12 by default, up to 16.
+ * - checkpoints: integer, branches in flight, 64 by default.
+ * - sendTo: component to which responses are sent instead, optional.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/counter_table.hpp>
+#include <utils/checkpoint_ring.hpp>
+#include <utils/folded_history.hpp>
+
+static const int TAGE_MAX_TABLES = 16;
+static const int TAGE_MAX_HISTORY = 1024;
+static const int TAGE_MAX_TAG_BITS = 16;
+static const int TAGE_PATH_HISTORY_BITS = 16;
+
+/** @brief State saved for a branch in flight. */
+struct TageCheckpoint {
+    const StaticInstructionInfo* instruction;
+    unsigned long historyHead; /**<The history before the branch. */
+    unsigned long pathHistory;
+    unsigned int indexFolds[TAGE_MAX_TABLES];
+    unsigned int tagFolds[TAGE_MAX_TABLES];
+    unsigned int tagFoldsShort[TAGE_MAX_TABLES];
+
+    unsigned int indices[TAGE_MAX_TABLES];
+    unsigned int tags[TAGE_MAX_TABLES];
+    unsigned long baseIndex;
+    int provider;  /**<Table of the provider, -1 for the base table. */
+    int alternate; /**<Table of the alternate, -1 for the base table. */
+    bool providerTaken;
+    bool alternateTaken;
+    bool providerWeak; /**<Provider counter in one of the two middle values. */
+    bool predictedTaken;
+};
+
+/** @brief Refer to tage_predictor.hpp documentation for details */
+class TagePredictor : public Component<PredictorPacket> {
+  private:
+    CounterTable base;
+    unsigned int* entries; /**<[tables x tableEntries] packed entries. */
+
+    int numTables;
+    unsigned int tableBits;
+    unsigned int baseBits;
+    int historyLengths[TAGE_MAX_TABLES];
+    int tagBits[TAGE_MAX_TABLES];
+
+    /** @brief Speculative global history, one bit per byte in a ring. */
+    unsigned char* history;
+    unsigned long historyMask;
+    unsigned long historyHead;
+    unsigned long pathHistory;
+    FoldedHistory indexFolds[TAGE_MAX_TABLES];
+    FoldedHistory tagFolds[TAGE_MAX_TABLES];
+    FoldedHistory tagFoldsShort[TAGE_MAX_TABLES];
+
+    CheckpointRing<TageCheckpoint> checkpoints; /**<Branches in flight. */
+
+    int useAltOnNewlyAllocated; /**<4-bit counter, use alternate if >= 8. */
+    unsigned long updatesSinceReset;
+    unsigned int randomState;
+
+    Component<PredictorPacket>* sendTo;
+    int sendToId;
+
+    /* Statistics */
+    unsigned long numberOfQueries;
+    unsigned long numberOfPredictions;
+    unsigned long numberOfUpdates;
+    unsigned long numberOfWrongPredictions;
+    unsigned long numberOfAllocations;
+    unsigned long numberOfFailedAllocations;
+    unsigned long providerHits[TAGE_MAX_TABLES];
+    unsigned long baseProvided;
+
+    static inline unsigned int Counter(unsigned int entry) {
+        return entry & 7;
+    }
+    static inline unsigned int Useful(unsigned int entry) {
+        return (entry >> 3) & 3;
+    }
+    static inline unsigned int Tag(unsigned int entry) { return entry >> 5; }
+    static inline unsigned int Pack(unsigned int tag, unsigned int useful,
+                                    unsigned int counter) {
+        return (tag << 5) | (useful << 3) | counter;
+    }
+
+    inline unsigned int* Entry(int table, unsigned int index) {
+        return &this->entries[((unsigned long)table << this->tableBits) +
+                              index];
+    }
+    /** @brief Bit [distance] branches ago, 0 is the newest. */
+    inline unsigned int HistoryBit(unsigned long distance) const {
+        return this->history[(this->historyHead - distance) &
+                             this->historyMask];
+    }
+    inline unsigned int Random() {
+        this->randomState = this->randomState * 1103515245 + 12345;
+        return this->randomState >> 16;
+    }
+
+    void PushHistory(bool taken, unsigned long addr);
+    void SaveHistory(TageCheckpoint* checkpoint);
+    void RestoreHistory(const TageCheckpoint* checkpoint);
+    /** @brief Saves the history before [checkpoint] and pushes it again. */
+    void ReplayBranch(TageCheckpoint* checkpoint);
+    void Predict(unsigned long addr, TageCheckpoint* checkpoint);
+    void Allocate(const TageCheckpoint* checkpoint, bool taken);
+    void Train(const TageCheckpoint* checkpoint, bool taken);
+
+    /** @brief Predicts [pkt], saves a checkpoint and updates the history. */
+    void Query(PredictorPacket* pkt);
+    /**
+     * @brief Trains the tables with the oldest branch in flight and repairs
+     * the history if it was mispredicted.
+     */
+    void Update(const PredictorPacket* pkt);
+
+  public:
+    TagePredictor();
+    virtual int Configure(Config config);
+    virtual void PrintStatistics();
+    virtual void Clock();
+    virtual ~TagePredictor();
+
+#ifndef NDEBUG
+    inline unsigned long GetNumberOfWrongPredictions() const {
+        return this->numberOfWrongPredictions;
+    }
+    /** @return The last [bits] bits of the history, newest in bit 0. */
+    inline unsigned long GetRecentHistory(int bits) const {
+        unsigned long recent = 0;
+        for (int i = bits - 1; i >= 0; --i) {
+            recent = (recent << 1) | this->HistoryBit(i);
+        }
+        return recent;
+    }
+    /** @return True if every folded history matches the history ring. */
+    bool FoldsAreConsistent() const;
+#endif
+};
+
+#ifndef NDEBUG
+int TestTage();
+#endif
+
+#endif  // SINUCA3_TAGE_PREDICTOR_HPP_
@@ -29,17 +29,29 @@
 #include <std_components/engine_debug_component.hpp>
 #endif  // NDEBUG
 
+#include <std_components/cores/out_of_order_core.hpp>
 #include <std_components/cores/simple_core.hpp>
 #include <std_components/execute/simple_execution_unit.hpp>
 #include <std_components/fetch/boom_fetch.hpp>
+#include <std_components/fetch/branch_prediction_unit.hpp>
+#include <std_components/fetch/fetch_unit.hpp>
 #include <std_components/fetch/fetcher.hpp>
+#include <std_components/memory/banked_cache.hpp>
+#include <std_components/memory/cache.hpp>
+#include <std_components/memory/dram_controller.hpp>
 #include <std_components/memory/itlb.hpp>
+#include <std_components/memory/page_walker.hpp>
 #include <std_components/memory/simple_instruction_memory.hpp>
 #include <std_components/memory/simple_memory.hpp>
+#include <std_components/memory/tlb.hpp>
 #include <std_components/misc/queues.hpp>
+#include <std_components/predictors/gshare_predictor.hpp>
 #include <std_components/predictors/hardwired_predictor.hpp>
 #include <std_components/predictors/interleavedBTB.hpp>
+#include <std_components/predictors/ittage_predictor.hpp>
+#include <std_components/predictors/perceptron_predictor.hpp>
 #include <std_components/predictors/ras.hpp>
+#include <std_components/predictors/tage_predictor.hpp>
 #include <std_components/trace_dumper_component.hpp>
 
 Linkable* CreateDefaultComponentByClass(const char* name) {
@@ -49,8 +61,14 @@ Linkable* CreateDefaultComponentByClass(const char* name) {
 #endif
 
     COMPONENT(SimpleMemory);
+    COMPONENT(Cache);
+    COMPONENT(BankedCache);
+    COMPONENT(DramController);
+    COMPONENT(TLB);
+    COMPONENT(PageWalker);
     COMPONENT(SimpleInstructionMemory);
     COMPONENT(SimpleCore);
+    COMPONENT(OutOfOrderCore);
     COMPONENT(Ras);
     COMPONENT(BranchTargetBuffer);
     COMPONENT(MemoryQueue);
@@ -58,8 +76,14 @@ Linkable* CreateDefaultComponentByClass(const char* name) {
     COMPONENT(InstructionQueue);
     COMPONENT(Fetcher);
     COMPONENT(BoomFetch);
+    COMPONENT(BranchPredictionUnit);
+    COMPONENT(FetchUnit);
     COMPONENT(SimpleExecutionUnit);
     COMPONENT(HardwiredPredictor);
+    COMPONENT(GsharePredictor);
+    COMPONENT(TagePredictor);
+    COMPONENT(PerceptronPredictor);
+    COMPONENT(IttagePredictor);
     COMPONENT(iTLB);
     COMPONENT(TraceDumperComponent);
 
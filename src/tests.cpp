@@ -29,12 +29,31 @@
 #include "tests.hpp"
 
 #include <sinuca3.hpp>
+#include <std_components/cores/out_of_order_core.hpp>
+#include <std_components/fetch/branch_prediction_unit.hpp>
+#include <std_components/fetch/fetch_unit.hpp>
 #include <std_components/misc/delay_queue.hpp>
+#include <std_components/memory/banked_cache.hpp>
+#include <std_components/memory/cache.hpp>
+#include <std_components/memory/dram_controller.hpp>
+#include <std_components/memory/itlb.hpp>
+#include <std_components/memory/tlb.hpp>
 #include <std_components/misc/queue.hpp>
 #include <std_components/predictors/gshare_predictor.hpp>
+#include <std_components/predictors/interleavedBTB.hpp>
+#include <std_components/predictors/ittage_predictor.hpp>
+#include <std_components/predictors/perceptron_predictor.hpp>
 #include <tracer/sinuca/trace_reader.hpp>
+#include <tracer/synthetic/trace_reader.hpp>
 #include <std_components/predictors/ras.hpp>
+#include <std_components/predictors/tage_predictor.hpp>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/cache/replacement_policies/lru.hpp>
+#include <utils/cache/replacement_policies/rrip.hpp>
+#include <utils/cache/replacement_policies/treePlru.hpp>
+#include <utils/counter_table.hpp>
 #include <utils/map.hpp>
+#include <utils/prefetchers/prefetcher.hpp>
 
 int TestExample() {
     SINUCA3_LOG_PRINTF("Hello, World!\n");
@@ -51,8 +70,31 @@ int Test(const char* test) {
     TEST(TestQueue);
     TEST(TestDelayQueue);
     TEST(TestGshare);
+    TEST(TestTage);
+    TEST(TestPerceptron);
+    TEST(TestIttage);
+    TEST(TestBranchTargetBuffer);
     TEST(TestTraceReader);
+    TEST(TestDynamicTraceRepeat);
+    TEST(TestContainerTrace);
+    TEST(TestSyntheticTraceReader);
     TEST(TestHashMap);
+    TEST(TestCounterTable);
+    TEST(TestCacheMemory);
+    TEST(TestLru);
+    TEST(TestTreePlru);
+    TEST(TestRrip);
+    TEST(TestCache);
+    TEST(TestCacheInclusion);
+    TEST(TestCachePrefetch);
+    TEST(TestBankedCache);
+    TEST(TestPrefetchers);
+    TEST(TestDramController);
+    TEST(TestTlb);
+    TEST(TestItlb);
+    TEST(TestOutOfOrderCore);
+    TEST(TestBranchPredictionUnit);
+    TEST(TestFetchUnit);
 
     return -1;
 }
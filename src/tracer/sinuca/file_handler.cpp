@@ -98,6 +98,8 @@ void FileHeader::SetHeaderType(uint8_t fileType) {
         strcpy((char*)this->prefix, PREFIX_DYNAMIC_FILE);
     } else if (this->fileType == FileTypeMemoryTrace) {
         strcpy((char*)this->prefix, PREFIX_MEMORY_FILE);
+    } else if (this->fileType == FileTypeContainerTrace) {
+        strcpy((char*)this->prefix, PREFIX_CONTAINER_FILE);
     } else {
         SINUCA3_ERROR_PRINTF("[FileHeader] Unkown file type!\n");
     }
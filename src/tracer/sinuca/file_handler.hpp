@@ -39,7 +39,21 @@ extern "C" {
 
 const int MAX_IMAGE_NAME_SIZE = 255;
 const int RECORD_ARRAY_SIZE = 10000;
-const int CURRENT_TRACE_VERSION = 1;
+const int CURRENT_TRACE_VERSION = 2;
+/** @brief Longest basic block sequence a repeat record may refer to. Must be a
+ * power of 2, readers keep a history ring of this size. */
+const int MAX_REPEAT_PERIOD = 16;
+/** @brief Max repetitions encoded in a single repeat record. */
+const unsigned int MAX_REPEAT_COUNT = 0xffff;
+/**
+ * @brief Size in bytes of a container chunk, including its header. Every
+ * stream takes at least one chunk and its last chunk is padded, so a container
+ * carries up to one chunk of padding per stream, about 2 MiB for 257 streams.
+ * Readers take the size from the container header.
+ */
+const unsigned int CONTAINER_CHUNK_SIZE = 1 << 13;
+/** @brief Max number of streams a container holds (1 static + 2 per thread). */
+const int MAX_CONTAINER_STREAMS = 1025;
 const unsigned char MAGIC_NUMBER = 187;
 
 const char TRACE_TARGET_X86[] = "X86";
@@ -48,12 +62,14 @@ const char TRACE_TARGET_RISCV[] = "RISCV";
 const char PREFIX_STATIC_FILE[] = "S3S";
 const char PREFIX_DYNAMIC_FILE[] = "S3D";
 const char PREFIX_MEMORY_FILE[] = "S3M";
+const char PREFIX_CONTAINER_FILE[] = "S3C";
 const int PREFIX_SIZE = sizeof(PREFIX_STATIC_FILE);
 
 enum FileType : uint8_t {
     FileTypeStaticTrace,
     FileTypeDynamicTrace,
-    FileTypeMemoryTrace
+    FileTypeMemoryTrace,
+    FileTypeContainerTrace
 };
 
 enum TargetArch : uint8_t { TargetArchX86, TargetArchARM, TargetArchRISCV };
@@ -65,7 +81,8 @@ enum StaticTraceRecordType : uint8_t {
 
 enum DynamicTraceRecordType : uint8_t {
     DynamicRecordBasicBlockIdentifier,
-    DynamicRecordThreadEvent
+    DynamicRecordThreadEvent,
+    DynamicRecordBasicBlockRepeat
 };
 
 enum ThreadEventType : uint32_t {
@@ -116,11 +133,21 @@ struct StaticTraceRecord {
     inline StaticTraceRecord() { memset(this, 0, sizeof(*this)); }
 } _PACKED;
 
-/** @brief Written to dynamic trace file. */
+/**
+ * @brief Written to dynamic trace file.
+ * @details A DynamicRecordBasicBlockRepeat record means "repeat the last
+ * `period` basic block ids `repetitions` times". The ids are the ones in the
+ * expanded stream, so a repeat may refer to ids produced by a previous repeat.
+ * Thread events are not part of the sequence.
+ */
 struct DynamicTraceRecord {
     union _PACKED {
         uint32_t basicBlockId;
         uint32_t threadEvent;
+        struct _PACKED {
+            uint16_t period;      /**<Length of the repeated sequence. */
+            uint16_t repetitions; /**<Times the sequence is repeated. */
+        } repeat;
     } data;
     uint8_t recordType;
 
@@ -158,6 +185,11 @@ struct FileHeader {
         struct {
             uint64_t totalExecutedInstructions;
         } dynamicHeader;
+        struct _PACKED {
+            uint32_t chunkSize;
+            uint32_t chunkCount;
+            uint16_t streamCount;
+        } containerHeader;
     } data;
 
     inline FileHeader() {
@@ -179,6 +211,25 @@ struct FileHeader {
     void SetHeaderType(uint8_t fileType);
 } _PACKED;
 
+/**
+ * @brief A container stores the static trace and every per-thread stream in a
+ * single file: a FileHeader, then chunkCount chunks of chunkSize bytes and, at
+ * the end, a directory with streamCount entries. Each chunk starts with a
+ * ContainerChunkHeader and belongs to a single stream. Chunks of a stream
+ * appear in order but are interleaved with chunks of other streams.
+ */
+struct ContainerChunkHeader {
+    uint16_t streamIndex; /**<Index of the stream in the directory. */
+    uint32_t usedBytes;   /**<Payload bytes, the rest of the chunk is unused. */
+} _PACKED;
+
+/** @brief Entry of the container directory. The stream payload has no header,
+ * it is stored here instead. */
+struct ContainerStreamEntry {
+    FileHeader header;
+    uint16_t tid; /**<Ignored for the static stream. */
+} _PACKED;
+
 inline void printFileErrorLog(const char *path, const char *mode) {
     SINUCA3_ERROR_PRINTF("Could not open [%s] in [%s] mode: ", path, mode);
     SINUCA3_ERROR_PRINTF("%s\n", strerror(errno));
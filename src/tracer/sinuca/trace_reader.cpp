@@ -32,7 +32,18 @@ int SinucaTraceReader::OpenTrace(const char *imageName, const char *sourceDir) {
         SINUCA3_ERROR_PRINTF("Failed to create static trace reader\n");
         return 1;
     }
-    if (this->staticTrace->OpenFile(sourceDir, imageName)) {
+    /* A container replaces every other trace file when present. */
+    if (ContainerTraceReader::Exists(sourceDir, imageName)) {
+        this->container = new ContainerTraceReader;
+        if (this->container->OpenFile(sourceDir, imageName)) {
+            SINUCA3_ERROR_PRINTF("Failed to open trace container\n");
+            return 1;
+        }
+        if (this->staticTrace->OpenStream(this->container)) {
+            SINUCA3_ERROR_PRINTF("Failed to open static trace\n");
+            return 1;
+        }
+    } else if (this->staticTrace->OpenFile(sourceDir, imageName)) {
         SINUCA3_ERROR_PRINTF("Failed to open static trace\n");
         return 1;
     }
@@ -56,7 +67,10 @@ int SinucaTraceReader::OpenTrace(const char *imageName, const char *sourceDir) {
         
         this->threadDataVec.push_back(tData);
         
-        if (tData->Allocate(sourceDir, imageName, i)) {
+        int failed = (this->container)
+                         ? tData->Allocate(this->container, i)
+                         : tData->Allocate(sourceDir, imageName, i);
+        if (failed) {
             SINUCA3_ERROR_PRINTF("[OpenTrace] tData Allocate method failed!\n");
             return 1;
         }
@@ -338,6 +352,18 @@ int ThreadData::Allocate(const char *sourceDir, const char *imageName,
     return 0;
 }
 
+int ThreadData::Allocate(ContainerTraceReader *container, int tid) {
+    if (this->dynFile.OpenStream(container, tid)) {
+        SINUCA3_ERROR_PRINTF("Failed to open dynamic trace stream\n");
+        return 1;
+    }
+    if (this->memFile.OpenStream(container, tid)) {
+        SINUCA3_ERROR_PRINTF("Failed to open memory trace stream\n");
+        return 1;
+    }
+    return 0;
+}
+
 #ifndef NDEBUG
 int TestTraceReader() {
     TraceReader *reader = new SinucaTraceReader;
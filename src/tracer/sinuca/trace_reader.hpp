@@ -27,6 +27,7 @@
 
 #include <vector>
 
+#include <tracer/sinuca/utils/container_trace_reader.hpp>
 #include <tracer/sinuca/utils/dynamic_trace_reader.hpp>
 #include <tracer/sinuca/utils/memory_trace_reader.hpp>
 #include <tracer/sinuca/utils/static_trace_reader.hpp>
@@ -45,6 +46,8 @@ struct ThreadData {
     bool isThreadAwake;
 
     int Allocate(const char* sourceDir, const char* imageName, int tid);
+    /** @brief Read the thread traces from [container] instead. */
+    int Allocate(ContainerTraceReader* container, int tid);
 
     inline ThreadData()
         : currentBasicBlock(0),
@@ -70,6 +73,7 @@ struct ThreadData {
 class SinucaTraceReader : public TraceReader {
   private:
     StaticTraceReader* staticTrace;
+    ContainerTraceReader* container; /**<Only used by container traces. */
     StaticInstructionInfo** instructionDict;
     StaticInstructionInfo* instructionPool;
     int* basicBlockSizeArr; /*<Each entry store size of corresponding bbl. */
@@ -107,6 +111,7 @@ class SinucaTraceReader : public TraceReader {
   public:
     inline SinucaTraceReader()
         : staticTrace(0),
+          container(0),
           instructionDict(0),
           instructionPool(0),
           basicBlockSizeArr(0),
@@ -123,6 +128,7 @@ class SinucaTraceReader : public TraceReader {
         delete[] this->instructionPool;
         delete[] this->basicBlockSizeArr;
         delete this->staticTrace;
+        delete this->container;
     }
 
     virtual FetchResult Fetch(InstructionPacket* ret, int tid);
@@ -142,6 +148,8 @@ class SinucaTraceReader : public TraceReader {
 
 #ifndef NDEBUG
 int TestTraceReader();
+int TestDynamicTraceRepeat();
+int TestContainerTrace();
 #endif
 
 #endif  // SINUCA3_SINUCA_TRACER_TRACE_READER_HPP_
@@ -0,0 +1,228 @@
+#ifndef NDEBUG
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file trace_writer_tests.cpp
+ * @brief Round trip tests of the trace formats.
+ * @details The traces are written with the writers the trace generator uses
+ * and read back with the readers of the simulator.
+ */
+
+#include <cstdio>
+#include <tracer/sinuca/trace_reader.hpp>
+#include <tracer/sinuca/utils/container_trace_reader.hpp>
+#include <tracer/sinuca/utils/container_trace_writer.hpp>
+#include <tracer/sinuca/utils/dynamic_trace_reader.hpp>
+#include <tracer/sinuca/utils/dynamic_trace_writer.hpp>
+
+/** @brief Directory where the tests write their traces. */
+static const char TEST_TRACE_DIR[] = "/tmp";
+
+/** @brief Marks a thread event in the expected basic block id sequence. */
+static const long TEST_THREAD_EVENT = -1;
+
+/** @brief Appends [repetitions] copies of [sequence] to [expected]. */
+static void TestAppendRepeats(long* expected, unsigned long* size,
+                              const long* sequence, unsigned long period,
+                              unsigned long repetitions) {
+    for (unsigned long r = 0; r < repetitions; ++r) {
+        for (unsigned long i = 0; i < period; ++i) {
+            expected[(*size)++] = sequence[i];
+        }
+    }
+}
+
+int TestDynamicTraceRepeat() {
+    const char imageName[] = "sinuca3_test_repeat";
+    const unsigned long maxSize = 2 * (MAX_REPEAT_COUNT + 16) + 4096;
+    long* expected = new long[maxSize];
+    unsigned long size = 0;
+
+    long sequence[MAX_REPEAT_PERIOD + 1];
+    for (long i = 0; i <= MAX_REPEAT_PERIOD; ++i) sequence[i] = 100 + i;
+
+    // Plain ids, then a period of 1, a short period, the longest period and
+    // one too long to be encoded.
+    long plain[] = {3, 1, 4, 1, 5, 9, 2, 6};
+    TestAppendRepeats(expected, &size, plain, 8, 1);
+    TestAppendRepeats(expected, &size, sequence, 1, 100);
+    TestAppendRepeats(expected, &size, sequence, 3, 50);
+    expected[size++] = TEST_THREAD_EVENT;
+    TestAppendRepeats(expected, &size, sequence, MAX_REPEAT_PERIOD, 20);
+    TestAppendRepeats(expected, &size, sequence, MAX_REPEAT_PERIOD + 1, 5);
+
+    // A loop body with a shorter period inside it.
+    long nested[] = {7, 7, 7, 8};
+    TestAppendRepeats(expected, &size, nested, 4, 30);
+
+    // More repetitions than a single record holds, ending mid repetition.
+    long pair[] = {11, 12};
+    TestAppendRepeats(expected, &size, pair, 2, MAX_REPEAT_COUNT + 10);
+    expected[size++] = 11;
+    expected[size++] = TEST_THREAD_EVENT;
+    expected[size++] = 11;
+
+    DynamicTraceWriter* writer = new DynamicTraceWriter;
+    if (writer->OpenFile(TEST_TRACE_DIR, imageName, 0)) {
+        delete writer;
+        delete[] expected;
+        return 1;
+    }
+    for (unsigned long i = 0; i < size; ++i) {
+        if (expected[i] == TEST_THREAD_EVENT) {
+            writer->AddThreadEvent(ThreadEventBarrierSync);
+        } else {
+            writer->AddBasicBlockId(expected[i]);
+        }
+    }
+    delete writer;
+
+    // The repeats must actually shrink the trace.
+    unsigned long bufferSize =
+        GetPathTidInSize(TEST_TRACE_DIR, "dynamic", imageName);
+    char* path = (char*)alloca(bufferSize);
+    FormatPathTidIn(path, TEST_TRACE_DIR, "dynamic", imageName, 0, bufferSize);
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        delete[] expected;
+        return 2;
+    }
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fclose(file);
+    if (fileSize > (long)(sizeof(FileHeader) +
+                          512 * sizeof(DynamicTraceRecord))) {
+        delete[] expected;
+        return 3;
+    }
+
+    DynamicTraceReader* reader = new DynamicTraceReader;
+    if (reader->OpenFile(TEST_TRACE_DIR, imageName, 0)) {
+        delete reader;
+        delete[] expected;
+        return 4;
+    }
+    unsigned long read = 0;
+    int ret = 0;
+    while (reader->ReadDynamicRecord() == 0) {
+        if (read == size) {
+            ret = 5;
+            break;
+        }
+        if (reader->GetRecordType() == DynamicRecordThreadEvent) {
+            if (expected[read] != TEST_THREAD_EVENT ||
+                reader->GetThreadEvent() != ThreadEventBarrierSync) {
+                ret = 6;
+                break;
+            }
+        } else if (expected[read] != reader->GetBasicBlockIdentifier()) {
+            SINUCA3_DEBUG_PRINTF("Id [%lu] is [%u], expected [%ld]\n", read,
+                                 reader->GetBasicBlockIdentifier(),
+                                 expected[read]);
+            ret = 7;
+            break;
+        }
+        ++read;
+    }
+    if (ret == 0 && read != size) ret = 8;
+
+    delete reader;
+    delete[] expected;
+    remove(path);
+
+    return ret;
+}
+
+int TestContainerTrace() {
+    const char imageName[] = "sinuca3_test_container";
+    const int threads = 4;
+    // Enough records for the record arrays of the writers to flush more than
+    // once, so chunks of different streams interleave in the file.
+    const unsigned long sizes[threads] = {25000, 1, 12000, 0};
+
+    ContainerTraceWriter* container = new ContainerTraceWriter;
+    if (container->OpenFile(TEST_TRACE_DIR, imageName)) {
+        delete container;
+        return 1;
+    }
+    DynamicTraceWriter* writers[threads];
+    for (int t = 0; t < threads; ++t) {
+        writers[t] = new DynamicTraceWriter;
+        if (writers[t]->OpenStream(container, t)) return 2;
+    }
+    // Strictly increasing ids are never folded into repeats.
+    for (unsigned long i = 0; i < sizes[0]; ++i) {
+        for (int t = 0; t < threads; ++t) {
+            if (i < sizes[t]) writers[t]->AddBasicBlockId(t * 100000 + i);
+        }
+    }
+    for (int t = 0; t < threads; ++t) delete writers[t];
+    delete container;
+
+    // Each stream is padded to whole chunks and nothing else is added.
+    unsigned long chunks = 0;
+    for (int t = 0; t < threads; ++t) {
+        unsigned long bytes = sizes[t] * sizeof(DynamicTraceRecord);
+        unsigned long payload =
+            CONTAINER_CHUNK_SIZE - sizeof(ContainerChunkHeader);
+        chunks += (bytes + payload - 1) / payload;
+    }
+    unsigned long bufferSize =
+        GetPathTidOutSize(TEST_TRACE_DIR, "container", imageName);
+    char* path = (char*)alloca(bufferSize);
+    FormatPathTidOut(path, TEST_TRACE_DIR, "container", imageName, bufferSize);
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return 3;
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fclose(file);
+    if (fileSize != (long)(sizeof(FileHeader) + chunks * CONTAINER_CHUNK_SIZE +
+                           threads * sizeof(ContainerStreamEntry))) {
+        return 4;
+    }
+
+    ContainerTraceReader* reader = new ContainerTraceReader;
+    int ret = 0;
+    if (reader->OpenFile(TEST_TRACE_DIR, imageName)) ret = 5;
+    for (int t = 0; t < threads && ret == 0; ++t) {
+        DynamicTraceReader* stream = new DynamicTraceReader;
+        if (stream->OpenStream(reader, t)) ret = 6;
+        int index = reader->FindStream(FileTypeDynamicTrace, t);
+        if (ret == 0 && reader->GetStreamSize(index) !=
+                            sizes[t] * sizeof(DynamicTraceRecord)) {
+            ret = 7;
+        }
+        unsigned long read = 0;
+        while (ret == 0 && stream->ReadDynamicRecord() == 0) {
+            if (read == sizes[t] ||
+                stream->GetBasicBlockIdentifier() != t * 100000 + read) {
+                ret = 8;
+            }
+            ++read;
+        }
+        if (ret == 0 && read != sizes[t]) ret = 9;
+        delete stream;
+    }
+    delete reader;
+    remove(path);
+
+    return ret;
+}
+
+#endif  // NDEBUG
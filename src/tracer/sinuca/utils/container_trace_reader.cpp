@@ -0,0 +1,182 @@
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file container_trace_reader.cpp
+ * @brief Implementation of the container trace reader.
+ */
+
+#include "container_trace_reader.hpp"
+
+#include <cstring>
+
+#include "utils/logging.hpp"
+
+extern "C" {
+#include <alloca.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+}
+
+bool ContainerTraceReader::Exists(const char* sourceDir,
+                                  const char* imageName) {
+    unsigned long bufferLen;
+    char* path;
+
+    bufferLen = GetPathTidOutSize(sourceDir, "container", imageName);
+    path = (char*)alloca(bufferLen);
+    FormatPathTidOut(path, sourceDir, "container", imageName, bufferLen);
+
+    return (access(path, R_OK) == 0);
+}
+
+int ContainerTraceReader::OpenFile(const char* sourceDir,
+                                   const char* imageName) {
+    unsigned long bufferLen;
+    char* path;
+
+    bufferLen = GetPathTidOutSize(sourceDir, "container", imageName);
+    path = (char*)alloca(bufferLen);
+    FormatPathTidOut(path, sourceDir, "container", imageName, bufferLen);
+
+    this->fileDescriptor = open(path, O_RDONLY);
+    if (this->fileDescriptor == -1) {
+        printFileErrorLog(path, "O_RDONLY");
+        return 1;
+    }
+    this->mmapSize = lseek(this->fileDescriptor, 0, SEEK_END);
+    if (this->mmapSize < sizeof(this->header)) {
+        SINUCA3_ERROR_PRINTF("Container file [%s] is truncated!\n", path);
+        return 1;
+    }
+    this->mmapPtr = (char*)mmap(0, this->mmapSize, PROT_READ, MAP_PRIVATE,
+                                this->fileDescriptor, 0);
+    if (this->mmapPtr == MAP_FAILED) {
+        this->mmapPtr = NULL;
+        printFileErrorLog(path, "PROT_READ MAP_PRIVATE");
+        return 1;
+    }
+
+    unsigned long offset = 0;
+    this->header.LoadHeader(this->mmapPtr, &offset);
+    if (this->header.fileType != FileTypeContainerTrace) {
+        SINUCA3_ERROR_PRINTF("File [%s] is not a container!\n", path);
+        return 1;
+    }
+
+    unsigned long streamCount = this->header.data.containerHeader.streamCount;
+    unsigned long chunkCount = this->header.data.containerHeader.chunkCount;
+    offset += chunkCount * this->GetChunkSize();
+    if (this->GetChunkSize() <= sizeof(ContainerChunkHeader) ||
+        offset + streamCount * sizeof(*this->directory) > this->mmapSize) {
+        SINUCA3_ERROR_PRINTF("Container file [%s] is truncated!\n", path);
+        return 1;
+    }
+    this->directory = (const ContainerStreamEntry*)(this->mmapPtr + offset);
+
+    return this->IndexChunks();
+}
+
+int ContainerTraceReader::IndexChunks() {
+    unsigned long streamCount = this->header.data.containerHeader.streamCount;
+    unsigned long chunkCount = this->header.data.containerHeader.chunkCount;
+
+    this->streamChunkStart = new unsigned long[streamCount + 1];
+    this->streamSize = new unsigned long[streamCount];
+    this->chunks = new uint32_t[chunkCount];
+    memset(this->streamChunkStart, 0,
+           sizeof(*this->streamChunkStart) * (streamCount + 1));
+    memset(this->streamSize, 0, sizeof(*this->streamSize) * streamCount);
+
+    /* Counting sort of the chunks by stream, keeping the file order. */
+    for (unsigned long i = 0; i < chunkCount; ++i) {
+        const ContainerChunkHeader* chunk = this->GetChunk(i);
+        if (chunk->streamIndex >= streamCount ||
+            chunk->usedBytes >
+                this->GetChunkSize() - sizeof(ContainerChunkHeader)) {
+            SINUCA3_ERROR_PRINTF("Container chunk [%lu] is corrupted!\n", i);
+            return 1;
+        }
+        ++this->streamChunkStart[chunk->streamIndex + 1];
+        this->streamSize[chunk->streamIndex] += chunk->usedBytes;
+    }
+    for (unsigned long i = 0; i < streamCount; ++i) {
+        this->streamChunkStart[i + 1] += this->streamChunkStart[i];
+    }
+
+    unsigned long* fill = new unsigned long[streamCount];
+    memcpy(fill, this->streamChunkStart, sizeof(*fill) * streamCount);
+    for (unsigned long i = 0; i < chunkCount; ++i) {
+        this->chunks[fill[this->GetChunk(i)->streamIndex]++] = i;
+    }
+    delete[] fill;
+
+    return 0;
+}
+
+int ContainerTraceReader::FindStream(uint8_t fileType, int tid) {
+    for (int i = 0; i < this->header.data.containerHeader.streamCount; ++i) {
+        if (this->directory[i].header.fileType != fileType) continue;
+        if (fileType == FileTypeStaticTrace || this->directory[i].tid == tid) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+unsigned long ContainerTraceReader::ReadStream(ContainerStreamCursor* cursor,
+                                               void* dest,
+                                               unsigned long size) {
+    unsigned long copied = 0;
+    unsigned long lastChunk = this->streamChunkStart[cursor->stream + 1];
+
+    while (copied < size) {
+        unsigned long chunkIndex =
+            this->streamChunkStart[cursor->stream] + cursor->chunk;
+        if (chunkIndex >= lastChunk) break;
+
+        const ContainerChunkHeader* chunk =
+            this->GetChunk(this->chunks[chunkIndex]);
+        unsigned long available = chunk->usedBytes - cursor->offset;
+        unsigned long toCopy =
+            (size - copied < available) ? size - copied : available;
+        memcpy((char*)dest + copied,
+               (const char*)(chunk + 1) + cursor->offset, toCopy);
+        copied += toCopy;
+        cursor->offset += toCopy;
+        if (cursor->offset == chunk->usedBytes) {
+            ++cursor->chunk;
+            cursor->offset = 0;
+        }
+    }
+
+    return copied;
+}
+
+ContainerTraceReader::~ContainerTraceReader() {
+    delete[] this->streamChunkStart;
+    delete[] this->streamSize;
+    delete[] this->chunks;
+    if (this->mmapPtr) {
+        munmap(this->mmapPtr, this->mmapSize);
+    }
+    if (this->fileDescriptor != -1) {
+        close(this->fileDescriptor);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef SINUCA3_SINUCA_TRACER_CONTAINER_TRACE_READER_HPP_
+#define SINUCA3_SINUCA_TRACER_CONTAINER_TRACE_READER_HPP_
+
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file container_trace_reader.hpp
+ * @brief Class implementation of the container trace reader.
+ * @details A container holds the static trace and the dynamic and memory
+ * traces of every thread in a single file (check file_handler.hpp for the
+ * layout). The whole file is opened once and mapped to virtual memory. Each
+ * stream is read sequentially through a ContainerStreamCursor, which walks the
+ * chunks of the stream in order, so the individual readers only copy records
+ * out of the map instead of issuing reads of their own.
+ */
+
+#include <stdint.h>
+
+#include <tracer/sinuca/file_handler.hpp>
+
+/** @brief Position of a reader inside a container stream. */
+struct ContainerStreamCursor {
+    int stream;
+    unsigned long chunk;  /**<Index in the chunk list of the stream. */
+    unsigned long offset; /**<Bytes already read from the current chunk. */
+
+    inline ContainerStreamCursor() : stream(-1), chunk(0), offset(0) {}
+};
+
+/** @brief Check container_trace_reader.hpp documentation for details */
+class ContainerTraceReader {
+  private:
+    FileHeader header;
+    int fileDescriptor;
+    char* mmapPtr;
+    unsigned long mmapSize;
+    const ContainerStreamEntry* directory; /**<Points into the map. */
+    unsigned long* streamChunkStart; /**<First entry of a stream in chunks. */
+    unsigned long* streamSize;       /**<Payload bytes of each stream. */
+    uint32_t* chunks; /**<Chunk indexes grouped by stream, in file order. */
+
+    inline const ContainerChunkHeader* GetChunk(unsigned long chunk) {
+        return (const ContainerChunkHeader*)(this->mmapPtr +
+                                             sizeof(this->header) +
+                                             chunk * this->GetChunkSize());
+    }
+    inline unsigned long GetChunkSize() {
+        return this->header.data.containerHeader.chunkSize;
+    }
+    int IndexChunks();
+
+  public:
+    inline ContainerTraceReader()
+        : fileDescriptor(-1),
+          mmapPtr(0),
+          mmapSize(0),
+          directory(0),
+          streamChunkStart(0),
+          streamSize(0),
+          chunks(0) {}
+    ~ContainerTraceReader();
+
+    /** @brief Check if a container exists in the [sourceDir] directory. */
+    static bool Exists(const char* sourceDir, const char* imageName);
+
+    /**
+     * @return 1 on failure, 0 otherwise.
+     */
+    int OpenFile(const char* sourceDir, const char* imageName);
+    /**
+     * @brief Find the stream of [fileType] written by thread [tid].
+     * @param tid Ignored for the static trace.
+     * @returns The stream index or -1 if there is no such stream.
+     */
+    int FindStream(uint8_t fileType, int tid);
+    /**
+     * @brief Copy up to [size] bytes of the stream into [dest].
+     * @returns The number of bytes copied, 0 at the end of the stream.
+     */
+    unsigned long ReadStream(ContainerStreamCursor* cursor, void* dest,
+                             unsigned long size);
+
+    inline const FileHeader* GetStreamHeader(int stream) {
+        return &this->directory[stream].header;
+    }
+    inline unsigned long GetStreamSize(int stream) {
+        return this->streamSize[stream];
+    }
+};
+
+#endif
@@ -0,0 +1,163 @@
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file container_trace_writer.cpp
+ * @details Implementation of ContainerTraceWriter class.
+ */
+
+#include "container_trace_writer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "tracer/sinuca/file_handler.hpp"
+#include "utils/logging.hpp"
+
+extern "C" {
+#include <alloca.h>
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+int ContainerTraceWriter::OpenFile(const char* sourceDir,
+                                   const char* imageName) {
+    unsigned long bufferSize;
+    char* path;
+
+    bufferSize = GetPathTidOutSize(sourceDir, "container", imageName);
+    path = (char*)alloca(bufferSize);
+    FormatPathTidOut(path, sourceDir, "container", imageName, bufferSize);
+    this->fileDescriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (this->fileDescriptor == -1) {
+        SINUCA3_ERROR_PRINTF("Failed to open container file [%s]\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+int ContainerTraceWriter::AddStream(int tid) {
+    if (this->fileDescriptor == -1) {
+        SINUCA3_ERROR_PRINTF("Container file is not open!\n");
+        return -1;
+    }
+
+    int stream = __sync_fetch_and_add(&this->streamCount, 1);
+    if (stream >= MAX_CONTAINER_STREAMS) {
+        SINUCA3_ERROR_PRINTF("Too many streams in container!\n");
+        return -1;
+    }
+
+    this->chunkBuffers[stream] = (char*)malloc(CONTAINER_CHUNK_SIZE);
+    if (this->chunkBuffers[stream] == NULL) {
+        SINUCA3_ERROR_PRINTF("Failed to alloc container chunk!\n");
+        return -1;
+    }
+    this->chunkOccupation[stream] = sizeof(ContainerChunkHeader);
+    this->directory[stream].tid = tid;
+
+    return stream;
+}
+
+int ContainerTraceWriter::WriteChunk(int stream) {
+    ContainerChunkHeader* chunkHeader =
+        (ContainerChunkHeader*)this->chunkBuffers[stream];
+    chunkHeader->streamIndex = stream;
+    chunkHeader->usedBytes =
+        this->chunkOccupation[stream] - sizeof(ContainerChunkHeader);
+    memset(this->chunkBuffers[stream] + this->chunkOccupation[stream], 0,
+           CONTAINER_CHUNK_SIZE - this->chunkOccupation[stream]);
+
+    unsigned long chunk = __sync_fetch_and_add(&this->chunkCount, 1);
+    off_t offset = sizeof(FileHeader) + chunk * CONTAINER_CHUNK_SIZE;
+    if (pwrite(this->fileDescriptor, this->chunkBuffers[stream],
+               CONTAINER_CHUNK_SIZE, offset) != CONTAINER_CHUNK_SIZE) {
+        SINUCA3_ERROR_PRINTF("Failed to write container chunk!\n");
+        return 1;
+    }
+    this->chunkOccupation[stream] = sizeof(ContainerChunkHeader);
+
+    return 0;
+}
+
+int ContainerTraceWriter::Write(int stream, const void* data,
+                                unsigned long size) {
+    const char* bytes = (const char*)data;
+
+    while (size > 0) {
+        unsigned long space =
+            CONTAINER_CHUNK_SIZE - this->chunkOccupation[stream];
+        unsigned long toCopy = (size < space) ? size : space;
+        memcpy(this->chunkBuffers[stream] + this->chunkOccupation[stream],
+               bytes, toCopy);
+        this->chunkOccupation[stream] += toCopy;
+        bytes += toCopy;
+        size -= toCopy;
+        if (this->chunkOccupation[stream] == CONTAINER_CHUNK_SIZE) {
+            if (this->WriteChunk(stream)) return 1;
+        }
+    }
+
+    return 0;
+}
+
+int ContainerTraceWriter::CloseStream(int stream,
+                                      const FileHeader* streamHeader) {
+    if (stream < 0 || this->chunkBuffers[stream] == NULL) return 1;
+
+    int ret = 0;
+    if (this->chunkOccupation[stream] > sizeof(ContainerChunkHeader)) {
+        ret = this->WriteChunk(stream);
+    }
+    this->directory[stream].header = *streamHeader;
+    free(this->chunkBuffers[stream]);
+    this->chunkBuffers[stream] = NULL;
+
+    return ret;
+}
+
+ContainerTraceWriter::~ContainerTraceWriter() {
+    if (this->fileDescriptor == -1) return;
+
+    unsigned int streams = this->streamCount;
+    if (streams > (unsigned int)MAX_CONTAINER_STREAMS) {
+        streams = MAX_CONTAINER_STREAMS;
+    }
+    for (unsigned int i = 0; i < streams; ++i) {
+        if (this->chunkBuffers[i] != NULL) {
+            SINUCA3_ERROR_PRINTF("Container stream [%u] was not closed!\n", i);
+            free(this->chunkBuffers[i]);
+        }
+    }
+
+    this->header.data.containerHeader.chunkCount = this->chunkCount;
+    this->header.data.containerHeader.streamCount = streams;
+    off_t directoryOffset =
+        sizeof(FileHeader) +
+        (off_t)this->chunkCount * CONTAINER_CHUNK_SIZE;
+    unsigned long directorySize = streams * sizeof(*this->directory);
+    if (pwrite(this->fileDescriptor, this->directory, directorySize,
+               directoryOffset) != (ssize_t)directorySize) {
+        SINUCA3_ERROR_PRINTF("Failed to write container directory!\n");
+    }
+    if (pwrite(this->fileDescriptor, &this->header, sizeof(this->header), 0) !=
+        sizeof(this->header)) {
+        SINUCA3_ERROR_PRINTF("Failed to write container header!\n");
+    }
+    close(this->fileDescriptor);
+}
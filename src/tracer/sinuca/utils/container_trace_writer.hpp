@@ -0,0 +1,79 @@
+#ifndef SINUCA3_GENERATOR_CONTAINER_FILE_HPP_
+#define SINUCA3_GENERATOR_CONTAINER_FILE_HPP_
+
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file container_trace_writer.hpp
+ * @details A container packs the static trace and the dynamic and memory
+ * traces of every thread in a single file, so a run with many threads does not
+ * create hundreds of files. Each stream (e.g. the dynamic trace of thread 3)
+ * owns a chunk buffer of CONTAINER_CHUNK_SIZE bytes. Whenever it fills up, a
+ * chunk index is claimed atomically and the buffer is written with pwrite at
+ * its final position, so threads never share a file cursor nor take a lock.
+ * The stream headers and the directory are written when the container is
+ * destroyed. The last chunk of a stream is padded to the full size, which is
+ * why chunks are kept small. Check file_handler.hpp for the layout.
+ */
+
+#include <stdint.h>
+
+#include <cstring>
+
+#include <tracer/sinuca/file_handler.hpp>
+
+/** @brief Check container_trace_writer.hpp documentation for details */
+class ContainerTraceWriter {
+  private:
+    int fileDescriptor;
+    FileHeader header;
+    ContainerStreamEntry directory[MAX_CONTAINER_STREAMS];
+    char* chunkBuffers[MAX_CONTAINER_STREAMS]; /**<Chunk being filled. */
+    unsigned int chunkOccupation[MAX_CONTAINER_STREAMS]; /**<In bytes. */
+    volatile uint32_t chunkCount;
+    volatile uint32_t streamCount;
+
+    int WriteChunk(int stream);
+
+  public:
+    inline ContainerTraceWriter()
+        : fileDescriptor(-1), chunkCount(0), streamCount(0) {
+        this->header.SetHeaderType(FileTypeContainerTrace);
+        this->header.data.containerHeader.chunkSize = CONTAINER_CHUNK_SIZE;
+        memset(this->chunkBuffers, 0, sizeof(this->chunkBuffers));
+    }
+    ~ContainerTraceWriter();
+
+    /** @brief Create the container file in the [sourceDir] directory. */
+    int OpenFile(const char* sourceDir, const char* imageName);
+    /**
+     * @brief Reserve a new stream. Thread safe.
+     * @param tid Thread of the stream, ignored for the static trace.
+     * @returns The stream index or -1 on failure.
+     */
+    int AddStream(int tid);
+    /**
+     * @brief Append [size] bytes to [stream]. Streams may be written
+     * concurrently, but a single stream must not.
+     */
+    int Write(int stream, const void* data, unsigned long size);
+    /** @brief Flush the last chunk of [stream] and set its header. */
+    int CloseStream(int stream, const FileHeader* streamHeader);
+};
+
+#endif
@@ -52,6 +52,19 @@ int DynamicTraceReader::OpenFile(const char *sourceDir, const char *imageName,
     return 0;
 }
 
+int DynamicTraceReader::OpenStream(ContainerTraceReader *container, int tid) {
+    this->cursor.stream = container->FindStream(FileTypeDynamicTrace, tid);
+    if (this->cursor.stream == -1) {
+        SINUCA3_ERROR_PRINTF("Container has no dynamic trace of thread [%d]!\n",
+                             tid);
+        return 1;
+    }
+    this->container = container;
+    this->header = *container->GetStreamHeader(this->cursor.stream);
+
+    return 0;
+}
+
 int DynamicTraceReader::ReadDynamicRecord() {
     if (this->reachedEnd) {
         SINUCA3_ERROR_PRINTF(
@@ -59,6 +72,43 @@ int DynamicTraceReader::ReadDynamicRecord() {
         return 1;
     }
 
+    if (this->repeatRemaining == 0) {
+        this->repeatPeriod = 0;
+        if (this->ReadRawRecord()) return 1;
+
+        const DynamicTraceRecord *record =
+            &this->recordArray[this->recordArrayIndex];
+        if (record->recordType == DynamicRecordBasicBlockIdentifier) {
+            this->currentBasicBlockId = record->data.basicBlockId;
+            this->PushRecentId(this->currentBasicBlockId);
+            return 0;
+        }
+        if (record->recordType != DynamicRecordBasicBlockRepeat) return 0;
+
+        this->repeatPeriod = record->data.repeat.period;
+        this->repeatRemaining =
+            (unsigned long)this->repeatPeriod * record->data.repeat.repetitions;
+        if (this->repeatPeriod == 0 ||
+            this->repeatPeriod > (unsigned int)MAX_REPEAT_PERIOD ||
+            this->repeatPeriod > this->recentIdsCount ||
+            this->repeatRemaining == 0) {
+            SINUCA3_ERROR_PRINTF(
+                "[ReadDynamicRecord] malformed repeat record!\n");
+            this->reachedEnd = true;
+            return 1;
+        }
+    }
+
+    this->currentBasicBlockId =
+        this->recentIds[(this->recentIdsCount - this->repeatPeriod) &
+                        (MAX_REPEAT_PERIOD - 1)];
+    this->PushRecentId(this->currentBasicBlockId);
+    --this->repeatRemaining;
+
+    return 0;
+}
+
+int DynamicTraceReader::ReadRawRecord() {
     this->recordArrayIndex =
         (this->numberOfRecordsRead == 0) ? 0 : this->recordArrayIndex + 1;
 
@@ -73,12 +123,17 @@ int DynamicTraceReader::ReadDynamicRecord() {
 }
 
 int DynamicTraceReader::LoadRecordArray() {
-    if (this->file == NULL) return 1;
+    if (this->file == NULL && this->container == NULL) return 1;
 
     this->recordArrayIndex = 0;
     unsigned long readBytes = 0;
-    readBytes =
-        fread(this->recordArray, 1, sizeof(this->recordArray), this->file);
+    if (this->container) {
+        readBytes = this->container->ReadStream(
+            &this->cursor, this->recordArray, sizeof(this->recordArray));
+    } else {
+        readBytes =
+            fread(this->recordArray, 1, sizeof(this->recordArray), this->file);
+    }
 
     this->numberOfRecordsRead = readBytes / sizeof(*this->recordArray);
 
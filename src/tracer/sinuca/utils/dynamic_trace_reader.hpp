@@ -21,11 +21,14 @@
 /**
  * @file dynamic_trace_reader.hpp
  * @brief Class implementation of the dynamic trace reader.
- * @details .
+ * @details Repeat records are expanded lazily: the reader keeps a ring with the
+ * last MAX_REPEAT_PERIOD basic block ids served and replays them while a repeat
+ * is pending, so the repeated sequence is never materialized.
  */
 
 #include <cstdio>
 #include <tracer/sinuca/file_handler.hpp>
+#include <tracer/sinuca/utils/container_trace_reader.hpp>
 
 #include "utils/logging.hpp"
 
@@ -33,17 +36,37 @@
 class DynamicTraceReader {
   private:
     FILE* file;
+    ContainerTraceReader* container; /**<Set when reading from a container. */
+    ContainerStreamCursor cursor;
     FileHeader header;
     DynamicTraceRecord recordArray[RECORD_ARRAY_SIZE];
     int numberOfRecordsRead;
     int recordArrayIndex;
+    unsigned int recentIds[MAX_REPEAT_PERIOD]; /**<Last ids served. */
+    unsigned long recentIdsCount; /**<Ids ever pushed into recentIds. */
+    unsigned long repeatRemaining; /**<Ids left to replay from a repeat. */
+    unsigned int repeatPeriod;     /**<Period of the pending repeat. */
+    unsigned int currentBasicBlockId; /**<Id of the current record. */
     bool reachedEnd;
 
     int LoadRecordArray();
+    int ReadRawRecord();
+
+    inline void PushRecentId(unsigned int id) {
+        this->recentIds[this->recentIdsCount & (MAX_REPEAT_PERIOD - 1)] = id;
+        ++this->recentIdsCount;
+    }
 
   public:
     inline DynamicTraceReader()
-        : file(0), numberOfRecordsRead(0), reachedEnd(0) {}
+        : file(0),
+          container(0),
+          numberOfRecordsRead(0),
+          recentIdsCount(0),
+          repeatRemaining(0),
+          repeatPeriod(0),
+          currentBasicBlockId(0),
+          reachedEnd(0) {}
     inline ~DynamicTraceReader() {
         if (file) {
             fclose(this->file);
@@ -55,18 +78,22 @@ class DynamicTraceReader {
     }
 
     int OpenFile(const char* sourceDir, const char* imageName, int tid);
+    /** @brief Read the [tid] dynamic trace from a stream of [container]. */
+    int OpenStream(ContainerTraceReader* container, int tid);
     int ReadDynamicRecord();
 
     inline unsigned long GetTotalExecutedInstructions() {
         return this->header.data.dynamicHeader.totalExecutedInstructions;
     }
+    /** @brief Repeat records are never returned, they are expanded into
+     * basic block identifiers. */
     inline DynamicTraceRecordType GetRecordType() {
+        if (this->repeatPeriod != 0) return DynamicRecordBasicBlockIdentifier;
         return (DynamicTraceRecordType)this->recordArray[this->recordArrayIndex]
         .recordType;
     }
     inline unsigned int GetBasicBlockIdentifier() {
-        return this->recordArray[this->recordArrayIndex]
-        .data.basicBlockId;
+        return this->currentBasicBlockId;
     }
     inline ThreadEventType GetThreadEvent() {
         return (ThreadEventType)this->recordArray[this->recordArrayIndex].data
@@ -0,0 +1,220 @@
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file dynamic_trace_writer.cpp
+ * @details Implementation of DynamicTraceFile class.
+ */
+
+#include "dynamic_trace_writer.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "tracer/sinuca/file_handler.hpp"
+#include "utils/logging.hpp"
+
+extern "C" {
+#include <alloca.h>
+}
+
+int DynamicTraceWriter::OpenFile(const char* sourceDir, const char* imageName,
+                                 int tid) {
+    unsigned long bufferSize;
+    char* path;
+
+    bufferSize = GetPathTidInSize(sourceDir, "dynamic", imageName);
+    path = (char*)alloca(bufferSize);
+    FormatPathTidIn(path, sourceDir, "dynamic", imageName, tid, bufferSize);
+    this->file = fopen(path, "wb");
+    if (this->file == NULL) {
+        SINUCA3_ERROR_PRINTF("Failed to alloc file in dynamic trace!");
+        return 1;
+    }
+    this->header.ReserveHeaderSpace(this->file);
+
+    return 0;
+}
+
+int DynamicTraceWriter::OpenStream(ContainerTraceWriter* container, int tid) {
+    this->containerStream = container->AddStream(tid);
+    if (this->containerStream == -1) {
+        SINUCA3_ERROR_PRINTF("Failed to add dynamic stream to container!\n");
+        return 1;
+    }
+    this->container = container;
+
+    return 0;
+}
+
+int DynamicTraceWriter::FlushRecordArray() {
+    unsigned long occupationInBytes =
+        this->recordArrayOccupation * sizeof(*this->recordArray);
+
+    if (this->container) {
+        return this->container->Write(this->containerStream, this->recordArray,
+                                      occupationInBytes);
+    }
+    if (this->file == NULL) {
+        SINUCA3_ERROR_PRINTF("File pointer is nil in mem trace!\n");
+        return 1;
+    }
+
+    if (fwrite(this->recordArray, 1, occupationInBytes, this->file) !=
+        occupationInBytes) {
+        SINUCA3_ERROR_PRINTF("Failed to flush memory records!\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int DynamicTraceWriter::CheckRecordArray() {
+    if (this->IsRecordArrayFull()) {
+        if (this->FlushRecordArray()) {
+            SINUCA3_ERROR_PRINTF("Failed to flush mem record array!\n")
+            return 1;
+        }
+        this->ResetRecordArray();
+    }
+    return 0;
+}
+
+int DynamicTraceWriter::AddDynamicRecord(DynamicTraceRecord record) {
+    this->recordArray[this->recordArrayOccupation] = record;
+    ++this->recordArrayOccupation;
+    if (this->CheckRecordArray()) return 1;
+    return 0;
+}
+
+int DynamicTraceWriter::CommitBasicBlockId(unsigned int identifier) {
+    DynamicTraceRecord record;
+    record.recordType = DynamicRecordBasicBlockIdentifier;
+    record.data.basicBlockId = identifier;
+    return (this->AddDynamicRecord(record));
+}
+
+int DynamicTraceWriter::CommitTail(int count) {
+    for (int i = 0; i < count; ++i) {
+        if (this->CommitBasicBlockId(this->tail[i])) return 1;
+    }
+    this->tailOccupation -= count;
+    if (this->tailOccupation > 0) {
+        memmove(this->tail, &this->tail[count],
+                this->tailOccupation * sizeof(*this->tail));
+    }
+    return 0;
+}
+
+int DynamicTraceWriter::CommitRepeat() {
+    if (this->repeatCount == 0) return 0;
+    if (this->CommitTail(this->tailOccupation)) return 1;
+
+    DynamicTraceRecord record;
+    record.recordType = DynamicRecordBasicBlockRepeat;
+    record.data.repeat.period = this->repeatPeriod;
+    record.data.repeat.repetitions = this->repeatCount;
+    this->repeatCount = 0;
+    return (this->AddDynamicRecord(record));
+}
+
+int DynamicTraceWriter::AddToTail(unsigned int id) {
+    if (this->tailOccupation == MAX_REPEAT_PERIOD) {
+        if (this->CommitTail(1)) return 1;
+    }
+    this->tail[this->tailOccupation] = id;
+    ++this->tailOccupation;
+    return 0;
+}
+
+int DynamicTraceWriter::DetectRepeat() {
+    // The smallest period whose last occurrence is still uncommitted wins.
+    for (int period = 1; period <= this->tailOccupation; ++period) {
+        if (this->recentIdsCount < (unsigned long)(2 * period)) break;
+
+        int i = 1;
+        while (i <= period &&
+               this->GetRecentId(i) == this->GetRecentId(i + period))
+            ++i;
+        if (i <= period) continue;
+
+        this->tailOccupation -= period;
+        this->repeatPeriod = period;
+        this->repeatMatched = 0;
+        this->repeatCount = 1;
+        return 0;
+    }
+
+    return 0;
+}
+
+int DynamicTraceWriter::EndRepeat() {
+    if (this->repeatPeriod == 0) return 0;
+
+    int back = this->repeatCount * this->repeatPeriod + this->repeatMatched;
+    // Short repeats are turned back into plain ids, otherwise a spurious
+    // period found inside a loop body would hide the period of the loop.
+    if (back > MAX_REPEAT_PERIOD) {
+        if (this->CommitRepeat()) return 1;
+        back = this->repeatMatched;
+    }
+    this->repeatPeriod = 0;
+    this->repeatMatched = 0;
+    this->repeatCount = 0;
+
+    // These ids are already in the history, they just become plain ids.
+    for (; back > 0; --back) {
+        if (this->AddToTail(this->GetRecentId(back))) return 1;
+    }
+    return 0;
+}
+
+int DynamicTraceWriter::FlushPending() {
+    if (this->EndRepeat()) return 1;
+    return this->CommitTail(this->tailOccupation);
+}
+
+int DynamicTraceWriter::AddThreadEvent(ThreadEventType evType) {
+    if (this->FlushPending()) return 1;
+
+    DynamicTraceRecord record;
+    record.recordType = DynamicRecordThreadEvent;
+    record.data.threadEvent = evType;
+    return (this->AddDynamicRecord(record));
+}
+
+int DynamicTraceWriter::AddBasicBlockId(unsigned int identifier) {
+    if (this->repeatPeriod > 0) {
+        if (identifier == this->GetRecentId(this->repeatPeriod)) {
+            this->PushRecentId(identifier);
+            ++this->repeatMatched;
+            if (this->repeatMatched == this->repeatPeriod) {
+                this->repeatMatched = 0;
+                ++this->repeatCount;
+                if (this->repeatCount == MAX_REPEAT_COUNT) {
+                    return this->CommitRepeat();
+                }
+            }
+            return 0;
+        }
+        if (this->EndRepeat()) return 1;
+    }
+
+    this->PushRecentId(identifier);
+    if (this->AddToTail(identifier)) return 1;
+    return this->DetectRepeat();
+}
@@ -25,21 +25,40 @@
  * this info to simulate an execution. This file defines the DynamicTraceWriter
  * class which encapsulates the dynamic trace file and the methods that may
  * modify it.
+ *
+ * Hot loops produce long repetitions of the same few basic block ids, so the
+ * writer detects periodic patterns online and emits them as a single
+ * DynamicRecordBasicBlockRepeat record. The last MAX_REPEAT_PERIOD plain ids
+ * are held back in a small tail so they can be folded into a repeat record
+ * before reaching the record array.
  */
 
 #include <cstdio>
 #include <tracer/sinuca/file_handler.hpp>
 
+#include "container_trace_writer.hpp"
+
 #include "utils/logging.hpp"
 
 /** @brief Check dynamic_trace_writer.hpp documentation for details */
 class DynamicTraceWriter {
   private:
     FILE* file;
+    ContainerTraceWriter* container; /**<Set when writing to a container. */
+    int containerStream;
     FileHeader header;
     DynamicTraceRecord recordArray[RECORD_ARRAY_SIZE]; /**<Buffer of records. */
     int recordArrayOccupation; /**<The number of records currently stored. */
 
+    unsigned int recentIds[2 * MAX_REPEAT_PERIOD]; /**<Ring with the last ids
+                                                      of the expanded stream. */
+    unsigned int tail[MAX_REPEAT_PERIOD]; /**<Plain ids not yet committed. */
+    unsigned long recentIdsCount; /**<Ids ever pushed into recentIds. */
+    int tailOccupation;           /**<Number of ids in tail. */
+    int repeatPeriod;       /**<Period being repeated, 0 when not repeating. */
+    int repeatMatched;      /**<Ids matched in the current repetition. */
+    unsigned int repeatCount; /**<Full repetitions matched so far. */
+
     inline void ResetRecordArray() { this->recordArrayOccupation = 0; }
     inline int IsRecordArrayEmpty() {
         return (this->recordArrayOccupation <= 0);
@@ -52,17 +71,55 @@ class DynamicTraceWriter {
     int CheckRecordArray();
     int AddDynamicRecord(DynamicTraceRecord record);
 
+    inline void PushRecentId(unsigned int id) {
+        this->recentIds[this->recentIdsCount & (2 * MAX_REPEAT_PERIOD - 1)] =
+            id;
+        ++this->recentIdsCount;
+    }
+    /** @brief Id [back] positions before the end of the expanded stream. */
+    inline unsigned int GetRecentId(int back) {
+        return this->recentIds[(this->recentIdsCount - back) &
+                               (2 * MAX_REPEAT_PERIOD - 1)];
+    }
+
+    int CommitBasicBlockId(unsigned int id);
+    int CommitTail(int count);
+    int CommitRepeat();
+    int AddToTail(unsigned int id);
+    int DetectRepeat();
+    /** @brief Leaves repeat mode, incomplete repetitions become plain ids. */
+    int EndRepeat();
+    /** @brief Writes every id held back by the repeat detection. */
+    int FlushPending();
+
   public:
-    inline DynamicTraceWriter() : file(0), recordArrayOccupation(0) {
+    inline DynamicTraceWriter()
+        : file(0),
+          container(0),
+          containerStream(-1),
+          recordArrayOccupation(0),
+          recentIdsCount(0),
+          tailOccupation(0),
+          repeatPeriod(0),
+          repeatMatched(0),
+          repeatCount(0) {
         this->header.SetHeaderType(FileTypeDynamicTrace);
     };
     inline ~DynamicTraceWriter() {
+        if (this->FlushPending()) {
+            SINUCA3_ERROR_PRINTF("Failed to flush pending basic blocks!\n");
+        }
         if (!this->IsRecordArrayEmpty()) {
             if (this->FlushRecordArray()) {
                 SINUCA3_ERROR_PRINTF("Failed to flush dynamic records!\n");
             }
         }
-        if (this->header.FlushHeader(this->file)) {
+        if (this->container) {
+            if (this->container->CloseStream(this->containerStream,
+                                             &this->header)) {
+                SINUCA3_ERROR_PRINTF("Failed to close dynamic stream!\n");
+            }
+        } else if (this->header.FlushHeader(this->file)) {
             SINUCA3_ERROR_PRINTF("Failed to write dynamic file header!\n");
         }
         if (file) {
@@ -72,6 +129,8 @@ class DynamicTraceWriter {
 
     /** @brief Create the [tid] dynamic file in the [sourceDir] directory. */
     int OpenFile(const char* sourceDir, const char* img, int tid);
+    /** @brief Write the [tid] dynamic trace to a stream of [container]. */
+    int OpenStream(ContainerTraceWriter* container, int tid);
     /**
      * @brief Add thread event record to the trace file.
      * @param type Event type
@@ -82,7 +141,7 @@ class DynamicTraceWriter {
     /** @brief Add the identifier of basic block executed. */
     int AddBasicBlockId(unsigned int basicBlockId);
 
-    inline void IncExecutedInstructions(int ins) {
+    inline void IncExecutedInstructions(unsigned long ins) {
         this->header.data.dynamicHeader.totalExecutedInstructions += ins;
     }
     inline void SetTargetArch(unsigned char target) {
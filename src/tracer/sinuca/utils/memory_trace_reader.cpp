@@ -50,6 +50,19 @@ int MemoryTraceReader::OpenFile(const char* sourceDir, const char* imageName,
     return 0;
 }
 
+int MemoryTraceReader::OpenStream(ContainerTraceReader* container, int tid) {
+    this->cursor.stream = container->FindStream(FileTypeMemoryTrace, tid);
+    if (this->cursor.stream == -1) {
+        SINUCA3_ERROR_PRINTF("Container has no memory trace of thread [%d]!\n",
+                             tid);
+        return 1;
+    }
+    this->container = container;
+    this->header = *container->GetStreamHeader(this->cursor.stream);
+
+    return 0;
+}
+
 int MemoryTraceReader::ReadMemoryOperations(InstructionPacket* inst) {
     if (this->reachedEnd) {
         SINUCA3_ERROR_PRINTF(
@@ -121,8 +134,13 @@ int MemoryTraceReader::LoadRecordArray() {
     this->recordArrayIndex = 0;
 
     unsigned long readBytes = 0;
-    readBytes =
-        fread(this->recordArray, 1, sizeof(this->recordArray), this->file);
+    if (this->container) {
+        readBytes = this->container->ReadStream(
+            &this->cursor, this->recordArray, sizeof(this->recordArray));
+    } else if (this->file) {
+        readBytes =
+            fread(this->recordArray, 1, sizeof(this->recordArray), this->file);
+    }
 
     this->numberOfRecordsRead = readBytes / sizeof(*this->recordArray);
 
@@ -26,12 +26,15 @@
 
 #include <engine/default_packets.hpp>
 #include <tracer/sinuca/file_handler.hpp>
+#include <tracer/sinuca/utils/container_trace_reader.hpp>
 #include <utils/logging.hpp>
 
 /** @brief Check memory_trace_reader.hpp documentation for details */
 class MemoryTraceReader {
   private:
     FILE* file;
+    ContainerTraceReader* container; /**<Set when reading from a container. */
+    ContainerStreamCursor cursor;
     FileHeader header;
     MemoryTraceRecord recordArray[RECORD_ARRAY_SIZE];
     int numberOfRecordsRead;
@@ -42,8 +45,11 @@ class MemoryTraceReader {
 
   public:
     inline MemoryTraceReader()
-        : file(0), numberOfRecordsRead(0), recordArrayIndex(0), reachedEnd(0) {
-          };
+        : file(0),
+          container(0),
+          numberOfRecordsRead(0),
+          recordArrayIndex(0),
+          reachedEnd(0) {};
     inline ~MemoryTraceReader() {
         if (file) {
             fclose(this->file);
@@ -56,6 +62,8 @@ class MemoryTraceReader {
     }
 
     int OpenFile(const char* sourceDir, const char* imgName, int tid);
+    /** @brief Read the [tid] memory trace from a stream of [container]. */
+    int OpenStream(ContainerTraceReader* container, int tid);
     int ReadMemoryOperations(InstructionPacket* inst);
 
     inline bool HasReachedEnd() { return this->reachedEnd; }
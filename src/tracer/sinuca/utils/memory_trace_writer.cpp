@@ -46,15 +46,30 @@ int MemoryTraceWriter::OpenFile(const char* sourceDir, const char* imageName,
     return 0;
 }
 
-int MemoryTraceWriter::FlushRecordArray() {
-    if (this->file == NULL) {
-        SINUCA3_ERROR_PRINTF("File pointer is nil in mem trace!\n");
+int MemoryTraceWriter::OpenStream(ContainerTraceWriter* container, int tid) {
+    this->containerStream = container->AddStream(tid);
+    if (this->containerStream == -1) {
+        SINUCA3_ERROR_PRINTF("Failed to add memory stream to container!\n");
         return 1;
     }
+    this->container = container;
 
+    return 0;
+}
+
+int MemoryTraceWriter::FlushRecordArray() {
     unsigned long occupationInBytes =
         this->recordArrayOccupation * sizeof(*this->recordArray);
 
+    if (this->container) {
+        return this->container->Write(this->containerStream, this->recordArray,
+                                      occupationInBytes);
+    }
+    if (this->file == NULL) {
+        SINUCA3_ERROR_PRINTF("File pointer is nil in mem trace!\n");
+        return 1;
+    }
+
     if (fwrite(this->recordArray, 1, occupationInBytes, this->file) !=
         occupationInBytes) {
         SINUCA3_ERROR_PRINTF("[1] Failed to flush memory records!\n");
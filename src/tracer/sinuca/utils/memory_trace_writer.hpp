@@ -34,10 +34,14 @@
 #include <cstdio>
 #include <tracer/sinuca/file_handler.hpp>
 
+#include "container_trace_writer.hpp"
+
 /** @brief Check memory_trace_writer.hpp documentation for details */
 class MemoryTraceWriter {
   private:
     FILE* file;
+    ContainerTraceWriter* container; /**<Set when writing to a container. */
+    int containerStream;
     FileHeader header;
     MemoryTraceRecord recordArray[RECORD_ARRAY_SIZE]; /**<Record buffer. */
     int recordArrayOccupation; /**<Number of records currently stored. */
@@ -55,7 +59,8 @@ class MemoryTraceWriter {
     int AddMemoryRecord(MemoryTraceRecord record);
 
   public:
-    inline MemoryTraceWriter() : file(0), recordArrayOccupation(0) {
+    inline MemoryTraceWriter()
+        : file(0), container(0), containerStream(-1), recordArrayOccupation(0) {
         this->header.SetHeaderType(FileTypeMemoryTrace);
     };
     inline ~MemoryTraceWriter() {
@@ -64,7 +69,12 @@ class MemoryTraceWriter {
                 SINUCA3_ERROR_PRINTF("Failed to flush memory records!\n");
             }
         }
-        if (this->header.FlushHeader(this->file)) {
+        if (this->container) {
+            if (this->container->CloseStream(this->containerStream,
+                                             &this->header)) {
+                SINUCA3_ERROR_PRINTF("Failed to close memory stream!\n");
+            }
+        } else if (this->header.FlushHeader(this->file)) {
             SINUCA3_ERROR_PRINTF("Failed to write memory file header!\n");
         }
         if (file) {
@@ -74,6 +84,8 @@ class MemoryTraceWriter {
 
     /** @brief Create the [tid] memory file in the [sourceDir] directory. */
     int OpenFile(const char* sourceDir, const char* imageName, int tid);
+    /** @brief Write the [tid] memory trace to a stream of [container]. */
+    int OpenStream(ContainerTraceWriter* container, int tid);
     /** @brief Add the number of memory operations. */
     int AddNumberOfMemOperations(unsigned int memoryOperations);
     /**
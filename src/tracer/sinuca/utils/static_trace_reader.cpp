@@ -58,6 +58,31 @@ int StaticTraceReader::OpenFile(const char *sourceDir, const char *imgName) {
     return 0;
 }
 
+int StaticTraceReader::OpenStream(ContainerTraceReader *container) {
+    ContainerStreamCursor cursor;
+
+    cursor.stream = container->FindStream(FileTypeStaticTrace, 0);
+    if (cursor.stream == -1) {
+        SINUCA3_ERROR_PRINTF("Container has no static trace!\n");
+        return 1;
+    }
+    this->header = *container->GetStreamHeader(cursor.stream);
+    this->mmapSize = container->GetStreamSize(cursor.stream);
+    this->mmapPtr = (char *)malloc(this->mmapSize);
+    if (this->mmapPtr == NULL) {
+        SINUCA3_ERROR_PRINTF("Failed to alloc static trace buffer!\n");
+        return 1;
+    }
+    this->ownsBuffer = true;
+    if (container->ReadStream(&cursor, this->mmapPtr, this->mmapSize) !=
+        this->mmapSize) {
+        SINUCA3_ERROR_PRINTF("Failed to read static trace stream!\n");
+        return 1;
+    }
+
+    return 0;
+}
+
 void *StaticTraceReader::ReadData(unsigned long len) {
     if (this->mmapOffset >= this->mmapSize) return NULL;
     void *ptr = (void *)(this->mmapPtr + this->mmapOffset);
@@ -66,7 +91,7 @@ void *StaticTraceReader::ReadData(unsigned long len) {
 }
 
 int StaticTraceReader::ReadStaticRecordFromFile() {
-    if (this->fileDescriptor == -1) return 1;
+    if (this->mmapPtr == NULL) return 1;
     void *readData = this->ReadData(sizeof(*this->record));
     if (readData == NULL) {
         SINUCA3_ERROR_PRINTF("Failed to read static trace record\n");
@@ -30,6 +30,7 @@
 
 #include <cstdlib>
 #include <tracer/sinuca/file_handler.hpp>
+#include <tracer/sinuca/utils/container_trace_reader.hpp>
 
 extern "C" {
 #include <sys/mman.h>
@@ -45,6 +46,7 @@ class StaticTraceReader {
     unsigned long mmapSize;
     int fileDescriptor;
     char *mmapPtr;
+    bool ownsBuffer; /**<mmapPtr was copied out of a container. */
 
     /**
      * @brief Returns pointer to generic data and updates mmapOffset value.
@@ -54,9 +56,15 @@ class StaticTraceReader {
 
   public:
     inline StaticTraceReader()
-        : mmapOffset(0), mmapSize(0), fileDescriptor(0), mmapPtr(0) {};
+        : mmapOffset(0),
+          mmapSize(0),
+          fileDescriptor(-1),
+          mmapPtr(0),
+          ownsBuffer(false) {};
     inline ~StaticTraceReader() {
-        if (this->mmapPtr) {
+        if (this->ownsBuffer) {
+            free(this->mmapPtr);
+        } else if (this->mmapPtr) {
             munmap(this->mmapPtr, this->mmapSize);
         }
         if (this->fileDescriptor != -1) {
@@ -68,6 +76,12 @@ class StaticTraceReader {
      * @return 1 on failure, 0 otherwise.
      */
     int OpenFile(const char *folderPath, const char *img);
+    /**
+     * @brief Read the static trace from [container]. The stream is copied to
+     * a contiguous buffer as its chunks are interleaved with other streams.
+     * @return 1 on failure, 0 otherwise.
+     */
+    int OpenStream(ContainerTraceReader *container);
     int ReadStaticRecordFromFile();
     void TranslateRawInstructionToSinucaInst(StaticInstructionInfo* instInfo);
 
@@ -77,6 +91,11 @@ class StaticTraceReader {
     inline int GetBasicBlockSize() {
         return this->record->data.basicBlockSize;
     }
+    /** @brief Instruction as stored in the trace, valid while the reader is
+     * open. */
+    inline const Instruction* GetRawInstruction() {
+        return &this->record->data.instruction;
+    }
     inline unsigned long GetTotalBasicBlocks() {
         return this->header.data.staticHeader.bblCount;
     }
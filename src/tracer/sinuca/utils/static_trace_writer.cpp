@@ -48,15 +48,30 @@ int StaticTraceWriter::OpenFile(const char* sourceDir, const char* imageName) {
     return 0;
 }
 
-int StaticTraceWriter::FlushBasicBlock() {
-    if (this->file == NULL) {
-        SINUCA3_ERROR_PRINTF("File pointer is nil in static trace obj!\n");
+int StaticTraceWriter::OpenStream(ContainerTraceWriter* container) {
+    this->containerStream = container->AddStream(0);
+    if (this->containerStream == -1) {
+        SINUCA3_ERROR_PRINTF("Failed to add static stream to container!\n");
         return 1;
     }
+    this->container = container;
 
+    return 0;
+}
+
+int StaticTraceWriter::FlushBasicBlock() {
     unsigned long occupationInBytes =
         this->basicBlockOccupation * sizeof(*basicBlock);
 
+    if (this->container) {
+        return this->container->Write(this->containerStream, this->basicBlock,
+                                      occupationInBytes);
+    }
+    if (this->file == NULL) {
+        SINUCA3_ERROR_PRINTF("File pointer is nil in static trace obj!\n");
+        return 1;
+    }
+
     if (fwrite(this->basicBlock, 1, occupationInBytes, file) !=
         occupationInBytes) {
         SINUCA3_ERROR_PRINTF("Failed to flush static records!\n");
@@ -36,10 +36,14 @@
 #include <cstdlib>
 #include <tracer/sinuca/file_handler.hpp>
 
+#include "container_trace_writer.hpp"
+
 /** @brief Check static_trace_writer.hpp documentation for details */
 class StaticTraceWriter {
   private:
     FILE* file;
+    ContainerTraceWriter* container; /**<Set when writing to a container. */
+    int containerStream;
     FileHeader header;
     StaticTraceRecord* basicBlock; /**<Current basic block. */
     int basicBlockArraySize;       /**<Current size of the buffer. */
@@ -66,14 +70,23 @@ class StaticTraceWriter {
 
   public:
     inline StaticTraceWriter()
-        : file(0), basicBlock(0), basicBlockArraySize(128) {
+        : file(0),
+          container(0),
+          containerStream(-1),
+          basicBlock(0),
+          basicBlockArraySize(128) {
         this->header.SetHeaderType(FileTypeStaticTrace);
         this->ResetBasicBlock();
         this->basicBlock = (StaticTraceRecord*)malloc(
             sizeof(StaticTraceRecord) * this->basicBlockArraySize);
     };
     inline ~StaticTraceWriter() {
-        if (this->header.FlushHeader(this->file)) {
+        if (this->container) {
+            if (this->container->CloseStream(this->containerStream,
+                                             &this->header)) {
+                SINUCA3_ERROR_PRINTF("Failed to close static stream!\n");
+            }
+        } else if (this->header.FlushHeader(this->file)) {
             SINUCA3_ERROR_PRINTF("Failed to write static header!\n")
         }
         if (!this->WasBasicBlockReset()) {
@@ -89,6 +102,8 @@ class StaticTraceWriter {
 
     /** @brief Create the static file in the [sourceDir] directory. */
     int OpenFile(const char* sourceDir, const char* imageName);
+    /** @brief Write the static trace to a stream of [container]. */
+    int OpenStream(ContainerTraceWriter* container);
     /** @brief Add a formated instruction to the current basic block. */
     int AddInstruction(const Instruction* inst);
     /** @brief Add the number of instructions of the current basic block. The
@@ -0,0 +1,365 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file trace_reader.cpp
+ * @brief Implementation of the synthetic trace reader.
+ */
+
+#include "trace_reader.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "utils/logging.hpp"
+
+/** @brief Address of the first synthetic instruction. */
+const unsigned long PROGRAM_BASE = 0x400000;
+/** @brief Every synthetic instruction has this size. */
+const unsigned long SYNTHETIC_INST_SIZE = 4;
+/** @brief Architectural registers used by synthetic instructions. */
+const unsigned short SYNTHETIC_REGISTERS = 16;
+/** @brief Size of every synthetic memory access. */
+const unsigned int ACCESS_SIZE = 8;
+/** @brief Largest accepted number of threads. */
+const unsigned long MAX_SYNTHETIC_THREADS = 1024;
+/** @brief Each thread accesses a region of this size. */
+const unsigned long REGION_SIZE = 1UL << 36;
+
+static int ParseDouble(const char* value, double* out) {
+    char* end;
+    *out = strtod(value, &end);
+    return (end == value || *end != '\0' || *out < 0.0 || *out > 1.0);
+}
+
+static int ParseUnsigned(const char* value, unsigned long* out) {
+    char* end;
+    *out = strtoul(value, &end, 0);
+    return (end == value || *end != '\0');
+}
+
+int SyntheticParameters::Parse(const char* spec) {
+    char buffer[1024];
+    if (strlen(spec) >= sizeof(buffer)) {
+        SINUCA3_ERROR_PRINTF("[synthetic] parameter list is too long\n");
+        return 1;
+    }
+    strcpy(buffer, spec);
+
+    char* pair = buffer;
+    while (*pair != '\0') {
+        char* next = strchr(pair, ',');
+        if (next != NULL) *next++ = '\0';
+        char* value = strchr(pair, '=');
+        if (value == NULL) {
+            SINUCA3_ERROR_PRINTF("[synthetic] expected key=value, got [%s]\n",
+                                 pair);
+            return 1;
+        }
+        *value++ = '\0';
+
+        unsigned long number = 0;
+        int failed = 0;
+        if (!strcmp(pair, "seed")) {
+            failed = ParseUnsigned(value, &this->seed);
+        } else if (!strcmp(pair, "threads")) {
+            failed = ParseUnsigned(value, &number) || number == 0 ||
+                     number > MAX_SYNTHETIC_THREADS;
+            this->threads = number;
+        } else if (!strcmp(pair, "instructions")) {
+            failed = ParseUnsigned(value, &this->instructions);
+        } else if (!strcmp(pair, "bbls")) {
+            failed = ParseUnsigned(value, &this->basicBlocks) ||
+                     this->basicBlocks == 0;
+        } else if (!strcmp(pair, "bblmin")) {
+            failed = ParseUnsigned(value, &number) || number == 0;
+            this->minBasicBlockSize = number;
+        } else if (!strcmp(pair, "bblmax")) {
+            failed = ParseUnsigned(value, &number) || number == 0;
+            this->maxBasicBlockSize = number;
+        } else if (!strcmp(pair, "branches")) {
+            failed = ParseDouble(value, &this->branchRatio);
+        } else if (!strcmp(pair, "taken")) {
+            failed = ParseDouble(value, &this->takenRate);
+        } else if (!strcmp(pair, "memops")) {
+            failed = ParseDouble(value, &this->memoryRatio);
+        } else if (!strcmp(pair, "loads")) {
+            failed = ParseDouble(value, &this->loadRatio);
+        } else if (!strcmp(pair, "stride")) {
+            failed = ParseUnsigned(value, &this->stride);
+        } else if (!strcmp(pair, "workingset")) {
+            failed = ParseUnsigned(value, &this->workingSet) ||
+                     this->workingSet < ACCESS_SIZE;
+        } else if (!strcmp(pair, "pattern")) {
+            if (!strcmp(value, "stride")) {
+                this->pattern = SyntheticPatternStride;
+            } else if (!strcmp(value, "random")) {
+                this->pattern = SyntheticPatternRandom;
+            } else if (!strcmp(value, "workingset")) {
+                this->pattern = SyntheticPatternWorkingSet;
+            } else {
+                failed = 1;
+            }
+        } else {
+            SINUCA3_ERROR_PRINTF("[synthetic] unknown parameter [%s]\n", pair);
+            return 1;
+        }
+        if (failed) {
+            SINUCA3_ERROR_PRINTF("[synthetic] invalid value [%s] for [%s]\n",
+                                 value, pair);
+            return 1;
+        }
+
+        if (next == NULL) break;
+        pair = next;
+    }
+
+    if (this->minBasicBlockSize > this->maxBasicBlockSize) {
+        SINUCA3_ERROR_PRINTF("[synthetic] bblmin is greater than bblmax\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+void SyntheticTraceReader::GenerateProgram() {
+    SyntheticRandom random;
+    random.Seed(this->parameters.seed);
+
+    unsigned long numberOfBasicBlocks = this->parameters.basicBlocks;
+    unsigned long sizeRange = this->parameters.maxBasicBlockSize -
+                              this->parameters.minBasicBlockSize + 1;
+
+    this->basicBlockStart = new unsigned long[numberOfBasicBlocks + 1];
+    this->branchTarget = new unsigned long[numberOfBasicBlocks];
+    this->basicBlockStart[0] = 0;
+    for (unsigned long bbl = 0; bbl < numberOfBasicBlocks; ++bbl) {
+        this->basicBlockStart[bbl + 1] =
+            this->basicBlockStart[bbl] + this->parameters.minBasicBlockSize +
+            random.Below(sizeRange);
+        this->branchTarget[bbl] = random.Below(numberOfBasicBlocks);
+    }
+
+    this->instructionPool =
+        new StaticInstructionInfo[this->basicBlockStart[numberOfBasicBlocks]];
+    for (unsigned long bbl = 0; bbl < numberOfBasicBlocks; ++bbl) {
+        unsigned long last = this->basicBlockStart[bbl + 1] - 1;
+        bool endsInBranch = random.Chance(this->parameters.branchRatio);
+        for (unsigned long i = this->basicBlockStart[bbl]; i <= last; ++i) {
+            StaticInstructionInfo* inst = &this->instructionPool[i];
+            inst->instAddress = PROGRAM_BASE + i * SYNTHETIC_INST_SIZE;
+            inst->instSize = SYNTHETIC_INST_SIZE;
+            inst->numberOfReadRegs = 2;
+            inst->readRegsArray[0] = random.Below(SYNTHETIC_REGISTERS);
+            inst->readRegsArray[1] = random.Below(SYNTHETIC_REGISTERS);
+
+            if (i == last && endsInBranch) {
+                inst->branchType = BranchCond;
+                strcpy(inst->instMnemonic, "jcc");
+                continue;
+            }
+            inst->numberOfWriteRegs = 1;
+            inst->writtenRegsArray[0] = random.Below(SYNTHETIC_REGISTERS);
+            if (random.Chance(this->parameters.memoryRatio)) {
+                if (random.Chance(this->parameters.loadRatio)) {
+                    inst->instReadsMemory = true;
+                    strcpy(inst->instMnemonic, "load");
+                } else {
+                    inst->instWritesMemory = true;
+                    strcpy(inst->instMnemonic, "store");
+                }
+            } else {
+                strcpy(inst->instMnemonic, "alu");
+            }
+        }
+    }
+}
+
+int SyntheticTraceReader::OpenTrace(const char* imageName, const char*) {
+    if (this->parameters.Parse(imageName)) return 1;
+
+    this->GenerateProgram();
+
+    this->threads = new SyntheticThread[this->parameters.threads];
+    for (int tid = 0; tid < this->parameters.threads; ++tid) {
+        SyntheticThread* thread = &this->threads[tid];
+        thread->random.Seed(this->parameters.seed + tid + 1);
+        thread->currentBasicBlock =
+            thread->random.Below(this->parameters.basicBlocks);
+        thread->currentInst = 0;
+        thread->fetchedInst = 0;
+        thread->nextAddress = 0;
+        thread->takenBranches = 0;
+        thread->memoryOperations = 0;
+    }
+
+    SINUCA3_WARNING_PRINTF("Synthetic trace:\n");
+    SINUCA3_WARNING_PRINTF("\t %d threads of %lu instructions, seed %lu\n",
+                           this->parameters.threads,
+                           this->parameters.instructions,
+                           this->parameters.seed);
+
+    return 0;
+}
+
+unsigned long SyntheticTraceReader::NextAddress(SyntheticThread* thread,
+                                                int tid) {
+    /* Threads get disjoint regions, so the patterns do not overlap. */
+    unsigned long base = (unsigned long)(tid + 1) * REGION_SIZE;
+
+    ++thread->memoryOperations;
+    if (this->parameters.pattern == SyntheticPatternRandom) {
+        return base + (thread->random.Next() & (REGION_SIZE - ACCESS_SIZE));
+    }
+    if (this->parameters.pattern == SyntheticPatternWorkingSet) {
+        unsigned long offset =
+            thread->random.Below(this->parameters.workingSet / ACCESS_SIZE);
+        return base + ((offset * ACCESS_SIZE) & (REGION_SIZE - 1));
+    }
+
+    unsigned long address = base + thread->nextAddress;
+    thread->nextAddress =
+        (thread->nextAddress + this->parameters.stride) & (REGION_SIZE - 1);
+    return address;
+}
+
+FetchResult SyntheticTraceReader::Fetch(InstructionPacket* ret, int tid) {
+    if (tid < 0 || tid >= this->parameters.threads) {
+        SINUCA3_ERROR_PRINTF("[synthetic] there is no thread [%d]\n", tid);
+        return FetchResultError;
+    }
+
+    SyntheticThread* thread = &this->threads[tid];
+    if (thread->fetchedInst >= this->parameters.instructions) {
+        return FetchResultEnd;
+    }
+
+    unsigned long bbl = thread->currentBasicBlock;
+    const StaticInstructionInfo* inst =
+        &this->instructionPool[this->basicBlockStart[bbl] +
+                               thread->currentInst];
+
+    ret->staticInfo = inst;
+    ret->dynamicInfo.numReadings = 0;
+    ret->dynamicInfo.numWritings = 0;
+    if (inst->instReadsMemory) {
+        ret->dynamicInfo.readsAddr[0] = this->NextAddress(thread, tid);
+        ret->dynamicInfo.readsSize[0] = ACCESS_SIZE;
+        ret->dynamicInfo.numReadings = 1;
+    } else if (inst->instWritesMemory) {
+        ret->dynamicInfo.writesAddr[0] = this->NextAddress(thread, tid);
+        ret->dynamicInfo.writesSize[0] = ACCESS_SIZE;
+        ret->dynamicInfo.numWritings = 1;
+    }
+
+    ++thread->currentInst;
+    if (this->basicBlockStart[bbl] + thread->currentInst ==
+        this->basicBlockStart[bbl + 1]) {
+        thread->currentInst = 0;
+        if (inst->branchType == BranchCond &&
+            thread->random.Chance(this->parameters.takenRate)) {
+            thread->currentBasicBlock = this->branchTarget[bbl];
+            ++thread->takenBranches;
+        } else {
+            thread->currentBasicBlock =
+                (bbl + 1) % this->parameters.basicBlocks;
+        }
+    }
+    ++thread->fetchedInst;
+
+    return FetchResultOk;
+}
+
+void SyntheticTraceReader::PrintStatistics() {
+    for (int tid = 0; tid < this->parameters.threads; ++tid) {
+        SINUCA3_LOG_PRINTF(
+            "synthetic: thread %d fetched %lu instructions, %lu taken "
+            "branches, %lu memory operations\n",
+            tid, this->threads[tid].fetchedInst,
+            this->threads[tid].takenBranches,
+            this->threads[tid].memoryOperations);
+    }
+}
+
+#ifndef NDEBUG
+int TestSyntheticTraceReader() {
+    const char* spec =
+        "seed=7,threads=2,instructions=100000,bbls=64,bblmin=2,bblmax=6,"
+        "branches=0.5,taken=0.5,memops=0.5,loads=0.5,pattern=workingset,"
+        "workingset=4096";
+    SyntheticTraceReader first;
+    SyntheticTraceReader second;
+    if (first.OpenTrace(spec, NULL) || second.OpenTrace(spec, NULL)) return 1;
+
+    InstructionPacket a;
+    InstructionPacket b;
+    unsigned long memoryOperations = 0;
+    for (unsigned long i = 0; i < 100000; ++i) {
+        /* Interleaving threads differently must not change a stream. */
+        if (first.Fetch(&a, 1) != FetchResultOk) return 2;
+        if (first.Fetch(&a, 0) != FetchResultOk) return 2;
+        if (second.Fetch(&b, 0) != FetchResultOk) return 2;
+        if (a.staticInfo->instAddress != b.staticInfo->instAddress) return 3;
+        if (a.dynamicInfo.numReadings != b.dynamicInfo.numReadings ||
+            a.dynamicInfo.numWritings != b.dynamicInfo.numWritings) {
+            return 4;
+        }
+        if (a.dynamicInfo.numReadings) {
+            if (a.dynamicInfo.readsAddr[0] != b.dynamicInfo.readsAddr[0]) {
+                return 5;
+            }
+            if ((a.dynamicInfo.readsAddr[0] & 0xfffffffffUL) >= 4096) return 6;
+        }
+        if (a.dynamicInfo.numWritings &&
+            a.dynamicInfo.writesAddr[0] != b.dynamicInfo.writesAddr[0]) {
+            return 5;
+        }
+        memoryOperations +=
+            a.dynamicInfo.numReadings + a.dynamicInfo.numWritings;
+    }
+    if (first.Fetch(&a, 0) != FetchResultEnd) return 7;
+    if (first.GetNumberOfFetchedInst(0) != 100000) return 8;
+    if (first.Fetch(&a, 2) != FetchResultError) return 9;
+    /* About half of the non-branch instructions access memory. */
+    if (memoryOperations < 30000 || memoryOperations > 60000) return 10;
+
+    SyntheticTraceReader invalid;
+    if (!invalid.OpenTrace("threads=0", NULL)) return 11;
+
+    /* A stride of 1 TiB wraps inside the region of the thread. */
+    SyntheticTraceReader strided;
+    if (strided.OpenTrace("threads=2,instructions=1000,memops=1,"
+                          "stride=1099511627776",
+                          NULL)) {
+        return 12;
+    }
+    for (unsigned long i = 0; i < 1000; ++i) {
+        for (int tid = 0; tid < 2; ++tid) {
+            if (strided.Fetch(&a, tid) != FetchResultOk) return 13;
+            unsigned long address = a.dynamicInfo.numReadings
+                                        ? a.dynamicInfo.readsAddr[0]
+                                        : a.dynamicInfo.writesAddr[0];
+            if (a.dynamicInfo.numReadings + a.dynamicInfo.numWritings &&
+                address / REGION_SIZE != (unsigned long)tid + 1) {
+                return 14;
+            }
+        }
+    }
+
+    return 0;
+}
+#endif
@@ -0,0 +1,176 @@
+#ifndef SINUCA3_SYNTHETIC_TRACER_TRACE_READER_HPP_
+#define SINUCA3_SYNTHETIC_TRACER_TRACE_READER_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file trace_reader.hpp
+ * @brief Trace reader that generates instructions in memory.
+ * @details The synthetic trace reader needs no files: it builds a random static
+ * program and walks it, drawing branch outcomes and memory addresses from a
+ * seeded generator. It is meant for measuring the throughput of the engine and
+ * of components without disk I/O and for reproducible performance tests.
+ * Each thread has its own generator, so the stream of a thread does not depend
+ * on how fetches of different threads interleave.
+ *
+ * The "image name" passed to OpenTrace is a list of key=value pairs separated
+ * by commas, e.g. "threads=2,instructions=1000000,pattern=random". The trace
+ * directory is ignored. Keys:
+ * - seed: generator seed (1).
+ * - threads: number of threads, at most 1024 (1).
+ * - instructions: instructions per thread (1000000).
+ * - bbls: number of static basic blocks (1024).
+ * - bblmin, bblmax: basic block sizes are uniform in [bblmin, bblmax] (4, 12).
+ * - branches: fraction of basic blocks ending in a conditional branch, the
+ *   others fall through (0.5).
+ * - taken: probability of a conditional branch being taken (0.6).
+ * - memops: fraction of instructions accessing memory (0.3).
+ * - loads: fraction of memory instructions that are loads (0.7).
+ * - pattern: stride, random or workingset (stride).
+ * - stride: bytes between consecutive accesses of the stride pattern (64).
+ * - workingset: bytes covered by the workingset pattern (1048576).
+ *
+ * Each thread accesses its own 64 GiB region, the patterns wrap around it.
+ */
+
+#include <engine/default_packets.hpp>
+#include <tracer/trace_reader.hpp>
+
+enum SyntheticAddressPattern {
+    SyntheticPatternStride,
+    SyntheticPatternRandom,
+    SyntheticPatternWorkingSet
+};
+
+struct SyntheticParameters {
+    unsigned long seed;
+    unsigned long instructions;
+    unsigned long basicBlocks;
+    unsigned long stride;
+    unsigned long workingSet;
+    double branchRatio;
+    double takenRate;
+    double memoryRatio;
+    double loadRatio;
+    int threads;
+    int minBasicBlockSize;
+    int maxBasicBlockSize;
+    SyntheticAddressPattern pattern;
+
+    inline SyntheticParameters()
+        : seed(1),
+          instructions(1000000),
+          basicBlocks(1024),
+          stride(64),
+          workingSet(1 << 20),
+          branchRatio(0.5),
+          takenRate(0.6),
+          memoryRatio(0.3),
+          loadRatio(0.7),
+          threads(1),
+          minBasicBlockSize(4),
+          maxBasicBlockSize(12),
+          pattern(SyntheticPatternStride) {}
+
+    /** @brief Parse a "key=value,..." list. @return 1 on failure. */
+    int Parse(const char* spec);
+};
+
+/** @brief xorshift64* generator. */
+class SyntheticRandom {
+  private:
+    unsigned long state;
+
+  public:
+    inline void Seed(unsigned long seed) {
+        /* splitmix64 step, so close seeds give unrelated states. */
+        seed += 0x9e3779b97f4a7c15UL;
+        seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9UL;
+        seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebUL;
+        this->state = (seed ^ (seed >> 31)) | 1;
+    }
+    inline unsigned long Next() {
+        this->state ^= this->state >> 12;
+        this->state ^= this->state << 25;
+        this->state ^= this->state >> 27;
+        return this->state * 0x2545f4914f6cdd1dUL;
+    }
+    /** @brief True with probability [p]. */
+    inline bool Chance(double p) {
+        return (this->Next() >> 11) * (1.0 / 9007199254740992.0) < p;
+    }
+    /** @brief Uniform in [0, bound). */
+    inline unsigned long Below(unsigned long bound) {
+        return this->Next() % bound;
+    }
+};
+
+struct SyntheticThread {
+    SyntheticRandom random;
+    unsigned long currentBasicBlock;
+    unsigned long fetchedInst;
+    unsigned long nextAddress; /**<Next address of the stride pattern. */
+    unsigned long takenBranches;
+    unsigned long memoryOperations;
+    int currentInst;
+};
+
+/** @brief Check trace_reader.hpp documentation for details */
+class SyntheticTraceReader : public TraceReader {
+  private:
+    SyntheticParameters parameters;
+    StaticInstructionInfo* instructionPool;
+    unsigned long* basicBlockStart; /**<First instruction of each bbl. */
+    unsigned long* branchTarget;    /**<Taken target of each bbl. */
+    SyntheticThread* threads;
+
+    void GenerateProgram();
+    unsigned long NextAddress(SyntheticThread* thread, int tid);
+
+  public:
+    inline SyntheticTraceReader()
+        : instructionPool(0), basicBlockStart(0), branchTarget(0), threads(0) {}
+    virtual inline ~SyntheticTraceReader() {
+        delete[] this->instructionPool;
+        delete[] this->basicBlockStart;
+        delete[] this->branchTarget;
+        delete[] this->threads;
+    }
+
+    virtual FetchResult Fetch(InstructionPacket* ret, int tid);
+    virtual int OpenTrace(const char* imageName, const char* sourceDir);
+    virtual void PrintStatistics();
+
+    virtual unsigned long GetNumberOfFetchedInst(int tid) {
+        return this->threads[tid].fetchedInst;
+    }
+    virtual unsigned long GetTotalInstToBeFetched(int) {
+        return this->parameters.instructions;
+    }
+
+    virtual inline int GetTotalThreads() { return this->parameters.threads; }
+    virtual inline int GetTotalBasicBlocks() {
+        return this->parameters.basicBlocks;
+    }
+};
+
+#ifndef NDEBUG
+int TestSyntheticTraceReader();
+#endif
+
+#endif  // SINUCA3_SYNTHETIC_TRACER_TRACE_READER_HPP_
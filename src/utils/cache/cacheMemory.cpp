@@ -0,0 +1,130 @@
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file cacheMemory.cpp
+ * @brief Tests of the templated cache memory, which is header only.
+ */
+
+#include "cacheMemory.hpp"
+
+#ifndef NDEBUG
+
+/** @brief Set associative cache with true LRU, the reference for the test. */
+struct ReferenceCache {
+    static const int SETS = 64;
+    static const int WAYS = 8;
+    unsigned long tags[SETS][WAYS];
+    unsigned long lastUse[SETS][WAYS];
+    bool valid[SETS][WAYS];
+    unsigned long now;
+
+    ReferenceCache() : now(0) { memset(this->valid, 0, sizeof(this->valid)); }
+
+    bool Read(unsigned long set, unsigned long tag) {
+        ++this->now;
+        for (int way = 0; way < WAYS; ++way) {
+            if (this->valid[set][way] && this->tags[set][way] == tag) {
+                this->lastUse[set][way] = this->now;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Write(unsigned long set, unsigned long tag) {
+        ++this->now;
+        int victim = 0;
+        for (int way = 0; way < WAYS; ++way) {
+            if (!this->valid[set][way]) {
+                victim = way;
+                break;
+            }
+            if (this->lastUse[set][way] < this->lastUse[set][victim]) {
+                victim = way;
+            }
+        }
+        this->valid[set][victim] = true;
+        this->tags[set][victim] = tag;
+        this->lastUse[set][victim] = this->now;
+    }
+};
+
+/**
+ * @brief Runs the same accesses on a cache of [numSets] x 8 ways, 64 B lines,
+ * and on the reference. 64 sets has a FixedCacheMemory specialization, 16
+ * sets goes to the dynamic one.
+ */
+static int CompareWithReference(int numSets) {
+    CacheMemory<unsigned long>* cache = CacheMemory<unsigned long>::fromNumSets(
+        numSets, 64, ReferenceCache::WAYS, "lru");
+    if (cache == NULL) return 1;
+    ReferenceCache reference;
+
+    /* Address pool slightly larger than the cache, so both hits and
+     * evictions happen often. */
+    unsigned long state = 12345;
+    for (int i = 0; i < 200000; ++i) {
+        state = state * 6364136223846793005UL + 1442695040888963407UL;
+        unsigned long line =
+            (state >> 33) % (numSets * ReferenceCache::WAYS * 3 / 2);
+        unsigned long addr = (line << 6) | ((state >> 20) & 63);
+        unsigned long set = cache->GetIndex(addr);
+        unsigned long tag = cache->GetTag(addr);
+
+        const unsigned long* value = cache->Read(addr);
+        bool hit = reference.Read(set, tag);
+        if ((value != NULL) != hit) return 2;
+        if (value != NULL && *value != line) return 3;
+        if (!hit) {
+            cache->Write(addr, &line);
+            reference.Write(set, tag);
+        }
+    }
+    if (cache->getStatValidProp() != 1.0f) return 4;
+
+    /* Peek and Invalidate take the same lookup path as Read. */
+    unsigned long numLines = numSets * ReferenceCache::WAYS * 3 / 2;
+    int numPresent = 0;
+    for (unsigned long line = 0; line < numLines; ++line) {
+        unsigned long addr = line << 6;
+        unsigned long* value = cache->Peek(addr);
+        unsigned long old = 0;
+        if (value != NULL && *value != line) return 5;
+        if (cache->Invalidate(addr, &old) != (value != NULL)) return 6;
+        if (value != NULL && old != line) return 7;
+        if (cache->Peek(addr) != NULL) return 8;
+        numPresent += (value != NULL);
+    }
+    if (numPresent != numSets * ReferenceCache::WAYS) return 9;
+    delete cache;
+
+    return 0;
+}
+
+int TestCacheMemory() {
+    int ret = CompareWithReference(16);
+    if (ret) return ret;
+    ret = CompareWithReference(ReferenceCache::SETS);
+    if (ret) return 10 + ret;
+
+    if (CacheMemory<int>::fromNumSets(4, 64, 65, "lru") != NULL) return 20;
+
+    return 0;
+}
+
+#endif
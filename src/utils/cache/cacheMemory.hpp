@@ -23,16 +23,25 @@
  * @brief Templated n-way cache memory.
  **/
 
+#include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstring>
 #include <sinuca3.hpp>
 #include <utils/logging.hpp>
 
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
 #include "replacement_policy.hpp"
 #include "utils/cache/replacement_policies/lru.hpp"
+#include "utils/cache/replacement_policies/lruMatrix.hpp"
+#include "utils/cache/replacement_policies/lruPacked.hpp"
 #include "utils/cache/replacement_policies/random.hpp"
 #include "utils/cache/replacement_policies/roundRobin.hpp"
+#include "utils/cache/replacement_policies/rrip.hpp"
+#include "utils/cache/replacement_policies/treePlru.hpp"
 
 /**
  * @brief Number of bits in a address.
@@ -43,22 +52,32 @@
  */
 static const int addrSizeBits = 64;
 
+/** @brief Max associativity, as each set keeps its valid bits in a word. */
+static const int maxNumWays = 64;
+
+/**
+ * @brief Ways of a set are stored padded to a multiple of this, so the tag
+ * comparison can always load whole vectors.
+ */
+static const int wayPadding = 4;
+
+/**
+ * @brief Handle to an entry, passed to the replacement policies. The cache
+ * itself does not store CacheLines, it is built when needed.
+ */
 struct CacheLine {
     unsigned long tag;
     unsigned long index;
     bool isValid;
 
-    // This is the position of this entry in the entries matrix.
-    // It can be useful for organizing other matrices.
+    // This is the position of this entry in the cache, i.e. the set and the
+    // way. It can be useful for organizing other matrices.
     int i, j;
 
     CacheLine() {};
 
     inline CacheLine(int i, int j, unsigned long tag, unsigned long index)
-        : tag(tag), index(index), isValid(false), i(i), j(j) {};
-
-    inline CacheLine(CacheLine* entry, unsigned long tag, unsigned long index)
-        : tag(tag), index(index), isValid(true), i(entry->i), j(entry->j) {};
+        : tag(tag), index(index), isValid(true), i(i), j(j) {};
 };
 
 /**
@@ -76,6 +95,11 @@ struct CacheLine {
  * the same set (a collision), a replacement policy is used to decide which
  * entry to evict.
  *
+ * Storage is a structure of arrays: each set has a contiguous array of tags, a
+ * bitmask of valid ways and the values live in a separate array. A lookup
+ * compares the tag against all ways of a set at once with AVX2 or SSE4.1 when
+ * available and takes the way from the resulting mask.
+ *
  * It is templated on the type of value stored (ValueType) and supports
  * operations such as:
  *   - Read: Lookup for a entry using a address.
@@ -195,7 +219,7 @@ class CacheMemory {
      * @return Pointer to the cached value if found (HIT), or `NULL` if not
      * found (MISS).
      */
-    const ValueType* Read(unsigned long addr);
+    virtual const ValueType* Read(unsigned long addr);
 
     /**
      * @brief Writes a value into the cache for the specified memory address.
@@ -210,8 +234,34 @@ class CacheMemory {
      * @tparam ValueType Type of the values stored in the cache.
      * @param addr Memory address to write to.
      * @param[in] result Pointer to the value to be written into the cache.
+     * @param[out] evicted If not NULL, receives the value of the entry
+     * replaced, if any.
+     * @return True if a valid entry was replaced.
      */
-    void Write(unsigned long addr, const ValueType* data);
+    virtual bool Write(unsigned long addr, const ValueType* data,
+                       ValueType* evicted = NULL);
+
+    /**
+     * @brief Same as Read, but the value can be updated in place, e.g. to mark
+     * a line dirty.
+     */
+    inline ValueType* ReadForUpdate(unsigned long addr) {
+        return const_cast<ValueType*>(this->Read(addr));
+    }
+
+    /**
+     * @brief Looks up [addr] without counting an access or updating the
+     * replacement policy.
+     * @return Pointer to the value, or NULL if not present.
+     */
+    virtual ValueType* Peek(unsigned long addr);
+
+    /**
+     * @brief Removes the entry of [addr], if present.
+     * @param[out] data If not NULL, receives the removed value.
+     * @return True if the entry was present.
+     */
+    virtual bool Invalidate(unsigned long addr, ValueType* data);
 
     unsigned long GetOffset(unsigned long addr) const;
     unsigned long GetIndex(unsigned long addr) const;
@@ -220,18 +270,18 @@ class CacheMemory {
     /**
      * @brief Find the entry for a addr.
      * @param addr Address to look for.
-     * @param result Pointer to store search result.
+     * @param resultWay Pointer to store the way found.
      * @return True if found, false otherwise.
      */
-    bool GetEntry(unsigned long addr, CacheLine** result) const;
+    bool GetEntry(unsigned long addr, int* resultWay) const;
 
     /**
      * @brief Can be used to find a entry that is not valid.
      * @param addr Address to look for.
-     * @param result Pointer to store result.
+     * @param resultWay Pointer to store the way found.
      * @return True if victim is found, false otherwise.
      */
-    bool FindEmptyEntry(unsigned long addr, CacheLine** result) const;
+    bool FindEmptyEntry(unsigned long addr, int* resultWay) const;
 
     void resetStatistics();
     unsigned long getStatMiss() const;
@@ -251,11 +301,14 @@ class CacheMemory {
     unsigned long indexMask;
     unsigned long tagMask;
 
-    CacheLine** entries;  // matrix [sets x ways]
+    int wayStride;  // numWays rounded up to wayPadding.
+    unsigned long allWaysMask;
 
-    ValueType** data;  // matrix [sets x ways]
+    unsigned long* tags;        // [sets x wayStride]
+    unsigned long* validMasks;  // [sets], bit j set if way j is valid.
+    ValueType* data;            // [sets x wayStride]
 
-    ReplacementPolicy* policy;
+    ReplacementPolicy* policy; /**< NULL in a FixedCacheMemory. */
 
     // Statistics
     unsigned long statMiss;
@@ -264,14 +317,76 @@ class CacheMemory {
     unsigned long statEvaction;
 
     inline CacheMemory()
-        : statMiss(0), statHit(0), statAcess(0), statEvaction(0) {};
+        : tags(0),
+          validMasks(0),
+          data(0),
+          policy(0),
+          statMiss(0),
+          statHit(0),
+          statAcess(0),
+          statEvaction(0) {};
+
+    /** @brief Bitmask of the ways of [set] whose tag is [tag]. */
+    inline unsigned long MatchTag(unsigned long set, unsigned long tag) const;
 
     static CacheMemory* Alocate(unsigned int numIndexBits,
                                 unsigned int numOffsetBits,
                                 unsigned int associativity, const char* policy);
     int SetReplacementPolicy(const char* policyName);
+    void SetGeometry(unsigned int numIndexBits, unsigned int numOffsetBits,
+                     unsigned int associativity);
+    void AllocateStorage();
 };
 
+/**
+ * @brief Returns a FixedCacheMemory when the geometry and policy have a
+ * pre-instantiated specialization, NULL otherwise. Defined in
+ * fixedCacheMemory.hpp.
+ */
+template <typename ValueType>
+CacheMemory<ValueType>* CreateFixedCacheMemory(unsigned int numIndexBits,
+                                               unsigned int numOffsetBits,
+                                               unsigned int associativity,
+                                               const char* policy);
+
+/**
+ * @brief Bitmask of the ways in [setTags] equal to [tag]. [wayStride] must be
+ * a multiple of wayPadding, ways past [numWays] may match and must be masked
+ * by the caller.
+ */
+static inline unsigned long MatchTagInSet(const unsigned long* setTags,
+                                          int wayStride, int numWays,
+                                          unsigned long tag) {
+    unsigned long matches = 0;
+
+#if defined(__AVX2__)
+    (void)numWays;
+    __m256i key = _mm256_set1_epi64x(tag);
+    for (int way = 0; way < wayStride; way += 4) {
+        __m256i ways = _mm256_loadu_si256((const __m256i*)&setTags[way]);
+        __m256i eq = _mm256_cmpeq_epi64(ways, key);
+        unsigned long bits = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+        matches |= bits << way;
+    }
+#elif defined(__SSE4_1__)
+    (void)numWays;
+    __m128i key = _mm_set1_epi64x(tag);
+    for (int way = 0; way < wayStride; way += 2) {
+        __m128i ways = _mm_loadu_si128((const __m128i*)&setTags[way]);
+        __m128i eq = _mm_cmpeq_epi64(ways, key);
+        unsigned long bits = _mm_movemask_pd(_mm_castsi128_pd(eq));
+        matches |= bits << way;
+    }
+#else
+    (void)wayStride;
+    for (int way = 0; way < numWays; ++way) {
+        matches |= (unsigned long)(setTags[way] == tag) << way;
+    }
+#endif
+
+    return matches;
+}
+
 // ===================================================================================
 //  Implementation
 // ===================================================================================
@@ -335,21 +450,19 @@ CacheMemory<ValueType>* CacheMemory<ValueType>::Alocate(
             "CacheMemory: associativity cannot be equal to 0.\n");
         return NULL;
     }
+    if (associativity > (unsigned int)maxNumWays) {
+        SINUCA3_ERROR_PRINTF(
+            "CacheMemory: associativity cannot be greater than %d.\n",
+            maxNumWays);
+        return NULL;
+    }
 
-    unsigned int numSets = 1u << numIndexBits;
-
-    CacheMemory<ValueType>* cm = new CacheMemory<ValueType>();
-    cm->numWays = associativity;
-    cm->numSets = numSets;
-
-    cm->offsetBits = numOffsetBits;
-    cm->indexBits = numIndexBits;
-    cm->tagBits = addrSizeBits - (cm->indexBits + cm->offsetBits);
+    CacheMemory<ValueType>* cm = CreateFixedCacheMemory<ValueType>(
+        numIndexBits, numOffsetBits, associativity, policy);
+    if (cm != NULL) return cm;
 
-    cm->offsetMask = (1UL << cm->offsetBits) - 1;
-    cm->indexMask = ((1UL << cm->indexBits) - 1) << cm->offsetBits;
-    cm->tagMask = ((1UL << cm->tagBits) - 1)
-                  << (cm->offsetBits + cm->indexBits);
+    cm = new CacheMemory<ValueType>();
+    cm->SetGeometry(numIndexBits, numOffsetBits, associativity);
 
     if (cm->SetReplacementPolicy(policy)) {
         delete cm;
@@ -357,56 +470,62 @@ CacheMemory<ValueType>* CacheMemory<ValueType>::Alocate(
         return NULL;
     }
 
-    size_t n = cm->numSets * cm->numWays;
-    cm->entries = new CacheLine*[cm->numSets];
-    cm->entries[0] = new CacheLine[n];
-    memset(cm->entries[0], 0, n * sizeof(CacheLine));
-    for (int i = 1; i < cm->numSets; ++i) {
-        cm->entries[i] = cm->entries[0] + (i * cm->numWays);
-    }
-
-    for (int i = 0; i < cm->numSets; ++i) {
-        for (int j = 0; j < cm->numWays; ++j) {
-            cm->entries[i][j].i = i;
-            cm->entries[i][j].j = j;
-        }
-    }
-
-    cm->data = new ValueType*[cm->numSets];
-    cm->data[0] = new ValueType[n];
-    memset(cm->data[0], 0, n * sizeof(ValueType));
-    for (int i = 1; i < cm->numSets; ++i) {
-        cm->data[i] = cm->data[0] + (i * cm->numWays);
-    }
+    cm->AllocateStorage();
 
     return cm;
 }
 
 template <typename ValueType>
-CacheMemory<ValueType>::~CacheMemory() {
-    if (this->entries) {
-        delete[] this->entries[0];
-        delete[] this->entries;
-    }
+void CacheMemory<ValueType>::SetGeometry(unsigned int numIndexBits,
+                                         unsigned int numOffsetBits,
+                                         unsigned int associativity) {
+    this->numWays = associativity;
+    this->numSets = 1u << numIndexBits;
+
+    this->offsetBits = numOffsetBits;
+    this->indexBits = numIndexBits;
+    this->tagBits = addrSizeBits - (this->indexBits + this->offsetBits);
+
+    this->offsetMask = (1UL << this->offsetBits) - 1;
+    this->indexMask = ((1UL << this->indexBits) - 1) << this->offsetBits;
+    this->tagMask = ((1UL << this->tagBits) - 1)
+                    << (this->offsetBits + this->indexBits);
+
+    this->wayStride = (this->numWays + wayPadding - 1) & ~(wayPadding - 1);
+    this->allWaysMask = (this->numWays == maxNumWays)
+                            ? ~0UL
+                            : (1UL << this->numWays) - 1;
+}
 
-    if (this->data) {
-        delete[] this->data[0];
-        delete[] this->data;
-    }
+template <typename ValueType>
+void CacheMemory<ValueType>::AllocateStorage() {
+    size_t n = (size_t)this->numSets * this->wayStride;
+    this->tags = new unsigned long[n]();
+    this->validMasks = new unsigned long[this->numSets]();
+    this->data = new ValueType[n]();
+}
 
+template <typename ValueType>
+CacheMemory<ValueType>::~CacheMemory() {
+    delete[] this->tags;
+    delete[] this->validMasks;
+    delete[] this->data;
     delete this->policy;
 }
 
 template <typename ValueType>
 const ValueType* CacheMemory<ValueType>::Read(unsigned long addr) {
     bool exist;
-    CacheLine* line;
+    int way;
     const ValueType* result = NULL;
 
-    exist = this->GetEntry(addr, &line);
+    assert(this->policy != NULL);
+    exist = this->GetEntry(addr, &way);
     if (exist) {
-        this->policy->Acess(line);
-        result = static_cast<const ValueType*>(&this->data[line->i][line->j]);
+        unsigned long index = this->GetIndex(addr);
+        CacheLine line(index, way, this->GetTag(addr), index);
+        this->policy->Acess(&line);
+        result = &this->data[index * this->wayStride + way];
     }
 
     this->statAcess += 1;
@@ -419,24 +538,48 @@ const ValueType* CacheMemory<ValueType>::Read(unsigned long addr) {
 }
 
 template <typename ValueType>
-void CacheMemory<ValueType>::Write(unsigned long addr, const ValueType* data) {
-    CacheLine* victim = NULL;
+bool CacheMemory<ValueType>::Write(unsigned long addr, const ValueType* data,
+                                   ValueType* evicted) {
     unsigned long tag = GetTag(addr);
     unsigned long index = GetIndex(addr);
+    int set = index;
+    int way;
+    bool replaced = false;
 
-    if (!FindEmptyEntry(addr, &victim)) {
-        int set, way;
+    assert(this->policy != NULL);
+    if (!FindEmptyEntry(addr, &way)) {
         this->policy->SelectVictim(tag, index, &set, &way);
-        victim = &this->entries[set][way];
+        replaced = true;
+        if (evicted != NULL) *evicted = this->data[set * this->wayStride + way];
     }
 
-    *victim = CacheLine(victim, tag, index);
-    this->policy->Acess(victim);
+    this->tags[set * this->wayStride + way] = tag;
+    this->validMasks[set] |= 1UL << way;
+    CacheLine victim(set, way, tag, index);
+    this->policy->Insert(&victim);
 
-    this->data[victim->i][victim->j] = *data;
+    this->data[set * this->wayStride + way] = *data;
 
     this->statEvaction += 1;
-    return;
+    return replaced;
+}
+
+template <typename ValueType>
+ValueType* CacheMemory<ValueType>::Peek(unsigned long addr) {
+    int way;
+    if (!this->GetEntry(addr, &way)) return NULL;
+    return &this->data[this->GetIndex(addr) * this->wayStride + way];
+}
+
+template <typename ValueType>
+bool CacheMemory<ValueType>::Invalidate(unsigned long addr, ValueType* data) {
+    int way;
+    if (!this->GetEntry(addr, &way)) return false;
+
+    unsigned long set = this->GetIndex(addr);
+    if (data != NULL) *data = this->data[set * this->wayStride + way];
+    this->validMasks[set] &= ~(1UL << way);
+    return true;
 }
 
 template <typename ValueType>
@@ -454,45 +597,70 @@ unsigned long CacheMemory<ValueType>::GetTag(unsigned long addr) const {
     return (addr & this->tagMask) >> (this->offsetBits + this->indexBits);
 }
 
+template <typename ValueType>
+inline unsigned long CacheMemory<ValueType>::MatchTag(unsigned long set,
+                                                      unsigned long tag) const {
+    const unsigned long* setTags = &this->tags[set * this->wayStride];
+    return MatchTagInSet(setTags, this->wayStride, this->numWays, tag) &
+           this->validMasks[set];
+}
+
 template <typename ValueType>
 bool CacheMemory<ValueType>::GetEntry(unsigned long addr,
-                                      CacheLine** result) const {
-    unsigned long tag = this->GetTag(addr);
-    unsigned long index = this->GetIndex(addr);
-    for (int way = 0; way < this->numWays; ++way) {
-        CacheLine* entry = &this->entries[index][way];
-
-        if (entry->isValid && entry->tag == tag) {
-            *result = entry;
-            return true;
-        }
-    }
-    return false;
+                                      int* resultWay) const {
+    unsigned long matches =
+        this->MatchTag(this->GetIndex(addr), this->GetTag(addr));
+    if (matches == 0) return false;
+
+    *resultWay = __builtin_ctzl(matches);
+    return true;
 }
 
 template <typename ValueType>
 bool CacheMemory<ValueType>::FindEmptyEntry(unsigned long addr,
-                                            CacheLine** result) const {
-    unsigned long index = this->GetIndex(addr);
-    for (int way = 0; way < this->numWays; ++way) {
-        CacheLine* entry = &this->entries[index][way];
-
-        if (!entry->isValid) {
-            *result = entry;
-            return true;
-        }
-    }
-    return false;
+                                            int* resultWay) const {
+    unsigned long empty =
+        ~this->validMasks[this->GetIndex(addr)] & this->allWaysMask;
+    if (empty == 0) return false;
+
+    *resultWay = __builtin_ctzl(empty);
+    return true;
 }
 
 template <typename ValueType>
 int CacheMemory<ValueType>::SetReplacementPolicy(const char* policyName) {
+    // All the LRU implementations choose the same victims, "lru" takes the
+    // cheapest one that supports the associativity.
     if (strcmp(policyName, "lru") == 0) {
+        if (this->numWays <= ReplacementPolicies::LRU_MATRIX_MAX_WAYS) {
+            policyName = "lrumatrix";
+        } else if (this->numWays <= ReplacementPolicies::LRU_PACKED_MAX_WAYS) {
+            policyName = "lrupacked";
+        } else {
+            policyName = "lrucounters";
+        }
+    }
+
+    if (strcmp(policyName, "lrucounters") == 0) {
         this->policy =
             new ReplacementPolicies::LRU(this->numSets, this->numWays);
         return 0;
     }
 
+    if (strcmp(policyName, "lrupacked") == 0 &&
+        this->numWays <= ReplacementPolicies::LRU_PACKED_MAX_WAYS) {
+        this->policy =
+            new ReplacementPolicies::LRUPacked(this->numSets, this->numWays);
+        return 0;
+    }
+
+    if (strcmp(policyName, "lrumatrix") == 0 &&
+        this->numWays <= ReplacementPolicies::LRU_MATRIX_MAX_WAYS) {
+        this->policy =
+            new ReplacementPolicies::LRUMatrix(this->numSets, this->numWays);
+        return 0;
+    }
+
     if (strcmp(policyName, "random") == 0) {
         this->policy =
             new ReplacementPolicies::Random(this->numSets, this->numWays);
@@ -505,6 +673,30 @@ int CacheMemory<ValueType>::SetReplacementPolicy(const char* policyName) {
         return 0;
     }
 
+    if (strcmp(policyName, "treeplru") == 0) {
+        this->policy =
+            new ReplacementPolicies::TreePLRU(this->numSets, this->numWays);
+        return 0;
+    }
+
+    if (strcmp(policyName, "srrip") == 0) {
+        this->policy =
+            new ReplacementPolicies::SRRIP(this->numSets, this->numWays);
+        return 0;
+    }
+
+    if (strcmp(policyName, "brrip") == 0) {
+        this->policy =
+            new ReplacementPolicies::BRRIP(this->numSets, this->numWays);
+        return 0;
+    }
+
+    if (strcmp(policyName, "drrip") == 0) {
+        this->policy =
+            new ReplacementPolicies::DRRIP(this->numSets, this->numWays);
+        return 0;
+    }
+
     return 1;
 }
 
@@ -540,10 +732,16 @@ template <typename ValueType>
 float CacheMemory<ValueType>::getStatValidProp() const {
     int n = this->numSets * this->numWays;
     int count = 0;
-    for (int i = 0; i < n; ++i) {
-        if (this->entries[0][i].isValid) count += 1;
+    for (int i = 0; i < this->numSets; ++i) {
+        count += __builtin_popcountl(this->validMasks[i]);
     }
     return (float)count / (float)n;
 }
 
+#include "fixedCacheMemory.hpp"
+
+#ifndef NDEBUG
+int TestCacheMemory();
+#endif
+
 #endif
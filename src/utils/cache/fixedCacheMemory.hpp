@@ -0,0 +1,199 @@
+#ifndef SINUCA3_FIXED_CACHE_MEMORY_HPP_
+#define SINUCA3_FIXED_CACHE_MEMORY_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file fixedCacheMemory.hpp
+ * @brief CacheMemory specialized at compile time for a given geometry.
+ * @details FixedCacheMemory keeps the storage layout of CacheMemory, but the
+ * number of sets, ways, line size and the replacement policy are template
+ * parameters. Address slicing becomes constant shifts and masks, the tag match
+ * loop has a known trip count and the policy is called without a virtual
+ * dispatch. Components do not use it directly: CacheMemory::fromCacheSize and
+ * friends return one when the requested geometry is in the table of
+ * CreateFixedCacheMemory, and the dynamic CacheMemory otherwise.
+ *
+ * Every lookup that touches the policy or runs on each access (Read, Write,
+ * Peek and Invalidate) is overridden with the constant geometry, so the
+ * dynamic `policy` of the base class is never used and stays NULL.
+ */
+
+#include <cstring>
+
+#include "cacheMemory.hpp"
+#include "replacement_policies/fixedPolicies.hpp"
+
+/** @brief Log2 of a power of two, evaluated at compile time. */
+template <unsigned long N>
+struct StaticLog2 {
+    enum { VALUE = 1 + StaticLog2<N / 2>::VALUE };
+};
+
+template <>
+struct StaticLog2<1> {
+    enum { VALUE = 0 };
+};
+
+template <typename ValueType, int NUM_SETS, int NUM_WAYS, int LINE_SIZE,
+          template <int, int> class Policy>
+class FixedCacheMemory : public CacheMemory<ValueType> {
+  public:
+    enum {
+        OFFSET_BITS = StaticLog2<LINE_SIZE>::VALUE,
+        INDEX_BITS = StaticLog2<NUM_SETS>::VALUE,
+        WAY_STRIDE = (NUM_WAYS + wayPadding - 1) & ~(wayPadding - 1)
+    };
+
+    inline FixedCacheMemory() {
+        this->SetGeometry(INDEX_BITS, OFFSET_BITS, NUM_WAYS);
+        this->AllocateStorage();
+    }
+    virtual ~FixedCacheMemory() {}
+
+    virtual const ValueType* Read(unsigned long addr) {
+        unsigned long set = SetOf(addr);
+        unsigned long matches = this->Match(set, addr);
+
+        this->statAcess += 1;
+        if (matches == 0) {
+            this->statMiss += 1;
+            return NULL;
+        }
+        this->statHit += 1;
+
+        int way = __builtin_ctzl(matches);
+        this->fixedPolicy.Acess(set, way);
+        return &this->data[set * WAY_STRIDE + way];
+    }
+
+    virtual bool Write(unsigned long addr, const ValueType* data,
+                       ValueType* evicted = NULL) {
+        unsigned long set = SetOf(addr);
+        unsigned long empty = ~this->validMasks[set] & AllWaysMask();
+        int way;
+        if (empty != 0) {
+            way = __builtin_ctzl(empty);
+        } else {
+            way = this->fixedPolicy.SelectVictim(set);
+            if (evicted != NULL) *evicted = this->data[set * WAY_STRIDE + way];
+        }
+
+        this->tags[set * WAY_STRIDE + way] = TagOf(addr);
+        this->validMasks[set] |= 1UL << way;
+        this->fixedPolicy.Acess(set, way);
+        this->data[set * WAY_STRIDE + way] = *data;
+
+        this->statEvaction += 1;
+        return empty == 0;
+    }
+
+    virtual ValueType* Peek(unsigned long addr) {
+        unsigned long set = SetOf(addr);
+        unsigned long matches = this->Match(set, addr);
+        if (matches == 0) return NULL;
+        return &this->data[set * WAY_STRIDE + __builtin_ctzl(matches)];
+    }
+
+    virtual bool Invalidate(unsigned long addr, ValueType* data) {
+        unsigned long set = SetOf(addr);
+        unsigned long matches = this->Match(set, addr);
+        if (matches == 0) return false;
+
+        int way = __builtin_ctzl(matches);
+        if (data != NULL) *data = this->data[set * WAY_STRIDE + way];
+        this->validMasks[set] &= ~(1UL << way);
+        return true;
+    }
+
+  private:
+    Policy<NUM_SETS, NUM_WAYS> fixedPolicy;
+
+    /** @brief Bitmask of the valid ways of [set] holding [addr]. */
+    inline unsigned long Match(unsigned long set, unsigned long addr) const {
+        return MatchTagInSet(&this->tags[set * WAY_STRIDE], WAY_STRIDE,
+                             NUM_WAYS, TagOf(addr)) &
+               this->validMasks[set];
+    }
+
+    static inline unsigned long SetOf(unsigned long addr) {
+        return (addr >> OFFSET_BITS) & (NUM_SETS - 1);
+    }
+    static inline unsigned long TagOf(unsigned long addr) {
+        return addr >> (OFFSET_BITS + INDEX_BITS);
+    }
+    static inline unsigned long AllWaysMask() {
+        return (NUM_WAYS == maxNumWays) ? ~0UL : (1UL << NUM_WAYS) - 1;
+    }
+};
+
+template <typename ValueType, int NUM_SETS, int NUM_WAYS, int LINE_SIZE>
+CacheMemory<ValueType>* CreateFixedCacheMemoryWithPolicy(const char* policy) {
+    if (strcmp(policy, "lru") == 0) {
+        return new FixedCacheMemory<ValueType, NUM_SETS, NUM_WAYS, LINE_SIZE,
+                                    FixedReplacementPolicies::LRU>();
+    }
+    if (strcmp(policy, "random") == 0) {
+        return new FixedCacheMemory<ValueType, NUM_SETS, NUM_WAYS, LINE_SIZE,
+                                    FixedReplacementPolicies::Random>();
+    }
+    if (strcmp(policy, "roundrobin") == 0) {
+        return new FixedCacheMemory<ValueType, NUM_SETS, NUM_WAYS, LINE_SIZE,
+                                    FixedReplacementPolicies::RoundRobin>();
+    }
+    return NULL;
+}
+
+/**
+ * @details Geometries of the common TLBs and caches. Each entry costs one
+ * instantiation per policy and per ValueType, so keep the table short; other
+ * geometries work just as well through the dynamic CacheMemory.
+ */
+#define SINUCA3_FIXED_CACHE_GEOMETRY(SETS, WAYS, LINE)                      \
+    if (numSets == (SETS) && associativity == (WAYS) && lineSize == (LINE)) \
+        return CreateFixedCacheMemoryWithPolicy<ValueType, SETS, WAYS, LINE>( \
+            policy);
+
+template <typename ValueType>
+CacheMemory<ValueType>* CreateFixedCacheMemory(unsigned int numIndexBits,
+                                               unsigned int numOffsetBits,
+                                               unsigned int associativity,
+                                               const char* policy) {
+    if (numIndexBits >= 32 || numOffsetBits >= 32) return NULL;
+    unsigned int numSets = 1u << numIndexBits;
+    unsigned int lineSize = 1u << numOffsetBits;
+
+    // TLBs, indexed by 4 KiB pages.
+    SINUCA3_FIXED_CACHE_GEOMETRY(64, 1, 4096);
+    SINUCA3_FIXED_CACHE_GEOMETRY(16, 4, 4096);
+    SINUCA3_FIXED_CACHE_GEOMETRY(16, 8, 4096);
+    SINUCA3_FIXED_CACHE_GEOMETRY(128, 12, 4096);
+    // 32 KiB and 48 KiB L1, 1 MiB and 2 MiB L2/LLC slices, 64 B lines.
+    SINUCA3_FIXED_CACHE_GEOMETRY(64, 8, 64);
+    SINUCA3_FIXED_CACHE_GEOMETRY(64, 12, 64);
+    SINUCA3_FIXED_CACHE_GEOMETRY(1024, 16, 64);
+    SINUCA3_FIXED_CACHE_GEOMETRY(2048, 16, 64);
+    // Prefetcher tables indexed by instruction address.
+    SINUCA3_FIXED_CACHE_GEOMETRY(64, 4, 1);
+
+    return NULL;
+}
+
+#undef SINUCA3_FIXED_CACHE_GEOMETRY
+
+#endif  // SINUCA3_FIXED_CACHE_MEMORY_HPP_
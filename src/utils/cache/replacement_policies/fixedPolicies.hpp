@@ -0,0 +1,117 @@
+#ifndef SINUCA3_FIXED_REPLACEMENT_POLICIES_HPP_
+#define SINUCA3_FIXED_REPLACEMENT_POLICIES_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file fixedPolicies.hpp
+ * @brief Replacement policies for FixedCacheMemory.
+ * @details Same behavior as the ones in ReplacementPolicies, but the geometry
+ * is a template parameter and the methods are not virtual, so the compiler
+ * inlines them in the cache and unrolls the loops over the ways.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "lruMatrix.hpp"
+#include "lruPacked.hpp"
+#include "random.hpp"
+
+namespace FixedReplacementPolicies {
+
+/**
+ * @brief Age matrix up to 8 ways, packed recency order up to 16. Larger
+ * geometries do not compile, use the dynamic CacheMemory for them.
+ */
+template <int NUM_SETS, int NUM_WAYS>
+class LRU {
+  public:
+    inline LRU() {
+        unsigned long initial =
+            MATRIX ? ReplacementPolicies::LruMatrixInitial(NUM_WAYS)
+                   : ReplacementPolicies::LruPackedInitialOrder(NUM_WAYS);
+        for (int i = 0; i < NUM_SETS; ++i) {
+            this->state[i] = initial;
+        }
+    }
+
+    inline void Acess(int set, int way) {
+        if (MATRIX) {
+            this->state[set] = ReplacementPolicies::LruMatrixTouch(
+                this->state[set], way, NUM_WAYS);
+        } else {
+            this->state[set] =
+                ReplacementPolicies::LruPackedTouch(this->state[set], way);
+        }
+    }
+
+    inline int SelectVictim(int set) {
+        if (MATRIX) {
+            return ReplacementPolicies::LruMatrixVictim(this->state[set]);
+        }
+        return ReplacementPolicies::LruPackedVictim(this->state[set], NUM_WAYS);
+    }
+
+  private:
+    enum { MATRIX = NUM_WAYS <= ReplacementPolicies::LRU_MATRIX_MAX_WAYS };
+    typedef char WaysCheck
+        [NUM_WAYS <= ReplacementPolicies::LRU_PACKED_MAX_WAYS ? 1 : -1];
+
+    unsigned long state[NUM_SETS];
+};
+
+template <int NUM_SETS, int NUM_WAYS>
+class Random {
+  public:
+    inline Random() { srand(ReplacementPolicies::SEED); }
+
+    inline void Acess(int set, int way) {
+        (void)set;
+        (void)way;
+    }
+
+    inline int SelectVictim(int set) {
+        (void)set;
+        return rand() % NUM_WAYS;
+    }
+};
+
+template <int NUM_SETS, int NUM_WAYS>
+class RoundRobin {
+  public:
+    inline RoundRobin() { memset(this->rrIndex, 0, sizeof(this->rrIndex)); }
+
+    inline void Acess(int set, int way) {
+        (void)set;
+        (void)way;
+    }
+
+    inline int SelectVictim(int set) {
+        int rr = this->rrIndex[set];
+        this->rrIndex[set] = (rr + 1) % NUM_WAYS;
+        return rr;
+    }
+
+  private:
+    int rrIndex[NUM_SETS];
+};
+
+}  // namespace FixedReplacementPolicies
+
+#endif  // SINUCA3_FIXED_REPLACEMENT_POLICIES_HPP_
@@ -66,3 +66,58 @@ void LRU::SelectVictim(unsigned long tag, unsigned long index, int* resultSet,
 }
 
 }  // namespace ReplacementPolicies
+
+#ifndef NDEBUG
+
+#include "lruMatrix.hpp"
+#include "lruPacked.hpp"
+
+/**
+ * @brief The packed and matrix LRUs must choose the same victims as the
+ * counters, including while some ways were never accessed.
+ */
+int TestLru() {
+    using namespace ReplacementPolicies;
+
+    const int numSets = 4;
+    unsigned long state = 42;
+
+    for (int numWays = 1; numWays <= LRU_PACKED_MAX_WAYS; ++numWays) {
+        LRU counters(numSets, numWays);
+        LRUPacked packed(numSets, numWays);
+        LRUMatrix* matrix = NULL;
+        if (numWays <= LRU_MATRIX_MAX_WAYS) {
+            matrix = new LRUMatrix(numSets, numWays);
+        }
+
+        for (int i = 0; i < 20000; ++i) {
+            state = state * 6364136223846793005UL + 1442695040888963407UL;
+            int set = (state >> 33) % numSets;
+            int way = (state >> 40) % numWays;
+
+            int expectedSet, expectedWay, resultSet, resultWay;
+            counters.SelectVictim(0, set, &expectedSet, &expectedWay);
+            packed.SelectVictim(0, set, &resultSet, &resultWay);
+            if (resultSet != expectedSet || resultWay != expectedWay) return 1;
+            if (matrix != NULL) {
+                matrix->SelectVictim(0, set, &resultSet, &resultWay);
+                if (resultSet != expectedSet || resultWay != expectedWay) {
+                    return 2;
+                }
+            }
+
+            // Half of the accesses replace the victim, as a miss would.
+            if ((state >> 60) & 1) way = expectedWay;
+            CacheLine line(set, way, 0, set);
+            counters.Acess(&line);
+            packed.Acess(&line);
+            if (matrix != NULL) matrix->Acess(&line);
+        }
+
+        delete matrix;
+    }
+
+    return 0;
+}
+
+#endif
@@ -43,4 +43,8 @@ class LRU : public ReplacementPolicy {
 
 }  // namespace ReplacementPolicies
 
+#ifndef NDEBUG
+int TestLru();
+#endif
+
 #endif
@@ -0,0 +1,54 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file lruMatrix.cpp
+ * @brief Implementation of LRUMatrix as replacement policy.
+ */
+
+#include "lruMatrix.hpp"
+
+#include <cassert>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/logging.hpp>
+
+namespace ReplacementPolicies {
+
+LRUMatrix::LRUMatrix(int numSets, int numWays)
+    : ReplacementPolicy(numSets, numWays) {
+    assert(numWays <= LRU_MATRIX_MAX_WAYS);
+    this->matrices = new unsigned long[this->numSets];
+    for (int i = 0; i < this->numSets; ++i) {
+        this->matrices[i] = LruMatrixInitial(this->numWays);
+    }
+}
+
+LRUMatrix::~LRUMatrix() { delete[] this->matrices; }
+
+void LRUMatrix::Acess(CacheLine* entry) {
+    this->matrices[entry->i] =
+        LruMatrixTouch(this->matrices[entry->i], entry->j, this->numWays);
+}
+
+void LRUMatrix::SelectVictim(unsigned long tag, unsigned long index,
+                             int* resultSet, int* resultWay) {
+    (void)tag;
+    *resultSet = index;
+    *resultWay = LruMatrixVictim(this->matrices[index]);
+}
+
+}  // namespace ReplacementPolicies
@@ -0,0 +1,80 @@
+#ifndef SINUCA3_LRU_MATRIX_CACHE_HPP_
+#define SINUCA3_LRU_MATRIX_CACHE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file lruMatrix.hpp
+ * @details True LRU with an age matrix, for up to 8 ways. Each set is a 8x8
+ * bit matrix in a 64-bit word: bit j of byte i is set when way i was used
+ * after way j. Touching a way sets its row and clears its column, and the LRU
+ * way is the one whose row is empty. Victims are the same as the ones of the
+ * counter based LRU.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/cache/replacement_policy.hpp>
+
+namespace ReplacementPolicies {
+
+static const int LRU_MATRIX_MAX_WAYS = 8;
+
+/**
+ * @brief Matrix of a set no way was accessed yet. Rows past [numWays] are
+ * kept non empty so they are never chosen.
+ */
+static inline unsigned long LruMatrixInitial(int numWays) {
+    if (numWays == LRU_MATRIX_MAX_WAYS) return 0;
+    return ~0UL << (8 * numWays);
+}
+
+static inline unsigned long LruMatrixTouch(unsigned long matrix, int way,
+                                           int numWays) {
+    const unsigned long column = 0x0101010101010101UL << way;
+    unsigned long row = ((1UL << numWays) - 1) & ~(1UL << way);
+
+    matrix &= ~column;
+    matrix &= ~(0xffUL << (8 * way));
+    return matrix | (row << (8 * way));
+}
+
+static inline int LruMatrixVictim(unsigned long matrix) {
+    const unsigned long ones = 0x0101010101010101UL;
+    const unsigned long highs = 0x8080808080808080UL;
+
+    // Lowest empty row, so ties between unused ways go to the first one.
+    unsigned long empty = (matrix - ones) & ~matrix & highs;
+    return __builtin_ctzl(empty) >> 3;
+}
+
+class LRUMatrix : public ReplacementPolicy {
+  public:
+    LRUMatrix(int numSets, int numWays);
+    virtual ~LRUMatrix();
+
+    virtual void Acess(CacheLine* entry);
+    virtual void SelectVictim(unsigned long tag, unsigned long index,
+                              int* resultSet, int* resultWay);
+
+  private:
+    unsigned long* matrices;  // [sets]
+};
+
+}  // namespace ReplacementPolicies
+
+#endif
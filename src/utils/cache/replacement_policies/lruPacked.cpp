@@ -0,0 +1,53 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file lruPacked.cpp
+ * @brief Implementation of LRUPacked as replacement policy.
+ */
+
+#include "lruPacked.hpp"
+
+#include <cassert>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/logging.hpp>
+
+namespace ReplacementPolicies {
+
+LRUPacked::LRUPacked(int numSets, int numWays)
+    : ReplacementPolicy(numSets, numWays) {
+    assert(numWays <= LRU_PACKED_MAX_WAYS);
+    this->orders = new unsigned long[this->numSets];
+    for (int i = 0; i < this->numSets; ++i) {
+        this->orders[i] = LruPackedInitialOrder(this->numWays);
+    }
+}
+
+LRUPacked::~LRUPacked() { delete[] this->orders; }
+
+void LRUPacked::Acess(CacheLine* entry) {
+    this->orders[entry->i] = LruPackedTouch(this->orders[entry->i], entry->j);
+}
+
+void LRUPacked::SelectVictim(unsigned long tag, unsigned long index,
+                             int* resultSet, int* resultWay) {
+    (void)tag;
+    *resultSet = index;
+    *resultWay = LruPackedVictim(this->orders[index], this->numWays);
+}
+
+}  // namespace ReplacementPolicies
@@ -0,0 +1,80 @@
+#ifndef SINUCA3_LRU_PACKED_CACHE_HPP_
+#define SINUCA3_LRU_PACKED_CACHE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file lruPacked.hpp
+ * @details LRU keeping the recency order of each set in a single 64-bit word.
+ * Nibble i holds the way at position i of the order, position 0 being the most
+ * recently used, so up to 16 ways fit. Acess and SelectVictim are constant
+ * time, and the victims are the same as the ones of the counter based LRU.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/cache/replacement_policy.hpp>
+
+namespace ReplacementPolicies {
+
+static const int LRU_PACKED_MAX_WAYS = 16;
+
+/** @brief Order of a set no way was accessed yet: way 0 is the LRU. */
+static inline unsigned long LruPackedInitialOrder(int numWays) {
+    unsigned long order = 0;
+    for (int way = 0; way < numWays; ++way) {
+        order |= (unsigned long)way << (4 * (numWays - 1 - way));
+    }
+    return order;
+}
+
+/** @brief Moves [way] to the MRU position of [order]. */
+static inline unsigned long LruPackedTouch(unsigned long order, int way) {
+    const unsigned long ones = 0x1111111111111111UL;
+    const unsigned long highs = 0x8888888888888888UL;
+
+    // The lowest zero nibble of order ^ way is the position of [way]. Bits
+    // above it may be false positives from the borrow, so only ctz is used.
+    unsigned long diff = order ^ (ones * way);
+    unsigned long zeros = (diff - ones) & ~diff & highs;
+    int shift = __builtin_ctzl(zeros) - 3;
+
+    unsigned long below = (1UL << shift) - 1;
+    unsigned long above = ~below << 4;
+    return (order & above) | ((order & below) << 4) | (unsigned long)way;
+}
+
+static inline int LruPackedVictim(unsigned long order, int numWays) {
+    return (order >> (4 * (numWays - 1))) & 0xf;
+}
+
+class LRUPacked : public ReplacementPolicy {
+  public:
+    LRUPacked(int numSets, int numWays);
+    virtual ~LRUPacked();
+
+    virtual void Acess(CacheLine* entry);
+    virtual void SelectVictim(unsigned long tag, unsigned long index,
+                              int* resultSet, int* resultWay);
+
+  private:
+    unsigned long* orders;  // [sets]
+};
+
+}  // namespace ReplacementPolicies
+
+#endif
@@ -0,0 +1,178 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file rrip.cpp
+ * @brief Implementation of SRRIP, BRRIP and DRRIP as replacement policies.
+ */
+
+#include "rrip.hpp"
+
+#include <cassert>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/logging.hpp>
+
+namespace ReplacementPolicies {
+
+SRRIP::SRRIP(int numSets, int numWays)
+    : ReplacementPolicy(numSets, numWays), insertions(0) {
+    assert(numWays <= maxNumWays);
+    this->wordsPerSet = (this->numWays + RRPV_PER_WORD - 1) / RRPV_PER_WORD;
+    this->rrpvs = new unsigned long[this->numSets * this->wordsPerSet];
+    for (int set = 0; set < this->numSets; ++set) {
+        for (int word = 0; word < this->wordsPerSet; ++word) {
+            this->rrpvs[set * this->wordsPerSet + word] =
+                this->FieldMask(word) * RRPV_MAX;
+        }
+    }
+}
+
+SRRIP::~SRRIP() { delete[] this->rrpvs; }
+
+void SRRIP::Acess(CacheLine* entry) { this->SetRrpv(entry->i, entry->j, 0); }
+
+void SRRIP::Insert(CacheLine* entry) {
+    this->SetRrpv(entry->i, entry->j, RRPV_MAX - 1);
+}
+
+void SRRIP::SelectVictim(unsigned long tag, unsigned long index,
+                         int* resultSet, int* resultWay) {
+    (void)tag;
+    unsigned long* words = &this->rrpvs[index * this->wordsPerSet];
+
+    unsigned long max = 0;
+    for (int word = 0; word < this->wordsPerSet; ++word) {
+        unsigned long x = words[word];
+        unsigned long mask = this->FieldMask(word);
+        if (x & (x >> 1) & mask) {
+            max = RRPV_MAX;
+            break;
+        }
+        if (((x >> 1) & mask) && max < 2) max = 2;
+        if ((x & mask) && max < 1) max = 1;
+    }
+
+    // Aging every way until one reaches RRPV_MAX is a single add per word,
+    // none of the fields can overflow.
+    unsigned long age = RRPV_MAX - max;
+    if (age != 0) {
+        for (int word = 0; word < this->wordsPerSet; ++word) {
+            words[word] += age * this->FieldMask(word);
+        }
+    }
+
+    *resultSet = index;
+    for (int word = 0; word < this->wordsPerSet; ++word) {
+        unsigned long x = words[word];
+        unsigned long distant = x & (x >> 1) & this->FieldMask(word);
+        if (distant != 0) {
+            *resultWay =
+                word * RRPV_PER_WORD + __builtin_ctzl(distant) / RRPV_BITS;
+            return;
+        }
+    }
+}
+
+void BRRIP::Insert(CacheLine* entry) {
+    this->SetRrpv(entry->i, entry->j, this->BimodalRrpv());
+}
+
+DRRIP::DRRIP(int numSets, int numWays)
+    : SRRIP(numSets, numWays), psel((DRRIP_PSEL_MAX + 1) / 2) {
+    // numSets is a power of two, so is the distance between leaders.
+    int stride = this->numSets / DRRIP_LEADER_SETS;
+    if (stride < 2) stride = 2;
+    this->leaderMask = stride - 1;
+}
+
+void DRRIP::Insert(CacheLine* entry) {
+    // Insertions are misses, so each one counts against its leader policy.
+    bool useBrrip;
+    if (this->IsSrripLeader(entry->i)) {
+        if (this->psel < DRRIP_PSEL_MAX) ++this->psel;
+        useBrrip = false;
+    } else if (this->IsBrripLeader(entry->i)) {
+        if (this->psel > 0) --this->psel;
+        useBrrip = true;
+    } else {
+        useBrrip = this->psel > DRRIP_PSEL_MAX / 2;
+    }
+
+    this->SetRrpv(entry->i, entry->j,
+                  useBrrip ? this->BimodalRrpv() : RRPV_MAX - 1);
+}
+
+}  // namespace ReplacementPolicies
+
+#ifndef NDEBUG
+
+int TestRrip() {
+    using namespace ReplacementPolicies;
+
+    // Fill 4 ways, reuse the first one: the second is the victim after aging,
+    // and the first one, promoted, survives.
+    for (int numWays = 4; numWays <= 64; numWays *= 4) {
+        SRRIP srrip(1, numWays);
+        int set, way;
+        for (int j = 0; j < numWays; ++j) {
+            CacheLine line(0, j, 0, 0);
+            srrip.Insert(&line);
+        }
+        CacheLine first(0, 0, 0, 0);
+        srrip.Acess(&first);
+        srrip.SelectVictim(0, 0, &set, &way);
+        if (set != 0 || way != 1) return 1;
+        for (int j = 2; j < numWays; ++j) {
+            srrip.SelectVictim(0, 0, &set, &way);
+            if (way != j - 1) return 2;
+            CacheLine line(0, way, 0, 0);
+            srrip.Insert(&line);
+        }
+    }
+
+    // Most BRRIP insertions are distant, so the last inserted way goes first.
+    BRRIP brrip(1, 4);
+    for (int j = 0; j < 4; ++j) {
+        CacheLine line(0, j, 0, 0);
+        brrip.Insert(&line);
+    }
+    int set, way;
+    brrip.SelectVictim(0, 0, &set, &way);
+    if (way != 0) return 3;
+    CacheLine hit(0, 0, 0, 0);
+    brrip.Acess(&hit);
+    brrip.SelectVictim(0, 0, &set, &way);
+    if (way != 1) return 4;
+
+    // Misses only in the SRRIP leaders push PSEL up to saturation, and back
+    // down with misses only in the BRRIP leaders.
+    DRRIP drrip(1024, 4);
+    for (int i = 0; i < 2 * DRRIP_PSEL_MAX; ++i) {
+        CacheLine line(0, i % 4, 0, 0);
+        drrip.Insert(&line);
+    }
+    if (drrip.GetPsel() != DRRIP_PSEL_MAX) return 5;
+    for (int i = 0; i < 2 * DRRIP_PSEL_MAX; ++i) {
+        CacheLine line(1023, i % 4, 0, 1023);
+        drrip.Insert(&line);
+    }
+    if (drrip.GetPsel() != 0) return 6;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef SINUCA3_RRIP_CACHE_HPP_
+#define SINUCA3_RRIP_CACHE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file rrip.hpp
+ * @details Re-reference interval prediction policies (Jaleel et al., ISCA
+ * 2010). Each way has a 2-bit re-reference prediction value (RRPV), packed 32
+ * ways per 64-bit word. Hits set the RRPV to 0 and the victim is the first way
+ * predicted distant (RRPV 3), aging the whole set first if there is none.
+ * - SRRIP inserts lines with RRPV 2.
+ * - BRRIP inserts lines with RRPV 3, and with 2 once every 32 insertions.
+ * - DRRIP duels the two: a few leader sets always use one of them, misses in
+ * the leaders move a saturating PSEL counter and the follower sets use the
+ * policy whose leaders missed less.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/cache/replacement_policy.hpp>
+
+namespace ReplacementPolicies {
+
+static const int RRPV_BITS = 2;
+static const unsigned long RRPV_MAX = (1 << RRPV_BITS) - 1;
+static const int RRPV_PER_WORD = 64 / RRPV_BITS;
+static const int BRRIP_LONG_INTERVAL = 32;
+
+class SRRIP : public ReplacementPolicy {
+  public:
+    SRRIP(int numSets, int numWays);
+    virtual ~SRRIP();
+
+    virtual void Acess(CacheLine* entry);
+    virtual void Insert(CacheLine* entry);
+    virtual void SelectVictim(unsigned long tag, unsigned long index,
+                              int* resultSet, int* resultWay);
+
+  protected:
+    unsigned long* rrpvs;  // [sets x wordsPerSet]
+    int wordsPerSet;
+    unsigned long insertions;
+
+    inline void SetRrpv(int set, int way, unsigned long value) {
+        unsigned long* word =
+            &this->rrpvs[set * this->wordsPerSet + way / RRPV_PER_WORD];
+        int shift = (way % RRPV_PER_WORD) * RRPV_BITS;
+        *word = (*word & ~(RRPV_MAX << shift)) | (value << shift);
+    }
+
+    /** @brief Bitmask of the low bit of the fields in use in [word]. */
+    inline unsigned long FieldMask(int word) const {
+        int ways = this->numWays - word * RRPV_PER_WORD;
+        if (ways >= RRPV_PER_WORD) return 0x5555555555555555UL;
+        return 0x5555555555555555UL & ((1UL << (ways * RRPV_BITS)) - 1);
+    }
+
+    /** @brief Insertion RRPV of BRRIP: 3, and 2 once every 32 calls. */
+    inline unsigned long BimodalRrpv() {
+        ++this->insertions;
+        return (this->insertions % BRRIP_LONG_INTERVAL == 0) ? RRPV_MAX - 1
+                                                             : RRPV_MAX;
+    }
+};
+
+class BRRIP : public SRRIP {
+  public:
+    BRRIP(int numSets, int numWays) : SRRIP(numSets, numWays) {}
+
+    virtual void Insert(CacheLine* entry);
+};
+
+static const int DRRIP_LEADER_SETS = 32;
+static const int DRRIP_PSEL_BITS = 10;
+static const int DRRIP_PSEL_MAX = (1 << DRRIP_PSEL_BITS) - 1;
+
+class DRRIP : public SRRIP {
+  public:
+    DRRIP(int numSets, int numWays);
+
+    virtual void Insert(CacheLine* entry);
+
+    inline int GetPsel() const { return this->psel; }
+
+  private:
+    int psel;  // Above half, BRRIP leaders miss less.
+    unsigned long leaderMask;
+
+    inline bool IsSrripLeader(int set) const {
+        return (set & this->leaderMask) == 0;
+    }
+    inline bool IsBrripLeader(int set) const {
+        return (set & this->leaderMask) == this->leaderMask;
+    }
+};
+
+}  // namespace ReplacementPolicies
+
+#ifndef NDEBUG
+int TestRrip();
+#endif
+
+#endif
@@ -0,0 +1,108 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file treePlru.cpp
+ * @brief Implementation of TreePLRU as replacement policy.
+ */
+
+#include "treePlru.hpp"
+
+#include <cassert>
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/logging.hpp>
+
+namespace ReplacementPolicies {
+
+TreePLRU::TreePLRU(int numSets, int numWays)
+    : ReplacementPolicy(numSets, numWays) {
+    assert(numWays <= maxNumWays);
+    this->treeLevels = 0;
+    while ((1 << this->treeLevels) < this->numWays) ++this->treeLevels;
+    this->trees = new unsigned long[this->numSets]();
+}
+
+TreePLRU::~TreePLRU() { delete[] this->trees; }
+
+void TreePLRU::Acess(CacheLine* entry) {
+    unsigned long tree = this->trees[entry->i];
+    unsigned long way = entry->j;
+    unsigned long node = 1;
+
+    // The path to a way follows its bits from the most significant one, and
+    // each node is left pointing to the other side.
+    for (int level = this->treeLevels - 1; level >= 0; --level) {
+        unsigned long right = (way >> level) & 1;
+        tree = (tree & ~(1UL << (node - 1))) | ((right ^ 1) << (node - 1));
+        node = 2 * node + right;
+    }
+
+    this->trees[entry->i] = tree;
+}
+
+void TreePLRU::SelectVictim(unsigned long tag, unsigned long index,
+                            int* resultSet, int* resultWay) {
+    (void)tag;
+    unsigned long tree = this->trees[index];
+    unsigned long way = 0;
+    unsigned long node = 1;
+
+    for (int level = this->treeLevels - 1; level >= 0; --level) {
+        unsigned long right = (tree >> (node - 1)) & 1;
+        // Halves past the last way have no lines.
+        right &= (((2 * way + 1) << level) < (unsigned long)this->numWays);
+        way = 2 * way + right;
+        node = 2 * node + right;
+    }
+
+    *resultSet = index;
+    *resultWay = way;
+}
+
+}  // namespace ReplacementPolicies
+
+#ifndef NDEBUG
+
+int TestTreePlru() {
+    using namespace ReplacementPolicies;
+
+    // Filling the ways in order leaves the first one as the victim, and the
+    // last touched way is never the victim.
+    for (int numWays = 1; numWays <= 16; ++numWays) {
+        TreePLRU plru(2, numWays);
+        int set, way;
+        for (int j = 0; j < numWays; ++j) {
+            CacheLine line(1, j, 0, 1);
+            plru.Insert(&line);
+        }
+        plru.SelectVictim(0, 1, &set, &way);
+        if (set != 1 || way != 0) return 1;
+
+        for (int i = 0; i < 1000; ++i) {
+            int touched = (i * 7 + i / 3) % numWays;
+            CacheLine line(1, touched, 0, 1);
+            plru.Acess(&line);
+            plru.SelectVictim(0, 1, &set, &way);
+            if (way >= numWays) return 2;
+            if (numWays > 1 && way == touched) return 3;
+        }
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SINUCA3_TREE_PLRU_CACHE_HPP_
+#define SINUCA3_TREE_PLRU_CACHE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file treePlru.hpp
+ * @details Tree pseudo LRU. Each set keeps a binary tree over its ways, one
+ * bit per internal node, packed in a 64-bit word in heap order. A bit points
+ * to the half the next victim comes from, and touching a way makes every
+ * node on its path point away from it. When the number of ways is not a power
+ * of two the tree is rounded up and the halves without ways are never chosen.
+ */
+
+#include <sinuca3.hpp>
+#include <utils/cache/replacement_policy.hpp>
+
+namespace ReplacementPolicies {
+
+class TreePLRU : public ReplacementPolicy {
+  public:
+    TreePLRU(int numSets, int numWays);
+    virtual ~TreePLRU();
+
+    virtual void Acess(CacheLine* entry);
+    virtual void SelectVictim(unsigned long tag, unsigned long index,
+                              int* resultSet, int* resultWay);
+
+  private:
+    unsigned long* trees;  // [sets], bit n - 1 is node n of the heap.
+    int treeLevels;        // log2 of numWays rounded up to a power of two.
+};
+
+}  // namespace ReplacementPolicies
+
+#ifndef NDEBUG
+int TestTreePlru();
+#endif
+
+#endif
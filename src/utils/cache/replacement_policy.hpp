@@ -32,6 +32,11 @@ class ReplacementPolicy {
     virtual ~ReplacementPolicy() {};
 
     virtual void Acess(CacheLine* entry) = 0;
+    /**
+     * @brief Called instead of Acess when [entry] was just filled, for the
+     * policies that insert lines differently from how they promote hits.
+     */
+    virtual void Insert(CacheLine* entry) { this->Acess(entry); }
     virtual void SelectVictim(unsigned long tag, unsigned long index,
                               int* resultSet, int* resultWay) = 0;
 
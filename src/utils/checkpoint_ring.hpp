@@ -0,0 +1,123 @@
+#ifndef SINUCA3_UTILS_CHECKPOINT_RING_HPP_
+#define SINUCA3_UTILS_CHECKPOINT_RING_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file checkpoint_ring.hpp
+ * @brief The branches in flight of the speculatively updated predictors, with
+ * the state each one saved when it was predicted.
+ */
+
+#include <cstddef>
+#include <engine/default_packets.hpp>
+
+/**
+ * @brief Ring of checkpoints of type [Checkpoint], oldest first, one per
+ * branch in flight. [Checkpoint] has a `const StaticInstructionInfo*
+ * instruction` member, set by Push and matched by Resolve.
+ * @details Predictions push a checkpoint and updates, which arrive in program
+ * order, resolve the oldest one. On a misprediction the owner restores the
+ * state saved in the oldest checkpoint, applies the actual outcome and calls
+ * Replay, which applies the predictions of the younger branches again: they
+ * are not squashed, since the trace only has the correct path.
+ */
+template <typename Checkpoint>
+class CheckpointRing {
+  private:
+    Checkpoint* checkpoints;
+    unsigned long size;
+    unsigned long head;
+    unsigned long occupation;
+    unsigned long numberOfDropped;
+
+  public:
+    inline CheckpointRing()
+        : checkpoints(NULL),
+          size(0),
+          head(0),
+          occupation(0),
+          numberOfDropped(0) {}
+
+    void Allocate(unsigned long size) {
+        this->size = size;
+        this->checkpoints = new Checkpoint[size];
+    }
+
+    inline unsigned long GetSize() const { return this->size; }
+    inline unsigned long GetOccupation() const { return this->occupation; }
+    inline unsigned long GetNumberOfDropped() const {
+        return this->numberOfDropped;
+    }
+
+    /** @brief Checkpoint [i] in flight, 0 is the oldest. */
+    inline Checkpoint* Get(unsigned long i) {
+        return &this->checkpoints[(this->head + i) % this->size];
+    }
+
+    /**
+     * @brief Checkpoint of a new branch, [instruction], younger than every
+     * other. When the ring is full the oldest one is dropped.
+     */
+    inline Checkpoint* Push(const StaticInstructionInfo* instruction) {
+        if (this->occupation == this->size) {
+            ++this->numberOfDropped;
+            this->Pop();
+        }
+        Checkpoint* checkpoint = this->Get(this->occupation);
+        ++this->occupation;
+        checkpoint->instruction = instruction;
+        return checkpoint;
+    }
+
+    /**
+     * @brief The checkpoint being resolved by an update of [instruction].
+     * @details Branches whose update was lost are dropped, the oldest one
+     * with the same instruction is the one being resolved.
+     * @return The oldest checkpoint, NULL if [instruction] has none.
+     */
+    inline Checkpoint* Resolve(const StaticInstructionInfo* instruction) {
+        while (this->occupation > 0 &&
+               this->Get(0)->instruction != instruction) {
+            ++this->numberOfDropped;
+            this->Pop();
+        }
+        return (this->occupation == 0) ? NULL : this->Get(0);
+    }
+
+    /**
+     * @brief Calls [apply] of [owner] with each checkpoint younger than the
+     * oldest, oldest first, once the owner repaired the state after it.
+     */
+    template <typename Owner, typename Result>
+    inline void Replay(Owner* owner, Result (Owner::*apply)(Checkpoint*)) {
+        for (unsigned long i = 1; i < this->occupation; ++i) {
+            (owner->*apply)(this->Get(i));
+        }
+    }
+
+    /** @brief Frees the oldest checkpoint. */
+    inline void Pop() {
+        this->head = (this->head + 1) % this->size;
+        --this->occupation;
+    }
+
+    inline ~CheckpointRing() { delete[] this->checkpoints; }
+};
+
+#endif  // SINUCA3_UTILS_CHECKPOINT_RING_HPP_
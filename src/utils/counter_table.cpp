@@ -0,0 +1,87 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file counter_table.cpp
+ * @brief Implementation of the table of 2-bit saturating counters.
+ */
+
+#include "counter_table.hpp"
+
+#include <sinuca3.hpp>
+
+int CounterTable::Allocate(unsigned long size, unsigned long value) {
+    if (size == 0) {
+        SINUCA3_ERROR_PRINTF("Counter table with no counters\n");
+        return 1;
+    }
+    this->Deallocate();
+    this->size = size;
+    this->words = new unsigned long[(size + COUNTERS_PER_WORD - 1) /
+                                    COUNTERS_PER_WORD];
+    this->Reset(value);
+    return 0;
+}
+
+void CounterTable::Deallocate() {
+    delete[] this->words;
+    this->words = NULL;
+    this->size = 0;
+}
+
+void CounterTable::Reset(unsigned long value) {
+    // 0x5555... has a 1 in the low bit of each counter.
+    unsigned long pattern = (value & 3) * 0x5555555555555555UL;
+    unsigned long numWords =
+        (this->size + COUNTERS_PER_WORD - 1) / COUNTERS_PER_WORD;
+    for (unsigned long i = 0; i < numWords; ++i) this->words[i] = pattern;
+}
+
+#ifndef NDEBUG
+
+int TestCounterTable() {
+    CounterTable table;
+    if (table.Allocate(100)) return 1;
+
+    for (unsigned long i = 0; i < 100; ++i) {
+        if (table.Get(i) != COUNTER_WEAKLY_TAKEN || !table.GetPrediction(i))
+            return 2;
+    }
+
+    // Saturates at both ends without touching the neighbours.
+    for (int i = 0; i < 5; ++i) table.Update(33, true);
+    if (table.Get(33) != 3) return 3;
+    for (int i = 0; i < 5; ++i) table.Update(31, false);
+    if (table.Get(31) != 0 || table.GetPrediction(31)) return 4;
+    if (table.Get(32) != 2 || table.Get(30) != 2 || table.Get(34) != 2)
+        return 5;
+    table.Update(31, true);
+    table.Update(31, true);
+    if (!table.GetPrediction(31)) return 6;
+
+    table.Set(99, 1);
+    if (table.Get(99) != 1 || table.Get(98) != 2) return 7;
+
+    table.Reset(0);
+    for (unsigned long i = 0; i < 100; ++i) {
+        if (table.Get(i) != 0) return 8;
+    }
+
+    return 0;
+}
+
+#endif
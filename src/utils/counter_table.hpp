@@ -0,0 +1,97 @@
+#ifndef SINUCA3_UTILS_COUNTER_TABLE_HPP_
+#define SINUCA3_UTILS_COUNTER_TABLE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+
+/**
+ * @file counter_table.hpp
+ * @brief Table of 2-bit saturating counters.
+ * @details The counters have the same meaning as in BimodalCounter (taken if
+ * the value is 2 or 3), but 32 of them are packed in each 64-bit word and the
+ * update is branch free, so big predictor tables take a quarter of the memory
+ * of a BimodalCounter array.
+ */
+
+#include <cstddef>
+
+static const int COUNTERS_PER_WORD = 32;
+static const unsigned long COUNTER_WEAKLY_TAKEN = 2;
+
+class CounterTable {
+  private:
+    unsigned long* words;
+    unsigned long size; /**<Number of counters. */
+
+    inline unsigned long* Word(unsigned long index) const {
+        return &this->words[index / COUNTERS_PER_WORD];
+    }
+    static inline unsigned int Shift(unsigned long index) {
+        return (index % COUNTERS_PER_WORD) * 2;
+    }
+
+  public:
+    inline CounterTable() : words(NULL), size(0) {}
+
+    /**
+     * @brief Allocates [size] counters set to [value].
+     * @return 0 if successfuly, 1 otherwise.
+     */
+    int Allocate(unsigned long size,
+                 unsigned long value = COUNTER_WEAKLY_TAKEN);
+    void Deallocate();
+
+    /** @brief Sets all counters to [value]. */
+    void Reset(unsigned long value = COUNTER_WEAKLY_TAKEN);
+
+    inline unsigned long GetSize() const { return this->size; }
+
+    /** @return The value of the counter, from 0 to 3. */
+    inline unsigned long Get(unsigned long index) const {
+        return (*this->Word(index) >> Shift(index)) & 3;
+    }
+
+    /** @return True if the counter predicts taken. */
+    inline bool GetPrediction(unsigned long index) const {
+        return (*this->Word(index) >> Shift(index)) & 2;
+    }
+
+    inline void Set(unsigned long index, unsigned long value) {
+        unsigned long* word = this->Word(index);
+        unsigned int shift = Shift(index);
+        *word = (*word & ~(3UL << shift)) | ((value & 3) << shift);
+    }
+
+    /** @brief Moves the counter towards [taken], saturating at 0 and 3. */
+    inline void Update(unsigned long index, bool taken) {
+        unsigned long* word = this->Word(index);
+        unsigned int shift = Shift(index);
+        unsigned long counter = (*word >> shift) & 3;
+        unsigned long updated = counter + (taken & (counter != 3)) -
+                                (!taken & (counter != 0));
+        *word ^= (counter ^ updated) << shift;
+    }
+
+    inline ~CounterTable() { this->Deallocate(); }
+};
+
+#ifndef NDEBUG
+int TestCounterTable();
+#endif
+
+#endif  // SINUCA3_UTILS_COUNTER_TABLE_HPP_
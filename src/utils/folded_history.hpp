@@ -0,0 +1,53 @@
+#ifndef SINUCA3_UTILS_FOLDED_HISTORY_HPP_
+#define SINUCA3_UTILS_FOLDED_HISTORY_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file folded_history.hpp
+ * @brief Global history folded onto a few bits, as used by TAGE-like
+ * predictors to hash long histories into table indices and tags.
+ */
+
+/**
+ * @brief A history of [length] bits folded onto [width] bits by XOR, updated
+ * in O(1) when a bit enters the history. The caller keeps the history itself
+ * and passes the bit leaving the window, the one [length] branches old.
+ */
+struct FoldedHistory {
+    unsigned int value;
+    int length;
+    int width;
+    int outPoint; /**<Where the bit leaving the history lands. */
+
+    inline void Configure(int length, int width) {
+        this->value = 0;
+        this->length = length;
+        this->width = width;
+        this->outPoint = length % width;
+    }
+
+    inline void Update(unsigned int newBit, unsigned int oldBit) {
+        this->value = (this->value << 1) | newBit;
+        this->value ^= oldBit << this->outPoint;
+        this->value ^= this->value >> this->width;
+        this->value &= (1U << this->width) - 1;
+    }
+};
+
+#endif  // SINUCA3_UTILS_FOLDED_HISTORY_HPP_
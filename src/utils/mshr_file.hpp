@@ -0,0 +1,180 @@
+#ifndef SINUCA3_UTILS_MSHR_FILE_HPP_
+#define SINUCA3_UTILS_MSHR_FILE_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file mshr_file.hpp
+ * @brief The miss and completion bookkeeping of the non-blocking caches and
+ * TLBs: a file of MSHRs (miss status holding registers) with the requests
+ * merged in each, and a wheel of requests completing at a later cycle.
+ */
+
+#include <utils/cache/cacheMemory.hpp>
+
+/** @brief Upper limit of the entries of a MshrFile, one bit per entry. */
+static const int MSHR_FILE_MAX_ENTRIES = maxNumWays;
+
+/**
+ * @brief Outstanding misses, each keyed by what it fetches (a line, a page)
+ * and holding up to maxTargets requests of type [Target] to answer when it
+ * completes.
+ * @details The keys are padded to wayPadding, so the lookup is the same SIMD
+ * tag match of CacheMemory, and a bit per busy entry is kept in a mask.
+ * Owners may keep masks of their own indexed by the entries.
+ */
+template <typename Target>
+class MshrFile {
+  private:
+    unsigned long* keys;
+    unsigned long valid;
+    int stride;
+    int numEntries;
+    int maxTargets;
+    int* numTargets;
+    Target* targets; /**< [numEntries x maxTargets] */
+
+  public:
+    inline MshrFile()
+        : keys(NULL),
+          valid(0),
+          stride(0),
+          numEntries(0),
+          maxTargets(0),
+          numTargets(NULL),
+          targets(NULL) {}
+
+    /**
+     * @brief [numEntries], from 1 to MSHR_FILE_MAX_ENTRIES, with room for
+     * [maxTargets] each.
+     */
+    void Allocate(int numEntries, int maxTargets) {
+        this->numEntries = numEntries;
+        this->maxTargets = maxTargets;
+        this->stride = (numEntries + wayPadding - 1) & ~(wayPadding - 1);
+        this->keys = new unsigned long[this->stride]();
+        this->numTargets = new int[numEntries]();
+        this->targets = new Target[numEntries * maxTargets];
+    }
+
+    /** @brief Entry of [key], -1 if there is none. */
+    inline int Find(unsigned long key) const {
+        unsigned long match =
+            MatchTagInSet(this->keys, this->stride, this->numEntries, key) &
+            this->valid;
+        return (match == 0) ? -1 : __builtin_ctzl(match);
+    }
+
+    /** @brief Mask of the free entries. */
+    inline unsigned long Free() const {
+        return ~this->valid & ((this->numEntries == MSHR_FILE_MAX_ENTRIES)
+                                   ? ~0UL
+                                   : (1UL << this->numEntries) - 1);
+    }
+
+    /** @brief Takes the first free entry for [key], there must be one. */
+    inline int Take(unsigned long key) {
+        int entry = __builtin_ctzl(this->Free());
+        this->keys[entry] = key;
+        this->valid |= 1UL << entry;
+        this->numTargets[entry] = 0;
+        return entry;
+    }
+
+    inline bool IsFull(int entry) const {
+        return this->numTargets[entry] == this->maxTargets;
+    }
+
+    /** @brief Merges [target] in [entry], which must not be full. */
+    inline void AddTarget(int entry, const Target* target) {
+        this->targets[entry * this->maxTargets + this->numTargets[entry]] =
+            *target;
+        ++this->numTargets[entry];
+    }
+
+    inline Target* GetTargets(int entry) {
+        return &this->targets[entry * this->maxTargets];
+    }
+    inline int GetNumTargets(int entry) const {
+        return this->numTargets[entry];
+    }
+
+    inline void Release(int entry) { this->valid &= ~(1UL << entry); }
+
+    inline ~MshrFile() {
+        delete[] this->keys;
+        delete[] this->numTargets;
+        delete[] this->targets;
+    }
+};
+
+/**
+ * @brief Items completing latency cycles after being scheduled, up to width
+ * per cycle.
+ * @details Slot (cycle % (latency + 1)) holds the items completing at that
+ * cycle, so scheduling and completing are O(1) and nothing is sorted.
+ */
+template <typename Item>
+class CompletionWheel {
+  private:
+    Item* items;
+    int* occupation;
+    unsigned long numSlots;
+    unsigned long latency;
+    int width;
+
+  public:
+    inline CompletionWheel()
+        : items(NULL), occupation(NULL), numSlots(0), latency(0), width(0) {}
+
+    void Allocate(unsigned long latency, int width) {
+        this->latency = latency;
+        this->numSlots = latency + 1;
+        this->width = width;
+        this->items = new Item[this->numSlots * width];
+        this->occupation = new int[this->numSlots]();
+    }
+
+    /**
+     * @brief Completes [item] latency cycles after [cycle]. At most width
+     * items may be scheduled per cycle.
+     */
+    inline void Schedule(unsigned long cycle, const Item* item) {
+        unsigned long slot = (cycle + this->latency) % this->numSlots;
+        this->items[slot * this->width + this->occupation[slot]] = *item;
+        ++this->occupation[slot];
+    }
+
+    /**
+     * @brief Empties the slot of [cycle].
+     * @return Its items, [count] of them, valid until the next Schedule.
+     */
+    inline Item* Complete(unsigned long cycle, int* count) {
+        unsigned long slot = cycle % this->numSlots;
+        *count = this->occupation[slot];
+        this->occupation[slot] = 0;
+        return &this->items[slot * this->width];
+    }
+
+    inline ~CompletionWheel() {
+        delete[] this->items;
+        delete[] this->occupation;
+    }
+};
+
+#endif  // SINUCA3_UTILS_MSHR_FILE_HPP_
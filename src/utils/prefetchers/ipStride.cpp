@@ -0,0 +1,83 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file ipStride.cpp
+ * @brief Implementation of the IP-indexed stride prefetcher.
+ */
+
+#include "ipStride.hpp"
+
+namespace Prefetchers {
+
+IpStride::IpStride(long lineSize, long degree, long distance,
+                   long tableEntries)
+    : table(NULL),
+      lineBits(__builtin_ctzl(lineSize)),
+      degree(degree),
+      distance(distance) {
+    long numSets = tableEntries / IP_STRIDE_WAYS;
+    if (numSets <= 0 || (numSets & (numSets - 1))) return;
+
+    // Instructions are byte aligned, so there is no offset.
+    this->table = CacheMemory<IpStrideEntry>::fromBits(
+        __builtin_ctzl(numSets), 0, IP_STRIDE_WAYS, "lru");
+}
+
+IpStride::~IpStride() { delete this->table; }
+
+int IpStride::Access(unsigned long line, unsigned long instAddress, bool hit,
+                     unsigned long* candidates) {
+    (void)hit;
+    if (instAddress == 0) return 0;
+
+    line >>= this->lineBits;
+    IpStrideEntry* entry = this->table->ReadForUpdate(instAddress);
+    if (entry == NULL) {
+        IpStrideEntry fresh;
+        fresh.lastLine = line;
+        fresh.stride = 0;
+        fresh.confidence = 0;
+        this->table->Write(instAddress, &fresh);
+        return 0;
+    }
+
+    long stride = (long)(line - entry->lastLine);
+    if (stride == 0) return 0;
+    entry->lastLine = line;
+    if (stride == entry->stride) {
+        if (entry->confidence < IP_STRIDE_MAX_CONFIDENCE) ++entry->confidence;
+    } else {
+        // A single odd access does not make a confident entry forget its
+        // stride.
+        if (entry->confidence > 0) {
+            --entry->confidence;
+        } else {
+            entry->stride = stride;
+        }
+        return 0;
+    }
+    if (entry->confidence < IP_STRIDE_MIN_CONFIDENCE) return 0;
+
+    for (long i = 0; i < this->degree; ++i) {
+        candidates[i] = (line + (this->distance + i) * stride)
+                        << this->lineBits;
+    }
+    return this->degree;
+}
+
+}  // namespace Prefetchers
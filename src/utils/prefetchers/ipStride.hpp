@@ -0,0 +1,68 @@
+#ifndef SINUCA3_IP_STRIDE_PREFETCHER_HPP_
+#define SINUCA3_IP_STRIDE_PREFETCHER_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file ipStride.hpp
+ * @details IP-indexed stride prefetcher (Chen and Baer, 1995). The reference
+ * prediction table is a CacheMemory indexed by the address of the load, and
+ * each entry keeps the last line the load touched, the stride between its
+ * last two accesses and a 2-bit confidence, which strides that repeat
+ * increase and other strides decrease, replacing the stride once it is 0.
+ * Once the stride has repeated twice, so from the fourth access of a load that
+ * keeps a constant stride, each access prefetches degree lines along it,
+ * starting distance strides ahead.
+ */
+
+#include <utils/cache/cacheMemory.hpp>
+#include <utils/prefetchers/prefetcher.hpp>
+
+namespace Prefetchers {
+
+struct IpStrideEntry {
+    unsigned long lastLine;
+    long stride; /**< In lines. */
+    int confidence;
+};
+
+static const int IP_STRIDE_WAYS = 4;
+static const int IP_STRIDE_MAX_CONFIDENCE = 3;
+/** @brief To start prefetching, a new stride starts at 0 and repeats add 1. */
+static const int IP_STRIDE_MIN_CONFIDENCE = 2;
+
+class IpStride : public Prefetcher {
+  public:
+    /** @brief Use IsValid to check the table could be created. */
+    IpStride(long lineSize, long degree, long distance, long tableEntries);
+    virtual ~IpStride();
+    virtual int Access(unsigned long line, unsigned long instAddress, bool hit,
+                       unsigned long* candidates);
+
+    inline bool IsValid() const { return this->table != NULL; }
+
+  private:
+    CacheMemory<IpStrideEntry>* table;
+    int lineBits;
+    long degree;
+    long distance;
+};
+
+}  // namespace Prefetchers
+
+#endif  // SINUCA3_IP_STRIDE_PREFETCHER_HPP_
@@ -0,0 +1,41 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file nextLine.cpp
+ * @brief Implementation of the next-line prefetcher.
+ */
+
+#include "nextLine.hpp"
+
+namespace Prefetchers {
+
+NextLine::NextLine(long lineSize, long degree, long distance)
+    : lineSize(lineSize), degree(degree), distance(distance) {}
+
+int NextLine::Access(unsigned long line, unsigned long instAddress, bool hit,
+                     unsigned long* candidates) {
+    (void)instAddress;
+    if (hit) return 0;
+
+    for (long i = 0; i < this->degree; ++i) {
+        candidates[i] = line + (this->distance + i) * this->lineSize;
+    }
+    return this->degree;
+}
+
+}  // namespace Prefetchers
@@ -0,0 +1,44 @@
+#ifndef SINUCA3_NEXT_LINE_PREFETCHER_HPP_
+#define SINUCA3_NEXT_LINE_PREFETCHER_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file nextLine.hpp
+ * @details Next-line prefetcher: each miss fetches the lines that follow it.
+ */
+
+#include <utils/prefetchers/prefetcher.hpp>
+
+namespace Prefetchers {
+
+class NextLine : public Prefetcher {
+  public:
+    NextLine(long lineSize, long degree, long distance);
+    virtual int Access(unsigned long line, unsigned long instAddress, bool hit,
+                       unsigned long* candidates);
+
+  private:
+    long lineSize;
+    long degree;
+    long distance;
+};
+
+}  // namespace Prefetchers
+
+#endif  // SINUCA3_NEXT_LINE_PREFETCHER_HPP_
@@ -0,0 +1,108 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file prefetcher.cpp
+ * @brief Creation of the prefetchers by name.
+ */
+
+#include "prefetcher.hpp"
+
+#include <cstring>
+#include <utils/prefetchers/ipStride.hpp>
+#include <utils/prefetchers/nextLine.hpp>
+#include <utils/prefetchers/stream.hpp>
+
+Prefetcher* CreatePrefetcher(const char* name, long lineSize, long degree,
+                             long distance, long tableEntries) {
+    if (lineSize <= 0 || (lineSize & (lineSize - 1))) return NULL;
+    if (degree <= 0 || degree > PREFETCHER_MAX_DEGREE) return NULL;
+    if (distance <= 0 || tableEntries <= 0) return NULL;
+
+    if (strcmp(name, "nextline") == 0) {
+        return new Prefetchers::NextLine(lineSize, degree, distance);
+    }
+    if (strcmp(name, "ipstride") == 0) {
+        Prefetchers::IpStride* prefetcher = new Prefetchers::IpStride(
+            lineSize, degree, distance, tableEntries);
+        if (prefetcher->IsValid()) return prefetcher;
+        delete prefetcher;
+        return NULL;
+    }
+    if (strcmp(name, "stream") == 0) {
+        return new Prefetchers::Stream(lineSize, degree, distance,
+                                       tableEntries);
+    }
+
+    return NULL;
+}
+
+#ifndef NDEBUG
+
+int TestPrefetchers() {
+    unsigned long candidates[PREFETCHER_MAX_DEGREE];
+
+    // Next-line only reacts to misses.
+    Prefetcher* nextLine = CreatePrefetcher("nextline", 64, 2, 1, 1);
+    if (nextLine == NULL) return 1;
+    if (nextLine->Access(0x1000, 0, true, candidates) != 0) return 2;
+    if (nextLine->Access(0x1000, 0, false, candidates) != 2) return 3;
+    if (candidates[0] != 0x1040 || candidates[1] != 0x1080) return 4;
+    delete nextLine;
+
+    // Two loads with their own strides, interleaved: each one is predicted
+    // from its fourth access, after its stride repeats twice.
+    Prefetcher* stride = CreatePrefetcher("ipstride", 64, 1, 2, 256);
+    if (stride == NULL) return 11;
+    for (unsigned long i = 0; i < 5; ++i) {
+        int expected = (i >= 3) ? 1 : 0;
+        int a = stride->Access(0x10000 + i * 0x100, 0x400000, false,
+                               candidates);
+        if (a != expected) return 12;
+        if (a == 1 && candidates[0] != 0x10000 + (i + 2) * 0x100) return 12;
+        int b = stride->Access(0x80000 - i * 0x40, 0x400010, false,
+                               candidates);
+        if (b != expected) return 12;
+        if (b == 1 && candidates[0] != 0x80000 - (i + 2) * 0x40) return 12;
+    }
+    // Unknown loads are not tracked.
+    if (stride->Access(0x10400, 0, false, candidates) != 0) return 13;
+    delete stride;
+
+    if (CreatePrefetcher("ipstride", 64, 1, 1, 3) != NULL) return 14;
+    if (CreatePrefetcher("nope", 64, 1, 1, 16) != NULL) return 15;
+
+    // A descending stream is confirmed on its third line and then kept
+    // distance lines ahead.
+    Prefetcher* stream = CreatePrefetcher("stream", 64, 4, 4, 4);
+    if (stream == NULL) return 21;
+    if (stream->Access(0x2000, 0, false, candidates) != 0) return 22;
+    if (stream->Access(0x1fc0, 0, false, candidates) != 0) return 23;
+    if (stream->Access(0x1f80, 0, false, candidates) != 4) return 24;
+    if (candidates[0] != 0x1f40 || candidates[3] != 0x1e80) return 25;
+    if (stream->Access(0x1f40, 0, false, candidates) != 1) return 26;
+    if (candidates[0] != 0x1e40) return 27;
+    // Hits far from any stream do not start a new one.
+    if (stream->Access(0x9000, 0, true, candidates) != 0) return 28;
+    if (stream->Access(0x9040, 0, true, candidates) != 0) return 29;
+    if (stream->Access(0x9080, 0, true, candidates) != 0) return 30;
+    delete stream;
+
+    return 0;
+}
+
+#endif
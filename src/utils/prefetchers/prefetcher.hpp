@@ -0,0 +1,67 @@
+#ifndef SINUCA3_PREFETCHER_HPP_
+#define SINUCA3_PREFETCHER_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file prefetcher.hpp
+ * @details Interface of the hardware prefetchers a Cache can host. A
+ * prefetcher sees the demand accesses of the cache and proposes lines to
+ * fetch before they are asked for; the cache filters the ones it already has
+ * or is already fetching.
+ */
+
+#include <sinuca3.hpp>
+
+/** @brief Upper limit of the candidates of a single access. */
+static const int PREFETCHER_MAX_DEGREE = 16;
+
+class Prefetcher {
+  public:
+    virtual ~Prefetcher() {};
+
+    /**
+     * @brief Trains on a demand access and proposes lines to prefetch.
+     * @param line Address of the line accessed.
+     * @param instAddress Address of the load or store, 0 if unknown.
+     * @param hit False on misses and on the first hit to a prefetched line, so
+     * the prefetchers keep running ahead of the streams they cover.
+     * @param candidates Receives up to PREFETCHER_MAX_DEGREE line addresses.
+     * @return The number of candidates.
+     */
+    virtual int Access(unsigned long line, unsigned long instAddress, bool hit,
+                       unsigned long* candidates) = 0;
+};
+
+/**
+ * @brief Creates the prefetcher [name]: nextline, ipstride or stream.
+ * @param lineSize Bytes per line, a power of two.
+ * @param degree Lines proposed per access, up to PREFETCHER_MAX_DEGREE.
+ * @param distance How many lines ahead the prefetches go.
+ * @param tableEntries Entries of the prefetcher tables, a power of two for
+ * ipstride.
+ * @return NULL if the name or the parameters are invalid.
+ */
+Prefetcher* CreatePrefetcher(const char* name, long lineSize, long degree,
+                             long distance, long tableEntries);
+
+#ifndef NDEBUG
+int TestPrefetchers();
+#endif
+
+#endif  // SINUCA3_PREFETCHER_HPP_
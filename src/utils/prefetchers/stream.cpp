@@ -0,0 +1,110 @@
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file stream.cpp
+ * @brief Implementation of the stream prefetcher.
+ */
+
+#include "stream.hpp"
+
+namespace Prefetchers {
+
+Stream::Stream(long lineSize, long degree, long distance, long numTrackers)
+    : numTrackers(numTrackers),
+      lineBits(__builtin_ctzl(lineSize)),
+      degree(degree),
+      distance(distance),
+      accesses(0) {
+    this->trackers = new StreamTracker[numTrackers];
+    for (long i = 0; i < numTrackers; ++i) this->trackers[i].valid = false;
+}
+
+Stream::~Stream() { delete[] this->trackers; }
+
+StreamTracker* Stream::Find(unsigned long line) {
+    for (long i = 0; i < this->numTrackers; ++i) {
+        StreamTracker* tracker = &this->trackers[i];
+        if (!tracker->valid) continue;
+        long delta = (long)(line - tracker->lastLine);
+        if (delta <= this->distance && delta >= -this->distance) {
+            return tracker;
+        }
+    }
+    return NULL;
+}
+
+StreamTracker* Stream::Allocate(unsigned long line) {
+    StreamTracker* victim = &this->trackers[0];
+    for (long i = 0; i < this->numTrackers; ++i) {
+        if (!this->trackers[i].valid) {
+            victim = &this->trackers[i];
+            break;
+        }
+        if (this->trackers[i].lastUse < victim->lastUse) {
+            victim = &this->trackers[i];
+        }
+    }
+    victim->lastLine = line;
+    victim->nextPrefetch = line;
+    victim->direction = 0;
+    victim->confidence = 0;
+    victim->valid = true;
+    return victim;
+}
+
+int Stream::Access(unsigned long line, unsigned long instAddress, bool hit,
+                   unsigned long* candidates) {
+    (void)instAddress;
+    line >>= this->lineBits;
+    ++this->accesses;
+
+    StreamTracker* tracker = this->Find(line);
+    if (tracker == NULL) {
+        if (!hit) this->Allocate(line)->lastUse = this->accesses;
+        return 0;
+    }
+    tracker->lastUse = this->accesses;
+
+    long delta = (long)(line - tracker->lastLine);
+    if (delta == 0) return 0;
+    int direction = (delta > 0) ? 1 : -1;
+    tracker->lastLine = line;
+    if (direction == tracker->direction) {
+        if (tracker->confidence < STREAM_MAX_CONFIDENCE) ++tracker->confidence;
+    } else {
+        tracker->direction = direction;
+        tracker->confidence = 1;
+        tracker->nextPrefetch = line + direction;
+    }
+    if (tracker->confidence < STREAM_MIN_CONFIDENCE) return 0;
+
+    // Picks up after the last line prefetched, unless the access overtook it.
+    long ahead = (long)(tracker->nextPrefetch - line) * direction;
+    if (ahead <= 0) tracker->nextPrefetch = line + direction;
+
+    int count = 0;
+    while (count < this->degree &&
+           (long)(tracker->nextPrefetch - line) * direction <= this->distance) {
+        candidates[count] = tracker->nextPrefetch << this->lineBits;
+        tracker->nextPrefetch += direction;
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace Prefetchers
@@ -0,0 +1,67 @@
+#ifndef SINUCA3_STREAM_PREFETCHER_HPP_
+#define SINUCA3_STREAM_PREFETCHER_HPP_
+
+//
+// Copyright (C) 2025  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file stream.hpp
+ * @details Stream prefetcher, in the style of the IBM POWER ones. A miss
+ * starts tracking a stream, and accesses within distance lines of where a
+ * tracked stream last was train its direction. Once a direction is confirmed,
+ * the stream prefetches up to distance lines ahead of the access, at most
+ * degree new lines per access. Trackers are replaced in LRU order.
+ */
+
+#include <utils/prefetchers/prefetcher.hpp>
+
+namespace Prefetchers {
+
+struct StreamTracker {
+    unsigned long lastLine;     /**< In lines, not bytes. */
+    unsigned long nextPrefetch; /**< First line not prefetched yet. */
+    unsigned long lastUse;
+    int direction; /**< 1, -1 or 0 when unknown. */
+    int confidence;
+    bool valid;
+};
+
+static const int STREAM_MAX_CONFIDENCE = 3;
+static const int STREAM_MIN_CONFIDENCE = 2; /**< To start prefetching. */
+
+class Stream : public Prefetcher {
+  public:
+    Stream(long lineSize, long degree, long distance, long numTrackers);
+    virtual ~Stream();
+    virtual int Access(unsigned long line, unsigned long instAddress, bool hit,
+                       unsigned long* candidates);
+
+  private:
+    StreamTracker* trackers;
+    long numTrackers;
+    int lineBits;
+    long degree;
+    long distance;
+    unsigned long accesses;
+
+    StreamTracker* Find(unsigned long line);
+    StreamTracker* Allocate(unsigned long line);
+};
+
+}  // namespace Prefetchers
+
+#endif  // SINUCA3_STREAM_PREFETCHER_HPP_
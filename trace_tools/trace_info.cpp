@@ -0,0 +1,548 @@
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file trace_info.cpp
+ * @brief Offline inspection of SiNUCA3 traces.
+ * @details Prints the instruction mix, the hottest basic blocks, the memory
+ * footprint and the per-thread instruction counts of a trace without running a
+ * simulation. The static trace is loaded once and every thread stream is then
+ * scanned by a pool of workers, so threads are processed in parallel. Works
+ * with both per-thread trace files and containers.
+ *
+ * Usage: sinuca3-traceinfo <trace dir> <image name> [-j jobs] [-t top]
+ */
+
+#include <pthread.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "engine/default_packets.hpp"
+#include "tracer/sinuca/file_handler.hpp"
+#include "tracer/sinuca/utils/container_trace_reader.hpp"
+#include "tracer/sinuca/utils/dynamic_trace_reader.hpp"
+#include "tracer/sinuca/utils/memory_trace_reader.hpp"
+#include "tracer/sinuca/utils/static_trace_reader.hpp"
+#include "utils/logging.hpp"
+
+extern "C" {
+#include <unistd.h>
+}
+
+const unsigned long LINE_SHIFT = 6;  /**<64B cache lines. */
+const unsigned long PAGE_SHIFT = 12; /**<4KiB pages. */
+const int DEFAULT_TOP = 10;
+
+const char* const BRANCH_NAMES[] = {"none",    "syscall", "call", "sysret",
+                                    "ret",     "uncond",  "cond"};
+const int NUMBER_OF_BRANCH_TYPES = sizeof(BRANCH_NAMES) / sizeof(*BRANCH_NAMES);
+
+enum OpClass {
+    OpClassAlu,
+    OpClassLoad,
+    OpClassStore,
+    OpClassLoadStore,
+    OpClassAtomic,
+    OpClassPrefetch,
+    OpClassBranch,
+    NUMBER_OF_OP_CLASSES
+};
+const char* const OP_CLASS_NAMES[] = {"alu/other",  "load",     "store",
+                                      "load+store", "atomic",   "prefetch",
+                                      "branch"};
+
+/**
+ * @brief Open addressing set of addresses. Keys are stored plus one so zero
+ * marks an empty slot.
+ */
+class AddressSet {
+  private:
+    unsigned long* table;
+    unsigned long capacity; /**<Always a power of 2. */
+    unsigned long size;
+
+    inline unsigned long Slot(unsigned long key) {
+        key *= 0x9e3779b97f4a7c15UL;
+        return (key ^ (key >> 29)) & (this->capacity - 1);
+    }
+    inline int Grow() {
+        unsigned long* newTable =
+            (unsigned long*)calloc(this->capacity << 1, sizeof(*table));
+        if (newTable == NULL) {
+            SINUCA3_ERROR_PRINTF("Failed to alloc address set!\n");
+            return 1;
+        }
+        unsigned long* oldTable = this->table;
+        unsigned long oldCapacity = this->capacity;
+        this->table = newTable;
+        this->capacity <<= 1;
+        this->size = 0;
+        for (unsigned long i = 0; i < oldCapacity; ++i) {
+            if (oldTable[i]) this->Insert(oldTable[i] - 1);
+        }
+        free(oldTable);
+        return 0;
+    }
+
+  public:
+    inline AddressSet() : capacity(1024), size(0) {
+        this->table = (unsigned long*)calloc(this->capacity, sizeof(*table));
+        if (this->table == NULL) {
+            SINUCA3_ERROR_PRINTF("Failed to alloc address set!\n");
+        }
+    }
+    inline ~AddressSet() { free(this->table); }
+
+    /** @returns 1 if the set failed to grow, 0 otherwise. */
+    inline int Insert(unsigned long key) {
+        if (this->table == NULL) return 1;
+        unsigned long slot = this->Slot(key);
+        while (this->table[slot]) {
+            if (this->table[slot] == key + 1) return 0;
+            slot = (slot + 1) & (this->capacity - 1);
+        }
+        this->table[slot] = key + 1;
+        if (++this->size * 2 > this->capacity) return this->Grow();
+        return 0;
+    }
+    /** @returns 1 if the set failed to grow, 0 otherwise. */
+    inline int Merge(const AddressSet* other) {
+        for (unsigned long i = 0; i < other->capacity; ++i) {
+            if (other->table[i] && this->Insert(other->table[i] - 1)) return 1;
+        }
+        return 0;
+    }
+    inline unsigned long GetSize() const { return this->size; }
+};
+
+/** @brief Static trace in a form indexed by basic block. */
+struct StaticInfo {
+    StaticInstructionInfo* pool;
+    StaticInstructionInfo** bbls;
+    int* bblSizes;
+    unsigned long bblCount;
+    unsigned long instCount;
+    int threadCount;
+};
+
+/** @brief Results of scanning the streams of a single thread. */
+struct ThreadInfo {
+    unsigned long* bblExecutions;
+    unsigned long instructions;
+    unsigned long loads;
+    unsigned long stores;
+    unsigned long threadEvents;
+    unsigned long expectedInstructions; /**<As recorded in the header. */
+    AddressSet lines;
+    AddressSet pages;
+    int failed;
+};
+
+/** @brief State shared by the workers. */
+struct Job {
+    const StaticInfo* info;
+    ThreadInfo* threads;
+    ContainerTraceReader* container;
+    const char* sourceDir;
+    const char* imageName;
+    volatile int nextThread;
+};
+
+int LoadStaticInfo(StaticTraceReader* reader, StaticInfo* info) {
+    info->bblCount = reader->GetTotalBasicBlocks();
+    info->instCount = reader->GetTotalInstInStaticTrace();
+    info->threadCount = reader->GetNumThreads();
+    info->pool = new StaticInstructionInfo[info->instCount];
+    info->bbls = new StaticInstructionInfo*[info->bblCount];
+    info->bblSizes = new int[info->bblCount];
+
+    unsigned long poolOffset = 0;
+    for (unsigned long bbl = 0; bbl < info->bblCount; ++bbl) {
+        if (reader->ReadStaticRecordFromFile() ||
+            reader->GetStaticRecordType() != StaticRecordBasicBlockSize) {
+            SINUCA3_ERROR_PRINTF("Expected size of basic block [%lu]\n", bbl);
+            return 1;
+        }
+        int size = reader->GetBasicBlockSize();
+        if (poolOffset + size > info->instCount) {
+            SINUCA3_ERROR_PRINTF("Static trace has more inst than expected\n");
+            return 1;
+        }
+        info->bblSizes[bbl] = size;
+        info->bbls[bbl] = &info->pool[poolOffset];
+        poolOffset += size;
+        for (int i = 0; i < size; ++i) {
+            if (reader->ReadStaticRecordFromFile() ||
+                reader->GetStaticRecordType() != StaticRecordInstruction) {
+                SINUCA3_ERROR_PRINTF("Expected instruction in bbl [%lu]\n",
+                                     bbl);
+                return 1;
+            }
+            reader->TranslateRawInstructionToSinucaInst(&info->bbls[bbl][i]);
+        }
+    }
+
+    return 0;
+}
+
+int ScanThread(Job* job, int tid) {
+    DynamicTraceReader dynFile;
+    MemoryTraceReader memFile;
+    ThreadInfo* thread = &job->threads[tid];
+    const StaticInfo* info = job->info;
+
+    int failed = (job->container)
+                     ? (dynFile.OpenStream(job->container, tid) ||
+                        memFile.OpenStream(job->container, tid))
+                     : (dynFile.OpenFile(job->sourceDir, job->imageName, tid) ||
+                        memFile.OpenFile(job->sourceDir, job->imageName, tid));
+    if (failed) return 1;
+
+    thread->expectedInstructions = dynFile.GetTotalExecutedInstructions();
+    thread->bblExecutions = new unsigned long[info->bblCount];
+    memset(thread->bblExecutions, 0,
+           sizeof(*thread->bblExecutions) * info->bblCount);
+
+    InstructionPacket packet;
+    while (!dynFile.ReadDynamicRecord()) {
+        if (dynFile.GetRecordType() == DynamicRecordThreadEvent) {
+            ++thread->threadEvents;
+            continue;
+        }
+        unsigned int bbl = dynFile.GetBasicBlockIdentifier();
+        if (bbl >= info->bblCount) {
+            SINUCA3_ERROR_PRINTF("Thread [%d] executed unknown bbl [%u]\n", tid,
+                                 bbl);
+            return 1;
+        }
+        ++thread->bblExecutions[bbl];
+        thread->instructions += info->bblSizes[bbl];
+
+        for (int i = 0; i < info->bblSizes[bbl]; ++i) {
+            const StaticInstructionInfo* inst = &info->bbls[bbl][i];
+            if (!inst->instReadsMemory && !inst->instWritesMemory) continue;
+
+            packet.dynamicInfo.numReadings = 0;
+            packet.dynamicInfo.numWritings = 0;
+            if (memFile.ReadMemoryOperations(&packet)) {
+                SINUCA3_ERROR_PRINTF("Thread [%d] memory trace is short\n",
+                                     tid);
+                return 1;
+            }
+            for (unsigned int r = 0; r < packet.dynamicInfo.numReadings; ++r) {
+                unsigned long addr = packet.dynamicInfo.readsAddr[r];
+                if (thread->lines.Insert(addr >> LINE_SHIFT) ||
+                    thread->pages.Insert(addr >> PAGE_SHIFT)) {
+                    return 1;
+                }
+            }
+            for (unsigned int w = 0; w < packet.dynamicInfo.numWritings; ++w) {
+                unsigned long addr = packet.dynamicInfo.writesAddr[w];
+                if (thread->lines.Insert(addr >> LINE_SHIFT) ||
+                    thread->pages.Insert(addr >> PAGE_SHIFT)) {
+                    return 1;
+                }
+            }
+            thread->loads += packet.dynamicInfo.numReadings;
+            thread->stores += packet.dynamicInfo.numWritings;
+        }
+    }
+    if (!dynFile.HasReachedEnd()) return 1;
+
+    return 0;
+}
+
+void* Worker(void* arg) {
+    Job* job = (Job*)arg;
+
+    for (;;) {
+        int tid = __sync_fetch_and_add(&job->nextThread, 1);
+        if (tid >= job->info->threadCount) break;
+        job->threads[tid].failed = ScanThread(job, tid);
+    }
+
+    return NULL;
+}
+
+OpClass ClassifyInstruction(const StaticInstructionInfo* inst) {
+    if (inst->branchType != BranchNone) return OpClassBranch;
+    if (inst->instPerformsAtomicUpdate) return OpClassAtomic;
+    if (inst->isPrefetchHintInst) return OpClassPrefetch;
+    if (inst->instReadsMemory && inst->instWritesMemory) {
+        return OpClassLoadStore;
+    }
+    if (inst->instReadsMemory) return OpClassLoad;
+    if (inst->instWritesMemory) return OpClassStore;
+    return OpClassAlu;
+}
+
+struct MnemonicCount {
+    const char* mnemonic;
+    unsigned long count;
+};
+
+int CompareMnemonics(const void* a, const void* b) {
+    return strcmp(((const MnemonicCount*)a)->mnemonic,
+                  ((const MnemonicCount*)b)->mnemonic);
+}
+
+int CompareCounts(const void* a, const void* b) {
+    unsigned long countA = ((const MnemonicCount*)a)->count;
+    unsigned long countB = ((const MnemonicCount*)b)->count;
+    return (countA < countB) - (countA > countB);
+}
+
+inline double Percent(unsigned long part, unsigned long total) {
+    return (total == 0) ? 0.0 : 100.0 * part / total;
+}
+
+void PrintInstructionMix(const StaticInfo* info, const unsigned long* bblExec,
+                         unsigned long total, int top) {
+    unsigned long branchCount[NUMBER_OF_BRANCH_TYPES] = {0};
+    unsigned long classCount[NUMBER_OF_OP_CLASSES] = {0};
+    MnemonicCount* mnemonics = new MnemonicCount[info->instCount];
+    unsigned long numberOfMnemonics = 0;
+
+    for (unsigned long bbl = 0; bbl < info->bblCount; ++bbl) {
+        for (int i = 0; i < info->bblSizes[bbl]; ++i) {
+            const StaticInstructionInfo* inst = &info->bbls[bbl][i];
+            branchCount[inst->branchType] += bblExec[bbl];
+            classCount[ClassifyInstruction(inst)] += bblExec[bbl];
+            if (bblExec[bbl] == 0) continue;
+            mnemonics[numberOfMnemonics].mnemonic = inst->instMnemonic;
+            mnemonics[numberOfMnemonics].count = bblExec[bbl];
+            ++numberOfMnemonics;
+        }
+    }
+
+    SINUCA3_LOG_PRINTF("Instruction mix by branch type:\n");
+    for (int i = 0; i < NUMBER_OF_BRANCH_TYPES; ++i) {
+        SINUCA3_LOG_PRINTF("\t%-10s %14lu %6.2f%%\n", BRANCH_NAMES[i],
+                           branchCount[i], Percent(branchCount[i], total));
+    }
+    SINUCA3_LOG_PRINTF("Instruction mix by class:\n");
+    for (int i = 0; i < NUMBER_OF_OP_CLASSES; ++i) {
+        SINUCA3_LOG_PRINTF("\t%-10s %14lu %6.2f%%\n", OP_CLASS_NAMES[i],
+                           classCount[i], Percent(classCount[i], total));
+    }
+
+    /* Sort by mnemonic to merge duplicates, then by count. */
+    qsort(mnemonics, numberOfMnemonics, sizeof(*mnemonics), CompareMnemonics);
+    unsigned long unique = 0;
+    for (unsigned long i = 0; i < numberOfMnemonics; ++i) {
+        if (unique > 0 && !strcmp(mnemonics[unique - 1].mnemonic,
+                                  mnemonics[i].mnemonic)) {
+            mnemonics[unique - 1].count += mnemonics[i].count;
+        } else {
+            mnemonics[unique++] = mnemonics[i];
+        }
+    }
+    qsort(mnemonics, unique, sizeof(*mnemonics), CompareCounts);
+    SINUCA3_LOG_PRINTF("Top %d opcodes of %lu:\n", top, unique);
+    for (unsigned long i = 0; i < unique && i < (unsigned long)top; ++i) {
+        SINUCA3_LOG_PRINTF("\t%-16s %14lu %6.2f%%\n", mnemonics[i].mnemonic,
+                           mnemonics[i].count,
+                           Percent(mnemonics[i].count, total));
+    }
+
+    delete[] mnemonics;
+}
+
+struct BasicBlockCount {
+    unsigned long bbl;
+    unsigned long instructions;
+};
+
+int CompareBasicBlocks(const void* a, const void* b) {
+    unsigned long countA = ((const BasicBlockCount*)a)->instructions;
+    unsigned long countB = ((const BasicBlockCount*)b)->instructions;
+    return (countA < countB) - (countA > countB);
+}
+
+void PrintHotness(const StaticInfo* info, const unsigned long* bblExec,
+                  unsigned long total, int top) {
+    BasicBlockCount* bbls = new BasicBlockCount[info->bblCount];
+    unsigned long executed = 0;
+
+    for (unsigned long bbl = 0; bbl < info->bblCount; ++bbl) {
+        bbls[bbl].bbl = bbl;
+        bbls[bbl].instructions = bblExec[bbl] * info->bblSizes[bbl];
+        if (bblExec[bbl]) ++executed;
+    }
+    qsort(bbls, info->bblCount, sizeof(*bbls), CompareBasicBlocks);
+
+    SINUCA3_LOG_PRINTF("Basic blocks executed: %lu of %lu\n", executed,
+                       info->bblCount);
+    SINUCA3_LOG_PRINTF("Top %d basic blocks by instructions:\n", top);
+    for (unsigned long i = 0; i < info->bblCount && i < (unsigned long)top;
+         ++i) {
+        unsigned long bbl = bbls[i].bbl;
+        if (bblExec[bbl] == 0) break;
+        SINUCA3_LOG_PRINTF(
+            "\tbbl %-8lu addr 0x%-14lx size %-4d exec %-12lu %6.2f%%\n", bbl,
+            info->bbls[bbl][0].instAddress, info->bblSizes[bbl], bblExec[bbl],
+            Percent(bbls[i].instructions, total));
+    }
+
+    const int coverages[] = {50, 90, 99};
+    unsigned long covered = 0;
+    unsigned long i = 0;
+    for (unsigned int c = 0; c < sizeof(coverages) / sizeof(*coverages);
+         ++c) {
+        while (i < info->bblCount && covered * 100 < total * coverages[c]) {
+            covered += bbls[i++].instructions;
+        }
+        SINUCA3_LOG_PRINTF("\t%lu basic blocks cover %d%% of instructions\n",
+                           i, coverages[c]);
+    }
+
+    delete[] bbls;
+}
+
+int Usage() {
+    SINUCA3_LOG_PRINTF(
+        "Usage: sinuca3-traceinfo <trace dir> <image name> [-j jobs] "
+        "[-t top]\n"
+        "-j: number of threads scanned in parallel, defaults to the number "
+        "of cpus.\n"
+        "-t: number of entries in the top lists, defaults to %d.\n",
+        DEFAULT_TOP);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) return Usage();
+
+    const char* sourceDir = argv[1];
+    const char* imageName = argv[2];
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int top = DEFAULT_TOP;
+    for (int i = 3; i < argc; ++i) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            jobs = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            top = atoi(argv[++i]);
+        } else {
+            return Usage();
+        }
+    }
+    if (jobs < 1) jobs = 1;
+
+    ContainerTraceReader* container = NULL;
+    StaticTraceReader staticTrace;
+    if (ContainerTraceReader::Exists(sourceDir, imageName)) {
+        container = new ContainerTraceReader;
+        if (container->OpenFile(sourceDir, imageName) ||
+            staticTrace.OpenStream(container)) {
+            return 1;
+        }
+    } else if (staticTrace.OpenFile(sourceDir, imageName)) {
+        return 1;
+    }
+
+    StaticInfo info;
+    if (LoadStaticInfo(&staticTrace, &info)) return 1;
+
+    SINUCA3_LOG_PRINTF("Trace [%s] in [%s]%s\n", imageName, sourceDir,
+                       (container) ? " (container)" : "");
+    SINUCA3_LOG_PRINTF("\tversion %u, target %s, %d threads\n",
+                       staticTrace.GetVersionInt(),
+                       staticTrace.GetTargetString(), info.threadCount);
+    SINUCA3_LOG_PRINTF("\t%lu basic blocks, %lu static instructions\n",
+                       info.bblCount, info.instCount);
+
+    Job job;
+    job.info = &info;
+    job.threads = new ThreadInfo[info.threadCount];
+    job.container = container;
+    job.sourceDir = sourceDir;
+    job.imageName = imageName;
+    job.nextThread = 0;
+    for (int i = 0; i < info.threadCount; ++i) {
+        job.threads[i].bblExecutions = NULL;
+        job.threads[i].instructions = 0;
+        job.threads[i].loads = 0;
+        job.threads[i].stores = 0;
+        job.threads[i].threadEvents = 0;
+        job.threads[i].expectedInstructions = 0;
+        job.threads[i].failed = 0;
+    }
+
+    if (jobs > info.threadCount) jobs = info.threadCount;
+    pthread_t* workers = new pthread_t[jobs];
+    for (long i = 0; i < jobs; ++i) {
+        pthread_create(&workers[i], NULL, Worker, &job);
+    }
+    for (long i = 0; i < jobs; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    delete[] workers;
+
+    unsigned long* bblExec = new unsigned long[info.bblCount];
+    memset(bblExec, 0, sizeof(*bblExec) * info.bblCount);
+    unsigned long total = 0;
+    AddressSet lines;
+    AddressSet pages;
+    int failed = 0;
+
+    SINUCA3_LOG_PRINTF("Per thread:\n");
+    for (int tid = 0; tid < info.threadCount; ++tid) {
+        ThreadInfo* thread = &job.threads[tid];
+        if (thread->failed) {
+            SINUCA3_ERROR_PRINTF("Failed to scan thread [%d]\n", tid);
+            failed = 1;
+        }
+        if (thread->bblExecutions == NULL) continue;
+        SINUCA3_LOG_PRINTF(
+            "\tthread %-3d inst %-14lu loads %-12lu stores %-12lu events "
+            "%-6lu lines %-10lu pages %lu\n",
+            tid, thread->instructions, thread->loads, thread->stores,
+            thread->threadEvents, thread->lines.GetSize(),
+            thread->pages.GetSize());
+        if (thread->instructions != thread->expectedInstructions) {
+            SINUCA3_WARNING_PRINTF(
+                "Thread [%d] header says [%lu] instructions\n", tid,
+                thread->expectedInstructions);
+        }
+        for (unsigned long bbl = 0; bbl < info.bblCount; ++bbl) {
+            bblExec[bbl] += thread->bblExecutions[bbl];
+        }
+        total += thread->instructions;
+        if (lines.Merge(&thread->lines) || pages.Merge(&thread->pages)) {
+            failed = 1;
+        }
+        delete[] thread->bblExecutions;
+    }
+
+    SINUCA3_LOG_PRINTF("Total instructions: %lu\n", total);
+    SINUCA3_LOG_PRINTF("Memory footprint: %lu lines of 64B (%lu KiB), %lu "
+                       "pages of 4KiB (%lu KiB)\n",
+                       lines.GetSize(), lines.GetSize() >> 4, pages.GetSize(),
+                       pages.GetSize() << 2);
+    PrintInstructionMix(&info, bblExec, total, top);
+    PrintHotness(&info, bblExec, total, top);
+
+    delete[] bblExec;
+    delete[] job.threads;
+    delete[] info.pool;
+    delete[] info.bbls;
+    delete[] info.bblSizes;
+    delete container;
+
+    return failed;
+}
@@ -0,0 +1,377 @@
+//
+// Copyright (C) 2024  HiPES - Universidade Federal do Paraná
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file trace_slice.cpp
+ * @brief Extraction of instruction windows from SiNUCA3 traces.
+ * @details Reads a trace (per-thread files or a container) and writes a new,
+ * self-contained trace set holding only the requested windows. A window is
+ * given as [tid:]start:length in dynamic instructions of the thread, or of
+ * every thread when tid is omitted. Windows are aligned to basic blocks: a
+ * basic block is kept when its first instruction falls inside a window.
+ * Thread events are kept only inside windows. Basic blocks never executed in
+ * the windows are pruned from the static trace and the remaining ones are
+ * renumbered, and every header count is recomputed.
+ *
+ * Usage: sinuca3-traceslice <trace dir> <image name> <output dir>
+ *        -w [tid:]start:length [-w ...]
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "engine/default_packets.hpp"
+#include "tracer/sinuca/file_handler.hpp"
+#include "tracer/sinuca/utils/container_trace_reader.hpp"
+#include "tracer/sinuca/utils/dynamic_trace_reader.hpp"
+#include "tracer/sinuca/utils/dynamic_trace_writer.hpp"
+#include "tracer/sinuca/utils/memory_trace_reader.hpp"
+#include "tracer/sinuca/utils/memory_trace_writer.hpp"
+#include "tracer/sinuca/utils/static_trace_reader.hpp"
+#include "tracer/sinuca/utils/static_trace_writer.hpp"
+#include "utils/logging.hpp"
+
+extern "C" {
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+const int MAX_WINDOWS = 256;
+const unsigned int PRUNED_BBL = ~0U;
+
+struct Window {
+    int tid; /**<-1 when the window applies to every thread. */
+    unsigned long start;
+    unsigned long end; /**<Exclusive. */
+};
+
+/** @brief Static trace indexed by basic block, pointing into the reader. */
+struct StaticInfo {
+    const Instruction** instructions;
+    unsigned long* bblStart; /**<First instruction of each bbl. */
+    unsigned long bblCount;
+    unsigned long instCount;
+    int threadCount;
+};
+
+/** @brief Input trace, either a container or a set of files. */
+struct InputTrace {
+    ContainerTraceReader* container;
+    const char* sourceDir;
+    const char* imageName;
+
+    inline int Open(DynamicTraceReader* dynFile, MemoryTraceReader* memFile,
+                    int tid) {
+        if (this->container) {
+            return (dynFile->OpenStream(this->container, tid) ||
+                    memFile->OpenStream(this->container, tid));
+        }
+        return (dynFile->OpenFile(this->sourceDir, this->imageName, tid) ||
+                memFile->OpenFile(this->sourceDir, this->imageName, tid));
+    }
+};
+
+Window windows[MAX_WINDOWS];
+int numberOfWindows = 0;
+
+bool IsInWindow(int tid, unsigned long inst) {
+    for (int i = 0; i < numberOfWindows; ++i) {
+        if (windows[i].tid != -1 && windows[i].tid != tid) continue;
+        if (inst >= windows[i].start && inst < windows[i].end) return true;
+    }
+    return false;
+}
+
+/** @brief First instruction after every window of [tid]. */
+unsigned long GetLastWindowEnd(int tid) {
+    unsigned long end = 0;
+    for (int i = 0; i < numberOfWindows; ++i) {
+        if (windows[i].tid != -1 && windows[i].tid != tid) continue;
+        if (windows[i].end > end) end = windows[i].end;
+    }
+    return end;
+}
+
+int ParseWindow(const char* arg) {
+    if (numberOfWindows == MAX_WINDOWS) {
+        SINUCA3_ERROR_PRINTF("Too many windows, at most %d\n", MAX_WINDOWS);
+        return 1;
+    }
+
+    unsigned long fields[3];
+    int numberOfFields = 0;
+    const char* ptr = arg;
+    while (numberOfFields < 3) {
+        char* end;
+        fields[numberOfFields++] = strtoul(ptr, &end, 0);
+        if (end == ptr) return 1;
+        if (*end == '\0') break;
+        if (*end != ':') return 1;
+        ptr = end + 1;
+    }
+    if (numberOfFields < 2) return 1;
+
+    Window* window = &windows[numberOfWindows++];
+    int first = numberOfFields - 2;
+    window->tid = (numberOfFields == 3) ? (int)fields[0] : -1;
+    window->start = fields[first];
+    window->end = fields[first] + fields[first + 1];
+
+    return 0;
+}
+
+int LoadStaticInfo(StaticTraceReader* reader, StaticInfo* info) {
+    info->bblCount = reader->GetTotalBasicBlocks();
+    info->instCount = reader->GetTotalInstInStaticTrace();
+    info->threadCount = reader->GetNumThreads();
+    info->instructions = new const Instruction*[info->instCount];
+    info->bblStart = new unsigned long[info->bblCount + 1];
+
+    unsigned long inst = 0;
+    for (unsigned long bbl = 0; bbl < info->bblCount; ++bbl) {
+        if (reader->ReadStaticRecordFromFile() ||
+            reader->GetStaticRecordType() != StaticRecordBasicBlockSize) {
+            SINUCA3_ERROR_PRINTF("Expected size of basic block [%lu]\n", bbl);
+            return 1;
+        }
+        int size = reader->GetBasicBlockSize();
+        if (inst + size > info->instCount) {
+            SINUCA3_ERROR_PRINTF("Static trace has more inst than expected\n");
+            return 1;
+        }
+        info->bblStart[bbl] = inst;
+        for (int i = 0; i < size; ++i, ++inst) {
+            if (reader->ReadStaticRecordFromFile() ||
+                reader->GetStaticRecordType() != StaticRecordInstruction) {
+                SINUCA3_ERROR_PRINTF("Expected instruction in bbl [%lu]\n",
+                                     bbl);
+                return 1;
+            }
+            info->instructions[inst] = reader->GetRawInstruction();
+        }
+    }
+    info->bblStart[info->bblCount] = inst;
+
+    return 0;
+}
+
+/** @brief Mark the basic blocks executed inside the windows of [tid]. */
+int MarkBasicBlocks(InputTrace* input, const StaticInfo* info, int tid,
+                    unsigned int* newIds) {
+    DynamicTraceReader dynFile;
+    MemoryTraceReader memFile;
+    if (input->Open(&dynFile, &memFile, tid)) return 1;
+
+    unsigned long inst = 0;
+    unsigned long lastEnd = GetLastWindowEnd(tid);
+    while (inst < lastEnd && !dynFile.ReadDynamicRecord()) {
+        if (dynFile.GetRecordType() != DynamicRecordBasicBlockIdentifier) {
+            continue;
+        }
+        unsigned int bbl = dynFile.GetBasicBlockIdentifier();
+        if (bbl >= info->bblCount) {
+            SINUCA3_ERROR_PRINTF("Thread [%d] executed unknown bbl [%u]\n", tid,
+                                 bbl);
+            return 1;
+        }
+        if (IsInWindow(tid, inst)) newIds[bbl] = 0;
+        inst += info->bblStart[bbl + 1] - info->bblStart[bbl];
+    }
+
+    return 0;
+}
+
+int WriteStaticTrace(StaticTraceReader* reader, const StaticInfo* info,
+                     unsigned int* newIds, const char* outputDir,
+                     const char* imageName) {
+    StaticTraceWriter writer;
+    if (writer.OpenFile(outputDir, imageName)) return 1;
+    writer.SetTargetArch(reader->GetTargetInt());
+    for (int i = 0; i < info->threadCount; ++i) {
+        writer.IncThreadCount();
+    }
+
+    unsigned int kept = 0;
+    for (unsigned long bbl = 0; bbl < info->bblCount; ++bbl) {
+        if (newIds[bbl] == PRUNED_BBL) continue;
+        newIds[bbl] = kept++;
+
+        unsigned long size = info->bblStart[bbl + 1] - info->bblStart[bbl];
+        if (writer.AddBasicBlockSize(size)) return 1;
+        writer.IncBasicBlockCount();
+        for (unsigned long i = info->bblStart[bbl]; i < info->bblStart[bbl + 1];
+             ++i) {
+            if (writer.AddInstruction(info->instructions[i])) return 1;
+            writer.IncStaticInstructionCount();
+        }
+    }
+    SINUCA3_LOG_PRINTF("Kept %u of %lu basic blocks\n", kept, info->bblCount);
+
+    return 0;
+}
+
+int CopyMemoryOperations(MemoryTraceReader* memFile, MemoryTraceWriter* writer,
+                         bool keep) {
+    InstructionPacket packet;
+    packet.dynamicInfo.numReadings = 0;
+    packet.dynamicInfo.numWritings = 0;
+    if (memFile->ReadMemoryOperations(&packet)) return 1;
+    if (!keep) return 0;
+
+    DynamicInstructionInfo* dyn = &packet.dynamicInfo;
+    if (writer->AddNumberOfMemOperations(dyn->numReadings + dyn->numWritings)) {
+        return 1;
+    }
+    for (unsigned int i = 0; i < dyn->numReadings; ++i) {
+        if (writer->AddMemOp(dyn->readsAddr[i], dyn->readsSize[i], true)) {
+            return 1;
+        }
+    }
+    for (unsigned int i = 0; i < dyn->numWritings; ++i) {
+        if (writer->AddMemOp(dyn->writesAddr[i], dyn->writesSize[i], false)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/** @brief Write the windows of [tid] with the renumbered basic blocks. */
+int SliceThread(InputTrace* input, const StaticInfo* info,
+                const unsigned int* newIds, int tid, unsigned char targetArch,
+                const char* outputDir) {
+    DynamicTraceReader dynFile;
+    MemoryTraceReader memFile;
+    if (input->Open(&dynFile, &memFile, tid)) return 1;
+
+    DynamicTraceWriter dynWriter;
+    MemoryTraceWriter memWriter;
+    if (dynWriter.OpenFile(outputDir, input->imageName, tid) ||
+        memWriter.OpenFile(outputDir, input->imageName, tid)) {
+        return 1;
+    }
+    dynWriter.SetTargetArch(targetArch);
+    memWriter.SetTargetArch(targetArch);
+
+    unsigned long inst = 0;
+    unsigned long keptInst = 0;
+    unsigned long lastEnd = GetLastWindowEnd(tid);
+    while (inst < lastEnd && !dynFile.ReadDynamicRecord()) {
+        if (dynFile.GetRecordType() == DynamicRecordThreadEvent) {
+            if (IsInWindow(tid, inst) &&
+                dynWriter.AddThreadEvent(dynFile.GetThreadEvent())) {
+                return 1;
+            }
+            continue;
+        }
+
+        unsigned int bbl = dynFile.GetBasicBlockIdentifier();
+        bool keep = IsInWindow(tid, inst);
+        if (keep && dynWriter.AddBasicBlockId(newIds[bbl])) return 1;
+
+        for (unsigned long i = info->bblStart[bbl]; i < info->bblStart[bbl + 1];
+             ++i) {
+            const Instruction* raw = info->instructions[i];
+            if (!raw->instReadsMemory && !raw->instWritesMemory) continue;
+            if (CopyMemoryOperations(&memFile, &memWriter, keep)) {
+                SINUCA3_ERROR_PRINTF("Thread [%d] memory trace is short\n",
+                                     tid);
+                return 1;
+            }
+        }
+
+        unsigned long size = info->bblStart[bbl + 1] - info->bblStart[bbl];
+        if (keep) keptInst += size;
+        inst += size;
+    }
+    dynWriter.IncExecutedInstructions(keptInst);
+    SINUCA3_LOG_PRINTF("Thread [%d]: kept %lu of the first %lu instructions\n",
+                       tid, keptInst, inst);
+
+    return 0;
+}
+
+int Usage() {
+    SINUCA3_LOG_PRINTF(
+        "Usage: sinuca3-traceslice <trace dir> <image name> <output dir> -w "
+        "[tid:]start:length [-w ...]\n"
+        "-w: instruction window to keep. Without tid it applies to every "
+        "thread. Windows are aligned to basic blocks.\n");
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 6) return Usage();
+
+    InputTrace input;
+    input.container = NULL;
+    input.sourceDir = argv[1];
+    input.imageName = argv[2];
+    const char* outputDir = argv[3];
+    for (int i = 4; i < argc; ++i) {
+        if (strcmp(argv[i], "-w") || i + 1 == argc || ParseWindow(argv[++i])) {
+            return Usage();
+        }
+    }
+    if (!strcmp(input.sourceDir, outputDir)) {
+        SINUCA3_ERROR_PRINTF("Output directory must differ from the input\n");
+        return 1;
+    }
+    if (access(outputDir, F_OK) != 0) {
+        mkdir(outputDir, S_IRWXU | S_IRWXG | S_IROTH);
+    }
+
+    StaticTraceReader staticTrace;
+    if (ContainerTraceReader::Exists(input.sourceDir, input.imageName)) {
+        input.container = new ContainerTraceReader;
+        if (input.container->OpenFile(input.sourceDir, input.imageName) ||
+            staticTrace.OpenStream(input.container)) {
+            return 1;
+        }
+    } else if (staticTrace.OpenFile(input.sourceDir, input.imageName)) {
+        return 1;
+    }
+
+    StaticInfo info;
+    if (LoadStaticInfo(&staticTrace, &info)) return 1;
+
+    unsigned int* newIds = new unsigned int[info.bblCount];
+    for (unsigned long bbl = 0; bbl < info.bblCount; ++bbl) {
+        newIds[bbl] = PRUNED_BBL;
+    }
+
+    int failed = 0;
+    for (int tid = 0; tid < info.threadCount && !failed; ++tid) {
+        failed = MarkBasicBlocks(&input, &info, tid, newIds);
+    }
+    if (!failed) {
+        failed = WriteStaticTrace(&staticTrace, &info, newIds, outputDir,
+                                  input.imageName);
+    }
+    for (int tid = 0; tid < info.threadCount && !failed; ++tid) {
+        failed = SliceThread(&input, &info, newIds, tid,
+                             staticTrace.GetTargetInt(), outputDir);
+    }
+    if (failed) SINUCA3_ERROR_PRINTF("Failed to slice trace\n");
+
+    delete[] newIds;
+    delete[] info.instructions;
+    delete[] info.bblStart;
+    delete input.container;
+
+    return failed;
+}
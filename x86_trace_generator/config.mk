@@ -1,8 +1,9 @@
 SINUCA_TRACER_DIR = ../src/tracer/sinuca/
-PINTOOL_UTILS_DIR = ./utils/
+PINTOOL_UTILS_DIR = $(SINUCA_TRACER_DIR)utils/
 TOOL_ROOTS = sinuca3_pintool
 FILE_HANDLER = file_handler
-PINTOOL_UTILS = dynamic_trace_writer \
+PINTOOL_UTILS = container_trace_writer \
+				dynamic_trace_writer \
 				memory_trace_writer \
 				static_trace_writer
 OBJ_DEPS = $(OBJDIR)$(TOOL_ROOTS)$(OBJ_SUFFIX) \
@@ -41,10 +41,11 @@
 #include "engine/default_packets.hpp"
 #include "pin.H"
 #include "tracer/sinuca/file_handler.hpp"
-#include "utils/dynamic_trace_writer.hpp"
+#include "tracer/sinuca/utils/container_trace_writer.hpp"
+#include "tracer/sinuca/utils/dynamic_trace_writer.hpp"
+#include "tracer/sinuca/utils/memory_trace_writer.hpp"
+#include "tracer/sinuca/utils/static_trace_writer.hpp"
 #include "utils/logging.hpp"
-#include "utils/memory_trace_writer.hpp"
-#include "utils/static_trace_writer.hpp"
 
 extern "C" {
 #include <sys/stat.h>
@@ -63,6 +64,11 @@ bool isInstrumentating;
  * blocks that are eventually reached during execution.
  */
 StaticTraceWriter* staticTrace;
+/**
+ * @brief When the container output is enabled, every trace is written as a
+ * stream of this single file instead of a file of its own.
+ */
+ContainerTraceWriter* container = NULL;
 
 /** @brief Directory where the trace files will be saved. */
 const char* traceDir = NULL;
@@ -85,6 +91,8 @@ KNOB<BOOL> knobForceInstrumentation(KNOB_MODE_WRITEONCE, "pintool", "f", "0",
                                     "Force instrumentation.");
 KNOB<UINT32> knobNumberOfInstructions(KNOB_MODE_WRITEONCE, "pintool", "n", "-1",
                                       "Set maximum of instructions.");
+KNOB<BOOL> knobContainer(KNOB_MODE_WRITEONCE, "pintool", "c", "0",
+                         "Write all traces to a single container file.");
 KNOB<std::string> KnobIntrinsics(KNOB_MODE_APPEND, "pintool", "i", "",
                                  "Intrinsic instructions in the format "
                                  "name:readregs:writeregs");
@@ -118,6 +126,7 @@ int Usage() {
         "------------------------------------------------------------"
         "-f: force instrumentation even when no blocks are defined.\n"
         "-o: output directory.\n"
+        "-c: write all traces to a single container file.\n"
         "-n: set maximum number of instructions to append to trace.\n"
         "-i: set intrinsics.\n");
 
@@ -174,13 +183,24 @@ VOID OnThreadStart(THREADID tid, CONTEXT* ctxt, INT32 flags, VOID* v) {
     }
 
     /* Create tracer files */
-    if (threadData->dynamicTrace.OpenFile(traceDir, imageName, tid)) {
-        SINUCA3_ERROR_PRINTF(
-            "[OnThreadStart] Failed to open dynamic trace file\n");
-    }
-    if (threadData->memoryTrace.OpenFile(traceDir, imageName, tid)) {
-        SINUCA3_ERROR_PRINTF(
-            "[OnThreadStart] Failed to open memory trace file\n");
+    if (container) {
+        if (threadData->dynamicTrace.OpenStream(container, tid)) {
+            SINUCA3_ERROR_PRINTF(
+                "[OnThreadStart] Failed to open dynamic trace stream\n");
+        }
+        if (threadData->memoryTrace.OpenStream(container, tid)) {
+            SINUCA3_ERROR_PRINTF(
+                "[OnThreadStart] Failed to open memory trace stream\n");
+        }
+    } else {
+        if (threadData->dynamicTrace.OpenFile(traceDir, imageName, tid)) {
+            SINUCA3_ERROR_PRINTF(
+                "[OnThreadStart] Failed to open dynamic trace file\n");
+        }
+        if (threadData->memoryTrace.OpenFile(traceDir, imageName, tid)) {
+            SINUCA3_ERROR_PRINTF(
+                "[OnThreadStart] Failed to open memory trace file\n");
+        }
     }
 
     PIN_GetLock(&threadAnalysisLock, tid);
@@ -729,7 +749,19 @@ VOID OnImageLoad(IMG img, VOID* ptr) {
             "[OnImageLoad] Failed to create StaticTraceWriter.\n");
         return;
     }
-    if (staticTrace->OpenFile(traceDir, imageName)) {
+    if (knobContainer.Value()) {
+        container = new ContainerTraceWriter();
+        if (container->OpenFile(traceDir, imageName)) {
+            SINUCA3_DEBUG_PRINTF(
+                "[OnImageLoad] Failed to create container file.\n");
+            return;
+        }
+        if (staticTrace->OpenStream(container)) {
+            SINUCA3_DEBUG_PRINTF(
+                "[OnImageLoad] Failed to create static trace stream.\n");
+            return;
+        }
+    } else if (staticTrace->OpenFile(traceDir, imageName)) {
         SINUCA3_DEBUG_PRINTF(
             "[OnImageLoad] Failed to create static trace file.\n");
         return;
@@ -859,6 +891,10 @@ VOID OnFini(INT32 code, VOID* ptr) {
     if (staticTrace) {
         delete staticTrace;
     }
+    /* Streams are closed by their writers, so it must be the last one. */
+    if (container) {
+        delete container;
+    }
     if (!wasInitInstrumentationCalled) {
         SINUCA3_DEBUG_PRINTF(
             "[OnFini] No instrumentation blocks were found in the target "